@@ -18,6 +18,7 @@ Copyright 2019 Matt Marchant
 
 #include "ActorSystem.hpp"
 #include "Actor.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 
@@ -30,6 +31,8 @@ ActorSystem::ActorSystem(xy::MessageBus& mb)
 
 void ActorSystem::process(float)
 {
+    Server::ProfileScope profile(Server::ProfileID::ActorSystem);
+
     m_aliveCount = 0;
     for (const auto& entity : getEntities())
     {
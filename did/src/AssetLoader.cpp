@@ -0,0 +1,423 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "AssetLoader.hpp"
+
+#include <xyginext/core/FileSystem.hpp>
+#include <xyginext/core/ConfigFile.hpp>
+#include <xyginext/core/Log.hpp>
+#include <xyginext/resources/ResourceHandler.hpp>
+
+#include <SFML/System/Lock.hpp>
+#include <SFML/System/Sleep.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Audio/SoundBuffer.hpp>
+#include <SFML/Audio/InputSoundFile.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+    const std::size_t MaxWorkers = 4;
+    const std::uint8_t AllGroups = AssetLoader::Menu | AssetLoader::Game;
+}
+
+AssetLoader::AssetLoader()
+    : m_running(true)
+{
+    //leave a core free for the main thread
+    auto workerCount = static_cast<std::size_t>(std::thread::hardware_concurrency());
+    workerCount = std::max(std::size_t(1), std::min(MaxWorkers, workerCount > 0 ? workerCount - 1 : 0));
+
+    for (auto i = 0u; i < workerCount; ++i)
+    {
+        m_workers.emplace_back(std::make_unique<Worker>(this));
+    }
+}
+
+AssetLoader::~AssetLoader()
+{
+    m_running = false;
+
+    {
+        sf::Lock lock(m_mutex);
+        m_pendingQueue.clear();
+    }
+
+    for (auto& worker : m_workers)
+    {
+        worker->thread.wait();
+    }
+}
+
+//public
+void AssetLoader::queueImage(const std::string& path, Group group)
+{
+    queue(path, Asset::Image, group);
+}
+
+void AssetLoader::queueSound(const std::string& path, Group group)
+{
+    queue(path, Asset::Sound, group);
+}
+
+void AssetLoader::queueSpriteSheet(const std::string& path, Group group)
+{
+    queue(path, Asset::SpriteSheet, group);
+}
+
+void AssetLoader::install(xy::ResourceHandler& resources, Group group)
+{
+    auto& textureLoader = resources.getLoader<sf::Texture>();
+    auto loadTexture = textureLoader.loader;
+    textureLoader.loader = [this, loadTexture, group](const std::string& path) -> std::any
+    {
+        auto asset = takeAsset(path, Asset::Image, group);
+        if (asset && asset->state == Asset::Decoded)
+        {
+            //sf::Texture has no move constructor so create it in place
+            //rather than copying it (and its GL texture) into the std::any
+            std::any texture(std::in_place_type<sf::Texture>);
+            if (std::any_cast<sf::Texture&>(texture).loadFromImage(asset->image))
+            {
+                return texture;
+            }
+        }
+        return loadTexture ? loadTexture(path) : std::any();
+    };
+
+    auto& soundLoader = resources.getLoader<sf::SoundBuffer>();
+    auto loadSound = soundLoader.loader;
+    soundLoader.loader = [this, loadSound, group](const std::string& path) -> std::any
+    {
+        auto asset = takeAsset(path, Asset::Sound, group);
+        if (asset && asset->state == Asset::Decoded)
+        {
+            std::any buffer(std::in_place_type<sf::SoundBuffer>);
+            if (std::any_cast<sf::SoundBuffer&>(buffer).loadFromSamples(asset->samples.data(), asset->samples.size(),
+                asset->channelCount, asset->sampleRate))
+            {
+                return buffer;
+            }
+        }
+        return loadSound ? loadSound(path) : std::any();
+    };
+}
+
+bool AssetLoader::upload(xy::ResourceHandler& resources, Group group, sf::Time budget)
+{
+    sf::Clock clock;
+    while (clock.getElapsedTime() < budget)
+    {
+        std::string path;
+        Asset::Type type = Asset::Image;
+        {
+            sf::Lock lock(m_mutex);
+
+            //anything not in this group is left for its own consumer
+            //to take, and anything already taken by every group is dropped
+            auto next = m_decodedQueue.begin();
+            while (next != m_decodedQueue.end())
+            {
+                auto result = m_assets.find(*next);
+                if (result == m_assets.end())
+                {
+                    next = m_decodedQueue.erase(next);
+                }
+                else if ((result->second->groups & group) == 0)
+                {
+                    ++next;
+                }
+                else
+                {
+                    type = result->second->type;
+                    break;
+                }
+            }
+
+            if (next == m_decodedQueue.end())
+            {
+                break;
+            }
+            //the entry is left for any other group still waiting
+            //on the asset, and is dropped above once it's all taken
+            path = *next;
+        }
+
+        if (type == Asset::Sound)
+        {
+            resources.load<sf::SoundBuffer>(path);
+        }
+        else
+        {
+            resources.load<sf::Texture>(path);
+        }
+
+        //if the handler already had the resource then the
+        //decoded data was never taken, so throw it away
+        takeAsset(path, type, group);
+    }
+
+    //parsed sprite sheets are kept so that they aren't queued twice
+    //and failed assets are never uploaded, so neither is counted
+    sf::Lock lock(m_mutex);
+    return std::none_of(m_assets.begin(), m_assets.end(),
+        [group](const std::pair<const std::string, std::unique_ptr<Asset>>& a)
+        {
+            return (a.second->groups & group) != 0
+                && (a.second->state == Asset::Queued
+                    || a.second->state == Asset::Decoding
+                    || (a.second->state == Asset::Decoded && a.second->type != Asset::SpriteSheet));
+        });
+}
+
+bool AssetLoader::takeImage(const std::string& path, sf::Image& dst)
+{
+    auto asset = takeAsset(path, Asset::Image, AllGroups);
+    if (asset && asset->state == Asset::Decoded)
+    {
+        dst = asset->image;
+        return true;
+    }
+    return false;
+}
+
+std::size_t AssetLoader::verifyImages()
+{
+    //sprite sheets queue their images once parsed
+    waitForWorkers();
+
+    std::vector<std::string> paths;
+    {
+        sf::Lock lock(m_mutex);
+        for (const auto& [path, asset] : m_assets)
+        {
+            if (asset->type == Asset::Image)
+            {
+                paths.push_back(path);
+            }
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::size_t mismatches = 0;
+    for (const auto& path : paths)
+    {
+        sf::Image reference;
+        reference.loadFromFile(xy::FileSystem::getResourcePath() + path);
+
+        sf::Image decoded;
+        takeImage(path, decoded);
+
+        const auto size = reference.getSize();
+        if (size != decoded.getSize()
+            || (size.x * size.y > 0 && std::memcmp(reference.getPixelsPtr(), decoded.getPixelsPtr(), size.x * size.y * 4) != 0))
+        {
+            xy::Logger::log(path + ": decoded image differs from reference", xy::Logger::Type::Error);
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+//private
+void AssetLoader::queue(const std::string& path, Asset::Type type, std::uint8_t groups)
+{
+    sf::Lock lock(m_mutex);
+    queueLocked(path, type, groups);
+}
+
+void AssetLoader::queueLocked(const std::string& path, Asset::Type type, std::uint8_t groups)
+{
+    if (!m_running)
+    {
+        return;
+    }
+
+    //assets shared between consumers are decoded once and
+    //kept until every group they were queued in has taken them
+    auto result = m_assets.find(path);
+    if (result != m_assets.end())
+    {
+        auto& existing = *result->second;
+        existing.groups |= groups;
+
+        //a parsed sheet has already queued its texture, which may
+        //since have been taken by the sheet's other group(s)
+        if (!existing.texturePath.empty())
+        {
+            queueLocked(existing.texturePath, Asset::Image, groups);
+        }
+        return;
+    }
+
+    auto asset = std::make_unique<Asset>();
+    asset->type = type;
+    asset->groups = groups;
+    asset->path = path;
+    m_pendingQueue.push_back(asset.get());
+    m_assets.insert(std::make_pair(path, std::move(asset)));
+
+    //workers only go idle while holding the lock with an empty queue
+    //so the one launched here is guaranteed to pick up this asset
+    auto worker = std::find_if(m_workers.begin(), m_workers.end(), [](const std::unique_ptr<Worker>& w) { return !w->busy; });
+    if (worker != m_workers.end())
+    {
+        (*worker)->busy = true;
+        (*worker)->thread.launch();
+    }
+}
+
+std::unique_ptr<AssetLoader::Asset> AssetLoader::takeAsset(const std::string& path, Asset::Type type, std::uint8_t groups)
+{
+    //workers never touch an asset again once it's
+    //marked as done, so it's safe to hand it over
+    while (true)
+    {
+        {
+            sf::Lock lock(m_mutex);
+            auto result = m_assets.find(path);
+            if (result == m_assets.end()
+                || result->second->type != type
+                || (result->second->groups & groups) == 0)
+            {
+                return nullptr;
+            }
+
+            if (result->second->state == Asset::Decoded
+                || result->second->state == Asset::Failed)
+            {
+                //other groups still waiting on the asset get their own copy
+                result->second->groups &= ~groups;
+                if (result->second->groups != 0)
+                {
+                    return std::make_unique<Asset>(*result->second);
+                }
+
+                auto asset = std::move(result->second);
+                m_assets.erase(result);
+                return asset;
+            }
+        }
+        sf::sleep(sf::milliseconds(1));
+    }
+    return nullptr;
+}
+
+void AssetLoader::waitForWorkers()
+{
+    while (true)
+    {
+        {
+            sf::Lock lock(m_mutex);
+            if (std::none_of(m_workers.begin(), m_workers.end(), [](const std::unique_ptr<Worker>& w) { return w->busy; }))
+            {
+                return;
+            }
+        }
+        sf::sleep(sf::milliseconds(1));
+    }
+}
+
+void AssetLoader::processQueue(Worker& worker)
+{
+    while (true)
+    {
+        Asset* asset = nullptr;
+        {
+            sf::Lock lock(m_mutex);
+            if (m_pendingQueue.empty() || !m_running)
+            {
+                worker.busy = false;
+                return;
+            }
+
+            asset = m_pendingQueue.front();
+            m_pendingQueue.pop_front();
+            asset->state = Asset::Decoding;
+        }
+
+        std::string texturePath;
+        const bool decoded = decode(*asset, texturePath);
+
+        //the sprite sheet texture is queued as a regular image
+        //before the sheet is marked as done, so that this worker
+        //can't go idle while there's still work to pick up. The
+        //sheet's groups may change until the lock is taken here.
+        sf::Lock lock(m_mutex);
+        if (!texturePath.empty())
+        {
+            asset->texturePath = texturePath;
+            queueLocked(texturePath, Asset::Image, asset->groups);
+        }
+        asset->state = decoded ? Asset::Decoded : Asset::Failed;
+        if (decoded && asset->type != Asset::SpriteSheet)
+        {
+            m_decodedQueue.push_back(asset->path);
+        }
+    }
+}
+
+bool AssetLoader::decode(Asset& asset, std::string& texturePath)
+{
+    const auto path = xy::FileSystem::getResourcePath() + asset.path;
+    bool success = false;
+
+    switch (asset.type)
+    {
+    default: break;
+    case Asset::Image:
+        success = asset.image.loadFromFile(path);
+        break;
+    case Asset::Sound:
+    {
+        sf::InputSoundFile file;
+        if (file.openFromFile(path))
+        {
+            asset.samples.resize(static_cast<std::size_t>(file.getSampleCount()));
+            asset.channelCount = file.getChannelCount();
+            asset.sampleRate = file.getSampleRate();
+            success = file.read(asset.samples.data(), asset.samples.size()) == asset.samples.size();
+        }
+    }
+        break;
+    case Asset::SpriteSheet:
+    {
+        //the parsed sheet is only needed to find the texture
+        xy::ConfigFile sheet;
+        if (sheet.loadFromFile(path))
+        {
+            if (auto* src = sheet.findProperty("src"); src)
+            {
+                texturePath = src->getValue<std::string>();
+                success = !texturePath.empty();
+            }
+        }
+    }
+        break;
+    }
+
+    if (!success)
+    {
+        xy::Logger::log("Failed to decode " + asset.path, xy::Logger::Type::Warning);
+    }
+    return success;
+}
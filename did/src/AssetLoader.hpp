@@ -0,0 +1,145 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <SFML/System/Thread.hpp>
+#include <SFML/System/Mutex.hpp>
+#include <SFML/System/Time.hpp>
+#include <SFML/Graphics/Image.hpp>
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+
+namespace xy
+{
+    class ResourceHandler;
+}
+
+/*
+Decodes image files, sound files and sprite sheets on worker threads
+into CPU side buffers, so that only the GPU upload is left for the main
+thread. Once installed on a ResourceHandler any texture or sound buffer
+loaded from a queued path is created from the decoded data (waiting for
+it if it's not yet ready) and any other path is loaded from disk as
+normal. Paths are relative to the resource directory, exactly as they
+are passed to the ResourceHandler. The loader must outlive any handler
+it's installed on.
+*/
+class AssetLoader final
+{
+public:
+    AssetLoader();
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader(AssetLoader&&) = delete;
+    AssetLoader& operator = (const AssetLoader&) = delete;
+    AssetLoader& operator = (AssetLoader&&) = delete;
+
+    //assets are queued in a group so that upload() only
+    //creates the resources its consumer asked for. An asset
+    //queued in more than one group is kept until each has taken it
+    enum Group
+    {
+        Menu = 0x1,
+        Game = 0x2
+    };
+
+    //queues an image to be decoded into an sf::Image
+    void queueImage(const std::string& path, Group);
+
+    //queues a sound file to be decoded into 16 bit samples
+    void queueSound(const std::string& path, Group);
+
+    //parses the sprite sheet on a worker thread and queues
+    //its texture in the same group(s)
+    void queueSpriteSheet(const std::string& path, Group);
+
+    //replaces the texture and sound buffer loaders of the given
+    //handler with ones which use the decoded data in the given
+    //group where available
+    void install(xy::ResourceHandler&, Group);
+
+    //creates resources in the given handler from any decoded data in
+    //the given group until the time budget is spent. Returns true once
+    //everything queued in the group so far has been uploaded.
+    bool upload(xy::ResourceHandler&, Group, sf::Time budget);
+
+    //waits for the image at the given path to be decoded, copies it
+    //into the given destination and releases the decoded data from
+    //every group it was queued in. Returns
+    //false if the path was not queued or failed to decode. Doesn't
+    //require an active OpenGL context.
+    bool takeImage(const std::string& path, sf::Image& dst);
+
+    //takes every queued image and compares it with the same file decoded
+    //on the calling thread. Returns the number of images which differ.
+    std::size_t verifyImages();
+
+private:
+    struct Asset final
+    {
+        enum Type
+        {
+            Image, Sound, SpriteSheet
+        }type = Image;
+
+        enum State
+        {
+            Queued, Decoding, Decoded, Failed
+        }state = Queued;
+
+        std::uint8_t groups = 0;
+        std::string path;
+        std::string texturePath; //sprite sheets only, once parsed
+
+        sf::Image image;
+
+        std::vector<sf::Int16> samples;
+        unsigned channelCount = 0;
+        unsigned sampleRate = 0;
+    };
+
+    sf::Mutex m_mutex;
+    std::unordered_map<std::string, std::unique_ptr<Asset>> m_assets;
+    std::deque<Asset*> m_pendingQueue;
+    std::deque<std::string> m_decodedQueue;
+
+    struct Worker final
+    {
+        explicit Worker(AssetLoader* loader)
+            : thread([loader, this]() { loader->processQueue(*this); }) {}
+        sf::Thread thread;
+        bool busy = false;
+    };
+    std::vector<std::unique_ptr<Worker>> m_workers;
+    std::atomic<bool> m_running;
+
+    void queue(const std::string&, Asset::Type, std::uint8_t groups);
+    void queueLocked(const std::string&, Asset::Type, std::uint8_t groups); //caller must hold m_mutex
+    std::unique_ptr<Asset> takeAsset(const std::string&, Asset::Type, std::uint8_t groups);
+    void waitForWorkers();
+    void processQueue(Worker&);
+    bool decode(Asset&, std::string&);
+};
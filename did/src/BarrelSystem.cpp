@@ -17,7 +17,7 @@ Copyright 2019 Matt Marchant
 *********************************************************************/
 
 #include "BarrelSystem.hpp"
-#include "SharedStateData.hpp"
+#include "ServerSharedStateData.hpp"
 #include "AnimationSystem.hpp"
 #include "CollisionBounds.hpp"
 #include "ServerRandom.hpp"
@@ -26,6 +26,7 @@ Copyright 2019 Matt Marchant
 #include "MessageIDs.hpp"
 #include "Actor.hpp"
 #include "ResourceIDs.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/ecs/components/BroadPhaseComponent.hpp>
@@ -48,8 +49,8 @@ namespace
         15.5f, 18.f, 14.f, 16.f, 15.f
     };
 
-    //we shuffle this each time a new system is created
-    std::array<Actor::ID, 14u> Items = 
+    //each system shuffles its own copy of this
+    const std::array<Actor::ID, 14u> Items = 
     {
         Actor::Food, Actor::Food ,Actor::MineItem, Actor::MineItem,
         Actor::Ammo, Actor::Ammo, Actor::FlareItem, Actor::MineItem,
@@ -59,10 +60,12 @@ namespace
     };
 }
 
-BarrelSystem::BarrelSystem(xy::MessageBus& mb)
+BarrelSystem::BarrelSystem(xy::MessageBus& mb, std::mt19937& rndEngine)
     : xy::System(mb, typeid(BarrelSystem)),
+    m_rndEngine (rndEngine),
     m_spawnIndex(0),
     m_spawnTimer(0.f),
+    m_items     (Items),
     m_itemIndex (0),
     m_mineCount (0)
 {
@@ -70,7 +73,7 @@ BarrelSystem::BarrelSystem(xy::MessageBus& mb)
     requireComponent<xy::Transform>();
     requireComponent<CollisionComponent>();
 
-    std::shuffle(Items.begin(), Items.end(), Server::rndEngine);
+    std::shuffle(m_items.begin(), m_items.end(), m_rndEngine);
 }
 
 //public
@@ -91,6 +94,8 @@ void BarrelSystem::handleMessage(const xy::Message& msg)
 
 void BarrelSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::BarrelSystem);
+
     auto& entities = getEntities();
     
     //check if it's time to spawn a barrel
@@ -128,7 +133,7 @@ void BarrelSystem::process(float dt)
 //private
 void BarrelSystem::spawn()
 {
-    auto direction = Server::getRandomInt(0, 3);
+    auto direction = Server::getRandomInt(m_rndEngine, 0, 3);
     sf::Vector2f position;
     switch (direction)
     {
@@ -196,9 +201,9 @@ void BarrelSystem::updateBeached(xy::Entity entity)
             entity.getComponent<AnimationModifier>().nextAnimation = AnimationID::Break;
     
             msg->id = inventory.weapon == Barrel::Gold ?
-                Actor::ID::Coin : Items[m_itemIndex];
+                Actor::ID::Coin : m_items[m_itemIndex];
 
-            m_itemIndex = (m_itemIndex + 1) % Items.size();
+            m_itemIndex = (m_itemIndex + 1) % m_items.size();
 
             //mines create non-despawning ents when placed
             //so limit the total number spawned to prevent
@@ -211,7 +216,7 @@ void BarrelSystem::updateBeached(xy::Entity entity)
             }
 
             //rarely a poop snail
-            if (Server::getRandomInt(0, 16) == 0)
+            if (Server::getRandomInt(m_rndEngine, 0, 16) == 0)
             {
                 msg->id = Actor::ID::Crab;
             }
@@ -19,9 +19,13 @@ Copyright 2019 Matt Marchant
 #pragma once
 
 #include "InventorySystem.hpp"
+#include "Actor.hpp"
 
 #include <xyginext/ecs/System.hpp>
 
+#include <array>
+#include <random>
+
 struct Barrel final
 {
     float speed = 60.f;
@@ -47,16 +51,18 @@ struct Barrel final
 class BarrelSystem final : public xy::System
 {
 public:
-    explicit BarrelSystem(xy::MessageBus&);
+    BarrelSystem(xy::MessageBus&, std::mt19937&);
 
     void handleMessage(const xy::Message&) override;
     void process(float) override;
 
 private:
+    std::mt19937& m_rndEngine;
 
     std::size_t m_spawnIndex;
     float m_spawnTimer;
 
+    std::array<Actor::ID, 14u> m_items;
     std::size_t m_itemIndex;
 
     std::size_t m_mineCount;
@@ -24,6 +24,7 @@ Copyright 2019 Matt Marchant
 #include "MessageIDs.hpp"
 #include "DecoySystem.hpp"
 #include "PlayerSystem.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
@@ -82,6 +83,8 @@ void BeeSystem::handleMessage(const xy::Message& msg)
 
 void BeeSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::BeeSystem);
+
     bool dayTime = isDayTime();
 
     auto& entities = getEntities();
@@ -23,7 +23,7 @@ Copyright 2019 Matt Marchant
 #include "ServerRandom.hpp"
 #include "InputBinding.hpp"
 #include "CollisionBounds.hpp"
-#include "SharedStateData.hpp"
+#include "ServerSharedStateData.hpp"
 #include "Packet.hpp"
 #include "PacketTypes.hpp"
 #include "Server.hpp"
@@ -36,6 +36,7 @@ Copyright 2019 Matt Marchant
 #include "CarriableSystem.hpp"
 #include "SkeletonSystem.hpp"
 #include "InputParser.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
@@ -79,6 +80,10 @@ namespace
 
     const float SweepTime = 1.f; //how frequently to sweep the area for interfering events
     const float SearchTime = 0.6f; //how frequently to search nearby area for dig spots
+    const std::size_t StaggerSlots = 8; //bots are spread across this many offsets of the sweep time
+
+    const sf::Time DefaultTimeBudget = sf::milliseconds(1);
+    const float LatencyInterval = 1.f;
 
     const float MaxMoveTime = 3.f; //if we didn't find a new node in time, reset the path
 
@@ -119,6 +124,15 @@ BotSystem::BotSystem(xy::MessageBus& mb, PathFinder& pf, std::size_t seed)
     : xy::System        (mb, typeid(BotSystem)),
     m_pathFinder        (pf),
     m_timeAccumulator   (0),
+    m_sweepInterval     (SweepTime),
+    m_searchInterval    (SearchTime),
+    m_timeBudget        (DefaultTimeBudget),
+    m_firstBot          (0),
+    m_processTime       (0),
+    m_latencySum        (0.f),
+    m_latencyCount      (0),
+    m_latencyTime       (0.f),
+    m_decisionLatency   (0.f),
     m_rndEngine         (seed),
     m_dayPosition       (0.f)
 {
@@ -204,7 +218,7 @@ void BotSystem::handleMessage(const xy::Message& msg)
                 {
                     bot.movementTimer = 0.f;
                     bot.resetState();
-                    bot.targetPoint = m_destinationPoints[Server::getRandomInt(0, m_destinationPoints.size() - 1)];
+                    bot.targetPoint = m_destinationPoints[Server::getRandomInt(m_rndEngine, 0, static_cast<int>(m_destinationPoints.size()) - 1)];
                     LOG("Reset bot " + ActorNames[entity.getComponent<Actor>().id], xy::Logger::Type::Info);
                 }
             }
@@ -288,11 +302,22 @@ void BotSystem::handleMessage(const xy::Message& msg)
 
 void BotSystem::process(float dt)
 {
-    m_timeAccumulator += static_cast<std::int32_t>(dt * 1000000.f);
+    Server::ProfileScope profile(Server::ProfileID::BotSystem);
+
+    m_processClock.restart();
+    m_timeAccumulator += static_cast<std::int64_t>(dt * 1000000.f);
 
+    //rotate the order in which bots are updated so that
+    //the same bots aren't always the ones deferred by the budget
     auto& entities = getEntities();
-    for (auto entity : entities)
+    if (!entities.empty())
+    {
+        m_firstBot = (m_firstBot + 1) % entities.size();
+    }
+
+    for (auto i = 0u; i < entities.size(); ++i)
     {
+        auto entity = entities[(i + m_firstBot) % entities.size()];
         auto& bot = entity.getComponent<Bot>();
         bot.inputMask = 0;
 
@@ -307,11 +332,14 @@ void BotSystem::process(float dt)
                 bot.resetState();
             }
 
-            //do a sweep to see if nearby items, other players or enemies are nearby
+            //do a sweep to see if nearby items, other players or enemies are nearby.
+            //if we're out of time the timer isn't reset, so the sweep happens next update
             bot.sweepTimer += dt;
-            if (bot.sweepTimer > SweepTime
-                && !bot.fleeing)
+            if (bot.sweepTimer > m_sweepInterval
+                && !bot.fleeing
+                && hasBudget())
             {
+                logLatency(bot.sweepTimer - m_sweepInterval);
                 bot.sweepTimer = 0.f;
                 wideSweep(entity);
             }
@@ -400,6 +428,17 @@ void BotSystem::process(float dt)
             playerIp.currentInput = (playerIp.currentInput + 1) % playerIp.history.size();
         }
     }
+
+    m_latencyTime += dt;
+    if (m_latencyTime > LatencyInterval)
+    {
+        m_decisionLatency = m_latencyCount ? (m_latencySum / static_cast<float>(m_latencyCount)) * 1000.f : 0.f;
+        m_latencySum = 0.f;
+        m_latencyCount = 0;
+        m_latencyTime = 0.f;
+    }
+
+    m_processTime = m_processClock.getElapsedTime().asMicroseconds();
 }
 
 void BotSystem::addDiggableSpot(sf::Vector2f pos)
@@ -432,7 +471,26 @@ void BotSystem::resetDigSpots()
     std::shuffle(m_destinationPoints.begin(), m_destinationPoints.end(), m_rndEngine);
 }
 
+void BotSystem::setPerceptionRate(float rate)
+{
+    XY_ASSERT(rate > 0, "Invalid rate");
+    m_sweepInterval = 1.f / rate;
+    m_searchInterval = m_sweepInterval * (SearchTime / SweepTime);
+}
+
 //private
+bool BotSystem::hasBudget() const
+{
+    return m_timeBudget == sf::Time::Zero
+        || m_processClock.getElapsedTime() < m_timeBudget;
+}
+
+void BotSystem::logLatency(float overdue)
+{
+    m_latencySum += overdue;
+    m_latencyCount++;
+}
+
 bool BotSystem::isDay() const
 {
     return (m_dayPosition > 0.25f && m_dayPosition < 0.5f) || (m_dayPosition > 0.75f && m_dayPosition < 1.f);
@@ -504,10 +562,12 @@ void BotSystem::updateSearching(xy::Entity entity, float dt)
 
         //check for diggable holes
         bot.searchTimer += dt;
-        if (bot.searchTimer > SearchTime
+        if (bot.searchTimer > m_searchInterval
             && !bot.fleeing
-            && entity.getComponent<Carrier>().carryFlags == 0) //ignore when carrying else item tends to get applied to treasure patch
+            && entity.getComponent<Carrier>().carryFlags == 0 //ignore when carrying else item tends to get applied to treasure patch
+            && hasBudget())
         {
+            logLatency(bot.searchTimer - m_searchInterval);
             bot.searchTimer = 0.f;
 
             auto position = entity.getComponent<xy::Transform>().getPosition();
@@ -593,7 +653,7 @@ void BotSystem::updateDigging(xy::Entity entity, float dt)
     if (tooFar(entity))
     {
         bot.resetState();
-        bot.sweepTimer = SweepTime;
+        bot.sweepTimer = m_sweepInterval;
         return;
     }
 
@@ -700,7 +760,7 @@ void BotSystem::updateDigging(xy::Entity entity, float dt)
                 bot.path.clear();
 
                 //force an immediate sweep to look for items
-                bot.sweepTimer = SweepTime;
+                bot.sweepTimer = m_sweepInterval;
             }
         }
     }
@@ -714,7 +774,7 @@ void BotSystem::updateDigging(xy::Entity entity, float dt)
         bot.targetEntity = {};
         bot.targetType = Bot::Target::None;
         bot.path.clear();
-        bot.sweepTimer = SweepTime; //force a sweep and hope we find the attacker
+        bot.sweepTimer = m_sweepInterval; //force a sweep and hope we find the attacker
     }
 }
 
@@ -730,7 +790,7 @@ void BotSystem::updateFighting(xy::Entity entity, float dt)
     /*if (tooFar(entity))
     {
         bot.resetState();
-        bot.sweepTimer = SweepTime;
+        bot.sweepTimer = m_sweepInterval;
         return;
     }*/
 
@@ -780,7 +840,7 @@ void BotSystem::updateFighting(xy::Entity entity, float dt)
     if (!(validActor && validState))
     {
         bot.popState();
-        bot.sweepTimer = SweepTime;
+        bot.sweepTimer = m_sweepInterval;
         return;
     }
 
@@ -1043,7 +1103,7 @@ void BotSystem::updateTargeting(xy::Entity entity, float dt)
     /*if (tooFar(entity))
     {
         bot.resetState();
-        bot.sweepTimer = SweepTime;
+        bot.sweepTimer = m_sweepInterval;
         return;
     }*/
 
@@ -1701,4 +1761,9 @@ void BotSystem::onEntityAdded(xy::Entity entity)
     entity.getComponent<Bot>().pointIndex = getRandomInt(0, m_destinationPoints.size());
     entity.getComponent<Bot>().indexStride = getRandomInt(1, 3);
     entity.getComponent<Bot>().targetPoint = m_destinationPoints[getRandomInt(0, m_destinationPoints.size())];
+
+    //stagger the sweeps so they're spread over multiple updates
+    const float offset = static_cast<float>(entity.getIndex() % StaggerSlots) / StaggerSlots;
+    entity.getComponent<Bot>().sweepTimer = m_sweepInterval * offset;
+    entity.getComponent<Bot>().searchTimer = m_searchInterval * offset;
 }
@@ -50,7 +50,7 @@ struct Bot final
     float buttonTimer = 0.f; //time until trying to press action button again
     float movementTimer = 0.f; //if this times out we assume we're stuck and need a better path
     float searchTimer = 0.f; //when timed out do a nearby search
-    float sweepTimer = 0.f; //which this times out do a sweep search
+    float sweepTimer = 0.f; //which this times out do a sweep search. Staggered by entity ID so bots don't all sweep at once
     float fightTimer = 0.f; //try restarting a fight if this expires
     float itemTimer = 8.f; //try using an item if we're carrying one?? (for some reason this one counts down, not up...)
     float fleeTimer = 0.f; //flee until this expires
@@ -163,11 +163,42 @@ public:
     //at the end of the round target boats instead
     void resetDigSpots(); 
 
+    //number of times per second each bot sweeps its surroundings
+    void setPerceptionRate(float);
+
+    //max time spent on AI each update. Steering always runs, but
+    //any sweeps which don't fit in the budget are deferred until
+    //the next update. A budget of zero is unlimited, which recorded
+    //and replayed matches use so that no sweeps depend on timing
+    void setTimeBudget(sf::Time budget) { m_timeBudget = budget; }
+
+    //time spent in the last update, in microseconds
+    std::int64_t getProcessTime() const { return m_processTime; }
+
+    //average time, in milliseconds, that sweeps were
+    //overdue by when they were run, over the last second
+    float getDecisionLatency() const { return m_decisionLatency; }
+
 private:
     PathFinder& m_pathFinder;
-    std::int32_t m_timeAccumulator;
+    std::int64_t m_timeAccumulator;
     std::vector<sf::Vector2f> m_destinationPoints;
 
+    float m_sweepInterval;
+    float m_searchInterval;
+    sf::Time m_timeBudget;
+    sf::Clock m_processClock;
+    std::size_t m_firstBot;
+
+    std::int64_t m_processTime;
+    float m_latencySum;
+    std::size_t m_latencyCount;
+    float m_latencyTime;
+    float m_decisionLatency;
+
+    bool hasBudget() const;
+    void logLatency(float);
+
     std::mt19937 m_rndEngine;
 
     float m_dayPosition;
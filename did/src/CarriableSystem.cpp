@@ -29,6 +29,7 @@ Copyright 2019 Matt Marchant
 #include "Operators.hpp"
 #include "GlobalConsts.hpp"
 #include "BoatSystem.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
@@ -81,6 +82,8 @@ void CarriableSystem::handleMessage(const xy::Message& msg)
 
 void CarriableSystem::process(float)
 {
+    Server::ProfileScope profile(Server::ProfileID::CarriableSystem);
+
     //find carried entities and update offset based on parent direction
     auto& entities = getEntities();
     for (auto entity : entities)
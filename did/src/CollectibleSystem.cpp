@@ -26,6 +26,7 @@ Copyright 2019 Matt Marchant
 #include "ServerRandom.hpp"
 #include "MessageIDs.hpp"
 #include "GlobalConsts.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 #include <xyginext/ecs/components/Transform.hpp>
@@ -35,9 +36,10 @@ namespace
 
 }
 
-CollectibleSystem::CollectibleSystem(xy::MessageBus& mb, Server::SharedStateData& sd)
+CollectibleSystem::CollectibleSystem(xy::MessageBus& mb, Server::SharedStateData& sd, std::mt19937& rndEngine)
     : xy::System(mb, typeid(CollectibleSystem)),
-    m_sharedData(sd)
+    m_sharedData(sd),
+    m_rndEngine (rndEngine)
 {
     requireComponent<Collectible>();
     requireComponent<CollisionComponent>();
@@ -47,6 +49,8 @@ CollectibleSystem::CollectibleSystem(xy::MessageBus& mb, Server::SharedStateData
 //public
 void CollectibleSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::CollectibleSystem);
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
@@ -173,6 +177,6 @@ void CollectibleSystem::process(float dt)
 void CollectibleSystem::onEntityAdded(xy::Entity entity)
 {
     auto& collectible = entity.getComponent<Collectible>();
-    collectible.velocity.x = Server::getRandomFloat(-100.f, 100.f);
-    collectible.velocity.y = Server::getRandomFloat(-100.f, 100.f);
+    collectible.velocity.x = Server::getRandomFloat(m_rndEngine, -100.f, 100.f);
+    collectible.velocity.y = Server::getRandomFloat(m_rndEngine, -100.f, 100.f);
 }
\ No newline at end of file
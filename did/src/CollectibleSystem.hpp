@@ -20,6 +20,8 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/ecs/System.hpp>
 
+#include <random>
+
 namespace Server
 {
     struct SharedStateData;
@@ -48,12 +50,13 @@ struct Collectible final
 class CollectibleSystem final : public xy::System
 {
 public:
-    CollectibleSystem(xy::MessageBus&, Server::SharedStateData&);
+    CollectibleSystem(xy::MessageBus&, Server::SharedStateData&, std::mt19937&);
 
     void process(float) override;
 
 private:
     Server::SharedStateData& m_sharedData;
+    std::mt19937& m_rndEngine;
 
     void onEntityAdded(xy::Entity) override;
 };
\ No newline at end of file
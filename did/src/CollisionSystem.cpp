@@ -20,6 +20,7 @@ Copyright 2019 Matt Marchant
 #include "QuadTreeFilter.hpp"
 #include "GlobalConsts.hpp"
 #include "Operators.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 #include <xyginext/ecs/components/Transform.hpp>
@@ -28,6 +29,10 @@ Copyright 2019 Matt Marchant
 #include <xyginext/util/Vector.hpp>
 #include <xyginext/util/Math.hpp>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+
 namespace
 {
     //this is because the graphical representation has been offset by
@@ -42,15 +47,34 @@ namespace
     {
         Water, Sand, Solid = Sand + 2
     };
+
+    //the broadphase grid is aligned with the tile grid
+    std::uint32_t cellCoord(float position, std::size_t cellCount)
+    {
+        auto cell = static_cast<std::int32_t>(std::floor(position / Global::TileSize));
+        return static_cast<std::uint32_t>(xy::Util::Math::clamp(cell, 0, static_cast<std::int32_t>(cellCount) - 1));
+    }
+
+    //packs a pair of entity indices, lowest first, so that
+    //sorting the keys matches the order of std::minmax(Entity, Entity)
+    std::uint64_t pairKey(std::uint32_t a, std::uint32_t b)
+    {
+        auto pair = std::minmax(a, b);
+        return (static_cast<std::uint64_t>(pair.first) << 32) | pair.second;
+    }
 }
 
 CollisionSystem::CollisionSystem(xy::MessageBus& mb, bool isServer)
     : xy::System(mb, typeid(CollisionSystem)),
-    m_server    (isServer)
+    m_server    (isServer),
+    m_tileTypes (Global::TileCount, TileType::Water),
+    m_gridDirty (true)
 {
     requireComponent<CollisionComponent>();
     requireComponent<xy::Transform>();
     requireComponent<xy::BroadphaseComponent>();
+
+    m_cellStart.resize(Global::TileCount + 1);
 }
 
 //public
@@ -61,7 +85,7 @@ void CollisionSystem::handleMessage(const xy::Message&)
 
 void CollisionSystem::process(float)
 {
-    m_collisions.clear();
+    Server::ProfileScope profile(Server::ProfileID::CollisionSystem);
 
     auto& entities = getEntities();
 
@@ -79,12 +103,11 @@ void CollisionSystem::process(float)
         {
             boatCollision(entity);
         }*/
-
-        actorCollision(entity);
     }
-    narrowPhase();
 
-    //resolveAll();
+    buildGrid();
+    broadPhase();
+    narrowPhase();
 }
 
 void CollisionSystem::queryState(xy::Entity entity)
@@ -92,16 +115,30 @@ void CollisionSystem::queryState(xy::Entity entity)
     XY_ASSERT(entity.hasComponent<CollisionComponent>() && entity.hasComponent<xy::Transform>(), "Nope!");
     entity.getComponent<CollisionComponent>().manifoldCount = 0;
 
-    m_collisions.swap(m_tempCollisions);
-
     terrainCollision(entity);
-    actorCollision(entity);
-    boatCollision(entity);
+
+    //the grid is only rebuilt if entities were added or removed, or
+    //changed cells, since it was last built. Otherwise just the queried
+    //entity is brought up to date
+    if (m_gridDirty)
+    {
+        buildGrid();
+    }
+    else
+    {
+        updateActor(entity);
+    }
     narrowPhaseQuery(entity);
-    //resolveAll();
 
-    m_collisions.clear();
-    m_tempCollisions.swap(m_collisions);
+    boatCollision(entity);
+}
+
+void CollisionSystem::setTileData(const TileArray& tileArray)
+{
+    for (auto i = 0u; i < Global::TileCount; ++i)
+    {
+        m_tileTypes[i] = tileArray[i] / 2;
+    }
 }
 
 //private
@@ -152,7 +189,7 @@ void CollisionSystem::terrainCollision(xy::Entity entity)
                     if (tileBounds.intersects(collisionBounds, intersection))
                     {
                         auto normal = (sf::Vector2f(tileBounds.left, tileBounds.top) + CollisionOffset) - position;
-                        collision.manifolds[collision.manifoldCount] = calcManifold(normal, intersection);
+                        collision.manifolds[collision.manifoldCount] = calcManifold(normal, { intersection.width, intersection.height });
                         collision.manifolds[collision.manifoldCount++].ID = ManifoldID::Terrain;
                     }
                 }
@@ -193,42 +230,6 @@ void CollisionSystem::terrainCollision(xy::Entity entity)
     }
 }
 
-void CollisionSystem::actorCollision(xy::Entity entity)
-{
-    if (entity.getComponent<xy::BroadphaseComponent>().getFilterFlags() == 0) return; //collision is disabled
-
-    const auto& tx = entity.getComponent<xy::Transform>();
-    auto position = tx.getWorldPosition();
-    //auto origin = tx.getOrigin();
-    auto bounds = entity.getComponent<CollisionComponent>().bounds;
-    auto queryBounds = bounds * 2.f;
-
-    bounds.left += position.x;// +origin.x;
-    bounds.top += position.y;// +origin.y;
-        
-    queryBounds.left += position.x;
-    queryBounds.top += position.y;
-
-    //query quad tree and do inter-sprite collision
-    std::vector<xy::Entity> ents = getScene()->getSystem<xy::DynamicTreeSystem>().query(queryBounds, QuadTreeFilter::Collidable);
-
-    for (auto otherEnt : ents)
-    {
-        if (otherEnt != entity)
-        {
-            auto otherPosition = otherEnt.getComponent<xy::Transform>().getWorldPosition();
-            auto otherBounds = otherEnt.getComponent<CollisionComponent>().bounds;
-            otherBounds.left += otherPosition.x;
-            otherBounds.top += otherPosition.y;
-
-            if (otherBounds.intersects(bounds))
-            {
-                m_collisions.insert(std::minmax(entity, otherEnt));
-            }
-        }
-    }
-}
-
 void CollisionSystem::boatCollision(xy::Entity entity)
 {
     auto position = entity.getComponent<xy::Transform>().getWorldPosition();
@@ -261,37 +262,200 @@ void CollisionSystem::boatCollision(xy::Entity entity)
     }
 }
 
+void CollisionSystem::buildGrid()
+{
+    m_actors.clear();
+    m_actorCells.clear();
+
+    auto& entities = getEntities();
+    for (auto entity : entities)
+    {
+        auto flags = entity.getComponent<xy::BroadphaseComponent>().getFilterFlags();
+        if (flags == 0) continue; //collision is disabled
+
+        //we don't want to include scale in the collision bounds, just world pos
+        auto position = entity.getComponent<xy::Transform>().getWorldPosition();
+        const auto& bounds = entity.getComponent<CollisionComponent>().bounds;
+
+        auto index = entity.getIndex();
+        if (index >= m_actorSlots.size())
+        {
+            m_actorSlots.resize(index + 1);
+        }
+        m_actorSlots[index] = static_cast<std::uint32_t>(m_actors.size());
+
+        m_actors.entities.push_back(entity);
+        m_actors.posX.push_back(position.x);
+        m_actors.posY.push_back(position.y);
+        m_actors.left.push_back(position.x + bounds.left);
+        m_actors.top.push_back(position.y + bounds.top);
+        m_actors.right.push_back(position.x + bounds.left + bounds.width);
+        m_actors.bottom.push_back(position.y + bounds.top + bounds.height);
+        m_actors.filterFlags.push_back(flags);
+    }
+
+    //count how many actors overlap each cell
+    std::fill(m_cellStart.begin(), m_cellStart.end(), 0);
+    for (auto i = 0u; i < m_actors.size(); ++i)
+    {
+        auto x0 = cellCoord(m_actors.left[i], Global::TileCountX);
+        auto y0 = cellCoord(m_actors.top[i], Global::TileCountY);
+        auto x1 = cellCoord(m_actors.right[i], Global::TileCountX);
+        auto y1 = cellCoord(m_actors.bottom[i], Global::TileCountY);
+
+        m_actorCells.push_back(x0);
+        m_actorCells.push_back(y0);
+        m_actorCells.push_back(x1);
+        m_actorCells.push_back(y1);
+
+        for (auto y = y0; y <= y1; ++y)
+        {
+            for (auto x = x0; x <= x1; ++x)
+            {
+                m_cellStart[y * Global::TileCountX + x]++;
+            }
+        }
+    }
+
+    //convert the counts to the end of each cell's range
+    for (auto i = 1u; i < Global::TileCount; ++i)
+    {
+        m_cellStart[i] += m_cellStart[i - 1];
+    }
+    m_cellStart[Global::TileCount] = m_cellStart[Global::TileCount - 1];
+    m_cellEntries.resize(m_cellStart[Global::TileCount]);
+
+    //and fill backwards, which leaves m_cellStart pointing at the start of each range
+    for (auto i = 0u; i < m_actors.size(); ++i)
+    {
+        const auto* cells = &m_actorCells[i * 4];
+        for (auto y = cells[1]; y <= cells[3]; ++y)
+        {
+            for (auto x = cells[0]; x <= cells[2]; ++x)
+            {
+                m_cellEntries[--m_cellStart[y * Global::TileCountX + x]] = i;
+            }
+        }
+    }
+    m_gridDirty = false;
+}
+
+void CollisionSystem::updateActor(xy::Entity entity)
+{
+    auto index = entity.getIndex();
+    if (index >= m_actorSlots.size()
+        || m_actorSlots[index] >= m_actors.size()
+        || m_actors.entities[m_actorSlots[index]] != entity)
+    {
+        return;
+    }
+
+    const auto a = m_actorSlots[index];
+    auto position = entity.getComponent<xy::Transform>().getWorldPosition();
+    const auto& bounds = entity.getComponent<CollisionComponent>().bounds;
+
+    m_actors.posX[a] = position.x;
+    m_actors.posY[a] = position.y;
+    m_actors.left[a] = position.x + bounds.left;
+    m_actors.top[a] = position.y + bounds.top;
+    m_actors.right[a] = position.x + bounds.left + bounds.width;
+    m_actors.bottom[a] = position.y + bounds.top + bounds.height;
+
+    //the query itself reads the new cells, but other entities
+    //will only find this one once the grid is rebuilt
+    auto* cells = &m_actorCells[a * 4];
+    const std::array<std::uint32_t, 4u> newCells =
+    {
+        cellCoord(m_actors.left[a], Global::TileCountX),
+        cellCoord(m_actors.top[a], Global::TileCountY),
+        cellCoord(m_actors.right[a], Global::TileCountX),
+        cellCoord(m_actors.bottom[a], Global::TileCountY)
+    };
+
+    if (!std::equal(newCells.begin(), newCells.end(), cells))
+    {
+        std::copy(newCells.begin(), newCells.end(), cells);
+        m_gridDirty = true;
+    }
+}
+
+void CollisionSystem::broadPhase()
+{
+    m_pairKeys.clear();
+
+    for (auto cell = 0u; cell < Global::TileCount; ++cell)
+    {
+        const auto begin = m_cellStart[cell];
+        const auto end = m_cellStart[cell + 1];
+
+        for (auto i = begin; i < end; ++i)
+        {
+            const auto a = m_cellEntries[i];
+            const auto flagsA = m_actors.filterFlags[a];
+
+            for (auto j = i + 1; j < end; ++j)
+            {
+                const auto b = m_cellEntries[j];
+                const auto flagsB = m_actors.filterFlags[b];
+
+                //at least one of the pair must be collidable
+                if ((flagsA & QuadTreeFilter::Collidable)
+                    || (flagsB & QuadTreeFilter::Collidable))
+                {
+                    m_pairKeys.push_back(pairKey(m_actors.entities[a].getIndex(), m_actors.entities[b].getIndex()));
+                }
+            }
+        }
+    }
+
+    //actors spanning more than one cell will create duplicates. Sorting
+    //also keeps the manifold order consistent between updates
+    std::sort(m_pairKeys.begin(), m_pairKeys.end());
+    m_pairKeys.erase(std::unique(m_pairKeys.begin(), m_pairKeys.end()), m_pairKeys.end());
+}
+
 void CollisionSystem::narrowPhase()
 {
-    for (auto c : m_collisions)
+    const auto pairCount = m_pairKeys.size();
+    m_pairA.resize(pairCount);
+    m_pairB.resize(pairCount);
+    m_overlapX.resize(pairCount);
+    m_overlapY.resize(pairCount);
+    m_pairHit.resize(pairCount);
+
+    for (auto i = 0u; i < pairCount; ++i)
     {
-        const auto& txA = c.first.getComponent<xy::Transform>();
-        const auto& txB = c.second.getComponent<xy::Transform>();
+        m_pairA[i] = m_actorSlots[m_pairKeys[i] >> 32];
+        m_pairB[i] = m_actorSlots[m_pairKeys[i] & 0xffffffff];
+    }
 
-        auto& collisionA = c.first.getComponent<CollisionComponent>();
-        auto& collisionB = c.second.getComponent<CollisionComponent>();
+    //calc all the overlaps in one pass, without touching any components
+    for (auto i = 0u; i < pairCount; ++i)
+    {
+        const auto a = m_pairA[i];
+        const auto b = m_pairB[i];
 
-        //we don't want to include scale in the collision bounds, just world pos
-        auto posA = txA.getWorldPosition();
-        auto posB = txB.getWorldPosition();
+        m_overlapX[i] = std::min(m_actors.right[a], m_actors.right[b]) - std::max(m_actors.left[a], m_actors.left[b]);
+        m_overlapY[i] = std::min(m_actors.bottom[a], m_actors.bottom[b]) - std::max(m_actors.top[a], m_actors.top[b]);
+        m_pairHit[i] = (m_overlapX[i] > 0.f && m_overlapY[i] > 0.f) ? 1 : 0;
+    }
 
-        //auto originA = txA.getOrigin() * txA.getScale();
-        //auto originB = txB.getOrigin() * txB.getScale();
+    for (auto i = 0u; i < pairCount; ++i)
+    {
+        if (!m_pairHit[i]) continue;
 
-        auto boundsA = collisionA.bounds;
-        boundsA.left += posA.x;// +originA.x;
-        boundsA.top += posA.y;// +originA.y;
-        auto boundsB = collisionB.bounds;
-        boundsB.left += posB.x;// +originB.x;
-        boundsB.top += posB.y;// +originB.y;
+        const auto a = m_pairA[i];
+        const auto b = m_pairB[i];
 
-        auto normal = posB - posA;
-        sf::FloatRect overlap;
-        boundsA.intersects(boundsB, overlap);
+        auto entityA = m_actors.entities[a];
+        auto entityB = m_actors.entities[b];
+        auto& collisionA = entityA.getComponent<CollisionComponent>();
+        auto& collisionB = entityB.getComponent<CollisionComponent>();
 
-        Manifold manifold = calcManifold(normal, overlap);
+        sf::Vector2f normal(m_actors.posX[b] - m_actors.posX[a], m_actors.posY[b] - m_actors.posY[a]);
+        Manifold manifold = calcManifold(normal, { m_overlapX[i], m_overlapY[i] });
         manifold.ID = collisionB.ID;
-        manifold.otherEntity = c.second;
+        manifold.otherEntity = entityB;
 
         if (collisionA.manifoldCount < CollisionComponent::MaxManifolds)
         {
@@ -300,7 +464,7 @@ void CollisionSystem::narrowPhase()
 
         manifold.normal = -manifold.normal;
         manifold.ID = collisionA.ID;
-        manifold.otherEntity = c.first;
+        manifold.otherEntity = entityA;
 
         if (collisionB.manifoldCount < CollisionComponent::MaxManifolds)
         {
@@ -311,44 +475,53 @@ void CollisionSystem::narrowPhase()
 
 void CollisionSystem::narrowPhaseQuery(xy::Entity entity)
 {
-    for (auto& c : m_collisions)
+    auto index = entity.getIndex();
+    if (index >= m_actorSlots.size()
+        || m_actorSlots[index] >= m_actors.size()
+        || m_actors.entities[m_actorSlots[index]] != entity)
     {
-        xy::Entity first;
-        xy::Entity second;
-        if (entity == c.first)
+        return; //collision is disabled
+    }
+
+    const auto a = m_actorSlots[index];
+    const auto* cells = &m_actorCells[a * 4];
+
+    //gather everything sharing a cell with the entity
+    m_queryResults.clear();
+    for (auto y = cells[1]; y <= cells[3]; ++y)
+    {
+        for (auto x = cells[0]; x <= cells[2]; ++x)
         {
-            first = c.first;
-            second = c.second;
+            const auto cell = y * Global::TileCountX + x;
+            for (auto i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i)
+            {
+                if (m_cellEntries[i] != a)
+                {
+                    m_queryResults.push_back(m_cellEntries[i]);
+                }
+            }
         }
-        else
+    }
+    std::sort(m_queryResults.begin(), m_queryResults.end());
+    m_queryResults.erase(std::unique(m_queryResults.begin(), m_queryResults.end()), m_queryResults.end());
+
+    auto& collisionA = entity.getComponent<CollisionComponent>();
+    for (auto b : m_queryResults)
+    {
+        if ((m_actors.filterFlags[a] & QuadTreeFilter::Collidable) == 0
+            && (m_actors.filterFlags[b] & QuadTreeFilter::Collidable) == 0)
         {
-            first = c.second;
-            second = c.first;
+            continue;
         }
 
-        const auto& txA = first.getComponent<xy::Transform>();
-        const auto& txB = second.getComponent<xy::Transform>();
-
-        auto& collisionA = first.getComponent<CollisionComponent>();
-        const auto& collisionB = second.getComponent<CollisionComponent>();
-
-        auto posA = txA.getWorldPosition();
-        auto posB = txB.getWorldPosition();
+        auto overlapX = std::min(m_actors.right[a], m_actors.right[b]) - std::max(m_actors.left[a], m_actors.left[b]);
+        auto overlapY = std::min(m_actors.bottom[a], m_actors.bottom[b]) - std::max(m_actors.top[a], m_actors.top[b]);
+        if (overlapX <= 0.f || overlapY <= 0.f) continue;
 
-        auto boundsA = collisionA.bounds;
-        boundsA.left += posA.x;
-        boundsA.top += posA.y;
-        auto boundsB = collisionB.bounds;
-        boundsB.left += posB.x;
-        boundsB.top += posB.y;
-
-        auto normal = posB - posA;
-        sf::FloatRect overlap;
-        boundsA.intersects(boundsB, overlap);
-
-        Manifold manifold = calcManifold(normal, overlap);
-        manifold.ID = collisionB.ID;
-        manifold.otherEntity = second;
+        sf::Vector2f normal(m_actors.posX[b] - m_actors.posX[a], m_actors.posY[b] - m_actors.posY[a]);
+        Manifold manifold = calcManifold(normal, { overlapX, overlapY });
+        manifold.ID = m_actors.entities[b].getComponent<CollisionComponent>().ID;
+        manifold.otherEntity = m_actors.entities[b];
 
         if (collisionA.manifoldCount < CollisionComponent::MaxManifolds)
         {
@@ -357,53 +530,46 @@ void CollisionSystem::narrowPhaseQuery(xy::Entity entity)
     }
 }
 
-std::uint32_t CollisionSystem::tileAt(std::size_t x, std::size_t y)
+std::uint32_t CollisionSystem::tileAt(std::size_t x, std::size_t y) const
 {
     if (x >= Global::TileCountX || y >= Global::TileCountY) return TileType::Water;
-    return m_tileArray[y * Global::TileCountX + x] / 2;
+    return m_tileTypes[y * Global::TileCountX + x];
 }
 
-Manifold CollisionSystem::calcManifold(sf::Vector2f normal, sf::FloatRect overlap)
+Manifold CollisionSystem::calcManifold(sf::Vector2f normal, sf::Vector2f overlap)
 {
     Manifold manifold;
-    if (overlap.width < overlap.height)
+    if (overlap.x < overlap.y)
     {
         manifold.normal.x = (normal.x < 0) ? 1.f : -1.f;
-        manifold.penetration = overlap.width;
+        manifold.penetration = overlap.x;
     }
     else
     {
         manifold.normal.y = (normal.y < 0) ? 1.f : -1.f;
-        manifold.penetration = overlap.height;
+        manifold.penetration = overlap.y;
     }
     return manifold;
 }
 
-void CollisionSystem::resolveAll()
+void CollisionSystem::ActorData::clear()
 {
-    //resolves all manifold collisions
-    //but leaves manifold data in tact in case other systems want to read it
-    for (auto c : m_collisions)
-    {
-        auto& txA = c.first.getComponent<xy::Transform>();
-        auto& txB = c.second.getComponent<xy::Transform>();
-
-        const auto& collisionA = c.first.getComponent<CollisionComponent>();
-        const auto& collisionB = c.second.getComponent<CollisionComponent>();
-
-        for (auto i = 0u; i < collisionA.manifoldCount; ++i)
-        {
-            const auto& manifold = collisionA.manifolds[i];
-            txA.move(manifold.normal * manifold.penetration);
-        }
+    entities.clear();
+    posX.clear();
+    posY.clear();
+    left.clear();
+    top.clear();
+    right.clear();
+    bottom.clear();
+    filterFlags.clear();
+}
 
-        for (auto i = 0u; i < collisionB.manifoldCount; ++i)
-        {
-            const auto& manifold = collisionB.manifolds[i];
-            txB.move(manifold.normal * manifold.penetration);
-        }
+void CollisionSystem::onEntityAdded(xy::Entity)
+{
+    m_gridDirty = true;
+}
 
-        //TODO static objects shouldn't move! Also if two dynamic objects they should
-        //move only by penetration / 2.f
-    }
-}
\ No newline at end of file
+void CollisionSystem::onEntityRemoved(xy::Entity)
+{
+    m_gridDirty = true;
+}
@@ -24,7 +24,7 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/System.hpp>
 #include <SFML/Graphics/Rect.hpp>
 
-#include <set>
+#include <vector>
 
 class CollisionSystem final : public xy::System
 {
@@ -36,26 +36,68 @@ public:
     void process(float) override;
 
     void queryState(xy::Entity);
-    void setTileData(const TileArray& ta) { m_tileArray = ta; }
+    void setTileData(const TileArray&);
 
 private:
     bool m_server;
-    TileArray m_tileArray;
+
+    //tile type of each grid cell. The grid is aligned
+    //with the tiles so terrain is read directly from it
+    std::vector<std::uint8_t> m_tileTypes;
+
+    //SoA copy of all actors which can collide, rebuilt each frame
+    struct ActorData final
+    {
+        std::vector<xy::Entity> entities;
+        std::vector<float> posX;
+        std::vector<float> posY;
+        std::vector<float> left;
+        std::vector<float> top;
+        std::vector<float> right;
+        std::vector<float> bottom;
+        std::vector<std::uint32_t> filterFlags;
+
+        void clear();
+        std::size_t size() const { return entities.size(); }
+    }m_actors;
+
+    //maps entity index to a slot in m_actors
+    std::vector<std::uint32_t> m_actorSlots;
+
+    //uniform grid rebuilt every frame with a counting sort.
+    //m_cellStart holds the offset of each cell's entries in m_cellEntries
+    //queries between updates only rebuild it if it's marked dirty
+    std::vector<std::uint32_t> m_cellStart;
+    std::vector<std::uint32_t> m_cellEntries;
+    std::vector<std::uint32_t> m_actorCells; //cell range of each actor, packed x0,y0,x1,y1
+    bool m_gridDirty;
+
+    //potential pairs as sorted, packed entity indices
+    std::vector<std::uint64_t> m_pairKeys;
+
+    //SoA narrow phase input / output
+    std::vector<std::uint32_t> m_pairA;
+    std::vector<std::uint32_t> m_pairB;
+    std::vector<float> m_overlapX;
+    std::vector<float> m_overlapY;
+    std::vector<std::uint8_t> m_pairHit;
+
+    std::vector<std::uint32_t> m_queryResults;
 
     void terrainCollision(xy::Entity);
-    void actorCollision(xy::Entity);
     void boatCollision(xy::Entity);
+
+    void buildGrid();
+    void updateActor(xy::Entity);
+    void broadPhase();
     void narrowPhase();
     void narrowPhaseQuery(xy::Entity);
 
-    std::set<std::pair<xy::Entity, xy::Entity>> m_collisions;
-    //used to hold any temporary collisions when querying state
-    std::set<std::pair<xy::Entity, xy::Entity>> m_tempCollisions;
-
-    std::uint32_t tileAt(std::size_t, std::size_t);
-    Manifold calcManifold(sf::Vector2f, sf::FloatRect);
+    std::uint32_t tileAt(std::size_t, std::size_t) const;
+    Manifold calcManifold(sf::Vector2f, sf::Vector2f);
 
-    void resolveAll();
+    void onEntityAdded(xy::Entity) override;
+    void onEntityRemoved(xy::Entity) override;
 };
 
     
@@ -28,7 +28,9 @@ namespace Server
         {
             Weather,
             Spawn,
-            BotEnable //0 false, 1 true
+            BotEnable, //0 false, 1 true
+            Profile, //0 logs a summary, > 0 dumps to CSV every n seconds, < 0 stops dumping
+            BotPerception //sweeps per second, as float
         };
 
         struct Data final
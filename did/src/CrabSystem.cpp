@@ -19,6 +19,7 @@ Copyright 2019 Matt Marchant
 #include "CrabSystem.hpp"
 #include "Actor.hpp"
 #include "AnimationSystem.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 
@@ -44,6 +45,8 @@ void CrabSystem::handleMessage(const xy::Message&)
 
 void CrabSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::CrabSystem);
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
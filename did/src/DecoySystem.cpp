@@ -18,6 +18,7 @@ Copyright 2019 Matt Marchant
 
 #include "DecoySystem.hpp"
 #include "AnimationSystem.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 
@@ -41,6 +42,8 @@ DecoySystem::DecoySystem(xy::MessageBus& mb)
 
 void DecoySystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::DecoySystem);
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
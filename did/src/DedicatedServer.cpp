@@ -0,0 +1,400 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+/*
+Headless dedicated server. Hosts one or more independent matches
+in a single process, each listening on its own port and running
+on its own thread. A watchdog on the main thread reports any match
+whose logic tick exceeds the given budget, or which stops ticking.
+Optionally each match writes its system timings and traffic to a
+CSV file every given number of seconds. Generated islands are cached
+in the island_cache directory.
+
+-v generates islands for the given number of seeds, single threaded,
+threaded and via the cache, checks that the output is identical and
+prints the time taken by each, then exits.
+
+-r 1 records every match to the match_recordings directory. -x replays
+the given recording as fast as possible, checks the simulation against
+the checksums stored in the recording, prints the timings, then exits.
+
+Usage: did_server [-m <match count>] [-p <first port>] [-b <tick budget ms>] [-d <dump interval sec>] [-v <seed count>] [-r 1] [-x <recording>]
+*/
+
+#include "Server.hpp"
+#include "GlobalConsts.hpp"
+#include "IslandGenerator.hpp"
+
+#include <xyginext/core/Log.hpp>
+#include <xyginext/core/FileSystem.hpp>
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::atomic<bool> running(true);
+
+    void onSignal(int)
+    {
+        running = false;
+    }
+
+    struct Options final
+    {
+        std::size_t matchCount = 1;
+        std::uint16_t basePort = Global::GamePort;
+        std::int64_t tickBudget = 16000; //microseconds. A logic step is 1/60th sec
+        float dumpInterval = 0.f;
+        std::size_t verifyCount = 0;
+        bool record = false;
+        std::string replayPath;
+    };
+
+    const sf::Time WatchdogInterval = sf::seconds(1.f);
+    const sf::Time StallTimeout = sf::seconds(5.f);
+    const std::size_t MaxMatches = 64;
+    const std::string MapCacheDirectory("island_cache/");
+    const std::string RecordDirectory("match_recordings/");
+
+    struct Match final
+    {
+        std::unique_ptr<GameServer> server;
+        std::uint64_t lastTickCount = 0;
+        sf::Clock stallClock;
+        bool stalled = false;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: did_server [-m <match count>] [-p <first port>] [-b <tick budget ms>] [-d <dump interval sec>] [-v <seed count>] [-r 1] [-x <recording>]\n";
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+
+            if (arg == "-x")
+            {
+                options.replayPath = argv[++i];
+                continue;
+            }
+
+            auto value = std::atoi(argv[++i]);
+            if (arg == "-m")
+            {
+                if (value < 1 || value > static_cast<int>(MaxMatches))
+                {
+                    return false;
+                }
+                options.matchCount = value;
+            }
+            else if (arg == "-p")
+            {
+                if (value < 1 || value > 0xffff)
+                {
+                    return false;
+                }
+                options.basePort = static_cast<std::uint16_t>(value);
+            }
+            else if (arg == "-b")
+            {
+                if (value < 1)
+                {
+                    return false;
+                }
+                options.tickBudget = value * 1000;
+            }
+            else if (arg == "-d")
+            {
+                if (value < 1)
+                {
+                    return false;
+                }
+                options.dumpInterval = static_cast<float>(value);
+            }
+            else if (arg == "-v")
+            {
+                if (value < 1)
+                {
+                    return false;
+                }
+                options.verifyCount = value;
+            }
+            else if (arg == "-r")
+            {
+                options.record = (value != 0);
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //generates each seed with every combination of threading and caching,
+    //and makes sure the output is identical. Returns false on mismatch
+    bool verifyIslands(std::size_t seedCount)
+    {
+        const std::string cacheDir("island_cache_verify/");
+
+        std::int64_t totalTimes[4] = {};
+        bool success = true;
+
+        for (auto i = 0u; i < seedCount; ++i)
+        {
+            //same hash the game uses for seed strings
+            const auto seed = static_cast<int>(std::hash<std::string>()("verify" + std::to_string(i)));
+
+            IslandGenerator singleThread;
+            singleThread.generate(seed);
+            const auto reference = singleThread.serialise();
+
+            IslandGenerator threaded;
+            threaded.setThreaded(true);
+            threaded.generate(seed);
+
+            //first pass writes the cache, second reads it
+            IslandGenerator cacheWrite;
+            cacheWrite.setThreaded(true);
+            cacheWrite.setCacheDirectory(cacheDir);
+            std::remove(cacheWrite.getCachePath(seed).c_str());
+            cacheWrite.generate(seed);
+
+            IslandGenerator cacheRead;
+            cacheRead.setCacheDirectory(cacheDir);
+            cacheRead.generate(seed);
+
+            const std::string name = "Seed " + std::to_string(seed);
+            if (threaded.serialise() != reference)
+            {
+                xy::Logger::log(name + ": threaded output differs", xy::Logger::Type::Error);
+                success = false;
+            }
+
+            if (cacheWrite.serialise() != reference
+                || cacheWrite.loadedFromCache())
+            {
+                xy::Logger::log(name + ": generated output differs", xy::Logger::Type::Error);
+                success = false;
+            }
+
+            if (cacheRead.serialise() != reference
+                || !cacheRead.loadedFromCache())
+            {
+                xy::Logger::log(name + ": cached output differs or was not loaded", xy::Logger::Type::Error);
+                success = false;
+            }
+
+            totalTimes[0] += singleThread.getGenerationTime();
+            totalTimes[1] += threaded.getGenerationTime();
+            totalTimes[2] += cacheWrite.getGenerationTime();
+            totalTimes[3] += cacheRead.getGenerationTime();
+        }
+
+        const auto average = [seedCount](std::int64_t total)
+        {
+            return std::to_string(total / static_cast<std::int64_t>(seedCount)) + "us\n";
+        };
+
+        std::cout << "Islands generated: " << seedCount << "\n";
+        std::cout << "Single thread: " << average(totalTimes[0]);
+        std::cout << "Threaded: " << average(totalTimes[1]);
+        std::cout << "Threaded + cache write: " << average(totalTimes[2]);
+        std::cout << "Cache read: " << average(totalTimes[3]);
+        std::cout << (success ? "All outputs match\n" : "Outputs DO NOT match\n");
+
+        return success;
+    }
+
+    //re-simulates a recorded match and checks it against the
+    //recorded checksums. Returns false if the match diverged
+    bool replayMatch(const Options& options)
+    {
+        GameServer server;
+        server.setMapCacheDirectory(MapCacheDirectory);
+        if (options.dumpInterval > 0)
+        {
+            server.getProfiler().setDumpFile("did_replay.csv", options.dumpInterval);
+        }
+
+        const auto result = server.replay(options.replayPath);
+        if (!result.loaded)
+        {
+            xy::Logger::log("Failed to load " + options.replayPath, xy::Logger::Type::Error);
+            return false;
+        }
+
+        const auto seconds = static_cast<float>(result.duration) / 1000000.f;
+        std::cout << "Ticks replayed: " << result.ticks << " of " << result.recordedTicks << "\n";
+        std::cout << "Duration: " << seconds << "s (" << (result.ticks / 60.f) << "s of game time)\n";
+        if (seconds > 0)
+        {
+            std::cout << "Ticks per second: " << static_cast<std::int64_t>(result.ticks / seconds) << "\n";
+        }
+        std::cout << "Peak tick: " << result.peakTickTime << "us\n";
+        std::cout << server.getProfiler().getSummary() << "\n";
+        std::cout << "Checksums: " << result.checksumCount << ", mismatches: " << result.mismatchCount;
+        if (result.mismatchCount)
+        {
+            std::cout << ", first at tick " << result.firstMismatch;
+        }
+        std::cout << "\n";
+
+        return result.mismatchCount == 0
+            && result.ticks == result.recordedTicks;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.verifyCount)
+    {
+        return verifyIslands(options.verifyCount) ? 0 : 1;
+    }
+
+    if (!options.replayPath.empty())
+    {
+        return replayMatch(options) ? 0 : 1;
+    }
+
+    if (options.basePort + options.matchCount > 0xffff)
+    {
+        xy::Logger::log("Port range exceeds 65535", xy::Logger::Type::Error);
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::size_t failedCount = 0;
+    std::vector<Match> matches(options.matchCount);
+    for (auto i = 0u; i < matches.size(); ++i)
+    {
+        auto& match = matches[i];
+        match.server = std::make_unique<GameServer>();
+        match.server->setMaxPlayers(4);
+        match.server->setPort(static_cast<std::uint16_t>(options.basePort + i));
+        match.server->setDedicated(true);
+        match.server->setMapCacheDirectory(MapCacheDirectory);
+        if (options.record)
+        {
+            match.server->setRecordDirectory(RecordDirectory);
+        }
+        if (options.dumpInterval > 0)
+        {
+            match.server->getProfiler().setDumpFile("did_server_" + std::to_string(options.basePort + i) + ".csv", options.dumpInterval);
+        }
+        match.server->start();
+
+        if (!match.server->running())
+        {
+            xy::Logger::log("Failed to start match on port " + std::to_string(options.basePort + i), xy::Logger::Type::Error);
+            failedCount++;
+        }
+    }
+
+    //a server with only some of its matches running is
+    //easily missed, so fail outright and let the caller retry
+    if (failedCount > 0)
+    {
+        xy::Logger::log(std::to_string(failedCount) + " of " + std::to_string(matches.size()) + " matches failed to start", xy::Logger::Type::Error);
+        for (auto& match : matches)
+        {
+            match.server->stop();
+        }
+        return 1;
+    }
+
+    //watchdog
+    sf::Clock watchdogClock;
+    while (running)
+    {
+        sf::sleep(sf::milliseconds(100));
+
+        if (watchdogClock.getElapsedTime() < WatchdogInterval)
+        {
+            continue;
+        }
+        watchdogClock.restart();
+
+        for (auto& match : matches)
+        {
+            if (!match.server->running())
+            {
+                continue;
+            }
+
+            const auto port = std::to_string(match.server->getPort());
+            auto peak = match.server->resetPeakTickTime();
+            if (peak > options.tickBudget)
+            {
+                xy::Logger::log("Match on port " + port + " exceeded tick budget: " + std::to_string(peak) + "us", xy::Logger::Type::Warning);
+            }
+
+            auto tickCount = match.server->getTickCount();
+            if (tickCount != match.lastTickCount)
+            {
+                match.lastTickCount = tickCount;
+                match.stallClock.restart();
+
+                if (match.stalled)
+                {
+                    match.stalled = false;
+                    xy::Logger::log("Match on port " + port + " recovered", xy::Logger::Type::Info);
+                }
+            }
+            else if (!match.stalled
+                && match.stallClock.getElapsedTime() > StallTimeout)
+            {
+                match.stalled = true;
+                xy::Logger::log("Match on port " + port + " has not ticked in " + std::to_string(StallTimeout.asSeconds()) + " seconds", xy::Logger::Type::Error);
+            }
+        }
+    }
+
+    for (auto& match : matches)
+    {
+        match.server->stop();
+    }
+
+    return 0;
+}
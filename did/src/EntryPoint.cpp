@@ -43,6 +43,7 @@ source distribution.
 #include <xyginext/core/StateStack.hpp>
 #include <xyginext/core/Log.hpp>
 #include <xyginext/core/App.hpp>
+#include <xyginext/core/FileSystem.hpp>
 
 #ifdef DD_DEBUG
 #include <csignal>
@@ -80,6 +81,10 @@ int begin(xy::StateStack* ss, SharedStateData* sharedData)
     sd.netClient = std::make_shared<xy::NetClient>();
     sd.netClient->create(Global::NetworkChannels);
 
+    sd.assetLoader = std::make_shared<AssetLoader>();
+    sd.gameResources = std::make_shared<xy::ResourceHandler>();
+    sd.assetLoader->install(*sd.gameResources, AssetLoader::Game);
+
     gameServer = sd.gameServer;
     netClient = sd.netClient;
 
@@ -92,6 +97,7 @@ int begin(xy::StateStack* ss, SharedStateData* sharedData)
     ss->registerState<PauseState>(StateID::Pause, sd);
 
     gameServer->setMaxPlayers(4);
+    gameServer->setMapCacheDirectory(xy::FileSystem::getConfigDirectory(xy::App::getActiveInstance()->getApplicationName()) + "islands/");
 
     xy::App::getActiveInstance()->setWindowTitle("Desert Island Duel");
 
@@ -0,0 +1,119 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+#include "ExplosionBench.hpp"
+#include "ExplosionSystem.hpp"
+
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Drawable.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+    const float FrameTime = 1.f / 60.f;
+    const float ExplosionLifetime = 2.f; //a little longer than the particles
+}
+
+ExplosionBenchResult runExplosionBench(std::size_t count, float duration)
+{
+    xy::MessageBus messageBus;
+    xy::Scene scene(messageBus);
+    auto& explosionSystem = scene.addSystem<ExplosionSystem>(messageBus);
+
+    struct Active final
+    {
+        xy::Entity entity;
+        float age = 0.f;
+    };
+    std::vector<Active> explosions;
+    explosions.reserve(count);
+
+    auto spawn = [&](float age)
+    {
+        auto entity = scene.createEntity();
+        entity.addComponent<xy::Transform>();
+        entity.addComponent<xy::Drawable>().setPrimitiveType(sf::Quads);
+        entity.addComponent<Explosion>().type = (explosions.size() % 4 == 0) ? Explosion::Dirt : Explosion::Fire;
+        explosions.push_back({ entity, age });
+    };
+
+    //stagger the start times so explosions burn out on different frames
+    for (auto i = 0u; i < count; ++i)
+    {
+        spawn(ExplosionLifetime * static_cast<float>(i) / count);
+    }
+
+    ExplosionBenchResult result;
+    std::size_t frameCount = 0;
+    std::size_t spawnCount = 0;
+    std::size_t initialGrowth = 0;
+    std::int64_t totalTime = 0;
+
+    const auto totalFrames = static_cast<std::size_t>(duration / FrameTime);
+    for (auto frame = 0u; frame < totalFrames; ++frame)
+    {
+        for (auto i = 0u; i < explosions.size();)
+        {
+            explosions[i].age += FrameTime;
+            if (explosions[i].age > ExplosionLifetime)
+            {
+                scene.destroyEntity(explosions[i].entity);
+                explosions[i] = explosions.back();
+                explosions.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        while (explosions.size() < count)
+        {
+            spawn(0.f);
+            spawnCount++;
+        }
+
+        scene.update(FrameTime);
+
+        //the first frame adds the initial explosions
+        if (frame == 0)
+        {
+            initialGrowth = explosionSystem.getGrowthCount();
+            spawnCount = 0;
+            continue;
+        }
+
+        const auto processTime = explosionSystem.getProcessTime();
+        totalTime += processTime;
+        result.updatePeak = std::max(result.updatePeak, static_cast<float>(processTime));
+        frameCount++;
+    }
+
+    if (frameCount)
+    {
+        result.updateTime = static_cast<float>(totalTime) / frameCount;
+        result.spawnRate = static_cast<float>(spawnCount) / frameCount;
+    }
+    result.blockCount = explosionSystem.getBlockCount();
+    result.growthCount = explosionSystem.getGrowthCount() - initialGrowth;
+
+    return result;
+}
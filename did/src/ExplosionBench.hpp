@@ -0,0 +1,38 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+#pragma once
+
+#include <cstddef>
+
+/*
+Keeps the given number of explosions alive at once in a scene with only
+an ExplosionSystem, for the given duration at 60 frames per second.
+Explosions are replaced as they burn out, so that particle blocks are
+recycled, and the cost of each update is recorded. Doesn't require a GL
+context.
+*/
+struct ExplosionBenchResult final
+{
+    float updateTime = 0.f; //average us per frame
+    float updatePeak = 0.f;
+    float spawnRate = 0.f; //explosions created per frame, each allocates its vertex array once
+    std::size_t blockCount = 0; //particle blocks allocated by the end
+    std::size_t growthCount = 0; //times the particle data grew after the first frame
+};
+
+ExplosionBenchResult runExplosionBench(std::size_t count = 100, float duration = 10.f);
@@ -21,14 +21,27 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/components/Drawable.hpp>
 #include <xyginext/util/Random.hpp>
 #include <xyginext/util/Vector.hpp>
+#include <xyginext/util/Const.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
 
 namespace
 {
+    const float TotalLife = 1.8f;
     const float RotationSpeed = 400.f;
     const float Friction = 0.6f;
     const sf::Vector2f Gravity(0.f, -520.f);
-    const std::array<float, 3> DefaultFireColour = { 255.f, 120.f, 10.f };
-    const std::array<float, 3> DefaultSmokeColour = { 255.f, 255.f, 255.f };
+    const sf::Vector2f Wind(5.f, 10.f);
+
+    //applied once per update, as fire shrinks and smoke grows
+    const float FireGrowth = 0.99f;
+    const float SmokeGrowth = 1.01f;
+    const float SmokeDrag = 0.99f;
+
+    //enough for a busy round without the particle data growing
+    const std::size_t InitialBlockCount = 32;
 
     const float FireOffset = 4.f;
     const float SmokeOffset = 18.f;
@@ -57,158 +70,230 @@ namespace
 }
 
 ExplosionSystem::ExplosionSystem(xy::MessageBus& mb)
-    : xy::System(mb, typeid(ExplosionSystem))
+    : xy::System    (mb, typeid(ExplosionSystem)),
+    m_processTime   (0)
 {
     requireComponent<xy::Drawable>();
     requireComponent<Explosion>();
+
+    const auto capacity = InitialBlockCount * BlockSize;
+    m_particles.positionX.reserve(capacity);
+    m_particles.positionY.reserve(capacity);
+    m_particles.velocityX.reserve(capacity);
+    m_particles.velocityY.reserve(capacity);
+    m_particles.rotation.reserve(capacity);
+    m_particles.spin.reserve(capacity);
+    m_particles.scale.reserve(capacity);
+    m_particles.lifeTime.reserve(capacity);
+    m_particles.colour.reserve(capacity);
+    m_particles.accelerationX.reserve(capacity);
+    m_particles.accelerationY.reserve(capacity);
+    m_particles.drag.reserve(capacity);
+    m_particles.growth.reserve(capacity);
+    m_particles.bounce.reserve(capacity);
+    m_particles.freeBlocks.reserve(InitialBlockCount);
 }
 
 //public
 void ExplosionSystem::process(float dt)
 {
+    m_timer.restart();
+
+    m_particles.update(dt);
+
+    //the particles are in the local space of each explosion, so
+    //that the quads are drawn with the explosion's 3D model matrix
     auto& entities = getEntities();
     for (auto entity : entities)
     {
-        auto& explosion = entity.getComponent<Explosion>();
-        auto& verts = entity.getComponent<xy::Drawable>().getVertices();
+        const auto& explosion = entity.getComponent<Explosion>();
+        auto& drawable = entity.getComponent<xy::Drawable>();
+        auto* vertex = drawable.getVertices().data();
 
-        auto i = 0u;
-        for (auto& particle : explosion.fire)
+        const auto first = explosion.particleBlock * BlockSize;
+        for (auto i = first; i < first + BlockSize; ++i)
         {
-            particle.move(particle.velocity * dt);
-            particle.velocity += Gravity * dt;
-
-            particle.lifeTime = std::max(0.f, particle.lifeTime - dt);
-
-            float ratio = particle.lifeTime / Particle::TotalLife;
-            /*particle.colour.r = static_cast<sf::Uint8>(DefaultFireColour[0] * ratio);
-            particle.colour.g = static_cast<sf::Uint8>(DefaultFireColour[1] * ratio);
-            particle.colour.b = static_cast<sf::Uint8>(DefaultFireColour[2] * ratio);*/
-            particle.colour.a = static_cast<sf::Uint8>(255.f * ratio);
- 
-            auto tx = particle.getTransform();
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[0]), particle.colour, QuadUVs[0]);
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[1]), particle.colour, QuadUVs[1]);
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[2]), particle.colour, QuadUVs[2]);
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[3]), particle.colour, QuadUVs[3]);
-
-            //bounce
-            auto position = particle.getPosition();
-            if (position.y < 0)
-            {
-                particle.velocity.y = -particle.velocity.y;
-                particle.velocity *= Friction;
-                particle.setPosition(position.x, 0.f);
+            const float angle = m_particles.rotation[i] * xy::Util::Const::degToRad;
+            const float cosine = std::cos(angle) * m_particles.scale[i];
+            const float sine = std::sin(angle) * m_particles.scale[i];
+            const sf::Vector2f position(m_particles.positionX[i], m_particles.positionY[i]);
 
-                particle.rotation *= Friction;
-            }
-
-            //shrink
-            particle.scale(0.99f, 0.99f);
-            particle.rotate(particle.rotation * dt);
+            auto colour = m_particles.colour[i];
+            colour.a = static_cast<sf::Uint8>(255.f * (m_particles.lifeTime[i] / TotalLife));
 
-            //temp to reset particles
-            /*if (particle.lifeTime == 0)
+            //smoke uses the second half of the texture
+            const auto uvOffset = (i - first < FireCount) ? 0u : 4u;
+            for (auto j = 0u; j < QuadPoints.size(); ++j)
             {
-                particle.lifeTime = Particle::TotalLife;
-                particle.setPosition(0.f, FireOffset);
-                particle.velocity = particle.defaultVelocity;
-                particle.setScale(1.f, 1.f);
-                particle.rotation = -particle.velocity.x * RotationSpeed;
-            }*/
-        }
-
-        //loop through smoke particles and update
-        for (auto& particle : explosion.smoke)
-        {
-            particle.move(particle.velocity * dt);
-            particle.velocity *= 0.99f;
-            particle.velocity += sf::Vector2f(5.f, 10.f) * dt;
-
-            particle.lifeTime = std::max(0.f, particle.lifeTime - dt);
-
-            float ratio = particle.lifeTime / Particle::TotalLife;
-            /*particle.colour.r = static_cast<sf::Uint8>(DefaultSmokeColour[0] * ratio);
-            particle.colour.g = static_cast<sf::Uint8>(DefaultSmokeColour[1] * ratio);
-            particle.colour.b = static_cast<sf::Uint8>(DefaultSmokeColour[2] * ratio);*/
-            particle.colour.a = static_cast<sf::Uint8>(255.f * ratio);
-
-            auto tx = particle.getTransform();
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[0]), particle.colour, QuadUVs[4]);
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[1]), particle.colour, QuadUVs[5]);
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[2]), particle.colour, QuadUVs[6]);
-            verts[i++] = sf::Vertex(tx.transformPoint(QuadPoints[3]), particle.colour, QuadUVs[7]);
-
-            //grow
-            particle.scale(1.01f, 1.01f);
-            particle.rotate(particle.rotation * dt);
-
-            //temp to reset particles
-            /*if (particle.lifeTime == 0)
-            {
-                particle.lifeTime = Particle::TotalLife;
-                particle.setPosition(0.f, SmokeOffset);
-                particle.velocity = particle.defaultVelocity;
-                particle.setScale(1.f, 1.f);
-                particle.rotation = -particle.velocity.x;
-            }*/
+                const auto& point = QuadPoints[j];
+                vertex->position = { position.x + (cosine * point.x) - (sine * point.y), position.y + (sine * point.x) + (cosine * point.y) };
+                vertex->color = colour;
+                vertex->texCoords = QuadUVs[j + uvOffset];
+                vertex++;
+            }
         }
 
-        entity.getComponent<xy::Drawable>().updateLocalBounds();
+        drawable.updateLocalBounds();
     }
+
+    m_processTime = m_timer.getElapsedTime().asMicroseconds();
 }
 
+//private
 void ExplosionSystem::onEntityAdded(xy::Entity entity)
 {
     auto& explosion = entity.getComponent<Explosion>();
+    explosion.particleBlock = m_particles.allocate(explosion.type);
+
+    entity.getComponent<xy::Drawable>().getVertices().resize(BlockSize * QuadPoints.size());
+}
 
-    if (explosion.type == Explosion::Fire)
+void ExplosionSystem::onEntityRemoved(xy::Entity entity)
+{
+    //leave the block idle until it's reused
+    const auto block = entity.getComponent<Explosion>().particleBlock;
+    const auto first = block * BlockSize;
+    for (auto i = first; i < first + BlockSize; ++i)
     {
-        for (auto& particle : explosion.fire)
-        {
-            particle.velocity.x = static_cast<float>(xy::Util::Random::value(-20, 20));
-            particle.velocity.y = 100.f;
-            particle.velocity = xy::Util::Vector::normalise(particle.velocity) * static_cast<float>(xy::Util::Random::value(160, 220));
-            particle.rotation = -particle.velocity.x * RotationSpeed;
-            //particle.defaultVelocity = particle.velocity; //temp, remove this
+        m_particles.velocityX[i] = 0.f;
+        m_particles.velocityY[i] = 0.f;
+        m_particles.accelerationX[i] = 0.f;
+        m_particles.accelerationY[i] = 0.f;
+        m_particles.spin[i] = 0.f;
+        m_particles.lifeTime[i] = 0.f;
+    }
+    m_particles.freeBlocks.push_back(block);
+}
 
-            particle.setPosition(0.f, FireOffset); //start at centre of sprite
-        }
+std::size_t ExplosionSystem::ParticleData::allocate(Explosion::Type type)
+{
+    std::size_t block = 0;
+    if (!freeBlocks.empty())
+    {
+        block = freeBlocks.back();
+        freeBlocks.pop_back();
+    }
+    else
+    {
+        block = blockCount++;
 
-        //init smoke particles
-        for (auto& particle : explosion.smoke)
+        const auto size = blockCount * BlockSize;
+        if (size > positionX.capacity())
         {
-            particle.velocity.x = static_cast<float>(xy::Util::Random::value(20, 40));
-            particle.velocity.y = 100.f;
-            particle.velocity = xy::Util::Vector::normalise(particle.velocity) * static_cast<float>(xy::Util::Random::value(30, 40));
-            particle.rotation = -particle.velocity.x;
-
-            particle.setPosition(0.f, SmokeOffset); //start at top of sprite
-            //particle.defaultVelocity = particle.velocity; //temp, remove this
+            growthCount++;
         }
+
+        positionX.resize(size);
+        positionY.resize(size);
+        velocityX.resize(size);
+        velocityY.resize(size);
+        rotation.resize(size);
+        spin.resize(size);
+        scale.resize(size);
+        lifeTime.resize(size);
+        colour.resize(size);
+        accelerationX.resize(size);
+        accelerationY.resize(size);
+        drag.resize(size);
+        growth.resize(size);
+        bounce.resize(size);
     }
-    else
+
+    const auto first = block * BlockSize;
+    for (auto i = first; i < first + BlockSize; ++i)
     {
-        for (auto& particle : explosion.fire)
-        {
-            particle.velocity.x = static_cast<float>(xy::Util::Random::value(-20, 20));
-            particle.velocity.y = 100.f;
-            particle.velocity = xy::Util::Vector::normalise(particle.velocity) * static_cast<float>(xy::Util::Random::value(60, 120));
-            particle.rotation = -particle.velocity.x * RotationSpeed;
+        const bool fire = (i - first) < FireCount;
 
-            auto colour = static_cast<sf::Uint8>(xy::Util::Random::value(120, 255));
-            particle.colour = { colour, colour, colour };
+        sf::Vector2f velocity;
+        if (fire)
+        {
+            velocity.x = static_cast<float>(xy::Util::Random::value(-20, 20));
+            velocity.y = 100.f;
+            velocity = xy::Util::Vector::normalise(velocity) * static_cast<float>(type == Explosion::Fire ? xy::Util::Random::value(160, 220) : xy::Util::Random::value(60, 120));
+        }
+        else
+        {
+            velocity.x = static_cast<float>(xy::Util::Random::value(20, 40));
+            velocity.y = 100.f;
+            velocity = xy::Util::Vector::normalise(velocity) * static_cast<float>(xy::Util::Random::value(30, 40));
         }
 
-        //init smoke particles
-        for (auto& particle : explosion.smoke)
+        velocityX[i] = velocity.x;
+        velocityY[i] = velocity.y;
+        spin[i] = fire ? -velocity.x * RotationSpeed : -velocity.x;
+
+        //fire starts at the centre of the sprite and smoke at the top
+        positionX[i] = 0.f;
+        positionY[i] = (type == Explosion::Fire) ? (fire ? FireOffset : SmokeOffset) : 0.f;
+
+        rotation[i] = 0.f;
+        scale[i] = 1.f;
+        lifeTime[i] = TotalLife;
+        colour[i] = sf::Color::White;
+
+        if (fire && type == Explosion::Dirt)
         {
-            particle.velocity.x = static_cast<float>(xy::Util::Random::value(20, 40));
-            particle.velocity.y = 100.f;
-            particle.velocity = xy::Util::Vector::normalise(particle.velocity) * static_cast<float>(xy::Util::Random::value(30, 40));
-            particle.rotation = -particle.velocity.x;
+            auto shade = static_cast<sf::Uint8>(xy::Util::Random::value(120, 255));
+            colour[i] = { shade, shade, shade };
         }
+
+        accelerationX[i] = fire ? Gravity.x : Wind.x;
+        accelerationY[i] = fire ? Gravity.y : Wind.y;
+        drag[i] = fire ? 1.f : SmokeDrag;
+        growth[i] = fire ? FireGrowth : SmokeGrowth;
+        bounce[i] = fire ? 1.f : 0.f;
     }
 
-    entity.getComponent<xy::Drawable>().getVertices().resize((explosion.fire.size() + explosion.smoke.size()) * 4u);
-}
\ No newline at end of file
+    return block;
+}
+
+void ExplosionSystem::ParticleData::update(float dt)
+{
+    //each loop runs over every particle and only touches a few
+    //arrays, so that they vectorise without too many alias checks
+    const auto count = blockCount * BlockSize;
+
+    float* posX = positionX.data();
+    float* posY = positionY.data();
+    float* velX = velocityX.data();
+    float* velY = velocityY.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        posX[i] += velX[i] * dt;
+        posY[i] += velY[i] * dt;
+    }
+
+    const float* accelX = accelerationX.data();
+    const float* accelY = accelerationY.data();
+    const float* dragValue = drag.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        velX[i] = (velX[i] * dragValue[i]) + (accelX[i] * dt);
+        velY[i] = (velY[i] * dragValue[i]) + (accelY[i] * dt);
+    }
+
+    //fire bounces off the ground, losing some speed
+    const float* bounceValue = bounce.data();
+    float* spinValue = spin.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const float hit = (posY[i] < 0.f) ? bounceValue[i] : 0.f;
+        const float friction = 1.f - (hit * (1.f - Friction));
+
+        velX[i] *= friction;
+        velY[i] *= (1.f - (2.f * hit)) * friction;
+        spinValue[i] *= friction;
+        posY[i] *= (1.f - hit);
+    }
+
+    float* life = lifeTime.data();
+    float* scaleValue = scale.data();
+    float* rotationValue = rotation.data();
+    const float* growthValue = growth.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        life[i] = std::max(0.f, life[i] - dt);
+        scaleValue[i] *= growthValue[i];
+        rotationValue[i] += spinValue[i] * dt;
+    }
+}
@@ -21,40 +21,79 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/System.hpp>
 
 #include <SFML/Graphics/Color.hpp>
-#include <SFML/Graphics/Transformable.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Clock.hpp>
 
-#include <array>
-
-struct Particle final : public sf::Transformable
-{
-    static constexpr float TotalLife = 1.8f;
-    sf::Color colour = sf::Color::White;
-    float lifeTime = TotalLife;
-    float rotation = 0.f;
-    sf::Vector2f velocity;
-    //sf::Vector2f defaultVelocity; //temp remove this
-};
+#include <vector>
 
+//particle data is stored in the ExplosionSystem so that the
+//particles of every explosion are updated together in one pass
 struct Explosion final
 {
-    std::array<Particle, 12u> fire;
-    std::array<Particle, 6u> smoke;
-
-    enum
+    enum Type
     {
         Dirt,
         Fire
     }type = Fire;
+
+    //index of this explosion's block in the system's particle data
+    std::size_t particleBlock = 0;
 };
 
-class ExplosionSystem : public xy::System
+class ExplosionSystem final : public xy::System
 {
 public:
     explicit ExplosionSystem(xy::MessageBus&);
 
     void process(float) override;
 
+    //time taken by the last update, in microseconds
+    std::int64_t getProcessTime() const { return m_processTime; }
+
+    //number of particle blocks in use, and allocated
+    std::size_t getActiveCount() const { return getEntities().size(); }
+    std::size_t getBlockCount() const { return m_particles.blockCount; }
+
+    //number of times the particle data has had to grow
+    std::size_t getGrowthCount() const { return m_particles.growthCount; }
+
+    static constexpr std::size_t FireCount = 12;
+    static constexpr std::size_t SmokeCount = 6;
+    static constexpr std::size_t BlockSize = FireCount + SmokeCount;
+
 private:
     void onEntityAdded(xy::Entity) override;
+    void onEntityRemoved(xy::Entity) override;
 
+    struct ParticleData final
+    {
+        std::vector<float> positionX;
+        std::vector<float> positionY;
+        std::vector<float> velocityX;
+        std::vector<float> velocityY;
+        std::vector<float> rotation;
+        std::vector<float> spin;
+        std::vector<float> scale;
+        std::vector<float> lifeTime;
+        std::vector<sf::Color> colour;
+
+        //fire and smoke are told apart by these rather
+        //than a branch, so that the update vectorises
+        std::vector<float> accelerationX;
+        std::vector<float> accelerationY;
+        std::vector<float> drag;
+        std::vector<float> growth;
+        std::vector<float> bounce;
+
+        //blocks are recycled when an explosion is removed
+        std::vector<std::size_t> freeBlocks;
+        std::size_t blockCount = 0;
+        std::size_t growthCount = 0;
+
+        std::size_t allocate(Explosion::Type);
+        void update(float dt);
+    }m_particles;
+
+    sf::Clock m_timer;
+    std::int64_t m_processTime;
 };
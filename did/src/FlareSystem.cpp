@@ -21,6 +21,7 @@ Copyright 2019 Matt Marchant
 #include "ServerRandom.hpp"
 #include "GlobalConsts.hpp"
 #include "Actor.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 #include <xyginext/ecs/components/Transform.hpp>
@@ -33,8 +34,9 @@ namespace
     const float LaunchOffset = 120.f;
 }
 
-FlareSystem::FlareSystem(xy::MessageBus& mb)
-    : xy::System(mb, typeid(FlareSystem))
+FlareSystem::FlareSystem(xy::MessageBus& mb, std::mt19937& rndEngine)
+    : xy::System(mb, typeid(FlareSystem)),
+    m_rndEngine (rndEngine)
 {
     requireComponent<Flare>();
     requireComponent<xy::Transform>();
@@ -43,6 +45,8 @@ FlareSystem::FlareSystem(xy::MessageBus& mb)
 //public
 void FlareSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::FlareSystem);
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
@@ -62,13 +66,13 @@ void FlareSystem::process(float dt)
             flare.fireTime += dt;
             if (flare.fireTime > Flare::NextFireTime)
             {
-                flare.fireTime = Server::getRandomFloat(-0.3f, 0.f);
+                flare.fireTime = Server::getRandomFloat(m_rndEngine, -0.3f, 0.f);
 
                 auto flarePos = entity.getComponent<xy::Transform>().getPosition();
 
                 auto gridPos = sf::Vector2i(flarePos / Global::TileSize);
-                gridPos.x += Server::getRandomInt(-5, 5);
-                gridPos.y += Server::getRandomInt(-10, 0);
+                gridPos.x += Server::getRandomInt(m_rndEngine, -5, 5);
+                gridPos.y += Server::getRandomInt(m_rndEngine, -10, 0);
 
                 gridPos.x = xy::Util::Math::clamp(gridPos.x, 0, static_cast<int>(Global::TileCountX));
                 gridPos.y = xy::Util::Math::clamp(gridPos.y, 0, static_cast<int>(Global::TileCountY));
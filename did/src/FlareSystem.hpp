@@ -20,6 +20,8 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/ecs/System.hpp>
 
+#include <random>
+
 struct Flare final
 {
     enum
@@ -40,12 +42,12 @@ struct Flare final
 class FlareSystem final : public xy::System
 {
 public:
-    explicit FlareSystem(xy::MessageBus&);
+    FlareSystem(xy::MessageBus&, std::mt19937&);
 
     void process(float) override;
 
     void onEntityAdded(xy::Entity) override;
 
 private:
-
+    std::mt19937& m_rndEngine;
 };
\ No newline at end of file
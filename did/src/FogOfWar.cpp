@@ -0,0 +1,124 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "FogOfWar.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    const float EdgeWidth = 1.5f; //tiles over which a stamp fades out
+    const std::uint8_t Fogged = 255;
+}
+
+FogOfWar::FogOfWar(std::size_t width, std::size_t height, float tileSize)
+    : m_width   (width),
+    m_height    (height),
+    m_tileSize  (tileSize),
+    m_values    (width * height, Fogged)
+{
+    clearDirtyRect();
+}
+
+//public
+std::size_t FogOfWar::addStamp(float radius)
+{
+    const float tileRadius = radius / m_tileSize;
+
+    Stamp stamp;
+    stamp.radius = static_cast<std::int32_t>(std::ceil(tileRadius));
+
+    const auto size = stamp.radius * 2 + 1;
+    stamp.values.resize(size * size);
+    for (auto y = -stamp.radius; y <= stamp.radius; ++y)
+    {
+        for (auto x = -stamp.radius; x <= stamp.radius; ++x)
+        {
+            const float distance = std::sqrt(static_cast<float>(x * x + y * y));
+            const float fog = std::min(1.f, std::max(0.f, (distance - (tileRadius - EdgeWidth)) / EdgeWidth));
+            stamp.values[(y + stamp.radius) * size + (x + stamp.radius)] = static_cast<std::uint8_t>(fog * Fogged);
+        }
+    }
+
+    m_stamps.push_back(std::move(stamp));
+    return m_stamps.size() - 1;
+}
+
+void FogOfWar::reveal(sf::Vector2f position, std::size_t index)
+{
+    const auto& stamp = m_stamps[index];
+    const auto size = stamp.radius * 2 + 1;
+
+    const auto centreX = static_cast<std::int32_t>(std::floor(position.x / m_tileSize));
+    const auto centreY = static_cast<std::int32_t>(std::floor(position.y / m_tileSize));
+
+    //clip the stamp to the map
+    const auto startX = std::max(0, centreX - stamp.radius);
+    const auto startY = std::max(0, centreY - stamp.radius);
+    const auto endX = std::min(static_cast<std::int32_t>(m_width) - 1, centreX + stamp.radius);
+    const auto endY = std::min(static_cast<std::int32_t>(m_height) - 1, centreY + stamp.radius);
+
+    for (auto y = startY; y <= endY; ++y)
+    {
+        const auto* src = &stamp.values[(y - centreY + stamp.radius) * size];
+        auto* dst = &m_values[y * m_width];
+
+        for (auto x = startX; x <= endX; ++x)
+        {
+            const auto value = src[x - centreX + stamp.radius];
+            if (value < dst[x])
+            {
+                dst[x] = value;
+
+                m_dirtyLeft = std::min(m_dirtyLeft, x);
+                m_dirtyTop = std::min(m_dirtyTop, y);
+                m_dirtyRight = std::max(m_dirtyRight, x + 1);
+                m_dirtyBottom = std::max(m_dirtyBottom, y + 1);
+            }
+        }
+    }
+}
+
+void FogOfWar::reset()
+{
+    std::fill(m_values.begin(), m_values.end(), Fogged);
+
+    m_dirtyLeft = 0;
+    m_dirtyTop = 0;
+    m_dirtyRight = static_cast<std::int32_t>(m_width);
+    m_dirtyBottom = static_cast<std::int32_t>(m_height);
+}
+
+sf::IntRect FogOfWar::getDirtyRect() const
+{
+    if (m_dirtyRight <= m_dirtyLeft)
+    {
+        return {};
+    }
+    return { m_dirtyLeft, m_dirtyTop, m_dirtyRight - m_dirtyLeft, m_dirtyBottom - m_dirtyTop };
+}
+
+void FogOfWar::clearDirtyRect()
+{
+    m_dirtyLeft = std::numeric_limits<std::int32_t>::max();
+    m_dirtyTop = std::numeric_limits<std::int32_t>::max();
+    m_dirtyRight = std::numeric_limits<std::int32_t>::min();
+    m_dirtyBottom = std::numeric_limits<std::int32_t>::min();
+}
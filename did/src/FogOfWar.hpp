@@ -0,0 +1,80 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/*
+Fog of war stored on the CPU at one value per map tile, where 255 is
+fully fogged and 0 is fully revealed. Areas are revealed by applying a
+precomputed circular stamp, which has a soft edge, and each tile only
+ever gets clearer. The tiles changed since the dirty rect was last
+cleared are tracked so that only they need to be redrawn. This has no
+dependency on any graphics resources.
+*/
+class FogOfWar final
+{
+public:
+    //width and height in tiles, tileSize in world units
+    FogOfWar(std::size_t width, std::size_t height, float tileSize);
+
+    //creates a stamp for the given view radius in world units,
+    //and returns the index used to apply it with reveal()
+    std::size_t addStamp(float radius);
+
+    //reveals the tiles around the given world position
+    void reveal(sf::Vector2f position, std::size_t stamp);
+
+    //fogs the entire map
+    void reset();
+
+    std::uint8_t getValue(std::size_t x, std::size_t y) const { return m_values[y * m_width + x]; }
+    const std::vector<std::uint8_t>& getValues() const { return m_values; }
+
+    std::size_t getWidth() const { return m_width; }
+    std::size_t getHeight() const { return m_height; }
+    float getTileSize() const { return m_tileSize; }
+
+    //returns the area in tiles changed since clearDirtyRect() was
+    //last called. The rect has no width or height if nothing changed
+    sf::IntRect getDirtyRect() const;
+    void clearDirtyRect();
+
+private:
+    std::size_t m_width;
+    std::size_t m_height;
+    float m_tileSize;
+    std::vector<std::uint8_t> m_values;
+
+    struct Stamp final
+    {
+        std::int32_t radius = 0; //in tiles, so the stamp is radius * 2 + 1 square
+        std::vector<std::uint8_t> values;
+    };
+    std::vector<Stamp> m_stamps;
+
+    std::int32_t m_dirtyLeft;
+    std::int32_t m_dirtyTop;
+    std::int32_t m_dirtyRight;
+    std::int32_t m_dirtyBottom;
+};
@@ -39,13 +39,6 @@ namespace sf
     class RenderTexture;
 }
 
-struct FoliageData final
-{
-    float width = 0.f;
-    sf::Vector2f position;
-    FoliageData(float w = 0.f, sf::Vector2f p = {}) : width(w), position(p) {}
-};
-
 class FoliageGenerator final
 {
 public:
@@ -17,15 +17,20 @@ Copyright 2019 Matt Marchant
 *********************************************************************/
 
 #include "FoliageSystem.hpp"
+#include "GlobalConsts.hpp"
 #include "fastnoise/FastNoiseSIMD.h"
 using fn = FastNoiseSIMD;
 
 #include <xyginext/ecs/components/Drawable.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/Scene.hpp>
 
 #include <xyginext/util/Vector.hpp>
 #include <xyginext/util/Math.hpp>
 #include <xyginext/util/Random.hpp>
 
+#include <algorithm>
+
 namespace
 {
     const sf::Vector2f NormalVec(0.f, 1.f);
@@ -41,114 +46,43 @@ namespace
     const float TrunkRight = 148.f;
     const float TrunkHeight = 192.f;
     const float LeafScale = 0.85f;
-}
-
-TreeSegment::TreeSegment(float length)
-    : m_length(length),
-    m_rotation(0.f)
-{
-
-}
 
-sf::Vector2f TreeSegment::getEnd() const
-{
-    auto vec = xy::Util::Vector::rotate(NormalVec, m_rotation);
-    m_normal = { -vec.y, vec.x };
-    return (vec * m_length);
-}
+    const float Damping = 0.99f;
 
-void TreeSegment::setRotation(float rotation)
-{
-    m_rotation = rotation;
-}
-
-void TreeSegment::setPosition(sf::Vector2f position)
-{
-    m_position = position;
-}
-
-sf::Vector2f TreeSegment::getPosition() const
-{
-    return m_position;
-}
-
-sf::Vector2f TreeSegment::getNormal() const
-{
-    return m_normal;
-}
+    //trees are culled outside the view, expanded by this much
+    const float CullMargin = 128.f;
+    const float ViewDistance = Global::IslandSize.y + Global::PlayerCameraOffset;
+    //trees further than this are updated every other frame
+    const float DistantTree = ViewDistance / 2.f;
 
-TreeBranch::TreeBranch(float length, std::size_t segmentCount, sf::Vector2f basePosition)
-    : m_basePosition(basePosition),
-    m_rotation      (0.f),
-    m_length        (length),
-    m_textureOffset (0.f)
-{
-    float segLength = length / segmentCount;
-    for (auto i = 0u; i < segmentCount; ++i)
+    //segment rotation never exceeds SegmentCount * MaxAngle (120 degrees)
+    //so these are accurate enough without range reduction, and unlike
+    //std::sin/cos they vectorise
+    float polySin(float x)
     {
-        m_segments.emplace_back(segLength);
-        m_segments.back().setRotation(DefaultAngle);
+        const float x2 = x * x;
+        return x * (1.f + x2 * (-1.f / 6.f + x2 * (1.f / 120.f + x2 * (-1.f / 5040.f + x2 * (1.f / 362880.f + x2 * (-1.f / 39916800.f))))));
     }
 
-    m_textureOffset += xy::Util::Random::value(0, 1) == 0 ? 0.f : LeafHeight;
-}
-
-void TreeBranch::update(float windstrength)
-{
-    //add wind
-    m_rotation = xy::Util::Math::clamp(m_rotation + windstrength, -MaxAngle, MaxAngle);
-
-    //add some value to make it look like it springs back
-    m_rotation *= 0.99f;
-    //if (m_rotation > DefaultAngle /*+ 0.1f*/)
-    //{
-    //    m_rotation -= 0.1f;
-    //}
-    //else if (m_rotation < DefaultAngle/* - 0.1f*/)
-    //{
-    //    m_rotation += 0.1f;
-    //}
-
-    //update all positions
-    sf::Vector2f basePosition = m_basePosition;
-    float rotation = m_rotation;
-    for (auto& segment : m_segments)
-    {
-        basePosition += segment.getEnd();
-
-        segment.setRotation(rotation);
-        segment.setPosition(basePosition);
-        rotation += m_rotation;
+    float polyCos(float x)
+    {
+        const float x2 = x * x;
+        return 1.f + x2 * (-1.f / 2.f + x2 * (1.f / 24.f + x2 * (-1.f / 720.f + x2 * (1.f / 40320.f + x2 * (-1.f / 3628800.f + x2 * (1.f / 479001600.f))))));
     }
 }
 
-const std::vector<TreeSegment>& TreeBranch::getSegments() const
-{
-    return m_segments;
-}
-
-sf::Vector2f TreeBranch::getBasePosition() const
-{
-    return m_basePosition;
-}
-
-float TreeBranch::getLength() const
-{
-    return m_length;
-}
-
-void TreeBranch::setBasePosition(sf::Vector2f position)
-{
-    m_basePosition = position;
-}
-
 //----Actual system----//
 FoliageSystem::FoliageSystem(xy::MessageBus& mb)
     : xy::System    (mb, typeid(FoliageSystem)),
     m_windStrength  (0.06f),
-    m_windIndex     (0)
+    m_windIndex     (0),
+    m_cullingEnabled(true),
+    m_frameCount    (0),
+    m_processTime   (0),
+    m_updateCount   (0)
 {
     requireComponent<xy::Drawable>();
+    requireComponent<xy::Transform>();
     requireComponent<Tree>();
 
     //windy wind
@@ -167,62 +101,71 @@ FoliageSystem::FoliageSystem(xy::MessageBus& mb)
 
 void FoliageSystem::process(float)
 {
+    m_timer.restart();
+    m_frameCount++;
     m_windIndex = (m_windIndex + 1) % NoiseTableSize;
-    
+
+    //branches not updated this frame get no wind or damping
+    std::fill(m_branches.wind.begin(), m_branches.wind.end(), 0.f);
+    std::fill(m_branches.damping.begin(), m_branches.damping.end(), 1.f);
+
+    auto camPos = getScene()->getActiveCamera().getComponent<xy::Transform>().getWorldPosition();
+    camPos.y += Global::PlayerCameraOffset;
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
-        auto& tree = entity.getComponent<Tree>();
-        auto& drawable = entity.getComponent<xy::Drawable>();
-        auto& verts = drawable.getVertices();
-        verts.clear();
+        const auto& tree = entity.getComponent<Tree>();
+        if (tree.branchCount == 0)
+        {
+            continue;
+        }
+
+        float rate = 1.f;
+        if (m_cullingEnabled)
+        {
+            auto position = entity.getComponent<xy::Transform>().getPosition();
+            if (position.y > camPos.y + CullMargin
+                || position.y < camPos.y - (ViewDistance + CullMargin))
+            {
+                continue;
+            }
+
+            //distant trees alternate frames, so not all of them update on the same one
+            if (position.y < camPos.y - DistantTree)
+            {
+                if ((m_frameCount + entity.getIndex()) % 2)
+                {
+                    continue;
+                }
+                rate = 2.f;
+            }
+        }
 
         auto offsetIndex = (m_windIndex + tree.indexOffset) % NoiseTableSize;
-        auto offsetStride = (NoiseTableSize / tree.branches.size()) / 2;
-        float width = TreeWidth;
+        auto offsetStride = (NoiseTableSize / tree.branchCount) / 2;
+        const float damping = (rate > 1.f) ? Damping * Damping : Damping;
 
-        for (auto& branch : tree.branches)
+        for (auto i = tree.firstBranch; i < tree.firstBranch + tree.branchCount; ++i)
         {
-            branch.update(m_windTable[offsetIndex] * m_windStrength);
+            m_branches.wind[i] = m_windTable[offsetIndex] * m_windStrength * rate;
+            m_branches.damping[i] = damping;
             offsetIndex = (offsetIndex + offsetStride) % NoiseTableSize;
-            
-            float yCoord = TrunkHeight;
-            float coordStride = yCoord / branch.getSegments().size();
-
-            sf::Vector2f lastPos = branch.getBasePosition();
-            verts.emplace_back(sf::Vector2f(lastPos.x - width, lastPos.y)); //extra for degen tri
-            verts.emplace_back(sf::Vector2f(lastPos.x - width, lastPos.y), sf::Vector2f(TrunkLeft, yCoord));
-            verts.emplace_back(sf::Vector2f(lastPos.x + width, lastPos.y), sf::Vector2f(TrunkRight, yCoord));
+        }
 
-            yCoord -= coordStride;
+        m_updateList.push_back(entity);
+    }
+    m_updateCount = m_updateList.size();
 
-            for (const auto& p : branch.getSegments())
-            {
-                verts.emplace_back(p.getPosition() + (p.getNormal() * width), sf::Vector2f(TrunkLeft, yCoord));
-                verts.emplace_back(p.getPosition() - (p.getNormal() * width), sf::Vector2f(TrunkRight, yCoord));
+    m_branches.update();
 
-                //width *= 0.8f;
-                yCoord -= coordStride;
-            }
-            auto dgen = verts.back();
-            verts.push_back(dgen);
-
-            //quad for leaves at top
-            float leafWidth = (LeafWidth / 2.f) * (branch.getLength() / tree.height);
-            float leafHeight = (LeafHeight / 2.f) * (branch.getLength() / tree.height);
-            float textureOffset = branch.getTextureOffset();
-            auto topPos = branch.getSegments().back().getPosition();
-            verts.emplace_back(topPos - sf::Vector2f(-leafWidth, -leafHeight) * LeafScale);
-            verts.emplace_back(topPos - sf::Vector2f(-leafWidth, -leafHeight) * LeafScale, sf::Vector2f(0.f, textureOffset));
-            verts.emplace_back(topPos - sf::Vector2f(leafWidth, -leafHeight) * LeafScale, sf::Vector2f(LeafWidth, textureOffset));
-            verts.emplace_back(topPos - sf::Vector2f(-leafWidth, leafHeight) * LeafScale, sf::Vector2f(0.f, LeafHeight+ textureOffset));
-            verts.emplace_back(topPos - sf::Vector2f(leafWidth, leafHeight) * LeafScale, sf::Vector2f(LeafWidth, LeafHeight + textureOffset));
-            verts.emplace_back(topPos - sf::Vector2f(leafWidth, leafHeight) * LeafScale);
-
-            width = TreeWidth;
-        }
-        drawable.updateLocalBounds();
+    for (auto entity : m_updateList)
+    {
+        buildVertices(entity);
     }
+    m_updateList.clear();
+
+    m_processTime = m_timer.getElapsedTime().asMicroseconds();
 }
 
 void FoliageSystem::setWindStrength(float strength)
@@ -236,19 +179,261 @@ void FoliageSystem::onEntityAdded(xy::Entity entity)
     auto& tree = entity.getComponent<Tree>();
     std::size_t count = static_cast<std::size_t>(tree.width / spacing);
 
+    tree.firstBranch = allocateBranches(count);
+    tree.branchCount = count;
+
     for (auto i = 0u; i < count; ++i)
     {
-        tree.branches.emplace_back(tree.height + xy::Util::Random::value(-40.f, 0.f), 4,
-            sf::Vector2f(i * (spacing - xy::Util::Random::value(-(spacing / 15.f), (spacing / 6.f))), 0.f));
+        float textureOffset = xy::Util::Random::value(0, 1) == 0 ? 0.f : LeafHeight;
+        m_branches.set(tree.firstBranch + i, tree.height + xy::Util::Random::value(-40.f, 0.f),
+            sf::Vector2f(i * (spacing - xy::Util::Random::value(-(spacing / 15.f), (spacing / 6.f))), 0.f), textureOffset);
         tree.indexOffset = xy::Util::Random::value(20, NoiseTableSize);
     }
 
     //TODO make sure last tree is approx 80 units from the end
-    auto backPos = tree.branches.back().getBasePosition();
-    auto diff = tree.width - backPos.x;
-    if (((diff - 80.f) > 20.f) || diff < 80.f)
+    if (count > 0)
+    {
+        auto last = tree.firstBranch + count - 1;
+        auto diff = tree.width - m_branches.baseX[last];
+        if (((diff - 80.f) > 20.f) || diff < 80.f)
+        {
+            m_branches.baseX[last] = tree.width - 80.f;
+        }
+    }
+}
+
+void FoliageSystem::onEntityRemoved(xy::Entity entity)
+{
+    auto& tree = entity.getComponent<Tree>();
+    freeBranches(tree.firstBranch, tree.branchCount);
+    tree.branchCount = 0;
+}
+
+//private
+std::size_t FoliageSystem::allocateBranches(std::size_t count)
+{
+    //first fit, as trees are all roughly the same size
+    for (auto it = m_freeBranches.begin(); it != m_freeBranches.end(); ++it)
+    {
+        if (it->count >= count)
+        {
+            auto first = it->first;
+            it->first += count;
+            it->count -= count;
+            if (it->count == 0)
+            {
+                m_freeBranches.erase(it);
+            }
+            return first;
+        }
+    }
+
+    auto first = m_branches.size();
+    m_branches.resize(first + count);
+    return first;
+}
+
+void FoliageSystem::freeBranches(std::size_t first, std::size_t count)
+{
+    if (count == 0)
     {
-        backPos.x = tree.width - 80.f;
-        tree.branches.back().setBasePosition(backPos);
+        return;
     }
-}
\ No newline at end of file
+
+    //removed branches idle until they're reused
+    std::fill(m_branches.wind.begin() + first, m_branches.wind.begin() + first + count, 0.f);
+
+    auto it = std::lower_bound(m_freeBranches.begin(), m_freeBranches.end(), first,
+        [](const BranchRange& range, std::size_t index) { return range.first < index; });
+    it = m_freeBranches.insert(it, { first, count });
+
+    //merge with the neighbouring ranges
+    auto next = it + 1;
+    if (next != m_freeBranches.end()
+        && it->first + it->count == next->first)
+    {
+        it->count += next->count;
+        m_freeBranches.erase(next);
+    }
+
+    if (it != m_freeBranches.begin())
+    {
+        auto prev = it - 1;
+        if (prev->first + prev->count == it->first)
+        {
+            prev->count += it->count;
+            it = m_freeBranches.erase(it) - 1;
+        }
+    }
+
+    //and give back anything at the end of the arrays
+    if (it->first + it->count == m_branches.size())
+    {
+        m_branches.resize(it->first);
+        m_freeBranches.erase(it);
+    }
+}
+
+void FoliageSystem::buildVertices(xy::Entity entity)
+{
+    const auto& tree = entity.getComponent<Tree>();
+    auto& drawable = entity.getComponent<xy::Drawable>();
+    auto& verts = drawable.getVertices();
+    verts.clear();
+
+    const float width = TreeWidth;
+    for (auto i = tree.firstBranch; i < tree.firstBranch + tree.branchCount; ++i)
+    {
+        float yCoord = TrunkHeight;
+        float coordStride = yCoord / SegmentCount;
+
+        sf::Vector2f lastPos(m_branches.baseX[i], m_branches.baseY[i]);
+        verts.emplace_back(sf::Vector2f(lastPos.x - width, lastPos.y)); //extra for degen tri
+        verts.emplace_back(sf::Vector2f(lastPos.x - width, lastPos.y), sf::Vector2f(TrunkLeft, yCoord));
+        verts.emplace_back(sf::Vector2f(lastPos.x + width, lastPos.y), sf::Vector2f(TrunkRight, yCoord));
+
+        yCoord -= coordStride;
+
+        for (auto j = 0u; j < SegmentCount; ++j)
+        {
+            sf::Vector2f position(m_branches.positionX[j][i], m_branches.positionY[j][i]);
+            sf::Vector2f normal(m_branches.normalX[j][i], m_branches.normalY[j][i]);
+
+            verts.emplace_back(position + (normal * width), sf::Vector2f(TrunkLeft, yCoord));
+            verts.emplace_back(position - (normal * width), sf::Vector2f(TrunkRight, yCoord));
+
+            yCoord -= coordStride;
+        }
+        auto dgen = verts.back();
+        verts.push_back(dgen);
+
+        //quad for leaves at top
+        float leafWidth = (LeafWidth / 2.f) * (m_branches.length[i] / tree.height);
+        float leafHeight = (LeafHeight / 2.f) * (m_branches.length[i] / tree.height);
+        float textureOffset = m_branches.textureOffset[i];
+        sf::Vector2f topPos(m_branches.positionX[SegmentCount - 1][i], m_branches.positionY[SegmentCount - 1][i]);
+        verts.emplace_back(topPos - sf::Vector2f(-leafWidth, -leafHeight) * LeafScale);
+        verts.emplace_back(topPos - sf::Vector2f(-leafWidth, -leafHeight) * LeafScale, sf::Vector2f(0.f, textureOffset));
+        verts.emplace_back(topPos - sf::Vector2f(leafWidth, -leafHeight) * LeafScale, sf::Vector2f(LeafWidth, textureOffset));
+        verts.emplace_back(topPos - sf::Vector2f(-leafWidth, leafHeight) * LeafScale, sf::Vector2f(0.f, LeafHeight+ textureOffset));
+        verts.emplace_back(topPos - sf::Vector2f(leafWidth, leafHeight) * LeafScale, sf::Vector2f(LeafWidth, LeafHeight + textureOffset));
+        verts.emplace_back(topPos - sf::Vector2f(leafWidth, leafHeight) * LeafScale);
+    }
+    drawable.updateLocalBounds();
+}
+
+void FoliageSystem::BranchData::resize(std::size_t count)
+{
+    baseX.resize(count);
+    baseY.resize(count);
+    length.resize(count);
+    segmentLength.resize(count);
+    textureOffset.resize(count);
+    rotation.resize(count);
+
+    wind.resize(count);
+    damping.resize(count, 1.f);
+
+    for (auto i = 0u; i < SegmentCount; ++i)
+    {
+        segmentRotation[i].resize(count);
+        positionX[i].resize(count);
+        positionY[i].resize(count);
+        normalX[i].resize(count);
+        normalY[i].resize(count);
+    }
+
+    sine.resize(count);
+    cosine.resize(count);
+    accumX.resize(count);
+    accumY.resize(count);
+}
+
+void FoliageSystem::BranchData::set(std::size_t index, float branchLength, sf::Vector2f basePosition, float texOffset)
+{
+    baseX[index] = basePosition.x;
+    baseY[index] = basePosition.y;
+    length[index] = branchLength;
+    segmentLength[index] = branchLength / SegmentCount;
+    textureOffset[index] = texOffset;
+    rotation[index] = 0.f;
+
+    wind[index] = 0.f;
+    damping[index] = 1.f;
+
+    for (auto i = 0u; i < SegmentCount; ++i)
+    {
+        segmentRotation[i][index] = DefaultAngle;
+        positionX[i][index] = basePosition.x;
+        positionY[i][index] = basePosition.y;
+        normalX[i][index] = 0.f;
+        normalY[i][index] = 0.f;
+    }
+}
+
+void FoliageSystem::BranchData::update()
+{
+    //each loop runs over every branch and only touches a few
+    //arrays, so that they vectorise without too many alias checks
+    const auto count = size();
+
+    //add wind, and damp so it looks like it springs back
+    float* rot = rotation.data();
+    const float* windIn = wind.data();
+    const float* dampingIn = damping.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        rot[i] = std::min(MaxAngle, std::max(-MaxAngle, rot[i] + windIn[i])) * dampingIn[i];
+    }
+
+    std::copy(baseX.begin(), baseX.end(), accumX.begin());
+    std::copy(baseY.begin(), baseY.end(), accumY.begin());
+
+    //each segment is placed at the end of the previous, using
+    //the rotation it had last frame, then takes its new rotation
+    for (auto s = 0u; s < SegmentCount; ++s)
+    {
+        const float* segRot = segmentRotation[s].data();
+        float* sinOut = sine.data();
+        float* cosOut = cosine.data();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            float rads = segRot[i] * xy::Util::Const::degToRad;
+            sinOut[i] = polySin(rads);
+            cosOut[i] = polyCos(rads);
+        }
+
+        //normal of rotated up vector
+        float* nx = normalX[s].data();
+        float* ny = normalY[s].data();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            nx[i] = -cosOut[i];
+            ny[i] = -sinOut[i];
+        }
+
+        const float* segLength = segmentLength.data();
+        float* ax = accumX.data();
+        float* px = positionX[s].data();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ax[i] -= sinOut[i] * segLength[i];
+            px[i] = ax[i];
+        }
+
+        float* ay = accumY.data();
+        float* py = positionY[s].data();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            ay[i] += cosOut[i] * segLength[i];
+            py[i] = ay[i];
+        }
+
+        float* segRotOut = segmentRotation[s].data();
+        const float multiplier = static_cast<float>(s + 1);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            segRotOut[i] = rot[i] * multiplier;
+        }
+    }
+}
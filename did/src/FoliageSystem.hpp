@@ -21,62 +21,22 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/System.hpp>
 
 #include <SFML/System/Vector2.hpp>
+#include <SFML/System/Clock.hpp>
 
+#include <array>
 #include <vector>
 
-class TreeSegment final
-{
-public:
-    explicit TreeSegment(float length);
-
-    sf::Vector2f getEnd() const;
-
-    void setRotation(float);
-
-    void setPosition(sf::Vector2f);
-
-    sf::Vector2f getPosition() const;
-
-    sf::Vector2f getNormal() const;
-
-private:
-    float m_length;
-    float m_rotation;
-    sf::Vector2f m_position;
-    mutable sf::Vector2f m_normal;
-};
-
-class TreeBranch final
-{
-public:
-    TreeBranch(float length, std::size_t segmentCount, sf::Vector2f basePosition);
-
-    void update(float windStrength);
-
-    const std::vector<TreeSegment>& getSegments() const;
-
-    sf::Vector2f getBasePosition() const;
-
-    float getLength() const;
-
-    void setBasePosition(sf::Vector2f);
-
-    float getTextureOffset() const { return m_textureOffset; }
-
-private:
-    std::vector<TreeSegment> m_segments;
-    sf::Vector2f m_basePosition;
-    float m_rotation;
-    float m_length;
-    float m_textureOffset;
-};
-
+//branch data is stored in the FoliageSystem so that all
+//branches can be animated together in a single pass
 struct Tree final
 {
-    std::vector<TreeBranch> branches;
     float width = 0.f;
     float height = 96.f; //total 128 when you include the leaves
     std::size_t indexOffset = 0;
+
+    //range of this tree's branches in the system's branch data
+    std::size_t firstBranch = 0;
+    std::size_t branchCount = 0;
 };
 
 
@@ -91,9 +51,76 @@ public:
 
     void onEntityAdded(xy::Entity) override;
 
+    void onEntityRemoved(xy::Entity) override;
+
+    //when enabled trees out of view aren't animated
+    //and distant trees are animated at half rate
+    void setCullingEnabled(bool enabled) { m_cullingEnabled = enabled; }
+
+    //time taken by the last update, in microseconds
+    std::int64_t getProcessTime() const { return m_processTime; }
+
+    //number of trees updated during the last frame
+    std::size_t getUpdateCount() const { return m_updateCount; }
+
+    static constexpr std::size_t SegmentCount = 4;
+
 private:
     float m_windStrength;
 
     std::vector<float> m_windTable;
     std::size_t m_windIndex;
-};
\ No newline at end of file
+
+    struct BranchData final
+    {
+        std::vector<float> baseX;
+        std::vector<float> baseY;
+        std::vector<float> length;
+        std::vector<float> segmentLength;
+        std::vector<float> textureOffset;
+        std::vector<float> rotation;
+
+        //inputs for this frame
+        std::vector<float> wind;
+        std::vector<float> damping;
+
+        //segment data is stored per segment index
+        //so each may be processed for all branches at once
+        std::array<std::vector<float>, SegmentCount> segmentRotation;
+        std::array<std::vector<float>, SegmentCount> positionX;
+        std::array<std::vector<float>, SegmentCount> positionY;
+        std::array<std::vector<float>, SegmentCount> normalX;
+        std::array<std::vector<float>, SegmentCount> normalY;
+
+        //working space
+        std::vector<float> sine;
+        std::vector<float> cosine;
+        std::vector<float> accumX;
+        std::vector<float> accumY;
+
+        std::size_t size() const { return baseX.size(); }
+        void resize(std::size_t);
+        void set(std::size_t index, float length, sf::Vector2f basePosition, float textureOffset);
+        void update();
+    }m_branches;
+
+    //ranges of branch data released by removed trees, sorted
+    //by first index, which are reused by the next trees added
+    struct BranchRange final
+    {
+        std::size_t first = 0;
+        std::size_t count = 0;
+    };
+    std::vector<BranchRange> m_freeBranches;
+    std::size_t allocateBranches(std::size_t);
+    void freeBranches(std::size_t first, std::size_t count);
+
+    bool m_cullingEnabled;
+    std::uint32_t m_frameCount;
+    sf::Clock m_timer;
+    std::int64_t m_processTime;
+    std::size_t m_updateCount;
+
+    std::vector<xy::Entity> m_updateList;
+    void buildVertices(xy::Entity);
+};
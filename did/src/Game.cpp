@@ -33,6 +33,8 @@ Copyright 2019 Matt Marchant
 
 #include "glad/glad.h"
 
+#include <xyginext/core/FileSystem.hpp>
+
 #include <SFML/Window/Event.hpp>
 
 #ifdef DD_DEBUG
@@ -108,6 +110,10 @@ bool Game::initialise()
     m_sharedData.netClient = std::make_shared<xy::NetClient>();
     m_sharedData.netClient->create(Global::NetworkChannels);
 
+    m_sharedData.assetLoader = std::make_shared<AssetLoader>();
+    m_sharedData.gameResources = std::make_shared<xy::ResourceHandler>();
+    m_sharedData.assetLoader->install(*m_sharedData.gameResources, AssetLoader::Game);
+
     xy::AudioMixer::setLabel("Sound FX", MixerChannel::FX);
     xy::AudioMixer::setLabel("Music", MixerChannel::Music);
 
@@ -117,6 +123,7 @@ bool Game::initialise()
     getRenderWindow()->setKeyRepeatEnabled(false);
 
     m_sharedData.gameServer->setMaxPlayers(4);
+    m_sharedData.gameServer->setMapCacheDirectory(xy::FileSystem::getConfigDirectory(getApplicationName()) + "islands/");
 
     xy::App::getActiveInstance()->setWindowTitle("Desert Island Duel");
 
@@ -134,6 +141,10 @@ void Game::finalise()
 
     m_stateStack.clearStates();
     m_stateStack.applyPendingChanges();
+
+    //release any textures while there's still a context
+    m_sharedData.gameResources.reset();
+    m_sharedData.assetLoader.reset();
 }
 
 void Game::registerStates()
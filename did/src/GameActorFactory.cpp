@@ -159,7 +159,7 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
     //    shadowTx.setOrigin(8.f, 8.f);
     //    shadowTx.setPosition(bounds.width / 2.f, 0.f);
     //    entity.addComponent<xy::Drawable>().setShader(&m_shaderResource.get(ShaderID::PlaneShader));
-    //    entity.addComponent<xy::Sprite>(m_textureResource.get("assets/images/player_shadow.png"));
+    //    entity.addComponent<xy::Sprite>(getTexture("assets/images/player_shadow.png"));
     //    spriteTx.addChild(shadowTx);
     //};
     auto addNameTag = [&](xy::Entity parent)
@@ -455,7 +455,7 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
         entity.getComponent<xy::Drawable>().setPrimitiveType(sf::Quads);
 
         entity.addComponent<Sprite3D>(m_modelMatrices).needsCorrection = false;
-        entity.getComponent<xy::Drawable>().setTexture(&m_textureResource.get("assets/images/dirt.png"));
+        entity.getComponent<xy::Drawable>().setTexture(&getTexture("assets/images/dirt.png"));
         entity.getComponent<xy::Drawable>().setShader(&m_shaderResource.get(ShaderID::SpriteShaderCulled));
         entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
         entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
@@ -480,7 +480,7 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
         lightningEnt.addComponent<AnimationModifier>();
         lightningEnt.addComponent<xy::Drawable>().setBlendMode(sf::BlendAdd);
 
-        lightningEnt.addComponent<xy::Sprite>(m_textureResource.get("assets/images/lightning.png"));
+        lightningEnt.addComponent<xy::Sprite>(getTexture("assets/images/lightning.png"));
         lightningEnt.addComponent<Sprite3D>(m_modelMatrices);
         lightningEnt.getComponent<xy::Drawable>().setShader(&m_shaderResource.get(ShaderID::SpriteShaderUnlitTextured));
         lightningEnt.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
@@ -515,7 +515,7 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
         if (!inWater)
         {
             entity.addComponent<Sprite3D>(m_modelMatrices).needsCorrection = false;
-            entity.getComponent<xy::Drawable>().setTexture(&m_textureResource.get("assets/images/explosion.png"));
+            entity.getComponent<xy::Drawable>().setTexture(&getTexture("assets/images/explosion.png"));
             entity.getComponent<xy::Drawable>().setShader(&m_shaderResource.get(ShaderID::SpriteShaderCulled));
             entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
             entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
@@ -732,14 +732,14 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
         break;
     case Actor::Parrot:
         entity.addComponent<Sprite3D>(m_modelMatrices).needsCorrection = false;
-        entity.getComponent<xy::Drawable>().setTexture(&m_textureResource.get("assets/images/parrot.png"));
+        entity.getComponent<xy::Drawable>().setTexture(&getTexture("assets/images/parrot.png"));
         entity.getComponent<xy::Drawable>().setShader(&m_shaderResource.get(ShaderID::SpriteShaderCulled));
         entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
         entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
         entity.getComponent<xy::Drawable>().bindUniform("u_texture", *entity.getComponent<xy::Drawable>().getTexture());
         entity.addComponent<ParrotFlock>();
         entity.addComponent<xy::CommandTarget>().ID = CommandID::Parrot;
-        entity.addComponent<xy::AudioEmitter>().setSource(m_audioResource.get("assets/sound/effects/bird_flight.wav"));
+        entity.addComponent<xy::AudioEmitter>().setSource(getSoundBuffer("assets/sound/effects/bird_flight.wav"));
         entity.getComponent<xy::AudioEmitter>().setAttenuation(1.f);
         entity.getComponent<xy::AudioEmitter>().setMinDistance(20.f);
         entity.getComponent<xy::AudioEmitter>().setVolume(9.f);
@@ -795,7 +795,7 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
                 grassEnt.getComponent<SpringFlower>().stiffness = -14.f;
                 grassEnt.getComponent<SpringFlower>().damping = -0.1f;
                 grassEnt.addComponent<xy::Drawable>();// .setPrimitiveType(sf::Quads);
-                grassEnt.getComponent<xy::Drawable>().setTexture(&m_textureResource.get("assets/images/grass.png"));
+                grassEnt.getComponent<xy::Drawable>().setTexture(&getTexture("assets/images/grass.png"));
                 grassEnt.getComponent<xy::Drawable>().setShader(&m_shaderResource.get(ShaderID::SpriteShaderCulled));
                 grassEnt.getComponent<xy::Drawable>().bindUniform("u_texture", *grassEnt.getComponent<xy::Drawable>().getTexture());
                 grassEnt.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
@@ -997,7 +997,7 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
 
         auto compassEntity = m_gameScene.createEntity();
         compassEntity.addComponent<xy::Drawable>();
-        compassEntity.getComponent<xy::Drawable>().setTexture(&m_textureResource.get("assets/images/compass.png"));
+        compassEntity.getComponent<xy::Drawable>().setTexture(&getTexture("assets/images/compass.png"));
         compassEntity.addComponent<xy::Transform>();
         compassEntity.addComponent<Compass>().parent = entity;
 
@@ -1068,7 +1068,7 @@ void GameState::spawnActor(Actor actor, sf::Vector2f position, std::int32_t time
         shadowTx.setOrigin(8.f, 8.f);
         shadowTx.setPosition(bounds.width / 2.f, 0.f);
         entity.addComponent<xy::Drawable>().setShader(&m_shaderResource.get(ShaderID::PlaneShader));
-        entity.addComponent<xy::Sprite>(m_textureResource.get("assets/images/player_shadow.png"));
+        entity.addComponent<xy::Sprite>(getTexture("assets/images/player_shadow.png"));
         entity.addComponent<SimpleShadow>().parent = parent;
         //entity.addComponent<xy::CommandTarget>().ID = CommandID::BasicShadow;
 
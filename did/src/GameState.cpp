@@ -24,6 +24,7 @@ Copyright 2019 Matt Marchant
 #include "GlobalConsts.hpp"
 #include "MessageIDs.hpp"
 #include "IslandGenerator.hpp"
+#include "IslandRenderer.hpp"
 #include "NetworkClient.hpp"
 #include "SharedStateData.hpp"
 #include "PlayerSystem.hpp"
@@ -64,8 +65,12 @@ Copyright 2019 Matt Marchant
 #include "ClientDecoySystem.hpp"
 #include "ClientFlareSystem.hpp"
 #include "InterpolationSystem.hpp"
+#include "InterpolationBench.hpp"
+#include "MiniMapBench.hpp"
+#include "ExplosionBench.hpp"
 #include "Packet.hpp"
 #include "AudioDelaySystem.hpp"
+#include "AssetLoader.hpp"
 
 #include <xyginext/core/App.hpp>
 #include <xyginext/core/SysTime.hpp>
@@ -123,6 +128,70 @@ namespace
         float alpha = 0.f;
         xy::Entity parent;
     };
+
+    //lanterns are swapped for pumpkins or trees depending on the time of year
+    std::string getLanternSheet()
+    {
+        if (xy::SysTime::now().months() == 10)
+        {
+            return "assets/sprites/pumpkin.spt";
+        }
+        else if (xy::SysTime::now().months() == 12)
+        {
+            return "assets/sprites/xtree.spt";
+        }
+        return "assets/sprites/lantern.spt";
+    }
+
+    const std::vector<std::string> GameSpriteSheets =
+    {
+        "assets/sprites/players.spt",
+        "assets/sprites/barrel.spt",
+        "assets/sprites/skeleton.spt",
+        "assets/sprites/ghosts.spt",
+        "assets/sprites/poopsnail.spt",
+        "assets/sprites/chest.spt",
+        "assets/sprites/wet_patch.spt",
+        "assets/sprites/weapons.spt",
+        "assets/sprites/collectibles.spt",
+        "assets/sprites/rings.spt",
+        "assets/sprites/fire.spt",
+        "assets/sprites/boat.spt",
+        "assets/sprites/ships.spt",
+        "assets/sprites/bees.spt",
+        "assets/sprites/decoy.spt",
+        "assets/sprites/flare.spt",
+        "assets/sprites/mine.spt",
+        "assets/sprites/impact.spt",
+        "assets/sprites/spooky_skull.spt",
+        "assets/sprites/splash.spt",
+        "assets/sprites/player_puff.spt",
+        "assets/sprites/water_details.spt",
+        "assets/sprites/cloud.spt",
+        "assets/sprites/lobby.spt",
+        "assets/sprites/hud.spt",
+        "assets/sprites/trophies.spt"
+    };
+
+    const std::vector<std::string> GameImages =
+    {
+        "assets/images/rain.png",
+        "assets/images/red_drapes.png",
+        "assets/images/summary_window.png",
+        "assets/images/buttons.png",
+        "assets/images/dirt.png",
+        "assets/images/lightning.png",
+        "assets/images/explosion.png",
+        "assets/images/parrot.png",
+        "assets/images/grass.png",
+        "assets/images/compass.png",
+        "assets/images/player_shadow.png"
+    };
+
+    const std::vector<std::string> GameSounds =
+    {
+        "assets/sound/effects/bird_flight.wav"
+    };
 }
 
 GameState::GameState(xy::StateStack& ss, xy::State::Context ctx, SharedData& sd)
@@ -191,6 +260,29 @@ GameState::GameState(xy::StateStack& ss, xy::State::Context ctx, SharedData& sd)
                 xy::Console::print("Set bots enabled to " + param);
             });
 
+        registerCommand("bot_perception", [&](const std::string& param)
+            {
+                //number of times per second each bot sweeps its surroundings
+                Server::ConCommand::Data data;
+                data.commandID = Server::ConCommand::BotPerception;
+                data.value.asFloat = static_cast<float>(std::atof(param.c_str()));
+                if (data.value.asFloat > 0)
+                {
+                    m_sharedData.netClient->sendPacket(PacketID::ConCommand, data, xy::NetFlag::Reliable, Global::LowPriorityChannel);
+                    xy::Console::print("Set bot perception rate to " + param);
+                }
+            });
+
+        registerCommand("server_stats", [&](const std::string& param)
+            {
+                //no param prints the current stats, a number of seconds
+                //starts writing them to a file, and 'off' stops writing
+                Server::ConCommand::Data data;
+                data.commandID = Server::ConCommand::Profile;
+                data.value.asInt = (param == "off") ? -1 : std::atoi(param.c_str());
+                m_sharedData.netClient->sendPacket(PacketID::ConCommand, data, xy::NetFlag::Reliable, Global::LowPriorityChannel);
+            });
+
         registerCommand("spawn", [&](const std::string& param)
             {
                 if (!param.empty())
@@ -262,11 +354,141 @@ GameState::GameState(xy::StateStack& ss, xy::State::Context ctx, SharedData& sd)
         {xy::Console::print(m_sharedData.seedData.str); }
     );
 
+#ifdef XY_DEBUG
+    //adds the given number of props to measure the cull and sort time of
+    //the 3D renderer and the cost of updating their matrices. Optionally
+    //only some of them move, eg render_bench 2000 100
+    registerCommand("render_bench", [&](const std::string& param)
+        {
+            char* next = nullptr;
+            auto count = static_cast<int>(std::strtol(param.c_str(), &next, 10));
+            auto moving = (*next) ? static_cast<int>(std::strtol(next, nullptr, 10)) : count;
+
+            for (auto i = 0; i < count; ++i)
+            {
+                sf::Vector2f position(xy::Util::Random::value(0.f, Global::IslandSize.x), xy::Util::Random::value(0.f, Global::IslandSize.y));
+
+                auto entity = m_gameScene.createEntity();
+                entity.addComponent<xy::Transform>().setPosition(position);
+                entity.addComponent<xy::Drawable>().setDepth(static_cast<std::int32_t>(position.y));
+                auto& verts = entity.getComponent<xy::Drawable>().getVertices();
+                verts.emplace_back(sf::Vector2f(-4.f, -8.f), sf::Color::Magenta);
+                verts.emplace_back(sf::Vector2f(4.f, -8.f), sf::Color::Magenta);
+                verts.emplace_back(sf::Vector2f(4.f, 0.f), sf::Color::Magenta);
+                verts.emplace_back(sf::Vector2f(-4.f, 0.f), sf::Color::Magenta);
+                entity.getComponent<xy::Drawable>().updateLocalBounds();
+                entity.addComponent<Sprite3D>(m_modelMatrices);
+
+                entity.addComponent<xy::Callback>().active = (i < moving);
+                entity.getComponent<xy::Callback>().function =
+                    [](xy::Entity e, float dt)
+                {
+                    auto& tx = e.getComponent<xy::Transform>();
+                    tx.move(0.f, xy::Util::Random::value(-20.f, 20.f) * dt);
+                    e.getComponent<xy::Drawable>().setDepth(static_cast<std::int32_t>(tx.getPosition().y));
+                };
+            }
+            xy::Console::print("Added " + std::to_string(count) + " props, " + std::to_string(std::min(count, moving)) + " moving");
+        });
+
+    //adds the given number of static torches around the island to
+    //measure shadow geometry updates at night, eg shadow_bench 100
+    registerCommand("shadow_bench", [&](const std::string& param)
+        {
+            auto count = std::atoi(param.c_str());
+            for (auto i = 0; i < count; ++i)
+            {
+                auto entity = m_gameScene.createEntity();
+                entity.addComponent<xy::Transform>().setPosition(xy::Util::Random::value(0.f, Global::IslandSize.x), xy::Util::Random::value(0.f, Global::IslandSize.y));
+                entity.addComponent<Torchlight>();
+
+                m_gameScene.getSystem<ShadowCastSystem>().addLight(entity);
+                m_gameScene.getSystem<SimpleShadowSystem>().addLight(entity);
+            }
+            xy::Console::print("Added " + std::to_string(count) + " torches");
+        });
+
+    //compares the cost of animating all foliage with only animating visible trees
+    registerCommand("foliage_cull", [&](const std::string& param)
+        {
+            m_gameScene.getSystem<FoliageSystem>().setCullingEnabled(param != "0");
+            xy::Console::print("Foliage culling " + std::string(param != "0" ? "enabled" : "disabled"));
+        });
+
+    //runs a synthetic snapshot stream through the interpolation with the given
+    //percentage of lost packets and jitter in ms, eg interp_bench 10 50
+    registerCommand("interp_bench", [](const std::string& param)
+        {
+            char* next = nullptr;
+            InterpolationBenchSettings settings;
+            settings.loss = static_cast<float>(std::strtod(param.c_str(), &next)) / 100.f;
+            settings.jitter = static_cast<float>(std::strtod(next, nullptr));
+
+            auto result = runInterpolationBench(settings);
+            xy::Console::print("Mean error: " + std::to_string(result.meanError) + ", max error: " + std::to_string(result.maxError));
+            xy::Console::print("Extrapolated: " + std::to_string(result.extrapolated * 100.f) + "%, delay: " + std::to_string(result.delay) + "ms");
+            xy::Console::print("Sample time: " + std::to_string(result.sampleTime) + "ns per actor");
+            xy::Console::print(result.passed ? "PASSED" : "FAILED");
+        });
+
+    //compares partial minimap updates with full redraws over a scripted
+    //walk of the given number of seconds, eg minimap_bench 60
+    registerCommand("minimap_bench", [&](const std::string& param)
+        {
+            auto duration = param.empty() ? 60.f : static_cast<float>(std::atof(param.c_str()));
+            auto result = runMiniMapBench(m_textureResource, m_islandRenderer.getTexture(), duration);
+            xy::Console::print("Partial: " + std::to_string(result.partialTime) + "us, peak " + std::to_string(result.partialPeak) + "us, " + std::to_string(result.partialTexels) + " texels per frame");
+            xy::Console::print("Full: " + std::to_string(result.fullTime) + "us, peak " + std::to_string(result.fullPeak) + "us, " + std::to_string(result.fullTexels) + " texels per frame");
+            xy::Console::print("Revealed: " + std::to_string(result.revealed * 100.f) + "%");
+            xy::Console::print(result.matches ? "Output matches" : "Output DOES NOT match");
+        });
+
+    //keeps the given number of explosions alive for 10 seconds, recycling
+    //them as they burn out, and measures the update, eg explosion_bench 100
+    registerCommand("explosion_bench", [](const std::string& param)
+        {
+            auto count = param.empty() ? 100 : std::max(1, std::atoi(param.c_str()));
+            auto result = runExplosionBench(static_cast<std::size_t>(count));
+            xy::Console::print("Update: " + std::to_string(result.updateTime) + "us, peak " + std::to_string(result.updatePeak) + "us");
+            xy::Console::print("Particle blocks: " + std::to_string(result.blockCount) + ", grown " + std::to_string(result.growthCount) + " times after the first frame");
+            xy::Console::print("Vertex arrays allocated: " + std::to_string(result.spawnRate) + " per frame");
+        });
+
+    //decodes the game's images on the asset loader threads and
+    //compares them with the same images decoded on this thread
+    registerCommand("asset_verify", [](const std::string&)
+        {
+            AssetLoader loader;
+            queueAssets(loader);
+            auto mismatches = loader.verifyImages();
+            xy::Console::print(mismatches == 0 ? "Decoded images match" : std::to_string(mismatches) + " decoded images DO NOT match");
+        });
+#endif
+
     update(0.f); //gets scene ready to draw before first frame
     quitLoadingScreen();   
 }
 
 //public
+void GameState::queueAssets(AssetLoader& assetLoader)
+{
+    for (const auto& path : GameSpriteSheets)
+    {
+        assetLoader.queueSpriteSheet(path, AssetLoader::Game);
+    }
+    assetLoader.queueSpriteSheet(getLanternSheet(), AssetLoader::Game);
+
+    for (const auto& path : GameImages)
+    {
+        assetLoader.queueImage(path, AssetLoader::Game);
+    }
+
+    for (const auto& path : GameSounds)
+    {
+        assetLoader.queueSound(path, AssetLoader::Game);
+    }
+}
+
 bool GameState::handleEvent(const sf::Event& evt)
 {
     if (xy::ui::wantsMouse() || xy::ui::wantsKeyboard())
@@ -674,6 +896,35 @@ bool GameState::update(float dt)
         frames = 0;
     }
     xy::Console::printStat("Incoming bw", std::to_string(bw) + "Kbps");
+
+    xy::Console::printStat("Bot AI", std::to_string(m_botStats.processTime) + "us");
+    xy::Console::printStat("Bot Latency", std::to_string(m_botStats.decisionLatency) + "ms");
+
+    const auto& renderSystem = m_gameScene.getSystem<Render3DSystem>();
+    xy::Console::printStat("3D Drawn", std::to_string(renderSystem.getDrawCount()));
+    xy::Console::printStat("3D Cull", std::to_string(renderSystem.getCullTime()) + "us");
+    xy::Console::printStat("3D Sort", std::to_string(renderSystem.getSortTime()) + "us" + (renderSystem.getRadixSorted() ? " (radix)" : ""));
+
+    const auto& spriteSystem = m_gameScene.getSystem<Sprite3DSystem>();
+    xy::Console::printStat("3D Matrices", std::to_string(spriteSystem.getUpdateCount()) + "/" + std::to_string(m_modelMatrices.getAllocatedCount())
+        + " in " + std::to_string(spriteSystem.getProcessTime()) + "us");
+
+    const auto& shadowSystem = m_gameScene.getSystem<ShadowCastSystem>();
+    xy::Console::printStat("Shadows", std::to_string(shadowSystem.getRebuiltCount()) + "/" + std::to_string(shadowSystem.getPairCount())
+        + " pairs in " + std::to_string(shadowSystem.getProcessTime()) + "us");
+
+    const auto& foliageSystem = m_gameScene.getSystem<FoliageSystem>();
+    xy::Console::printStat("Foliage", std::to_string(foliageSystem.getUpdateCount()) + "/" + std::to_string(foliageSystem.getEntities().size())
+        + " trees in " + std::to_string(foliageSystem.getProcessTime()) + "us");
+
+    const auto& explosionSystem = m_gameScene.getSystem<ExplosionSystem>();
+    xy::Console::printStat("Explosions", std::to_string(explosionSystem.getActiveCount()) + "/" + std::to_string(explosionSystem.getBlockCount())
+        + " in " + std::to_string(explosionSystem.getProcessTime()) + "us");
+
+    const auto& interpSystem = m_gameScene.getSystem<InterpolationSystem>();
+    const auto& serverClock = interpSystem.getServerClock();
+    xy::Console::printStat("Interpolation", std::to_string(interpSystem.getExtrapolatedCount()) + " extrapolated in " + std::to_string(interpSystem.getProcessTime()) + "us");
+    xy::Console::printStat("Interp Delay", std::to_string(static_cast<int>(serverClock.getDelay())) + "ms, jitter " + std::to_string(static_cast<int>(serverClock.getJitter())) + "ms");
 #else
     xy::NetEvent evt;
     while (m_sharedData.netClient->pollEvent(evt))
@@ -815,9 +1066,13 @@ void GameState::loadResources()
         }
     }
 
+    //textures are shared between rounds, and created from data
+    //decoded by the asset loader while the menu was active
+    auto& gameResources = *m_sharedData.gameResources;
+
     //actor sprites
     xy::SpriteSheet spriteSheet;
-    spriteSheet.loadFromFile("assets/sprites/players.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/players.spt", gameResources);
     auto spriteIndex = std::to_string(m_sharedData.clientInformation.getClient(0).spriteIndex);
 
     m_sprites[SpriteID::PlayerOne] = spriteSheet.getSprite(spriteIndex);
@@ -876,7 +1131,7 @@ void GameState::loadResources()
         0,0
     };
 
-    spriteSheet.loadFromFile("assets/sprites/barrel.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/barrel.spt", gameResources);
     m_sprites[SpriteID::BarrelOne] = spriteSheet.getSprite("barrel01");
     m_animationMaps[SpriteID::BarrelOne] =
     {
@@ -895,7 +1150,7 @@ void GameState::loadResources()
         0,0,0,0,0,0,0
     };
 
-    spriteSheet.loadFromFile("assets/sprites/skeleton.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/skeleton.spt", gameResources);
     
     m_sprites[SpriteID::Skeleton] = spriteSheet.getSprite("zombie");
     m_animationMaps[SpriteID::Skeleton] = 
@@ -912,10 +1167,10 @@ void GameState::loadResources()
         spriteSheet.getAnimationIndex("die", "zombie")
     };
 
-    spriteSheet.loadFromFile("assets/sprites/ghosts.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/ghosts.spt", gameResources);
     m_sprites[SpriteID::Ghost] = spriteSheet.getSprite("ghost");
 
-    spriteSheet.loadFromFile("assets/sprites/poopsnail.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/poopsnail.spt", gameResources);
     m_sprites[SpriteID::Crab] = spriteSheet.getSprite("poopsnail");
     m_animationMaps[SpriteID::Crab] =
     {
@@ -926,23 +1181,12 @@ void GameState::loadResources()
         spriteSheet.getAnimationIndex("dig", "poopsnail")
     };
 
-    if (xy::SysTime::now().months() == 10)
-    {
-        spriteSheet.loadFromFile("assets/sprites/pumpkin.spt", m_textureResource);
-    }
-    else if (xy::SysTime::now().months() == 12)
-    {
-        spriteSheet.loadFromFile("assets/sprites/xtree.spt", m_textureResource);
-    }
-    else
-    {
-        spriteSheet.loadFromFile("assets/sprites/lantern.spt", m_textureResource);
-    }
+    spriteSheet.loadFromFile(getLanternSheet(), gameResources);
     m_sprites[SpriteID::Lantern] = spriteSheet.getSprite("lantern");
     auto id = spriteSheet.getAnimationIndex("flicker", "lantern");
     m_animationMaps[SpriteID::Lantern] = { id };
 
-    spriteSheet.loadFromFile("assets/sprites/chest.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/chest.spt", gameResources);
     m_sprites[SpriteID::Treasure] = spriteSheet.getSprite("chest");
     auto front = spriteSheet.getAnimationIndex("down", "chest");
     auto side = spriteSheet.getAnimationIndex("left", "chest");
@@ -954,23 +1198,23 @@ void GameState::loadResources()
         0,0
     };
 
-    spriteSheet.loadFromFile("assets/sprites/wet_patch.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/wet_patch.spt", gameResources);
     m_sprites[SpriteID::WetPatch] = spriteSheet.getSprite("wet_patch");
 
-    spriteSheet.loadFromFile("assets/sprites/weapons.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/weapons.spt", gameResources);
     m_sprites[SpriteID::WeaponRodney] = spriteSheet.getSprite("weapon_rodney");
     m_sprites[SpriteID::WeaponJean] = spriteSheet.getSprite("weapon_jean");
     m_gameScene.getSystem<ClientWeaponSystem>().setAnimations(spriteSheet);
 
-    spriteSheet.loadFromFile("assets/sprites/collectibles.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/collectibles.spt", gameResources);
     m_sprites[SpriteID::Ammo] = spriteSheet.getSprite("ammo");
     m_sprites[SpriteID::Coin] = spriteSheet.getSprite("coin");
     m_sprites[SpriteID::Food] = spriteSheet.getSprite("food");
 
-    spriteSheet.loadFromFile("assets/sprites/rings.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/rings.spt", gameResources);
     m_sprites[SpriteID::Rings] = spriteSheet.getSprite("rings");
 
-    spriteSheet.loadFromFile("assets/sprites/fire.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/fire.spt", gameResources);
     m_sprites[SpriteID::Fire] = spriteSheet.getSprite("fire");
 
     auto burn = spriteSheet.getAnimationIndex("burn", "fire");
@@ -978,7 +1222,7 @@ void GameState::loadResources()
     m_animationMaps[SpriteID::Fire][AnimationID::Die] = spriteSheet.getAnimationIndex("die", "fire");
     m_animationMaps[SpriteID::Fire][AnimationID::Spawn] = spriteSheet.getAnimationIndex("idle", "fire");
 
-    spriteSheet.loadFromFile("assets/sprites/boat.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/boat.spt", gameResources);
     m_sprites[SpriteID::Boat] = spriteSheet.getSprite("boat");
     m_animationMaps[SpriteID::Boat] = 
     {
@@ -992,11 +1236,11 @@ void GameState::loadResources()
     };
     m_sprites[SpriteID::Sail] = spriteSheet.getSprite("sail");
 
-    spriteSheet.loadFromFile("assets/sprites/ships.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/ships.spt", gameResources);
     m_sprites[SpriteID::Ships] = spriteSheet.getSprite("ship");
     m_sprites[SpriteID::ShipLights] = spriteSheet.getSprite("lights");
 
-    spriteSheet.loadFromFile("assets/sprites/bees.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/bees.spt", gameResources);
     m_sprites[SpriteID::Bees] = spriteSheet.getSprite("bees");
     m_animationMaps[SpriteID::Bees][AnimationID::WalkLeft] = spriteSheet.getAnimationIndex("left", "bees");
     m_animationMaps[SpriteID::Bees][AnimationID::WalkRight] = spriteSheet.getAnimationIndex("right", "bees");
@@ -1005,7 +1249,7 @@ void GameState::loadResources()
 
     m_sprites[SpriteID::Beehive] = spriteSheet.getSprite("hive");
 
-    spriteSheet.loadFromFile("assets/sprites/decoy.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/decoy.spt", gameResources);
     m_sprites[SpriteID::Decoy] = spriteSheet.getSprite("decoy");
     m_animationMaps[SpriteID::Decoy][AnimationID::Spawn] = spriteSheet.getAnimationIndex("spawn", "decoy");
     m_animationMaps[SpriteID::Decoy][AnimationID::IdleDown] = spriteSheet.getAnimationIndex("idle", "decoy");
@@ -1013,7 +1257,7 @@ void GameState::loadResources()
 
     m_sprites[SpriteID::DecoyItem] = spriteSheet.getSprite("decoy_item");
 
-    spriteSheet.loadFromFile("assets/sprites/flare.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/flare.spt", gameResources);
     m_sprites[SpriteID::Flare] = spriteSheet.getSprite("flare");
     m_sprites[SpriteID::FlareItem] = spriteSheet.getSprite("flare_item");
     m_sprites[SpriteID::SmokePuff] = spriteSheet.getSprite("smoke");
@@ -1024,33 +1268,33 @@ void GameState::loadResources()
     m_animationMaps[SpriteID::FlareItem][AnimationID::WalkLeft] = flareItemCarried;
     m_animationMaps[SpriteID::FlareItem][AnimationID::WalkRight] = flareItemCarried;
 
-    spriteSheet.loadFromFile("assets/sprites/mine.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/mine.spt", gameResources);
     m_sprites[SpriteID::MineItem] = spriteSheet.getSprite("mine_item");
 
-    spriteSheet.loadFromFile("assets/sprites/impact.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/impact.spt", gameResources);
     m_sprites[SpriteID::Impact] = spriteSheet.getSprite("impact");
 
-    spriteSheet.loadFromFile("assets/sprites/spooky_skull.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/spooky_skull.spt", gameResources);
     m_sprites[SpriteID::SkullItem] = spriteSheet.getSprite("skull");
     m_sprites[SpriteID::SkullShield] = spriteSheet.getSprite("shield");
     m_animationMaps[SpriteID::SkullShield][AnimationID::Spawn] = spriteSheet.getAnimationIndex("spawn", "shield");
     m_animationMaps[SpriteID::SkullShield][AnimationID::IdleDown] = spriteSheet.getAnimationIndex("idle", "shield");
     m_animationMaps[SpriteID::SkullShield][AnimationID::Die] = spriteSheet.getAnimationIndex("despawn", "shield");
 
-    spriteSheet.loadFromFile("assets/sprites/splash.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/splash.spt", gameResources);
     m_sprites[SpriteID::WaterSplash] = spriteSheet.getSprite("splash");
 
-    spriteSheet.loadFromFile("assets/sprites/player_puff.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/player_puff.spt", gameResources);
     m_sprites[SpriteID::PlayerPuff] = spriteSheet.getSprite("player_puff");
 
-    spriteSheet.loadFromFile("assets/sprites/water_details.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/water_details.spt", gameResources);
     m_sprites[SpriteID::Seagull] = spriteSheet.getSprite("seagull");
     m_sprites[SpriteID::Posts] = spriteSheet.getSprite("rope_posts");
     m_sprites[SpriteID::LargeRock] = spriteSheet.getSprite("large_rock");
     m_sprites[SpriteID::SmallRock01] = spriteSheet.getSprite("small_rock01");
     m_sprites[SpriteID::SmallRock02] = spriteSheet.getSprite("small_rock02");
 
-    spriteSheet.loadFromFile("assets/sprites/cloud.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/cloud.spt", gameResources);
     m_sprites[SpriteID::Cloud] = spriteSheet.getSprite("cloud");
 
     m_audioScape.loadFromFile("assets/sound/game.xas");
@@ -1064,7 +1308,8 @@ void GameState::loadScene(const TileArray& tileArray)
     if (m_sceneLoaded) return;
     
     //do this first so path finder data is accurate
-    m_islandGenerator.render(tileArray, m_textureResource);
+    m_islandGenerator.setTileData(tileArray);
+    m_islandRenderer.render(m_islandGenerator.getMapData().tileData, m_textureResource);
 
     m_pathFinder.setGridSize({ static_cast<int>(Global::TileCountX), static_cast<int>(Global::TileCountY) });
     m_pathFinder.setTileSize({ Global::TileSize, Global::TileSize });
@@ -1098,11 +1343,11 @@ void GameState::loadScene(const TileArray& tileArray)
     //load from island generator
     auto entity = m_gameScene.createEntity();
     entity.addComponent<xy::Transform>();
-    entity.addComponent<Island>().texture = &m_islandGenerator.getTexture();
-    entity.getComponent<Island>().normalMap = &m_islandGenerator.getNormalMap();
-    entity.getComponent<Island>().waveMap = &m_islandGenerator.getWaveMap();
+    entity.addComponent<Island>().texture = &m_islandRenderer.getTexture();
+    entity.getComponent<Island>().normalMap = &m_islandRenderer.getNormalMap();
+    entity.getComponent<Island>().waveMap = &m_islandRenderer.getWaveMap();
 
-    m_miniMap.setTexture(m_islandGenerator.getTexture());
+    m_miniMap.setTexture(m_islandRenderer.getTexture());
 
     //read foliage data from map generator
     m_foliageGenerator.generate(m_islandGenerator.getMapData(), m_gameScene);
@@ -1112,6 +1357,10 @@ void GameState::loadScene(const TileArray& tileArray)
 
     m_sceneLoaded = true;
 
+    //time from the lobby launching the game to the match being playable
+    const auto launchTime = m_sharedData.launchClock.getElapsedTime().asMilliseconds();
+    xy::Logger::log("Match ready " + std::to_string(launchTime) + "ms after launch", xy::Logger::Type::Info);
+
     auto msg = getContext().appInstance.getMessageBus().post<MapEvent>(MessageID::MapMessage);
     msg->type = MapEvent::Loaded;
 
@@ -1170,7 +1419,7 @@ void GameState::loadScene(const TileArray& tileArray)
     tx2.addChild(entity.getComponent<xy::Transform>());
 
     //sprites for rain layers
-    auto& rainTexture = m_textureResource.get("assets/images/rain.png");
+    auto& rainTexture = getTexture("assets/images/rain.png");
     rainTexture.setRepeated(true);
     sf::Vector2f rainPos;
 
@@ -1449,6 +1698,9 @@ void GameState::handlePacket(const xy::NetEvent& evt)
         m_roundTime = evt.packet.as<std::int32_t>();
         break;
 #ifdef XY_DEBUG
+    case PacketID::BotStats:
+        m_botStats = evt.packet.as<BotStats>();
+        break;
     case PacketID::DebugUpdate:
     {
         auto state = evt.packet.as<DebugState>();
@@ -2057,6 +2309,18 @@ xy::Entity GameState::createPlayerPuff(sf::Vector2f position, bool playerAttachm
     return entity;
 }
 
+sf::Texture& GameState::getTexture(const std::string& path)
+{
+    auto& resources = *m_sharedData.gameResources;
+    return resources.get<sf::Texture>(resources.load<sf::Texture>(path));
+}
+
+sf::SoundBuffer& GameState::getSoundBuffer(const std::string& path)
+{
+    auto& resources = *m_sharedData.gameResources;
+    return resources.get<sf::SoundBuffer>(resources.load<sf::SoundBuffer>(path));
+}
+
 void GameState::handleDisconnect()
 {
     m_inputParser.setEnabled(false);
@@ -21,6 +21,7 @@ Copyright 2019 Matt Marchant
 #include "StateIDs.hpp"
 #include "FoliageGenerator.hpp"
 #include "IslandGenerator.hpp"
+#include "IslandRenderer.hpp"
 #include "Server.hpp"
 #include "Actor.hpp"
 #include "InputParser.hpp"
@@ -44,6 +45,7 @@ Copyright 2019 Matt Marchant
 
 struct Packet;
 struct SharedData;
+class AssetLoader;
 
 namespace xy
 {
@@ -71,6 +73,10 @@ public:
 
     void draw() override;
 
+    //queues everything the game needs to be decoded in the
+    //background, so it can be uploaded before the game starts
+    static void queueAssets(AssetLoader&);
+
 private:
     xy::AudioResource m_audioResource;  //needs to outlive the scene!
 
@@ -89,6 +95,7 @@ private:
     MatrixPool m_modelMatrices;
     FoliageGenerator m_foliageGenerator;
     IslandGenerator m_islandGenerator;
+    IslandRenderer m_islandRenderer;
 
     PathFinder m_pathFinder;
 
@@ -100,6 +107,7 @@ private:
     bool m_canShowMessage;
 
     std::int32_t m_roundTime;
+    BotStats m_botStats;
 
     bool m_roundOver;
     bool m_updateSummary;
@@ -134,6 +142,9 @@ private:
     void plotPath(const std::vector<sf::Vector2f>&);
     void loadAudio();
 
+    sf::Texture& getTexture(const std::string&);
+    sf::SoundBuffer& getSoundBuffer(const std::string&);
+
     void handleDisconnect();
 
     void updateLoadingScreen(float, sf::RenderWindow&) override;
@@ -189,7 +189,7 @@ void GameState::loadUI()
 
 
     xy::SpriteSheet spriteSheet;
-    spriteSheet.loadFromFile("assets/sprites/lobby.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/lobby.spt", *m_sharedData.gameResources);
     Avatars[UI::SpriteID::Bot] = spriteSheet.getSprite("bot_icon");
     Avatars[UI::SpriteID::PlayerOneIcon] = spriteSheet.getSprite("player_one");
     Avatars[UI::SpriteID::PlayerTwoIcon] = spriteSheet.getSprite("player_two");
@@ -197,7 +197,7 @@ void GameState::loadUI()
     Avatars[UI::SpriteID::PlayerFourIcon] = spriteSheet.getSprite("player_four");
 
 
-    spriteSheet.loadFromFile("assets/sprites/hud.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/hud.spt", *m_sharedData.gameResources);
 
     //inventory display
     auto entity = m_uiScene.createEntity();
@@ -346,7 +346,7 @@ void GameState::loadUI()
     entity.addComponent<xy::Transform>();
     entity.getComponent<xy::Transform>().setScale(4.f, 4.f);
     entity.addComponent<xy::Drawable>().setDepth(20000);
-    entity.addComponent<xy::Sprite>(m_textureResource.get("assets/images/red_drapes.png"));
+    entity.addComponent<xy::Sprite>(getTexture("assets/images/red_drapes.png"));
     entity.addComponent<xy::CommandTarget>().ID = UI::CommandID::Curtain;
     entity.addComponent<xy::Callback>().function =
         [&](xy::Entity ent, float dt)
@@ -427,7 +427,7 @@ void GameState::loadRoundEnd()
     //once the game has ended
     auto parentEntity = m_uiScene.createEntity();
     parentEntity.addComponent<xy::Transform>();
-    parentEntity.addComponent<xy::Sprite>(m_textureResource.get("assets/images/summary_window.png"));
+    parentEntity.addComponent<xy::Sprite>(getTexture("assets/images/summary_window.png"));
     parentEntity.addComponent<xy::Drawable>().setDepth(-200);
     //auto bounds = parentEntity.getComponent<xy::Sprite>().getTextureBounds();
     parentEntity.getComponent<xy::Transform>().setPosition(UI::RoundScreenOffPosition);
@@ -453,7 +453,7 @@ void GameState::loadRoundEnd()
     //trophy sprites
     std::array<int, 4u> IDs = { UI::CommandID::TrophyOne, UI::CommandID::TrophyTwo, UI::CommandID::TrophyThree, UI::CommandID::TrophyFour };
     xy::SpriteSheet spriteSheet;
-    spriteSheet.loadFromFile("assets/sprites/trophies.spt", m_textureResource);
+    spriteSheet.loadFromFile("assets/sprites/trophies.spt", *m_sharedData.gameResources);
     for (auto i = 0u; i < TrophyPositions.size(); ++i)
     {
         entity = m_uiScene.createEntity();
@@ -628,7 +628,7 @@ void GameState::showEndButton()
 
     auto entity = m_uiScene.createEntity();
     entity.addComponent<xy::Drawable>();
-    entity.addComponent<xy::Sprite>(m_textureResource.get("assets/images/buttons.png"));
+    entity.addComponent<xy::Sprite>(getTexture("assets/images/buttons.png"));
     auto bounds = entity.getComponent<xy::Sprite>().getTextureRect();
     entity.addComponent<xy::Transform>().setOrigin(bounds.width / 2.f, bounds.height / 2.f);
     entity.addComponent<xy::UIHitBox>().area = bounds;
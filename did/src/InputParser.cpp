@@ -187,7 +187,7 @@ void InputParser::handleEvent(const sf::Event& evt)
 
 void InputParser::update(float dt)
 {
-    m_timeAccumulator += static_cast<std::int32_t>(dt * 1000000.f);
+    m_timeAccumulator += static_cast<std::int64_t>(dt * 1000000.f);
 
     if (!m_playerEntity.isValid()) return;
 
@@ -38,7 +38,7 @@ namespace xy
 
 struct Input final
 {
-    std::int32_t timestamp = 0;
+    std::int64_t timestamp = 0; //microseconds
     float acceleration = 1.f;
     std::uint16_t mask = 0;
 };
@@ -46,7 +46,7 @@ struct Input final
 struct InputUpdate final //encapsulates packets sent to server
 {
     float acceleration = 1.f; //acceleration applied by analogue inputs    
-    std::int32_t clientTime = 0; //client timestamp this input was received
+    std::int64_t clientTime = 0; //client timestamp this input was received
     std::uint16_t input = 0; //input mask
     std::uint8_t playerNumber = 0; //player number
 };
@@ -92,7 +92,7 @@ private:
     sf::Uint16 m_prevStick;
     float m_analogueAmount;
 
-    std::int32_t m_timeAccumulator;
+    std::int64_t m_timeAccumulator;
 
     bool m_enabled;
 
@@ -0,0 +1,170 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "InterpolationBench.hpp"
+#include "InterpolationSystem.hpp"
+
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace
+{
+    const double ServerStep = 1000.0 / 30.0; //ms, matches the server network update
+    const double FrameTime = 1000.0 / 60.0;
+    const double ClockOffset = 12345.0; //server time is ahead of the local clock by this much
+    const double WarmUp = 1000.0; //gives the clock estimate time to settle
+
+    const float Speed = 100.f; //units per second
+    const float MaxMeanError = 1.f;
+    const float MaxError = 16.f;
+
+    struct Path final
+    {
+        sf::Vector2f centre;
+        float radius = 0.f;
+        float phase = 0.f;
+
+        sf::Vector2f getPosition(double time) const
+        {
+            const auto angle = phase + static_cast<float>(time / 1000.0) * (Speed / radius);
+            return centre + sf::Vector2f(std::cos(angle), std::sin(angle)) * radius;
+        }
+    };
+
+    struct Packet final
+    {
+        double arrival = 0.0; //local time
+        std::size_t actor = 0;
+        InterpolationPoint point;
+    };
+}
+
+InterpolationBenchResult runInterpolationBench(const InterpolationBenchSettings& settings)
+{
+    std::mt19937 rndEngine(settings.seed);
+    std::uniform_real_distribution<float> unit(0.f, 1.f);
+
+    std::vector<Path> paths(settings.actorCount);
+    for (auto& path : paths)
+    {
+        path.centre = { unit(rndEngine) * 1000.f, unit(rndEngine) * 1000.f };
+        path.radius = 64.f + unit(rndEngine) * 192.f;
+        path.phase = unit(rndEngine) * 6.283f;
+    }
+
+    //server side - every actor is sent each network step, in the same order
+    const double duration = settings.duration * 1000.0;
+    std::vector<Packet> packets;
+    for (auto serverTime = 0.0; serverTime < duration; serverTime += ServerStep)
+    {
+        //all actors are sent together so arrive with the same delay
+        const auto timestamp = static_cast<std::int32_t>(serverTime);
+        const auto arrival = serverTime - ClockOffset + settings.latency + (unit(rndEngine) * settings.jitter);
+        for (auto i = 0u; i < paths.size(); ++i)
+        {
+            if (unit(rndEngine) < settings.loss)
+            {
+                continue;
+            }
+
+            Packet packet;
+            packet.arrival = arrival;
+            packet.actor = i;
+            packet.point.position = paths[i].getPosition(timestamp);
+            packet.point.timestamp = timestamp;
+            packets.push_back(packet);
+        }
+    }
+    std::stable_sort(packets.begin(), packets.end(),
+        [](const Packet& a, const Packet& b)
+        {
+            return a.arrival < b.arrival;
+        });
+
+    //client side
+    ServerClock serverClock;
+    SnapshotHistory history;
+    std::vector<std::size_t> slots(paths.size());
+    for (auto& slot : slots)
+    {
+        slot = history.addSlot();
+    }
+
+    double totalError = 0.0;
+    float maxError = 0.f;
+    std::size_t sampleCount = 0;
+    std::size_t extrapolatedCount = 0;
+    std::int64_t sampleTime = 0;
+    std::vector<sf::Vector2f> positions(paths.size());
+
+    auto packet = packets.cbegin();
+    const double start = -ClockOffset;
+    for (auto localTime = start; localTime < start + duration; localTime += FrameTime)
+    {
+        //packets are only read once per frame
+        while (packet != packets.cend() && packet->arrival <= localTime)
+        {
+            serverClock.addSample(packet->point.timestamp, localTime);
+            history.push(slots[packet->actor], packet->point);
+            ++packet;
+        }
+
+        const auto renderTime = serverClock.getRenderTime(localTime);
+        if (localTime - start < WarmUp)
+        {
+            continue;
+        }
+
+        sf::Clock timer;
+        for (auto i = 0u; i < paths.size(); ++i)
+        {
+            float rotation = 0.f;
+            if (history.sample(slots[i], renderTime, positions[i], rotation) == SnapshotHistory::Extrapolated)
+            {
+                extrapolatedCount++;
+            }
+        }
+        sampleTime += timer.getElapsedTime().asMicroseconds();
+
+        for (auto i = 0u; i < paths.size(); ++i)
+        {
+            const auto diff = positions[i] - paths[i].getPosition(renderTime);
+            const auto error = std::sqrt((diff.x * diff.x) + (diff.y * diff.y));
+            totalError += error;
+            maxError = std::max(maxError, error);
+            sampleCount++;
+        }
+    }
+
+    InterpolationBenchResult result;
+    if (sampleCount)
+    {
+        result.meanError = static_cast<float>(totalError / sampleCount);
+        result.maxError = maxError;
+        result.extrapolated = static_cast<float>(extrapolatedCount) / sampleCount;
+        result.sampleTime = static_cast<float>(sampleTime * 1000) / sampleCount;
+    }
+    result.delay = static_cast<float>(serverClock.getDelay());
+    result.passed = sampleCount && result.meanError < MaxMeanError && result.maxError < MaxError;
+
+    return result;
+}
@@ -0,0 +1,51 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+Feeds a synthetic stream of actor snapshots through the same ServerClock
+and SnapshotHistory used by the InterpolationSystem, with simulated packet
+loss, latency and jitter, and compares the sampled positions with the
+actual path of each actor. The simulation runs on its own timeline so the
+results are the same for the same settings and seed, apart from the timing.
+*/
+struct InterpolationBenchSettings final
+{
+    float loss = 0.f; //probability of each snapshot being dropped
+    float jitter = 0.f; //max additional latency of each update in ms
+    float latency = 50.f;
+    std::size_t actorCount = 256;
+    float duration = 20.f; //seconds
+    std::uint32_t seed = 1234;
+};
+
+struct InterpolationBenchResult final
+{
+    float meanError = 0.f;
+    float maxError = 0.f;
+    float extrapolated = 0.f; //proportion of samples
+    float delay = 0.f; //final interpolation delay in ms
+    float sampleTime = 0.f; //ns per actor per frame
+    bool passed = false;
+};
+
+InterpolationBenchResult runInterpolationBench(const InterpolationBenchSettings&);
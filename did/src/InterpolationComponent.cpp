@@ -29,10 +29,9 @@ source distribution.
 
 InterpolationComponent::InterpolationComponent(InterpolationPoint initialPoint)
     : m_enabled         (true),
-    m_targetPoint       (initialPoint),
-    m_previousPoint     (initialPoint),
-    m_timeDifference    (0.0001f),
-    m_started           (false)
+    m_initialPoint      (initialPoint),
+    m_system            (nullptr),
+    m_slot              (0)
 {
 
 }
@@ -40,16 +39,14 @@ InterpolationComponent::InterpolationComponent(InterpolationPoint initialPoint)
 //public
 void InterpolationComponent::setTarget(const InterpolationPoint& target)
 {
-    if(m_buffer.size() < m_buffer.capacity())
+    if (m_system)
     {
-        m_buffer.push_back(target);
+        m_system->addSnapshot(m_slot, target);
     }
-
-    if (!m_started && m_buffer.size() == m_buffer.capacity())
+    else if (target.timestamp > m_initialPoint.timestamp)
     {
-        m_started = true;
+        m_initialPoint = target;
     }
-    applyNextTarget();
 }
 
 void InterpolationComponent::setEnabled(bool enabled)
@@ -64,32 +61,24 @@ bool InterpolationComponent::getEnabled() const
 
 void InterpolationComponent::resetPosition(sf::Vector2f position)
 {
-    m_previousPoint.position = m_targetPoint.position = position;
-    m_buffer.clear();
-    m_started = false;
+    if (m_system)
+    {
+        m_system->resetSnapshot(m_slot, position);
+    }
+    else
+    {
+        m_initialPoint.position = position;
+    }
 }
 
 void InterpolationComponent::resetRotation(float rotation)
 {
-    m_previousPoint.rotation = m_targetPoint.rotation = rotation;
-}
-
-//private
-void InterpolationComponent::applyNextTarget()
-{
-    if (m_started && m_buffer.size() > 0)
+    if (m_system)
     {
-        InterpolationPoint target;
-        while (m_buffer.size() > 0 &&
-            target.timestamp <= m_targetPoint.timestamp)
-        {
-            target = m_buffer.pop_front();
-        }
-
-        m_previousPoint = m_targetPoint;
-        m_elapsedTime.restart();
-        auto targetTimestamp = static_cast<float>(target.timestamp) / 1000.f;
-        m_timeDifference = targetTimestamp - static_cast<float>(m_previousPoint.timestamp) / 1000.f;
-        m_targetPoint = target;
+        m_system->resetRotation(m_slot, rotation);
     }
-}
\ No newline at end of file
+    else
+    {
+        m_initialPoint.rotation = rotation;
+    }
+}
@@ -32,10 +32,23 @@ source distribution.
 
 #include <xyginext/util/Vector.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace
 {
     const float MaxDistSqr = 460.f * 460.f; //if we're bigger than this go straight to dest to hide flickering
 
+    const double SnapshotInterval = 1000.0 / 30.0; //rate at which the server sends actor updates
+    const double MinDelay = SnapshotInterval * 2.0; //enough to cover a single lost snapshot
+    const double MaxDelay = 250.0;
+    const double JitterScale = 3.0;
+    const double OffsetSmoothing = 0.05;
+    const double JitterSmoothing = 1.0 / 16.0;
+    const double ResetThreshold = 1000.0; //server clock is assumed to have been restarted if it jumps by more than this
+    const double MaxExtrapolation = 100.0;
+
     float linearInterpRotation(float a, float b, float t)
     {
         return a + (t * (xy::Util::Math::shortestRotation(a, b)));
@@ -43,8 +56,232 @@ namespace
     }
 }
 
+//server clock
+void ServerClock::addSample(std::int32_t serverTime, double localTime)
+{
+    const double offset = static_cast<double>(serverTime) - localTime;
+    const double deviation = offset - m_offset;
+
+    if (!m_started
+        || std::abs(deviation) > ResetThreshold)
+    {
+        m_lastServerTime = serverTime;
+        m_offset = offset;
+        m_jitter = 0.0;
+        m_renderTime = std::numeric_limits<double>::lowest();
+        m_started = true;
+        return;
+    }
+
+    //every actor in an update shares the same timestamp, only the
+    //first to arrive is used so that each update is weighted equally
+    if (serverTime <= m_lastServerTime)
+    {
+        return;
+    }
+    m_lastServerTime = serverTime;
+
+    m_offset += deviation * OffsetSmoothing;
+    m_jitter += (std::abs(deviation) - m_jitter) * JitterSmoothing;
+}
+
+double ServerClock::getRenderTime(double localTime)
+{
+    const double target = localTime + m_offset - getDelay();
+
+    //hold rather than step backwards when the delay grows, but
+    //follow the server if its clock was restarted
+    if (target > m_renderTime
+        || m_renderTime - target > ResetThreshold)
+    {
+        m_renderTime = target;
+    }
+    return m_renderTime;
+}
+
+double ServerClock::getDelay() const
+{
+    return std::min(MinDelay + (m_jitter * JitterScale), MaxDelay);
+}
+
+void ServerClock::reset()
+{
+    m_offset = 0.0;
+    m_jitter = 0.0;
+    m_renderTime = 0.0;
+    m_lastServerTime = 0;
+    m_started = false;
+}
+
+//snapshot history
+std::size_t SnapshotHistory::addSlot()
+{
+    std::size_t slot = 0;
+    if (!m_freeSlots.empty())
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        slot = m_count.size();
+        m_head.push_back(0);
+        m_count.push_back(0);
+
+        const auto size = m_count.size() * RingSize;
+        m_positionX.resize(size);
+        m_positionY.resize(size);
+        m_rotation.resize(size);
+        m_timestamp.resize(size);
+    }
+
+    m_head[slot] = 0;
+    m_count[slot] = 0;
+    return slot;
+}
+
+void SnapshotHistory::removeSlot(std::size_t slot)
+{
+    m_count[slot] = 0;
+    m_freeSlots.push_back(slot);
+}
+
+void SnapshotHistory::push(std::size_t slot, const InterpolationPoint& point)
+{
+    const auto base = slot * RingSize;
+    if (m_count[slot] > 0)
+    {
+        const auto newest = m_timestamp[base + ((m_head[slot] + RingSize - 1) % RingSize)];
+        if (point.timestamp <= newest)
+        {
+            if (newest - point.timestamp < ResetThreshold)
+            {
+                //out of order or duplicate
+                return;
+            }
+            m_count[slot] = 0;
+        }
+    }
+
+    const auto index = base + m_head[slot];
+    m_positionX[index] = point.position.x;
+    m_positionY[index] = point.position.y;
+    m_rotation[index] = point.rotation;
+    m_timestamp[index] = point.timestamp;
+
+    m_head[slot] = static_cast<std::uint8_t>((m_head[slot] + 1) % RingSize);
+    m_count[slot] = static_cast<std::uint8_t>(std::min(m_count[slot] + 1u, static_cast<unsigned>(RingSize)));
+}
+
+void SnapshotHistory::reset(std::size_t slot, const InterpolationPoint& point)
+{
+    m_count[slot] = 0;
+    push(slot, point);
+}
+
+void SnapshotHistory::resetRotation(std::size_t slot, float rotation)
+{
+    const auto base = slot * RingSize;
+    std::fill(m_rotation.begin() + base, m_rotation.begin() + base + RingSize, rotation);
+}
+
+InterpolationPoint SnapshotHistory::getNewest(std::size_t slot, const InterpolationPoint& defaultPoint) const
+{
+    if (m_count[slot] == 0)
+    {
+        return defaultPoint;
+    }
+
+    const auto index = slot * RingSize + ((m_head[slot] + RingSize - 1) % RingSize);
+
+    InterpolationPoint point;
+    point.position = { m_positionX[index], m_positionY[index] };
+    point.rotation = m_rotation[index];
+    point.timestamp = m_timestamp[index];
+    return point;
+}
+
+SnapshotHistory::SampleResult SnapshotHistory::sample(std::size_t slot, double time, sf::Vector2f& position, float& rotation) const
+{
+    const std::size_t count = m_count[slot];
+    if (count == 0)
+    {
+        return Empty;
+    }
+
+    const auto base = slot * RingSize;
+    const auto first = m_head[slot] + RingSize - count;
+    const auto index = [base, first](std::size_t i)
+    {
+        return base + ((first + i) % RingSize);
+    };
+
+    const auto newest = index(count - 1);
+    if (time >= m_timestamp[newest])
+    {
+        position = { m_positionX[newest], m_positionY[newest] };
+        rotation = m_rotation[newest];
+
+        if (time == m_timestamp[newest])
+        {
+            return Interpolated;
+        }
+
+        //packets are late - continue along the last known path for a short while
+        if (count > 1)
+        {
+            const auto previous = index(count - 2);
+            const auto timeDiff = static_cast<double>(m_timestamp[newest] - m_timestamp[previous]);
+            const sf::Vector2f diff(m_positionX[newest] - m_positionX[previous], m_positionY[newest] - m_positionY[previous]);
+
+            if (timeDiff > 0 && xy::Util::Vector::lengthSquared(diff) < MaxDistSqr)
+            {
+                const auto elapsed = std::min(time - m_timestamp[newest], MaxExtrapolation);
+                position += diff * static_cast<float>(elapsed / timeDiff);
+            }
+        }
+        return Extrapolated;
+    }
+
+    //find the newest snapshot at or before the given time
+    auto i = count - 1;
+    while (i > 0 && m_timestamp[index(i - 1)] > time)
+    {
+        i--;
+    }
+
+    const auto target = index(i);
+    if (i == 0)
+    {
+        //older than anything we have
+        position = { m_positionX[target], m_positionY[target] };
+        rotation = m_rotation[target];
+        return Interpolated;
+    }
+
+    const auto previous = index(i - 1);
+    const sf::Vector2f diff(m_positionX[target] - m_positionX[previous], m_positionY[target] - m_positionY[previous]);
+
+    //jump if a very large difference
+    if (xy::Util::Vector::lengthSquared(diff) > MaxDistSqr)
+    {
+        position = { m_positionX[target], m_positionY[target] };
+        rotation = m_rotation[target];
+        return Interpolated;
+    }
+
+    const auto t = static_cast<float>((time - m_timestamp[previous]) / static_cast<double>(m_timestamp[target] - m_timestamp[previous]));
+    position = sf::Vector2f(m_positionX[previous], m_positionY[previous]) + (diff * t);
+    rotation = linearInterpRotation(m_rotation[previous], m_rotation[target], t);
+    return Interpolated;
+}
+
+//system
 InterpolationSystem::InterpolationSystem(xy::MessageBus& mb)
-    : System(mb, typeid(InterpolationSystem))
+    : System            (mb, typeid(InterpolationSystem)),
+    m_renderTime        (0.0),
+    m_extrapolatedCount (0),
+    m_processTime       (0)
 {
     requireComponent<xy::Transform>();
     requireComponent<InterpolationComponent>();
@@ -53,50 +290,82 @@ InterpolationSystem::InterpolationSystem(xy::MessageBus& mb)
 //public
 void InterpolationSystem::process(float)
 {
+    sf::Clock timer;
+
+    //every entity is sampled at the same point on the server's timeline
+    m_renderTime = m_serverClock.getRenderTime(getLocalTime());
+    m_extrapolatedCount = 0;
+
     auto& entities = getEntities();
     for (auto& entity : entities)
     {
-        auto& tx = entity.getComponent<xy::Transform>();
         auto& interp = entity.getComponent<InterpolationComponent>();
-        
-        //jump if a very large difference
-        auto diff = (interp.m_targetPoint.position - interp.m_previousPoint.position);
-        if (xy::Util::Vector::lengthSquared(diff) > MaxDistSqr)
+        if (!interp.m_enabled)
         {
-            if (interp.m_enabled)
-            {
-                tx.setPosition(interp.m_targetPoint.position);
-                tx.setRotation(interp.m_targetPoint.rotation);
-
-                interp.applyNextTarget();
-            }
             continue;
         }
 
-        //previous position + diff * timePassed
-        if (interp.m_enabled)
+        sf::Vector2f position;
+        float rotation = 0.f;
+        auto result = m_history.sample(interp.m_slot, m_renderTime, position, rotation);
+        if (result != SnapshotHistory::Empty)
         {
-            float currTime = std::min(interp.m_elapsedTime.getElapsedTime().asSeconds() / interp.m_timeDifference, 1.f);
+            auto& tx = entity.getComponent<xy::Transform>();
+            tx.setPosition(position);
+            tx.setRotation(rotation);
 
-            if (currTime < 1)
+            if (result == SnapshotHistory::Extrapolated)
             {
-                tx.setRotation(linearInterpRotation(interp.m_previousPoint.rotation, interp.m_targetPoint.rotation, currTime));
-                tx.setPosition(interp.m_previousPoint.position + (diff * currTime));
-            }
-            else
-            {
-                tx.setPosition(interp.m_targetPoint.position);
-                tx.setRotation(interp.m_targetPoint.rotation);
-
-                //shift interp target to next in buffer if available
-                interp.applyNextTarget();
+                m_extrapolatedCount++;
             }
         }
     }
+
+    m_processTime = timer.getElapsedTime().asMicroseconds();
 }
 
 //private
-void InterpolationSystem::onEntityAdded(xy::Entity)
+double InterpolationSystem::getLocalTime() const
 {
+    return static_cast<double>(m_clock.getElapsedTime().asMicroseconds()) / 1000.0;
+}
 
+void InterpolationSystem::addSnapshot(std::size_t slot, const InterpolationPoint& point)
+{
+    m_serverClock.addSample(point.timestamp, getLocalTime());
+    m_history.push(slot, point);
+}
+
+void InterpolationSystem::resetSnapshot(std::size_t slot, sf::Vector2f position)
+{
+    //hold the new position from the current render time until
+    //the next snapshot arrives
+    auto point = m_history.getNewest(slot, {});
+    point.position = position;
+    point.timestamp = static_cast<std::int32_t>(std::floor(m_renderTime));
+    m_history.reset(slot, point);
+}
+
+void InterpolationSystem::resetRotation(std::size_t slot, float rotation)
+{
+    m_history.resetRotation(slot, rotation);
+}
+
+void InterpolationSystem::onEntityAdded(xy::Entity entity)
+{
+    auto& interp = entity.getComponent<InterpolationComponent>();
+    interp.m_system = this;
+    interp.m_slot = m_history.addSlot();
+    m_history.reset(interp.m_slot, interp.m_initialPoint);
+
+    if (m_slots.size() <= entity.getIndex())
+    {
+        m_slots.resize(entity.getIndex() + 1);
+    }
+    m_slots[entity.getIndex()] = interp.m_slot;
+}
+
+void InterpolationSystem::onEntityRemoved(xy::Entity entity)
+{
+    m_history.removeSlot(m_slots[entity.getIndex()]);
 }
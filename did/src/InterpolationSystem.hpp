@@ -27,9 +27,13 @@ source distribution.
 
 #pragma once
 
-#include "CircularBuffer.hpp"
 #include <xyginext/ecs/System.hpp>
 
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <cstdint>
+#include <vector>
 
 /*!
 \brief Contains information required for a inperpolation to occur
@@ -41,18 +45,132 @@ struct InterpolationPoint final
     std::int32_t timestamp = 0;
 };
 
+/*!
+\brief Estimates the offset between the local clock and the server
+clock from the timestamps of incoming snapshots, along with the
+variation (jitter) in their arrival times. The render time is the
+estimated server time, delayed far enough that there are usually
+two snapshots to interpolate between.
+All times are in milliseconds.
+*/
+class ServerClock final
+{
+public:
+    /*!
+    \brief Adds a snapshot received at the given local time
+    */
+    void addSample(std::int32_t serverTime, double localTime);
+
+    /*!
+    \brief Returns the time on the server's timeline at which
+    snapshots should be displayed for the given local time.
+    This never goes backwards, unless the server clock is reset.
+    */
+    double getRenderTime(double localTime);
+
+    /*!
+    \brief Returns the estimated difference between server and local time
+    */
+    double getOffset() const { return m_offset; }
+
+    /*!
+    \brief Returns the average variation in snapshot arrival times
+    */
+    double getJitter() const { return m_jitter; }
+
+    /*!
+    \brief Returns the current interpolation delay
+    */
+    double getDelay() const;
+
+    void reset();
+
+private:
+    double m_offset = 0.0;
+    double m_jitter = 0.0;
+    double m_renderTime = 0.0;
+    std::int32_t m_lastServerTime = 0;
+    bool m_started = false;
+};
+
+/*!
+\brief History of received snapshots for a set of actors.
+Each actor is assigned a slot, and each slot is a ring of the
+most recent snapshots stored as separate arrays of x, y, rotation
+and timestamp.
+*/
+class SnapshotHistory final
+{
+public:
+    static constexpr std::size_t RingSize = 8;
+
+    std::size_t addSlot();
+    void removeSlot(std::size_t);
+
+    /*!
+    \brief Adds a snapshot to the slot. Snapshots older than the
+    newest in the slot are dropped, unless they are far enough in
+    the past that the server clock has been reset.
+    */
+    void push(std::size_t slot, const InterpolationPoint&);
+
+    /*!
+    \brief Replaces the history of the slot with a single point
+    */
+    void reset(std::size_t slot, const InterpolationPoint&);
+
+    /*!
+    \brief Replaces the rotation of all snapshots in the slot
+    */
+    void resetRotation(std::size_t slot, float);
+
+    /*!
+    \brief Returns the newest snapshot in the slot, or the given
+    default if the slot is empty
+    */
+    InterpolationPoint getNewest(std::size_t slot, const InterpolationPoint&) const;
+
+    enum SampleResult
+    {
+        Empty, Interpolated, Extrapolated
+    };
+
+    /*!
+    \brief Samples the slot at the given server time.
+    If the time is newer than the newest snapshot the motion
+    between the last two snapshots is extrapolated, up to
+    MaxExtrapolation milliseconds, after which the actor is held.
+    */
+    SampleResult sample(std::size_t slot, double time, sf::Vector2f& position, float& rotation) const;
+
+private:
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_rotation;
+    std::vector<std::int32_t> m_timestamp;
+
+    //per slot
+    std::vector<std::uint8_t> m_head; //next write
+    std::vector<std::uint8_t> m_count;
+
+    std::vector<std::size_t> m_freeSlots;
+};
+
+class InterpolationSystem;
+
 /*!
 \brief Interpolates positionand rotation received from a server.
 When receiving infrequent (say 100ms or so) position updates from
 a remote server entities can have their position interpolated via
 this component. The component, when coupled with an InterpolationSystem
-will travel towards the given target position using the given timestamp
-to linearly interpolate movement. This component is not limited to
+will be placed at the position it had on the server a short time ago,
+interpolated between the received snapshots. All components are
+sampled at the same point in time, measured by a single clock owned
+by the InterpolationSystem. This component is not limited to
 networked entities, and can be used anywhere linear interpolation of
 movement is desired, for example path finding.
 
 Requires:
-    CircularBuffer.hpp
     InterpolationSystem.hpp
     InterpolationSystem.cpp
     InterpolationComponent.cpp
@@ -70,14 +188,10 @@ public:
     explicit InterpolationComponent(InterpolationPoint = {});
 
     /*!
-    \brief Sets the target position and timestamp.
-    The timestamp is used in conjunction with the previous timestamp
-    to decide how quickly motion should be integrated between positions.
+    \brief Adds a snapshot of the position and timestamp.
     The timestamp would usually be in server time, and arrive in the packet
-    data with the destination postion, in milliseconds.
-    \param pos Target destination
-    \param timestamp Time at which this position should be reached, relative
-    to the previous position.
+    data with the destination postion, in milliseconds. It is also used to
+    estimate the server clock, so should not come from any other source.
     */
     void setTarget(const InterpolationPoint&);
 
@@ -103,18 +217,14 @@ public:
 
 private:
     bool m_enabled;
-    InterpolationPoint m_targetPoint;
-    InterpolationPoint m_previousPoint;
 
-    sf::Clock m_elapsedTime;
-    float m_timeDifference;
+    //used until the component is added to a system
+    InterpolationPoint m_initialPoint;
 
-    CircularBuffer<InterpolationPoint, 4u> m_buffer;
-    bool m_started;
+    InterpolationSystem* m_system;
+    std::size_t m_slot;
 
     friend class InterpolationSystem;
-
-    void applyNextTarget();
 };
 
 /*!
@@ -129,7 +239,38 @@ public:
 
     void process(float) override;
 
+    const ServerClock& getServerClock() const { return m_serverClock; }
+
+    /*!
+    \brief Returns the number of entities extrapolated last frame
+    */
+    std::size_t getExtrapolatedCount() const { return m_extrapolatedCount; }
+
+    /*!
+    \brief Returns the time taken by the last call to process()
+    in microseconds
+    */
+    std::int64_t getProcessTime() const { return m_processTime; }
+
 private:
+    sf::Clock m_clock;
+    ServerClock m_serverClock;
+    SnapshotHistory m_history;
+    double m_renderTime;
+
+    //slot assigned to each entity index
+    std::vector<std::size_t> m_slots;
+
+    std::size_t m_extrapolatedCount;
+    std::int64_t m_processTime;
+
+    double getLocalTime() const;
+
+    friend class InterpolationComponent;
+    void addSnapshot(std::size_t, const InterpolationPoint&);
+    void resetSnapshot(std::size_t, sf::Vector2f);
+    void resetRotation(std::size_t, float);
 
     void onEntityAdded(xy::Entity) override;
+    void onEntityRemoved(xy::Entity) override;
 };
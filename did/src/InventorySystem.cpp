@@ -23,6 +23,7 @@ Copyright 2019 Matt Marchant
 #include "PacketTypes.hpp"
 #include "ServerRandom.hpp"
 #include "GlobalConsts.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/Entity.hpp>
 
@@ -163,6 +164,8 @@ void InventorySystem::handleMessage(const xy::Message& msg)
 
 void InventorySystem::process(float)
 {
+    Server::ProfileScope profile(Server::ProfileID::InventorySystem);
+
     auto& entities = getEntities();
 
     for(auto entity : entities)
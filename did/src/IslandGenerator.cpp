@@ -17,28 +17,26 @@ Copyright 2019 Matt Marchant
 *********************************************************************/
 
 #include "IslandGenerator.hpp"
-#include "glad/glad.h"
 #include "fastnoise/FastNoiseSIMD.h"
-#include "ServerRandom.hpp"
 #include "Actor.hpp"
 
 #include <xyginext/core/Log.hpp>
+#include <xyginext/core/FileSystem.hpp>
 #include <xyginext/util/Math.hpp>
 #include <xyginext/util/Vector.hpp>
 #include <xyginext/util/Random.hpp>
-#include <xyginext/resources/Resource.hpp>
 
-#include <SFML/Graphics/Sprite.hpp>
-#include <SFML/Graphics/Shader.hpp>
-#include <SFML/Graphics/RectangleShape.hpp>
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Thread.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 using fn = FastNoiseSIMD;
 
 namespace
 {
-    const sf::Vector2u NormalMapSize(Global::IslandSize/* / 2.f*/);
-    const float OutlinePixelOffset = 1.f / (Global::IslandSize.x /*/ 4.f*/);
-
     enum TileType
     {
         DarkSand = 2,
@@ -48,84 +46,77 @@ namespace
 
     const float BoatRadSqr = (Global::BoatRadius * 3.5f) * (Global::BoatRadius * 3.5f);
 
-    //converts the rendered heightmap to a normal map
-const std::string& NormalFrag =
-R"(
-#version 120
-            
-uniform sampler2D u_texture;
-uniform float u_textureSize;
+    //increment this whenever the generator output changes
+    //so that out of date cache files are regenerated
+    const std::uint16_t CacheVersion = 1;
+    const std::uint32_t CacheIdent = 0x49444944; //DIDI
 
-const float strength = 0.65;
+    struct CacheHeader final
+    {
+        std::uint32_t ident = CacheIdent;
+        std::uint16_t version = CacheVersion;
+        std::uint16_t padding = 0;
+        std::int32_t seed = 0;
+        std::uint32_t treasureCount = 0;
+        std::uint32_t spawnCount = 0;
+    };
 
-void main()
-{
-    float pixelSize = 1.0 / u_textureSize;
-    vec2 uv = gl_TexCoord[0].xy;
-
-    //sample surrounding pixels
-    float tl = texture2D(u_texture, uv + (pixelSize * vec2(-1.0, -1.0))).r;
-    float l = texture2D(u_texture, uv + (pixelSize * vec2(-1.0, 0.0))).r;
-    float bl = texture2D(u_texture, uv + (pixelSize * vec2(-1.0, 1.0))).r;
-    float t = texture2D(u_texture, uv + (pixelSize * vec2(0.0, -1.0))).r;
-    float b = texture2D(u_texture, uv + (pixelSize * vec2(0.0, 1.0))).r;
-    float tr = texture2D(u_texture, uv + (pixelSize * vec2(1.0, -1.0))).r;
-    float r = texture2D(u_texture, uv + (pixelSize * vec2(1.0, 0.0))).r;
-    float br = texture2D(u_texture, uv + (pixelSize * vec2(1.0, 1.0))).r;
-
-    //sobel
-    // -1 0 1
-    // -2 0 2
-    // -1 0 1
-    float dx = tr + (2.0 * r) + br - tl - (2.0 * l) - bl;
-
-    // -1 -2 -1
-    //  0  0  0
-    //  1  2  1
-    float dy = tl + (2.0 * t) + tr - bl - (2.0 * b) - br;
-
-    vec3 normal = normalize(vec3(-dx * strength, -dy * strength, 1.0));
-
-    gl_FragColor = vec4(normal * 0.5 + 0.5, 1.0);
-})";
-
-//draws outline used in wave texture
-const std::string OutlineFrag =
-R"(
-#version 120
-
-uniform sampler2D u_texture;
-uniform float u_pixelOffset;
-
-const float Thickness = 2.0;
-
-void main()
-{
-    vec2 uv = gl_TexCoord[0].xy;
-    float baseAlpha = texture2D(u_texture, uv).a;
-    float alpha = Thickness * 4.0 * baseAlpha;
+    struct CacheSpawn final
+    {
+        float x = 0.f;
+        float y = 0.f;
+        std::int32_t id = 0;
+    };
 
-    for(float i = 1.0; i <= Thickness; ++i)
+    //marching squares pass which converts tile types to tile indices
+    void processTileEdges(const TileArray& src, TileArray& dst)
     {
-        alpha -= texture2D(u_texture, uv - vec2(u_pixelOffset * i, 0.0f)).a;
-        alpha -= texture2D(u_texture, uv - vec2(-u_pixelOffset * i, 0.0f)).a;
-        alpha -= texture2D(u_texture, uv - vec2(0.0f, u_pixelOffset * i)).a;
-        alpha -= texture2D(u_texture, uv - vec2(0.0f, -u_pixelOffset * i)).a;
-    }
+        dst = src;
+
+        auto offsetVal =
+            [&src](std::size_t x, std::size_t y)->int
+        {
+            return src[y * (Global::TileCountX) + x];
+        };
+
+        for (auto y = 1u; y < Global::TileCountY - 1; ++y)
+        {
+            for (auto x = 1u; x < Global::TileCountX - 1; ++x)
+            {
+                std::size_t i = y * Global::TileCountX + x;
+
+                auto TL = offsetVal(x, y);
+                auto TR = offsetVal(x + 1, y);
+                auto BL = offsetVal(x, y + 1);
+                auto BR = offsetVal(x + 1, y + 1);
+
+                auto hTL = TL >> 1;
+                auto hTR = TR >> 1;
+                auto hBL = BL >> 1;
+                auto hBR = BR >> 1;
 
-    float wave = (sin(uv.x * 100.0) + 1.0 / 2.0);
-    wave *= (cos(uv.y * 100.0) + 1.0 / 2.0);
-    wave = clamp(wave + 0.8, 0.0, 1.0);
+                auto saddle = ((TL & 1) + (TR & 1) + (BL & 1) + (BR & 1) + 1) >> 2;
+                auto shape = (hTL & 1) | (hTR & 1) << 1 | (hBL & 1) << 2 | (hBR & 1) << 3;
+                auto ring = (hTL + hTR + hBL + hBR) >> 2;
 
-    vec3 waveColour = vec3(1.0) * clamp(alpha, 0.0, 1.0) * 0.9 * wave;
+                auto row = (ring << 1) | saddle;
+                auto col = shape - (ring & 1);
+                auto index = row * 15 + col;
 
-    gl_FragColor = vec4(waveColour, waveColour.r);// clamp((1.0 - baseAlpha) + (waveColour.b * 0.9999), 0.0, 1.0));
-})";
+                dst[i] = index;
+            }
+        }
+    }
 }
 
 IslandGenerator::IslandGenerator()
     : m_treasureCount   (0),
-    m_edgesProcessed    (false)
+    m_edgesProcessed    (false),
+    m_pathDataReady     (false),
+    m_threaded          (false),
+    m_loadedFromCache   (false),
+    m_generationTime    (0),
+    m_seed              (0)
 {
 
 }
@@ -133,8 +124,104 @@ IslandGenerator::IslandGenerator()
 //public
 void IslandGenerator::generate(int seed)
 {
-    edgeNoise(seed);
+    sf::Clock clock;
+
+    m_seed = seed;
+    m_treasureCount = 0;
+    m_edgesProcessed = false;
+    m_pathDataReady = false;
+    m_actorSpawns.clear();
+
+    m_loadedFromCache = loadCache(seed);
+    if (!m_loadedFromCache)
+    {
+        m_rndEngine.seed(static_cast<std::uint32_t>(seed));
+
+        edgeNoise(seed);
+
+        //the path data only depends on the tiles so is
+        //processed at the same time as the actor spawns
+        auto pathFunc = [&]()
+        {
+            processTileEdges(m_mapData.tileData, m_pathData);
+        };
+        sf::Thread pathThread(pathFunc);
+
+        if (m_threaded)
+        {
+            pathThread.launch();
+            createSpawns();
+            pathThread.wait();
+        }
+        else
+        {
+            createSpawns();
+            pathFunc();
+        }
+        m_pathDataReady = true;
+
+        saveCache(seed);
+    }
+
+    m_generationTime = clock.getElapsedTime().asMicroseconds();
+}
+
+void IslandGenerator::setCacheDirectory(const std::string& path)
+{
+    m_cacheDirectory = path;
 
+    if (!m_cacheDirectory.empty())
+    {
+        if (m_cacheDirectory.back() != '/')
+        {
+            m_cacheDirectory.push_back('/');
+        }
+
+        if (!xy::FileSystem::directoryExists(m_cacheDirectory)
+            && !xy::FileSystem::createDirectory(m_cacheDirectory))
+        {
+            xy::Logger::log("Failed to create island cache directory " + m_cacheDirectory, xy::Logger::Type::Error);
+            m_cacheDirectory.clear();
+        }
+    }
+}
+
+std::vector<std::uint8_t> IslandGenerator::serialise() const
+{
+    CacheHeader header;
+    header.seed = m_seed;
+    header.treasureCount = static_cast<std::uint32_t>(m_treasureCount);
+    header.spawnCount = static_cast<std::uint32_t>(m_actorSpawns.size());
+
+    std::vector<std::uint8_t> data(sizeof(header) + (sizeof(TileArray::data) * 2) + (sizeof(CacheSpawn) * m_actorSpawns.size()));
+    auto* ptr = data.data();
+
+    std::memcpy(ptr, &header, sizeof(header));
+    ptr += sizeof(header);
+
+    std::memcpy(ptr, m_mapData.tileData.data, sizeof(TileArray::data));
+    ptr += sizeof(TileArray::data);
+
+    std::memcpy(ptr, m_pathData.data, sizeof(TileArray::data));
+    ptr += sizeof(TileArray::data);
+
+    for (const auto& spawn : m_actorSpawns)
+    {
+        CacheSpawn cs;
+        cs.x = spawn.position.x;
+        cs.y = spawn.position.y;
+        cs.id = spawn.id;
+
+        std::memcpy(ptr, &cs, sizeof(cs));
+        ptr += sizeof(cs);
+    }
+
+    return data;
+}
+
+//private
+void IslandGenerator::createSpawns()
+{
     static const int beeChance = 140;
     static const int birdChance = 60;
     for (auto i = 0u; i < Global::TileCount; ++i)
@@ -142,7 +229,7 @@ void IslandGenerator::generate(int seed)
         //spawn bees
         if (m_mapData.tileData[i] >= TileType::Grass)
         {
-            if (Server::getRandomInt(0, beeChance) == 0)
+            if (getRandomInt(0, beeChance) == 0)
             {
                 auto x = i % Global::TileCountX;
                 auto y = i / Global::TileCountX;
@@ -151,7 +238,7 @@ void IslandGenerator::generate(int seed)
                 continue; //no chance of spawning birds on top
             }
 
-            if (Server::getRandomInt(0, birdChance) == 0)
+            if (getRandomInt(0, birdChance) == 0)
             {
                 auto x = i % Global::TileCountX;
                 auto y = i / Global::TileCountX;
@@ -161,7 +248,7 @@ void IslandGenerator::generate(int seed)
     }
 
     //chose one of 3 edges for a seagull
-    auto edge = Server::getRandomInt(0, 2);
+    auto edge = getRandomInt(0, 2);
     int x = 0;
     int y = 0;
     switch (edge)
@@ -169,56 +256,56 @@ void IslandGenerator::generate(int seed)
     default:
     case 0:
     {
-        y = Server::getRandomInt(0, Global::TileCountY-6);
+        y = getRandomInt(0, Global::TileCountY-6);
         m_actorSpawns.emplace_back(-64.f, y * Global::TileSize, Actor::Seagull);
     }
         break;
     case 1:
     {
-        x = Server::getRandomInt(0, Global::TileCountX);
+        x = getRandomInt(0, Global::TileCountX);
         m_actorSpawns.emplace_back(x * Global::TileSize, -64.f, Actor::Seagull);
     }
         break;
     case 2:
     {
-        y = Server::getRandomInt(0, Global::TileCountY-6);
+        y = getRandomInt(0, Global::TileCountY-6);
         m_actorSpawns.emplace_back(Global::IslandSize.y + 64.f, y * Global::TileSize, Actor::Seagull);
     }
         break;
     }
 
     //throw in some rocks etc
-    auto rockCount = Server::getRandomInt(1, 4);
+    auto rockCount = getRandomInt(1, 4);
     int startTile = 0;
     for (auto i = 0; i < rockCount; ++i)
     {
-        auto rockY = Server::getRandomInt(startTile, Global::TileCountY - 10);
+        auto rockY = getRandomInt(startTile, Global::TileCountY - 10);
         startTile = std::min(rockY + 1, static_cast<int>(Global::TileCountY - 11));
         if (rockY != y) //don't overlap with seagull
         {
-            m_actorSpawns.emplace_back(-48.f + Server::getRandomFloat(-12.f, 12.f), rockY * Global::TileSize, Actor::WaterDetail);
+            m_actorSpawns.emplace_back(-48.f + getRandomFloat(-12.f, 12.f), rockY * Global::TileSize, Actor::WaterDetail);
         }
     }
-    rockCount = Server::getRandomInt(1, 4);
+    rockCount = getRandomInt(1, 4);
     startTile = 2;
     for (auto i = 0; i < rockCount; ++i)
     {
-        auto rockY = Server::getRandomInt(startTile, Global::TileCountY - 10);
+        auto rockY = getRandomInt(startTile, Global::TileCountY - 10);
         startTile = std::min(rockY + 1, static_cast<int>(Global::TileCountY - 11));
         if (rockY != y) //don't overlap with seagull
         {
-            m_actorSpawns.emplace_back(Global::IslandSize.y + 48.f + Server::getRandomFloat(-12.f, 12.f), rockY * Global::TileSize, Actor::WaterDetail);
+            m_actorSpawns.emplace_back(Global::IslandSize.y + 48.f + getRandomFloat(-12.f, 12.f), rockY * Global::TileSize, Actor::WaterDetail);
         }
     }
-    rockCount = Server::getRandomInt(1, 4);
+    rockCount = getRandomInt(1, 4);
     startTile = 4;
     for (auto i = 0; i < rockCount; ++i)
     {
-        auto rockX = Server::getRandomInt(startTile, Global::TileCountX);
+        auto rockX = getRandomInt(startTile, Global::TileCountX);
         startTile = std::min(rockX + 1, static_cast<int>(Global::TileCountX - 1));
         if (rockX != x) //don't overlap with seagull
         {
-            m_actorSpawns.emplace_back(rockX * Global::TileSize, -48.f + Server::getRandomFloat(-12.f, 12.f), Actor::WaterDetail);
+            m_actorSpawns.emplace_back(rockX * Global::TileSize, -48.f + getRandomFloat(-12.f, 12.f), Actor::WaterDetail);
         }
     }
 
@@ -227,7 +314,7 @@ void IslandGenerator::generate(int seed)
     auto validateSpawn = [&](int& x0, int& y0) //x0,y0 to prevent accidentally capturing x,y above
     {
         //check if it's on solid then move in a random direction until it isn't
-        int up = Server::getRandomInt(0, 1) == 0 ? -2 : 2;
+        int up = getRandomInt(0, 1) == 0 ? -2 : 2;
         while (m_mapData.tileData[y0 * Global::TileCountX + x0] >= TileType::Grass)
         {
             y += up;
@@ -281,8 +368,8 @@ void IslandGenerator::generate(int seed)
     //for (auto i = 0; i < 2; ++i)
     {
         //pick a point at random within 4 tiles from the edge
-        x = Server::getRandomInt(4, Global::TileCountX - 8);
-        y = Server::getRandomInt(4, Global::TileCountY - 8);
+        x = getRandomInt(4, Global::TileCountX - 8);
+        y = getRandomInt(4, Global::TileCountY - 8);
 
         validateSpawn(x, y);
 
@@ -296,7 +383,7 @@ void IslandGenerator::generate(int seed)
     sf::Vector2f offset(6.f , 6.f); //so we'll add it ourself
     auto points = xy::Util::Random::poissonDiscDistribution(
         { 0.f, 0.f, static_cast<float>(Global::TileCountX -  12.f), static_cast<float>( Global::TileCountY - 12.f) },
-        8.f, 15, Server::rndEngine);
+        8.f, 15, m_rndEngine);
 
     const float minTreaureDistance = (8.f * Global::TileSize) * (8.f * Global::TileSize);
     for (auto point : points)
@@ -327,11 +414,11 @@ void IslandGenerator::generate(int seed)
         
         if (canPlace)
         {
-            m_actorSpawns.emplace_back(spawnPos.x, spawnPos.y, Server::getRandomInt(Actor::AmmoSpawn, Actor::CoinSpawn));
+            m_actorSpawns.emplace_back(spawnPos.x, spawnPos.y, getRandomInt(Actor::AmmoSpawn, Actor::CoinSpawn));
         }
     }
 
-    std::shuffle(m_actorSpawns.begin(), m_actorSpawns.end(), Server::rndEngine);
+    std::shuffle(m_actorSpawns.begin(), m_actorSpawns.end(), m_rndEngine);
 
     //convert a few more to treasure
     auto stride = m_actorSpawns.size() / 7; //max extra treasures - we want 5 in total so there should always be at least one winner
@@ -360,176 +447,29 @@ void IslandGenerator::generate(int seed)
     }
 }
 
-void IslandGenerator::render(const TileArray& tileData, xy::TextureResource& tr)
+void IslandGenerator::setTileData(const TileArray& tileData)
 {
-    m_mapData.tileData = tileData;    
-  
+    m_mapData.tileData = tileData;
+
     processFoliage();
 
     //marching square pass
     processEdges();
-
-    if (!m_renderTexture.create(static_cast<int>(Global::IslandSize.x), static_cast<int>(Global::IslandSize.y)))
-    {
-        xy::Logger::log("Failed creating render texture for island generator", xy::Logger::Type::Error);
-    }
-
-    if (!m_normalMapTexture.create(NormalMapSize.x, NormalMapSize.y))
-    {
-        xy::Logger::log("Failed creating normal map render texture for island generator", xy::Logger::Type::Error);
-    }
-
-    if (!m_waveTexture.create(NormalMapSize.x/* / 4*/, NormalMapSize.y /*/ 4*/))
-    {
-        xy::Logger::log("Failed creating wave render texture for island generator", xy::Logger::Type::Error);
-    }   
-    
-    auto details = xy::Util::Random::poissonDiscDistribution(
-        sf::FloatRect(sf::Vector2f(), Global::IslandSize),
-        150.f, 50);
-
-    sf::Texture& tileset = tr.get("assets/images/test_set.png");
-    sf::Texture& detailset = tr.get("assets/images/details.png");
-    sf::Texture& heightset = tr.get("assets/images/test_set_height.png");
-
-    sf::Shader normalShader;
-    normalShader.loadFromMemory(NormalFrag, sf::Shader::Fragment);
-    normalShader.setUniform("u_textureSize", static_cast<float>(NormalMapSize.x));
-    
-    /*if (tileset.loadFromFile("assets/images/test_set.png")
-        && detailset.loadFromFile("assets/images/details.png")
-        && heightset.loadFromFile("assets/images/test_set_height.png"))*/
-    {
-        int tileSetCountX = tileset.getSize().x / static_cast<int>(Global::TileSize);
-        int tileSetCountY = tileset.getSize().y / static_cast<int>(Global::TileSize);
-
-        sf::Sprite sprite(heightset);
-        //sprite.setScale(0.5f, 0.5f); //remember to reset this if changing buffer size
-
-        auto getSubrect = [&tileSetCountX, &tileSetCountY](std::uint8_t idx) ->sf::IntRect
-        {
-            int left = (idx % tileSetCountX) * static_cast<int>(Global::TileSize);
-            int top = (idx / tileSetCountX) * static_cast<int>(Global::TileSize);
-            return { left, top, static_cast<int>(Global::TileSize), static_cast<int>(Global::TileSize) };
-        };
-
-        //normal map
-        sf::RenderTexture tempTexture;
-        tempTexture.create(NormalMapSize.x, NormalMapSize.y);
-        tempTexture.clear(sf::Color::Blue);
-        for (auto i = 0u; i < Global::TileCount; ++i)
-        {
-            sprite.setTextureRect(getSubrect(m_mapData.tileData[i]));
-
-            float posX = ((i % Global::TileCountX) * Global::TileSize);// / 2.f;
-            float posY = ((i / Global::TileCountX) * Global::TileSize);// / 2.f;
-            sprite.setPosition(posX, posY);
-
-            tempTexture.draw(sprite);
-        }
-        tempTexture.display();
-        //render to buffer with normal map shader
-        sprite.setTexture(tempTexture.getTexture(), true);
-        sprite.setPosition(0.f, 0.f);
-        //sprite.setScale(1.f, 1.f);
-        normalShader.setUniform("u_texture", tempTexture.getTexture());
-        m_normalMapTexture.clear(sf::Color::Red);
-        m_normalMapTexture.draw(sprite, &normalShader);
-        m_normalMapTexture.display();
-
-        //colour map
-        //sf::RectangleShape shape({ Global::TileSize, Global::TileSize });
-        sprite.setTexture(tileset);
-        m_renderTexture.clear(sf::Color::Transparent);
-        for (auto i = 0u; i < Global::TileCount; ++i)
-        {
-            sprite.setTextureRect(getSubrect(m_mapData.tileData[i]));
-
-            float posX = (i % Global::TileCountX) * Global::TileSize;
-            float posY = (i / Global::TileCountX) * Global::TileSize;
-            sprite.setPosition(posX, posY);
-
-            m_renderTexture.draw(sprite);
-
-            /*if (tileData[i] < TileType::DarkSand)
-            {
-                shape.setFillColor({ 0, 0, 120, 120 });
-            }
-            else if (tileData[i] < TileType::Grass)
-            {
-                shape.setFillColor({ 0, 120, 0, 120 });
-            }
-            else
-            {
-                shape.setFillColor({ 120, 0, 0, 120 });
-            }
-            shape.setPosition(posX - (Global::TileSize / 2.f), posY - (Global::TileSize / 2.f));
-            m_renderTexture.draw(shape);*/
-        }
-
-        //sprinkle details
-        tileSetCountX = detailset.getSize().x / Global::TileSize;
-        tileSetCountY = detailset.getSize().y / Global::TileSize;
-        auto tileSetCount = tileSetCountX * tileSetCountY;
-
-        sprite.setTexture(detailset);
-
-        for (auto pos : details)
-        {
-            //check we're not in the water
-            auto tileX = std::floor(pos.x / Global::TileSize);
-            auto tileY = std::floor(pos.y / Global::TileSize);
-            int idx = static_cast<int>(tileY) * Global::TileCountX + tileX;
-            
-            if (m_mapData.tileData[idx] == 60 || m_mapData.tileData[idx] == 75)
-            {
-                sprite.setTextureRect(getSubrect(xy::Util::Random::value(0, tileSetCount - 1)));
-                sprite.setPosition(pos);
-                m_renderTexture.draw(sprite);
-            }
-        }
-
-        m_renderTexture.display();
-
-        //take colour map and render outline with it for wave effect
-        sf::Shader outlineShader;
-        outlineShader.loadFromMemory(OutlineFrag, sf::Shader::Fragment);
-        outlineShader.setUniform("u_texture", m_renderTexture.getTexture());
-        outlineShader.setUniform("u_pixelOffset", OutlinePixelOffset);
-
-        sprite.setTexture(m_renderTexture.getTexture(), true);
-        sprite.setPosition(0.f, 0.f);
-        sprite.setScale(1.f, 1.f);
-        m_waveTexture.clear(sf::Color::Transparent);
-        m_waveTexture.draw(sprite, &outlineShader);
-        m_waveTexture.display();
-    }
-    /*else
-    {
-        xy::Logger::log("failed loading island, missing texture", xy::Logger::Type::Error);
-    }*/
-}
-
-const sf::Texture& IslandGenerator::getTexture() const
-{
-    return m_renderTexture.getTexture();
-}
-
-const sf::Texture& IslandGenerator::getNormalMap() const
-{
-    return m_normalMapTexture.getTexture();
-}
-
-const sf::Texture& IslandGenerator::getWaveMap() const
-{
-    return m_waveTexture.getTexture();
 }
 
 const TileArray& IslandGenerator::getPathData()
 {
     if (!m_edgesProcessed)
     {
-        processEdges();
+        if (m_pathDataReady)
+        {
+            m_mapData.tileData = m_pathData;
+            m_edgesProcessed = true;
+        }
+        else
+        {
+            processEdges();
+        }
     }
     return m_mapData.tileData;
 }
@@ -595,12 +535,28 @@ void IslandGenerator::heightNoise(int seed)
 
 void IslandGenerator::edgeNoise(int seed)
 {
-    //creates a 1D noise used to shape the edges of the island
-    auto noise = fn::NewFastNoiseSIMD(seed);
-    noise->SetFractalOctaves(1);
-    noise->SetFrequency(0.05f);
+    //creates a 1D noise used to shape the edges of the island.
+    //This doesn't touch the rng so is built while the base tiles are filled
+    float* landNoise = nullptr;
+    auto noiseFunc = [&landNoise, seed]()
+    {
+        auto noise = fn::NewFastNoiseSIMD(seed);
+        noise->SetFractalOctaves(1);
+        noise->SetFrequency(0.05f);
 
-    auto landNoise = noise->GetSimplexFractalSet(0, 0, 0, (Global::TileCountX * 2) + ((Global::TileCountY * 2) - 4), 1, 1);
+        landNoise = noise->GetSimplexFractalSet(0, 0, 0, (Global::TileCountX * 2) + ((Global::TileCountY * 2) - 4), 1, 1);
+        delete noise;
+    };
+    sf::Thread noiseThread(noiseFunc);
+
+    if (m_threaded)
+    {
+        noiseThread.launch();
+    }
+    else
+    {
+        noiseFunc();
+    }
 
     //as there are 2 rows in the tileset for variations
     //of the same contour, material types change every *2* values
@@ -608,9 +564,11 @@ void IslandGenerator::edgeNoise(int seed)
     for (auto i = 0u; i < Global::TileCount; ++i)
     {
         m_mapData.tileData.data[i] = TileType::LightSand;
-        m_mapData.tileData.data[i] += Server::getRandomInt(0, 1);
+        m_mapData.tileData.data[i] += getRandomInt(0, 1);
     }
 
+    noiseThread.wait();
+
     //lookup func
     auto getVal = [landNoise](std::size_t i) -> int
     {
@@ -631,7 +589,7 @@ void IslandGenerator::edgeNoise(int seed)
         //add two rows of dark sand
         for (auto y = val; y < val + 2; ++y)
         {
-            m_mapData.tileData.data[i + (y * Global::TileCountX)] = TileType::DarkSand + Server::getRandomInt(0, 1);
+            m_mapData.tileData.data[i + (y * Global::TileCountX)] = TileType::DarkSand + getRandomInt(0, 1);
         }
     
     }
@@ -653,7 +611,7 @@ void IslandGenerator::edgeNoise(int seed)
             auto idx = ((i - Global::TileCountX) * Global::TileCountX) + x;
             if (m_mapData.tileData[idx] != 0)
             {
-                m_mapData.tileData.data[idx] = TileType::DarkSand + Server::getRandomInt(0, 1);
+                m_mapData.tileData.data[idx] = TileType::DarkSand + getRandomInt(0, 1);
             }
         }
     }
@@ -678,7 +636,7 @@ void IslandGenerator::edgeNoise(int seed)
             auto idx = col - (Global::TileCountX * y);
             if (m_mapData.tileData[idx] != 0)
             {
-                m_mapData.tileData.data[idx] = TileType::DarkSand + Server::getRandomInt(0, 1);
+                m_mapData.tileData.data[idx] = TileType::DarkSand + getRandomInt(0, 1);
             }
         }
     }
@@ -701,7 +659,7 @@ void IslandGenerator::edgeNoise(int seed)
         {
             if (m_mapData.tileData[x] != 0)
             {
-                m_mapData.tileData.data[x] = TileType::DarkSand + Server::getRandomInt(0, 1);
+                m_mapData.tileData.data[x] = TileType::DarkSand + getRandomInt(0, 1);
 
                 //if tile above or below is water add extra tile
                 //if (m_mapData.tileData[x - Global::TileCountX] == 0
@@ -733,7 +691,7 @@ void IslandGenerator::edgeNoise(int seed)
         //skip at least 2 sand tiles on left
         auto j = i;
         auto edgeCount = 0;
-        auto maxEdges = Server::getRandomInt(2, 4);
+        auto maxEdges = getRandomInt(2, 4);
         while (edgeCount < maxEdges)
         {
             if (m_mapData.tileData[j] >= TileType::LightSand)
@@ -745,49 +703,49 @@ void IslandGenerator::edgeNoise(int seed)
         
         auto rowStart = j;
         auto rowLength = j;
-        maxEdges = Server::getRandomInt(2, 4);
+        maxEdges = getRandomInt(2, 4);
 
         //add grass until 1 from the edge of dark sand
         for (; j < i + Global::TileCountX; ++j)
         {
             if (m_mapData.tileData[j] >= TileType::LightSand && m_mapData.tileData[j+maxEdges] >= TileType::LightSand)
             {
-                m_mapData.tileData.data[j] = Server::getRandomInt(TileType::Grass, TileType::Grass + 1);
+                m_mapData.tileData.data[j] = getRandomInt(TileType::Grass, TileType::Grass + 1);
                 rowLength++;
             }
         }
 
         //add gaps
-        auto gap = Server::getRandomInt(rowStart + 3, rowLength - 6);
+        auto gap = getRandomInt(rowStart + 3, rowLength - 6);
         //try preventing gaps in similar positions across rows
         auto diff = std::abs(lastGap - (gap - static_cast<int>(i)));
         auto tries = 6;
         while (diff < 6 && tries--)
         {
-            gap = Server::getRandomInt(rowStart + 3, rowLength - 6);
+            gap = getRandomInt(rowStart + 3, rowLength - 6);
             diff = std::abs(lastGap - (gap - static_cast<int>(i)));
         }
 
         lastGap = gap - i;
 
-        m_mapData.tileData.data[gap] = TileType::LightSand + Server::getRandomInt(0, 1);;
-        m_mapData.tileData.data[gap + 1] = TileType::LightSand + Server::getRandomInt(0, 1);;
+        m_mapData.tileData.data[gap] = TileType::LightSand + getRandomInt(0, 1);;
+        m_mapData.tileData.data[gap + 1] = TileType::LightSand + getRandomInt(0, 1);;
 
         //add extra gap if gap near one ed or other
         auto relLength = rowLength - i;
         if (lastGap < (relLength / 4))
         {
             auto offset = relLength / 3;
-            m_mapData.tileData.data[gap + offset] = TileType::LightSand + Server::getRandomInt(0, 1);;
-            m_mapData.tileData.data[gap + offset + 1] = TileType::LightSand + Server::getRandomInt(0, 1);
+            m_mapData.tileData.data[gap + offset] = TileType::LightSand + getRandomInt(0, 1);;
+            m_mapData.tileData.data[gap + offset + 1] = TileType::LightSand + getRandomInt(0, 1);
 
             lastGap = (gap + offset) - i;
         }
         else if (lastGap > ((relLength / 4) * 32))
         {
             auto offset = relLength / 3;
-            m_mapData.tileData.data[gap - offset] = TileType::LightSand + Server::getRandomInt(0, 1);;
-            m_mapData.tileData.data[(gap - offset) + 1] = TileType::LightSand + Server::getRandomInt(0, 1);;
+            m_mapData.tileData.data[gap - offset] = TileType::LightSand + getRandomInt(0, 1);;
+            m_mapData.tileData.data[(gap - offset) + 1] = TileType::LightSand + getRandomInt(0, 1);;
             lastGap = (gap - offset) - i;
         } 
 
@@ -842,39 +800,115 @@ void IslandGenerator::processFoliage()
 void IslandGenerator::processEdges()
 {
     auto tempSet = m_mapData.tileData;
-    
-    auto offsetVal =
-        [&tempSet](std::size_t x, std::size_t y)->int
+    processTileEdges(tempSet, m_mapData.tileData);
+    m_edgesProcessed = true;
+}
+
+int IslandGenerator::getRandomInt(int begin, int end)
+{
+    std::uniform_int_distribution<int> dist(begin, end);
+    return dist(m_rndEngine);
+}
+
+float IslandGenerator::getRandomFloat(float begin, float end)
+{
+    std::uniform_real_distribution<float> dist(begin, end);
+    return dist(m_rndEngine);
+}
+
+bool IslandGenerator::loadCache(int seed)
+{
+    if (m_cacheDirectory.empty())
     {
-        return tempSet[y * (Global::TileCountX) + x];
-    };
+        return false;
+    }
 
-    for (auto y = 1u; y < Global::TileCountY - 1; ++y)
+    std::ifstream file(getCachePath(seed), std::ios::binary);
+    if (!file.is_open())
     {
-        for (auto x = 1u; x < Global::TileCountX - 1; ++x)
-        {
-            std::size_t i = y * Global::TileCountX + x;
+        return false;
+    }
 
-            auto TL = offsetVal(x, y);
-            auto TR = offsetVal(x + 1, y);
-            auto BL = offsetVal(x, y + 1);
-            auto BR = offsetVal(x + 1, y + 1);
+    CacheHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.ident != CacheIdent
+        || header.version != CacheVersion
+        || header.seed != seed)
+    {
+        xy::Logger::log("Ignoring invalid island cache for seed " + std::to_string(seed), xy::Logger::Type::Warning);
+        return false;
+    }
 
-            auto hTL = TL >> 1;
-            auto hTR = TR >> 1;
-            auto hBL = BL >> 1;
-            auto hBR = BR >> 1;
+    //make sure the spawn count agrees with the file size
+    //before allocating anything based on it
+    const auto dataStart = file.tellg();
+    file.seekg(0, std::ios::end);
+    const auto remaining = static_cast<std::uint64_t>(file.tellg() - dataStart);
+    file.seekg(dataStart);
+    const std::uint64_t expected = (sizeof(TileArray::data) * 2) + (static_cast<std::uint64_t>(header.spawnCount) * sizeof(CacheSpawn));
+    if (remaining != expected)
+    {
+        xy::Logger::log("Ignoring truncated island cache for seed " + std::to_string(seed), xy::Logger::Type::Warning);
+        return false;
+    }
 
-            auto saddle = ((TL & 1) + (TR & 1) + (BL & 1) + (BR & 1) + 1) >> 2;
-            auto shape = (hTL & 1) | (hTR & 1) << 1 | (hBL & 1) << 2 | (hBR & 1) << 3;
-            auto ring = (hTL + hTR + hBL + hBR) >> 2;
+    MapData mapData;
+    TileArray pathData;
+    std::vector<CacheSpawn> spawns(header.spawnCount);
+    if (!file.read(reinterpret_cast<char*>(mapData.tileData.data), sizeof(TileArray::data))
+        || !file.read(reinterpret_cast<char*>(pathData.data), sizeof(TileArray::data))
+        || !file.read(reinterpret_cast<char*>(spawns.data()), sizeof(CacheSpawn) * spawns.size()))
+    {
+        xy::Logger::log("Ignoring truncated island cache for seed " + std::to_string(seed), xy::Logger::Type::Warning);
+        return false;
+    }
 
-            auto row = (ring << 1) | saddle;
-            auto col = shape - (ring & 1);
-            auto index = row * 15 + col;
+    m_mapData = mapData;
+    m_pathData = pathData;
+    m_pathDataReady = true;
+    m_treasureCount = header.treasureCount;
 
-            m_mapData.tileData[i] = index;
+    m_actorSpawns.reserve(spawns.size());
+    for (const auto& spawn : spawns)
+    {
+        m_actorSpawns.emplace_back(spawn.x, spawn.y, spawn.id);
+    }
+
+    return true;
+}
+
+void IslandGenerator::saveCache(int seed) const
+{
+    if (m_cacheDirectory.empty())
+    {
+        return;
+    }
+
+    auto data = serialise();
+
+    //write to a temp file first so that a match starting at the
+    //same time on another thread never reads a partial file
+    const auto path = getCachePath(seed);
+    const auto tempPath = path + "." + std::to_string(reinterpret_cast<std::uintptr_t>(this)) + ".tmp";
+
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file.is_open()
+            || !file.write(reinterpret_cast<const char*>(data.data()), data.size()))
+        {
+            xy::Logger::log("Failed writing island cache " + tempPath, xy::Logger::Type::Error);
+            return;
         }
     }
-    m_edgesProcessed = true;
-}
\ No newline at end of file
+
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+    {
+        //most likely another instance won the race - theirs is the same data
+        std::remove(tempPath.c_str());
+    }
+}
+
+std::string IslandGenerator::getCachePath(int seed) const
+{
+    return m_cacheDirectory + "island_" + std::to_string(CacheVersion) + "_" + std::to_string(seed) + ".bin";
+}
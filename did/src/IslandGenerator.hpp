@@ -19,18 +19,14 @@ Copyright 2019 Matt Marchant
 #pragma once
 
 #include "GlobalConsts.hpp"
-#include "FoliageGenerator.hpp"
 
-#include <SFML/Graphics/RenderTexture.hpp>
+#include <SFML/System/Vector2.hpp>
 
 #include <array>
+#include <random>
+#include <string>
 #include <vector>
 
-namespace xy
-{
-    class TextureResource;
-}
-
 struct TileArray final
 {
     std::uint8_t data[Global::TileCount] = {};
@@ -47,6 +43,13 @@ struct TileArray final
     }
 };
 
+struct FoliageData final
+{
+    float width = 0.f;
+    sf::Vector2f position;
+    FoliageData(float w = 0.f, sf::Vector2f p = {}) : width(w), position(p) {}
+};
+
 struct MapData final
 {
     TileArray tileData;
@@ -67,13 +70,34 @@ class IslandGenerator final
 public:
     IslandGenerator();
  
+    //generates the tile data, actor spawns and path data for the
+    //given seed, or loads them from the cache if a cache directory is set
     void generate(int);
 
-    void render(const TileArray&, xy::TextureResource&);
+    //if not empty generated islands are stored in, and loaded from, this directory
+    void setCacheDirectory(const std::string&);
 
-    const sf::Texture& getTexture() const;
-    const sf::Texture& getNormalMap() const;
-    const sf::Texture& getWaveMap() const;
+    //returns the path of the cache file for the given seed
+    std::string getCachePath(int) const;
+
+    //when true independent generation stages are run on worker threads.
+    //The output is the same either way. Off by default as at the current
+    //map size the thread start up costs more than it saves (see did_server -v)
+    void setThreaded(bool threaded) { m_threaded = threaded; }
+
+    //returns true if the last call to generate() was loaded from the cache
+    bool loadedFromCache() const { return m_loadedFromCache; }
+
+    //time taken by the last call to generate(), in microseconds
+    std::int64_t getGenerationTime() const { return m_generationTime; }
+
+    //returns the generated tile data, path data and spawns in the
+    //format used by the cache. Used to check generation is deterministic
+    std::vector<std::uint8_t> serialise() const;
+
+    //applies tile data recieved from the server and processes
+    //the foliage and edge data. Used client side, before rendering
+    void setTileData(const TileArray&);
 
     const MapData& getMapData() const { return m_mapData; }
 
@@ -93,16 +117,29 @@ private:
 
     std::size_t m_treasureCount;
     bool m_edgesProcessed;
+    bool m_pathDataReady;
+    bool m_threaded;
+    bool m_loadedFromCache;
+    std::int64_t m_generationTime;
+    std::int32_t m_seed;
+    std::string m_cacheDirectory;
+
+    //used only for generation so that the output depends on nothing but the seed
+    std::mt19937 m_rndEngine;
+    int getRandomInt(int, int);
+    float getRandomFloat(float, float);
 
     void heightNoise(int);
     void edgeNoise(int);
+    void createSpawns();
     void processFoliage();
     void processEdges();
 
+    bool loadCache(int);
+    void saveCache(int) const;
+
     MapData m_mapData;
-    sf::RenderTexture m_renderTexture;
-    sf::RenderTexture m_normalMapTexture;
-    sf::RenderTexture m_waveTexture;
+    TileArray m_pathData;
 
     std::vector<ActorSpawn> m_actorSpawns;
 };
\ No newline at end of file
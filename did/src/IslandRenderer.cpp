@@ -0,0 +1,270 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "IslandRenderer.hpp"
+#include "IslandGenerator.hpp"
+
+#include <xyginext/core/Log.hpp>
+#include <xyginext/util/Random.hpp>
+#include <xyginext/resources/Resource.hpp>
+
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Shader.hpp>
+#include <SFML/Graphics/RectangleShape.hpp>
+
+#include <cmath>
+
+namespace
+{
+    const sf::Vector2u NormalMapSize(Global::IslandSize/* / 2.f*/);
+    const float OutlinePixelOffset = 1.f / (Global::IslandSize.x /*/ 4.f*/);
+
+    //converts the rendered heightmap to a normal map
+const std::string& NormalFrag =
+R"(
+#version 120
+            
+uniform sampler2D u_texture;
+uniform float u_textureSize;
+
+const float strength = 0.65;
+
+void main()
+{
+    float pixelSize = 1.0 / u_textureSize;
+    vec2 uv = gl_TexCoord[0].xy;
+
+    //sample surrounding pixels
+    float tl = texture2D(u_texture, uv + (pixelSize * vec2(-1.0, -1.0))).r;
+    float l = texture2D(u_texture, uv + (pixelSize * vec2(-1.0, 0.0))).r;
+    float bl = texture2D(u_texture, uv + (pixelSize * vec2(-1.0, 1.0))).r;
+    float t = texture2D(u_texture, uv + (pixelSize * vec2(0.0, -1.0))).r;
+    float b = texture2D(u_texture, uv + (pixelSize * vec2(0.0, 1.0))).r;
+    float tr = texture2D(u_texture, uv + (pixelSize * vec2(1.0, -1.0))).r;
+    float r = texture2D(u_texture, uv + (pixelSize * vec2(1.0, 0.0))).r;
+    float br = texture2D(u_texture, uv + (pixelSize * vec2(1.0, 1.0))).r;
+
+    //sobel
+    // -1 0 1
+    // -2 0 2
+    // -1 0 1
+    float dx = tr + (2.0 * r) + br - tl - (2.0 * l) - bl;
+
+    // -1 -2 -1
+    //  0  0  0
+    //  1  2  1
+    float dy = tl + (2.0 * t) + tr - bl - (2.0 * b) - br;
+
+    vec3 normal = normalize(vec3(-dx * strength, -dy * strength, 1.0));
+
+    gl_FragColor = vec4(normal * 0.5 + 0.5, 1.0);
+})";
+
+//draws outline used in wave texture
+const std::string OutlineFrag =
+R"(
+#version 120
+
+uniform sampler2D u_texture;
+uniform float u_pixelOffset;
+
+const float Thickness = 2.0;
+
+void main()
+{
+    vec2 uv = gl_TexCoord[0].xy;
+    float baseAlpha = texture2D(u_texture, uv).a;
+    float alpha = Thickness * 4.0 * baseAlpha;
+
+    for(float i = 1.0; i <= Thickness; ++i)
+    {
+        alpha -= texture2D(u_texture, uv - vec2(u_pixelOffset * i, 0.0f)).a;
+        alpha -= texture2D(u_texture, uv - vec2(-u_pixelOffset * i, 0.0f)).a;
+        alpha -= texture2D(u_texture, uv - vec2(0.0f, u_pixelOffset * i)).a;
+        alpha -= texture2D(u_texture, uv - vec2(0.0f, -u_pixelOffset * i)).a;
+    }
+
+    float wave = (sin(uv.x * 100.0) + 1.0 / 2.0);
+    wave *= (cos(uv.y * 100.0) + 1.0 / 2.0);
+    wave = clamp(wave + 0.8, 0.0, 1.0);
+
+    vec3 waveColour = vec3(1.0) * clamp(alpha, 0.0, 1.0) * 0.9 * wave;
+
+    gl_FragColor = vec4(waveColour, waveColour.r);// clamp((1.0 - baseAlpha) + (waveColour.b * 0.9999), 0.0, 1.0));
+})";
+}
+
+//public
+void IslandRenderer::render(const TileArray& tileData, xy::TextureResource& tr)
+{
+    //expects tile data which has already been edge processed by the IslandGenerator
+    if (!m_renderTexture.create(static_cast<int>(Global::IslandSize.x), static_cast<int>(Global::IslandSize.y)))
+    {
+        xy::Logger::log("Failed creating render texture for island renderer", xy::Logger::Type::Error);
+    }
+
+    if (!m_normalMapTexture.create(NormalMapSize.x, NormalMapSize.y))
+    {
+        xy::Logger::log("Failed creating normal map render texture for island renderer", xy::Logger::Type::Error);
+    }
+
+    if (!m_waveTexture.create(NormalMapSize.x/* / 4*/, NormalMapSize.y /*/ 4*/))
+    {
+        xy::Logger::log("Failed creating wave render texture for island renderer", xy::Logger::Type::Error);
+    }   
+    
+    auto details = xy::Util::Random::poissonDiscDistribution(
+        sf::FloatRect(sf::Vector2f(), Global::IslandSize),
+        150.f, 50);
+
+    sf::Texture& tileset = tr.get("assets/images/test_set.png");
+    sf::Texture& detailset = tr.get("assets/images/details.png");
+    sf::Texture& heightset = tr.get("assets/images/test_set_height.png");
+
+    sf::Shader normalShader;
+    normalShader.loadFromMemory(NormalFrag, sf::Shader::Fragment);
+    normalShader.setUniform("u_textureSize", static_cast<float>(NormalMapSize.x));
+    
+    /*if (tileset.loadFromFile("assets/images/test_set.png")
+        && detailset.loadFromFile("assets/images/details.png")
+        && heightset.loadFromFile("assets/images/test_set_height.png"))*/
+    {
+        int tileSetCountX = tileset.getSize().x / static_cast<int>(Global::TileSize);
+        int tileSetCountY = tileset.getSize().y / static_cast<int>(Global::TileSize);
+
+        sf::Sprite sprite(heightset);
+        //sprite.setScale(0.5f, 0.5f); //remember to reset this if changing buffer size
+
+        auto getSubrect = [&tileSetCountX, &tileSetCountY](std::uint8_t idx) ->sf::IntRect
+        {
+            int left = (idx % tileSetCountX) * static_cast<int>(Global::TileSize);
+            int top = (idx / tileSetCountX) * static_cast<int>(Global::TileSize);
+            return { left, top, static_cast<int>(Global::TileSize), static_cast<int>(Global::TileSize) };
+        };
+
+        //normal map
+        sf::RenderTexture tempTexture;
+        tempTexture.create(NormalMapSize.x, NormalMapSize.y);
+        tempTexture.clear(sf::Color::Blue);
+        for (auto i = 0u; i < Global::TileCount; ++i)
+        {
+            sprite.setTextureRect(getSubrect(tileData[i]));
+
+            float posX = ((i % Global::TileCountX) * Global::TileSize);// / 2.f;
+            float posY = ((i / Global::TileCountX) * Global::TileSize);// / 2.f;
+            sprite.setPosition(posX, posY);
+
+            tempTexture.draw(sprite);
+        }
+        tempTexture.display();
+        //render to buffer with normal map shader
+        sprite.setTexture(tempTexture.getTexture(), true);
+        sprite.setPosition(0.f, 0.f);
+        //sprite.setScale(1.f, 1.f);
+        normalShader.setUniform("u_texture", tempTexture.getTexture());
+        m_normalMapTexture.clear(sf::Color::Red);
+        m_normalMapTexture.draw(sprite, &normalShader);
+        m_normalMapTexture.display();
+
+        //colour map
+        //sf::RectangleShape shape({ Global::TileSize, Global::TileSize });
+        sprite.setTexture(tileset);
+        m_renderTexture.clear(sf::Color::Transparent);
+        for (auto i = 0u; i < Global::TileCount; ++i)
+        {
+            sprite.setTextureRect(getSubrect(tileData[i]));
+
+            float posX = (i % Global::TileCountX) * Global::TileSize;
+            float posY = (i / Global::TileCountX) * Global::TileSize;
+            sprite.setPosition(posX, posY);
+
+            m_renderTexture.draw(sprite);
+
+            /*if (tileData[i] < TileType::DarkSand)
+            {
+                shape.setFillColor({ 0, 0, 120, 120 });
+            }
+            else if (tileData[i] < TileType::Grass)
+            {
+                shape.setFillColor({ 0, 120, 0, 120 });
+            }
+            else
+            {
+                shape.setFillColor({ 120, 0, 0, 120 });
+            }
+            shape.setPosition(posX - (Global::TileSize / 2.f), posY - (Global::TileSize / 2.f));
+            m_renderTexture.draw(shape);*/
+        }
+
+        //sprinkle details
+        tileSetCountX = detailset.getSize().x / Global::TileSize;
+        tileSetCountY = detailset.getSize().y / Global::TileSize;
+        auto tileSetCount = tileSetCountX * tileSetCountY;
+
+        sprite.setTexture(detailset);
+
+        for (auto pos : details)
+        {
+            //check we're not in the water
+            auto tileX = std::floor(pos.x / Global::TileSize);
+            auto tileY = std::floor(pos.y / Global::TileSize);
+            int idx = static_cast<int>(tileY) * Global::TileCountX + tileX;
+            
+            if (tileData[idx] == 60 || tileData[idx] == 75)
+            {
+                sprite.setTextureRect(getSubrect(xy::Util::Random::value(0, tileSetCount - 1)));
+                sprite.setPosition(pos);
+                m_renderTexture.draw(sprite);
+            }
+        }
+
+        m_renderTexture.display();
+
+        //take colour map and render outline with it for wave effect
+        sf::Shader outlineShader;
+        outlineShader.loadFromMemory(OutlineFrag, sf::Shader::Fragment);
+        outlineShader.setUniform("u_texture", m_renderTexture.getTexture());
+        outlineShader.setUniform("u_pixelOffset", OutlinePixelOffset);
+
+        sprite.setTexture(m_renderTexture.getTexture(), true);
+        sprite.setPosition(0.f, 0.f);
+        sprite.setScale(1.f, 1.f);
+        m_waveTexture.clear(sf::Color::Transparent);
+        m_waveTexture.draw(sprite, &outlineShader);
+        m_waveTexture.display();
+    }
+    /*else
+    {
+        xy::Logger::log("failed loading island, missing texture", xy::Logger::Type::Error);
+    }*/
+}
+
+const sf::Texture& IslandRenderer::getTexture() const
+{
+    return m_renderTexture.getTexture();
+}
+
+const sf::Texture& IslandRenderer::getNormalMap() const
+{
+    return m_normalMapTexture.getTexture();
+}
+
+const sf::Texture& IslandRenderer::getWaveMap() const
+{
+    return m_waveTexture.getTexture();
+}
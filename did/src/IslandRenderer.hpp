@@ -0,0 +1,49 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <SFML/Graphics/RenderTexture.hpp>
+
+struct TileArray;
+
+namespace xy
+{
+    class TextureResource;
+}
+
+//renders the tile data created by the IslandGenerator
+//to the island textures. This is split from the generator
+//so that the server has no dependency on an OpenGL context
+class IslandRenderer final
+{
+public:
+    IslandRenderer() = default;
+
+    //tile data is expected to have been processed with IslandGenerator::setTileData()
+    void render(const TileArray&, xy::TextureResource&);
+
+    const sf::Texture& getTexture() const;
+    const sf::Texture& getNormalMap() const;
+    const sf::Texture& getWaveMap() const;
+
+private:
+    sf::RenderTexture m_renderTexture;
+    sf::RenderTexture m_normalMapTexture;
+    sf::RenderTexture m_waveTexture;
+};
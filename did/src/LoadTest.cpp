@@ -0,0 +1,666 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+/*
+Headless load tester. Hosts one or more matches in process, then
+connects a swarm of scripted clients to them over localhost. Each
+client performs the same join handshake as the game client, then
+streams InputUpdate packets at the client frame rate. At the end
+of the run server tick durations, per peer bandwidth and snapshot
+lateness are reported. Optionally the host client will spawn a number
+of extra actors each round via the Spawn console command, to load the
+server's collision and AI systems.
+
+Usage: did_loadtest [-m <match count>] [-c <clients per match>] [-t <seconds>]
+                    [-p <first port>] [-i <random|scripted>] [-s <seed>]
+                    [-a <extra actors per match>]
+*/
+
+#include "Server.hpp"
+#include "GlobalConsts.hpp"
+#include "Packet.hpp"
+#include "PacketTypes.hpp"
+#include "InputParser.hpp"
+#include "InputBinding.hpp"
+#include "ConCommands.hpp"
+
+#include <xyginext/core/Log.hpp>
+#include <xyginext/network/NetClient.hpp>
+#include <xyginext/network/NetData.hpp>
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+#include <SFML/System/String.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::atomic<bool> running(true);
+
+    void onSignal(int)
+    {
+        running = false;
+    }
+
+    //matches the rate at which InputParser::update() is called by the client
+    const float InputStep = 1.f / 60.f;
+    const sf::Time StartRequestInterval = sf::seconds(1.f);
+    const std::size_t MaxMatches = 64;
+    const std::size_t MaxActors = 1000;
+    const std::size_t SpawnsPerStep = 10;
+
+    enum class InputModel
+    {
+        Random, Scripted
+    };
+
+    struct Options final
+    {
+        std::size_t matchCount = 1;
+        std::size_t clientsPerMatch = 4;
+        float duration = 60.f;
+        std::uint16_t basePort = Global::GamePort + 100;
+        InputModel inputModel = InputModel::Random;
+        std::uint32_t seed = 1234;
+        std::size_t actorCount = 0;
+    };
+
+    //walks in a square, digging at each corner
+    struct ScriptStep final
+    {
+        std::uint16_t mask = 0;
+        float duration = 0.f;
+    };
+
+    const std::array<ScriptStep, 8u> Script =
+    {{
+        { InputFlag::Up, 1.f }, { InputFlag::Action, 0.1f },
+        { InputFlag::Right, 1.f }, { InputFlag::Action, 0.1f },
+        { InputFlag::Down, 1.f }, { InputFlag::Action, 0.1f },
+        { InputFlag::Left, 1.f }, { InputFlag::Action, 0.1f }
+    }};
+
+    const std::array<std::uint16_t, 9u> Directions =
+    {
+        0,
+        InputFlag::Up, InputFlag::Down, InputFlag::Left, InputFlag::Right,
+        InputFlag::Up | InputFlag::Left, InputFlag::Up | InputFlag::Right,
+        InputFlag::Down | InputFlag::Left, InputFlag::Down | InputFlag::Right
+    };
+
+    template <typename T>
+    T percentile(std::vector<T>& values, float p)
+    {
+        if (values.empty())
+        {
+            return T(0);
+        }
+
+        auto idx = static_cast<std::size_t>(p * static_cast<float>(values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + idx, values.end());
+        return values[idx];
+    }
+
+    //performs the client side of the join handshake then
+    //plays the game via a simple input model
+    class BotClient final
+    {
+    public:
+        BotClient(std::uint16_t port, std::size_t expectedClients, bool host, std::size_t index, InputModel model, std::uint32_t seed, std::size_t actorCount)
+            : m_port        (port),
+            m_expectedClients(expectedClients),
+            m_host          (host),
+            m_index         (index),
+            m_inputModel    (model),
+            m_rndEngine     (seed),
+            m_actorCount    (actorCount)
+        {
+            m_client.create(Global::NetworkChannels);
+        }
+
+        bool connect()
+        {
+            if (m_client.connect("127.0.0.1", m_port))
+            {
+                m_phase = Phase::Lobby;
+                return true;
+            }
+            return false;
+        }
+
+        void disconnect()
+        {
+            if (m_client.connected())
+            {
+                m_client.disconnect();
+            }
+        }
+
+        void pollNetwork()
+        {
+            xy::NetEvent evt;
+            while (m_client.pollEvent(evt))
+            {
+                if (evt.type == xy::NetEvent::PacketReceived)
+                {
+                    m_bytesIn += evt.packet.getSize() + sizeof(std::uint8_t);
+                    m_packetsIn++;
+
+                    handlePacket(evt);
+                }
+                else if (evt.type == xy::NetEvent::ClientDisconnect)
+                {
+                    m_phase = Phase::Disconnected;
+                }
+            }
+
+            //lobby host requests the game start once all the other clients are ready
+            if (m_host && m_phase == Phase::Lobby
+                && std::count(m_readyStates.begin(), m_readyStates.end(), true) == static_cast<std::ptrdiff_t>(m_expectedClients)
+                && m_startClock.getElapsedTime() > StartRequestInterval)
+            {
+                send(PacketID::StartGame, std::uint8_t(0), xy::NetFlag::Reliable, Global::ReliableChannel);
+                m_startClock.restart();
+            }
+        }
+
+        void sendInput(float dt)
+        {
+            m_timeAccumulator += static_cast<std::int64_t>(dt * 1000000.f);
+
+            if (m_phase != Phase::Playing)
+            {
+                return;
+            }
+
+            updateInputModel(dt);
+            spawnActors();
+
+            InputUpdate iu;
+            iu.clientTime = m_timeAccumulator;
+            iu.input = m_inputMask;
+            iu.playerNumber = m_playerNumber;
+            iu.acceleration = 1.f;
+
+            send(PacketID::ClientInput, iu, xy::NetFlag::Unreliable, 0);
+        }
+
+        bool playing() const { return m_phase == Phase::Playing; }
+        bool disconnected() const { return m_phase == Phase::Disconnected; }
+
+        std::size_t getBytesIn() const { return m_bytesIn; }
+        std::size_t getBytesOut() const { return m_bytesOut; }
+        std::size_t getPacketsIn() const { return m_packetsIn; }
+        std::size_t getPacketsOut() const { return m_packetsOut; }
+        std::vector<std::int32_t>& getSnapshotLateness() { return m_lateness; }
+
+        void flushLateness()
+        {
+            for (auto offset : m_offsets)
+            {
+                m_lateness.push_back(offset - m_minOffset);
+            }
+            m_offsets.clear();
+        }
+
+    private:
+        enum class Phase
+        {
+            Idle, Lobby, Loading, Playing, Disconnected
+        }m_phase = Phase::Idle;
+
+        xy::NetClient m_client;
+        std::uint16_t m_port = 0;
+        std::size_t m_expectedClients = 0;
+        bool m_host = false;
+        std::array<bool, 4u> m_readyStates = {};
+        std::size_t m_index = 0;
+        sf::Clock m_startClock;
+
+        std::uint8_t m_playerNumber = 0;
+
+        InputModel m_inputModel;
+        std::mt19937 m_rndEngine;
+        std::int64_t m_timeAccumulator = 0;
+        std::uint16_t m_inputMask = 0;
+        float m_inputTime = 0.f;
+        std::size_t m_scriptIndex = 0;
+
+        std::size_t m_actorCount = 0;
+        std::size_t m_actorsToSpawn = 0;
+
+        std::size_t m_bytesIn = 0;
+        std::size_t m_bytesOut = 0;
+        std::size_t m_packetsIn = 0;
+        std::size_t m_packetsOut = 0;
+
+        //lateness is measured against the smallest observed offset between
+        //the local clock and the server timestamp, so includes jitter only
+        sf::Clock m_localClock;
+        std::int32_t m_minOffset = std::numeric_limits<std::int32_t>::max();
+        std::vector<std::int32_t> m_offsets;
+        std::vector<std::int32_t> m_lateness;
+
+        template <typename T>
+        void send(std::uint8_t id, const T& data, xy::NetFlag flag, std::uint8_t channel)
+        {
+            m_client.sendPacket(id, data, flag, channel);
+            m_bytesOut += sizeof(T) + sizeof(std::uint8_t);
+            m_packetsOut++;
+        }
+
+        void send(std::uint8_t id, const void* data, std::size_t size, xy::NetFlag flag, std::uint8_t channel)
+        {
+            m_client.sendPacket(id, data, size, flag, channel);
+            m_bytesOut += size + sizeof(std::uint8_t);
+            m_packetsOut++;
+        }
+
+        void handlePacket(const xy::NetEvent& evt)
+        {
+            switch (evt.packet.getID())
+            {
+            default: break;
+            case PacketID::RejectClient:
+                xy::Logger::log("Load test client " + std::to_string(m_index) + " was rejected by server", xy::Logger::Type::Error);
+                m_phase = Phase::Disconnected;
+                break;
+            case PacketID::ReqPlayerInfo:
+            {
+                sf::String name = "Load Bot " + std::to_string(m_index);
+                auto nameBytes = name.toUtf32();
+                auto size = std::min(nameBytes.size() * sizeof(sf::Uint32), Global::MaxNameSize);
+
+                std::vector<std::uint8_t> buffer(size + sizeof(PlayerInfoHeader));
+                PlayerInfoHeader ph;
+                ph.spriteIndex = static_cast<std::uint8_t>(m_index % 4);
+                ph.hatIndex = 0;
+
+                std::memcpy(buffer.data(), &ph, sizeof(ph));
+                std::memcpy(buffer.data() + sizeof(ph), nameBytes.data(), size);
+                send(PacketID::SupPlayerInfo, buffer.data(), buffer.size(), xy::NetFlag::Reliable, Global::ReliableChannel);
+
+                send(PacketID::SetReadyState, std::uint8_t(1), xy::NetFlag::Reliable, 0);
+            }
+                break;
+            case PacketID::GetReadyState:
+            {
+                auto data = evt.packet.as<std::uint16_t>();
+                auto playerID = (data >> 8) % m_readyStates.size();
+                m_readyStates[playerID] = (data & 0xff) != 0;
+            }
+                break;
+            case PacketID::PlayerLeft:
+                m_readyStates[evt.packet.as<std::uint8_t>() % m_readyStates.size()] = false;
+                break;
+            case PacketID::LaunchGame:
+                if (m_phase == Phase::Lobby)
+                {
+                    m_phase = Phase::Loading;
+                    m_minOffset = std::numeric_limits<std::int32_t>::max();
+                    m_offsets.clear();
+                    send(PacketID::RequestMap, std::uint8_t(0), xy::NetFlag::Reliable, Global::ReliableChannel);
+                }
+                break;
+            case PacketID::MapData:
+                send(PacketID::RequestPlayer, std::uint8_t(0), xy::NetFlag::Reliable, Global::ReliableChannel);
+                break;
+            case PacketID::PlayerData:
+            {
+                const auto& playerInfo = evt.packet.as<PlayerInfo>();
+                m_playerNumber = static_cast<std::uint8_t>(playerInfo.actor.id - Actor::ID::PlayerOne);
+                m_phase = Phase::Playing;
+
+                //only the host is allowed to send console commands
+                if (m_host)
+                {
+                    m_actorsToSpawn = m_actorCount;
+                }
+            }
+                break;
+            case PacketID::ActorUpdate:
+            {
+                const auto& state = evt.packet.as<ActorState>();
+                auto offset = m_localClock.getElapsedTime().asMilliseconds() - state.serverTime;
+                m_minOffset = std::min(m_minOffset, offset);
+                m_offsets.push_back(offset);
+            }
+                break;
+            case PacketID::EndOfRound:
+                //server drops back into the lobby - ready up again
+                flushLateness();
+                m_phase = Phase::Lobby;
+                m_readyStates = {};
+                send(PacketID::SetReadyState, std::uint8_t(1), xy::NetFlag::Reliable, 0);
+                break;
+            case PacketID::ServerQuit:
+                m_phase = Phase::Disconnected;
+                break;
+            }
+        }
+
+        void updateInputModel(float dt)
+        {
+            m_inputTime -= dt;
+            if (m_inputTime > 0)
+            {
+                return;
+            }
+
+            if (m_inputModel == InputModel::Random)
+            {
+                std::uniform_int_distribution<std::size_t> dirDist(0, Directions.size() - 1);
+                std::uniform_real_distribution<float> timeDist(0.25f, 1.5f);
+                std::uniform_int_distribution<int> actionDist(0, 9);
+
+                m_inputMask = Directions[dirDist(m_rndEngine)];
+                if (actionDist(m_rndEngine) == 0)
+                {
+                    m_inputMask |= InputFlag::Action;
+                }
+                m_inputTime = timeDist(m_rndEngine);
+            }
+            else
+            {
+                m_inputMask = Script[m_scriptIndex].mask;
+                m_inputTime = Script[m_scriptIndex].duration;
+                m_scriptIndex = (m_scriptIndex + 1) % Script.size();
+            }
+        }
+
+        //spread the spawn requests over several steps so
+        //as not to flood the reliable channel
+        void spawnActors()
+        {
+            std::uniform_real_distribution<float> posDist(Global::TileSize * 4.f, Global::IslandSize.x - (Global::TileSize * 4.f));
+            std::uniform_int_distribution<int> typeDist(0, 1);
+
+            for (auto i = 0u; i < SpawnsPerStep && m_actorsToSpawn > 0; ++i, --m_actorsToSpawn)
+            {
+                Server::ConCommand::Data data;
+                data.commandID = Server::ConCommand::Spawn;
+                data.value.asInt = typeDist(m_rndEngine) == 0 ? Actor::Skeleton : Actor::Ammo;
+                data.position = { posDist(m_rndEngine), posDist(m_rndEngine) };
+                send(PacketID::ConCommand, data, xy::NetFlag::Reliable, Global::LowPriorityChannel);
+            }
+        }
+    };
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            std::string value(argv[++i]);
+
+            if (arg == "-m")
+            {
+                auto count = std::atoi(value.c_str());
+                if (count < 1 || count > static_cast<int>(MaxMatches))
+                {
+                    return false;
+                }
+                options.matchCount = count;
+            }
+            else if (arg == "-c")
+            {
+                auto count = std::atoi(value.c_str());
+                if (count < 1 || count > 4)
+                {
+                    return false;
+                }
+                options.clientsPerMatch = count;
+            }
+            else if (arg == "-t")
+            {
+                options.duration = static_cast<float>(std::atof(value.c_str()));
+                if (options.duration <= 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg == "-p")
+            {
+                auto port = std::atoi(value.c_str());
+                if (port < 1 || port > 0xffff)
+                {
+                    return false;
+                }
+                options.basePort = static_cast<std::uint16_t>(port);
+            }
+            else if (arg == "-i")
+            {
+                if (value == "random")
+                {
+                    options.inputModel = InputModel::Random;
+                }
+                else if (value == "scripted")
+                {
+                    options.inputModel = InputModel::Scripted;
+                }
+                else
+                {
+                    return false;
+                }
+            }
+            else if (arg == "-s")
+            {
+                options.seed = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+            }
+            else if (arg == "-a")
+            {
+                auto count = std::atoi(value.c_str());
+                if (count < 0 || count > static_cast<int>(MaxActors))
+                {
+                    return false;
+                }
+                options.actorCount = count;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void printUsage()
+    {
+        std::cout << "Usage: did_loadtest [-m <match count>] [-c <clients per match>] [-t <seconds>]\n"
+            << "                    [-p <first port>] [-i <random|scripted>] [-s <seed>]\n"
+            << "                    [-a <extra actors per match>]\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.basePort + options.matchCount > 0xffff)
+    {
+        xy::Logger::log("Port range exceeds 65535", xy::Logger::Type::Error);
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    struct Match final
+    {
+        std::unique_ptr<GameServer> server;
+        std::uint64_t lastTickCount = 0;
+        std::vector<std::int64_t> tickTimes;
+    };
+    std::vector<Match> matches(options.matchCount);
+    std::vector<std::unique_ptr<BotClient>> clients;
+
+    for (auto i = 0u; i < matches.size(); ++i)
+    {
+        auto port = static_cast<std::uint16_t>(options.basePort + i);
+
+        auto& match = matches[i];
+        match.server = std::make_unique<GameServer>();
+        match.server->setMaxPlayers(4);
+        match.server->setPort(port);
+        match.server->setDedicated(true);
+        match.server->start();
+
+        if (!match.server->running())
+        {
+            xy::Logger::log("Failed to start match on port " + std::to_string(port), xy::Logger::Type::Error);
+            return 1;
+        }
+
+        for (auto j = 0u; j < options.clientsPerMatch; ++j)
+        {
+            auto idx = clients.size();
+            clients.emplace_back(std::make_unique<BotClient>(port, options.clientsPerMatch, j == 0, idx, options.inputModel, options.seed + static_cast<std::uint32_t>(idx), options.actorCount));
+            if (!clients.back()->connect())
+            {
+                xy::Logger::log("Client " + std::to_string(idx) + " failed to connect to port " + std::to_string(port), xy::Logger::Type::Error);
+            }
+        }
+    }
+
+    xy::Logger::log("Running " + std::to_string(clients.size()) + " clients across " + std::to_string(matches.size()) + " matches", xy::Logger::Type::Info);
+
+    sf::Clock runClock;
+    sf::Clock inputClock;
+    float inputAccumulator = 0.f;
+    float playingTime = 0.f;
+
+    while (running
+        && runClock.getElapsedTime().asSeconds() < options.duration)
+    {
+        //sample the server tick times as they change. If the server
+        //has to catch up with several ticks some samples will be missed
+        for (auto& match : matches)
+        {
+            auto tickCount = match.server->getTickCount();
+            if (tickCount != match.lastTickCount)
+            {
+                match.lastTickCount = tickCount;
+                match.tickTimes.push_back(match.server->getLastTickTime());
+            }
+        }
+
+        for (auto& client : clients)
+        {
+            client->pollNetwork();
+        }
+
+        auto dt = inputClock.restart().asSeconds();
+        inputAccumulator += dt;
+        while (inputAccumulator > InputStep)
+        {
+            inputAccumulator -= InputStep;
+            for (auto& client : clients)
+            {
+                client->sendInput(InputStep);
+            }
+        }
+
+        if (std::any_of(clients.begin(), clients.end(), [](const std::unique_ptr<BotClient>& c) {return c->playing(); }))
+        {
+            playingTime += dt;
+        }
+
+        sf::sleep(sf::milliseconds(1));
+    }
+
+    //report
+    std::vector<std::int64_t> allTicks;
+    std::cout << "\nServer tick time (us)\n";
+    std::cout << std::setw(8) << "match" << std::setw(10) << "ticks" << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max\n";
+    for (auto i = 0u; i < matches.size(); ++i)
+    {
+        auto& ticks = matches[i].tickTimes;
+        allTicks.insert(allTicks.end(), ticks.begin(), ticks.end());
+
+        std::cout << std::setw(8) << i << std::setw(10) << ticks.size()
+            << std::setw(10) << percentile(ticks, 0.5f)
+            << std::setw(10) << percentile(ticks, 0.95f)
+            << std::setw(10) << percentile(ticks, 0.99f)
+            << std::setw(10) << percentile(ticks, 1.f) << "\n";
+    }
+    std::cout << std::setw(8) << "all" << std::setw(10) << allTicks.size()
+        << std::setw(10) << percentile(allTicks, 0.5f)
+        << std::setw(10) << percentile(allTicks, 0.95f)
+        << std::setw(10) << percentile(allTicks, 0.99f)
+        << std::setw(10) << percentile(allTicks, 1.f) << "\n";
+
+    const float seconds = std::max(playingTime, 1.f);
+    std::vector<std::int32_t> allLateness;
+    std::cout << "\nPer peer traffic (bytes/sec over " << seconds << "s of play) and snapshot lateness (ms)\n";
+    std::cout << std::setw(8) << "client" << std::setw(12) << "in B/s" << std::setw(12) << "out B/s"
+        << std::setw(10) << "pkt in" << std::setw(10) << "pkt out" << std::setw(8) << "p50" << std::setw(8) << "p95" << std::setw(8) << "p99\n";
+    for (auto i = 0u; i < clients.size(); ++i)
+    {
+        auto& client = clients[i];
+        client->flushLateness();
+        auto& lateness = client->getSnapshotLateness();
+        allLateness.insert(allLateness.end(), lateness.begin(), lateness.end());
+
+        std::cout << std::setw(8) << i
+            << std::setw(12) << static_cast<std::size_t>(client->getBytesIn() / seconds)
+            << std::setw(12) << static_cast<std::size_t>(client->getBytesOut() / seconds)
+            << std::setw(10) << client->getPacketsIn()
+            << std::setw(10) << client->getPacketsOut()
+            << std::setw(8) << percentile(lateness, 0.5f)
+            << std::setw(8) << percentile(lateness, 0.95f)
+            << std::setw(8) << percentile(lateness, 0.99f) << "\n";
+    }
+    std::cout << "all snapshot lateness (ms) p50: " << percentile(allLateness, 0.5f)
+        << " p95: " << percentile(allLateness, 0.95f)
+        << " p99: " << percentile(allLateness, 0.99f)
+        << " max: " << percentile(allLateness, 1.f) << "\n\n";
+
+    for (auto& client : clients)
+    {
+        client->disconnect();
+    }
+
+    for (auto& match : matches)
+    {
+        match.server->stop();
+    }
+
+    return 0;
+}
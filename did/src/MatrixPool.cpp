@@ -19,24 +19,49 @@ Copyright 2019 Matt Marchant
 #include "MatrixPool.hpp"
 
 MatrixPool::MatrixPool()
-    : m_nextFreeIndex(MaxMatrices)
 {
-    for (auto i = 0u; i < MaxMatrices; ++i)
+    addPage();
+}
+
+//public
+MatrixPool::Handle MatrixPool::allocate()
+{
+    if (m_freeIndices.empty())
     {
-        m_freeIndices[i] = i;
+        addPage();
     }
+
+    Handle handle;
+    handle.index = m_freeIndices.back();
+    m_freeIndices.pop_back();
+
+    handle.generation = ++m_generations[handle.index];
+    at(handle) = glm::mat4(1.f);
+
+    return handle;
 }
 
-//public
-std::size_t MatrixPool::allocate()
+void MatrixPool::deallocate(Handle handle)
 {
-    XY_ASSERT(m_nextFreeIndex > 0, "Max matrices have been allocated!");
-    return m_freeIndices[--m_nextFreeIndex];
+    XY_ASSERT(valid(handle), "Matrix has already been deallocated, or handle is invalid!");
+    if (valid(handle))
+    {
+        m_generations[handle.index]++;
+        m_freeIndices.push_back(handle.index);
+    }
 }
 
-void MatrixPool::deallocate(std::size_t idx)
+//private
+void MatrixPool::addPage()
 {
-    XY_ASSERT(idx < MaxMatrices, "Index out of range!");
-    XY_ASSERT(m_nextFreeIndex < MaxMatrices, "Everything is deallocated, something went wrong!");
-    m_freeIndices[m_nextFreeIndex++] = idx;
-}
\ No newline at end of file
+    const auto first = static_cast<std::uint32_t>(m_pages.size() * PageSize);
+    m_pages.emplace_back(std::make_unique<Page>());
+
+    m_generations.resize(m_generations.size() + PageSize, 0);
+
+    //reversed so that lower indices are allocated first
+    for (auto i = PageSize; i > 0; --i)
+    {
+        m_freeIndices.push_back(first + static_cast<std::uint32_t>(i - 1));
+    }
+}
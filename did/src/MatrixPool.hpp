@@ -20,36 +20,65 @@ Copyright 2019 Matt Marchant
 
 /*
 Pools matrices as a resource so they aren't invalidated
-when components using them are moved in memory.
+when components using them are moved in memory. Matrices
+are stored in fixed size pages so that growing the pool
+never moves existing matrices, which are bound to shaders
+by address. Handles carry a generation so that use of a
+deallocated matrix can be detected.
 */
 
 #include "glm/mat4x4.hpp"
 #include <xyginext/core/Assert.hpp>
+
 #include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 class MatrixPool final
 {
 public:
+    struct Handle final
+    {
+        std::uint32_t index = 0;
+        std::uint32_t generation = 0; //even generations are never valid
+    };
+
     MatrixPool();
 
-    std::size_t allocate();
-    void deallocate(std::size_t);
+    Handle allocate();
+    void deallocate(Handle);
 
-    glm::mat4& at(std::size_t idx)
+    //returns true if the handle refers to a currently allocated matrix
+    bool valid(Handle handle) const
     {
-        XY_ASSERT(idx < MaxMatrices, "Index out of range!");
-        return m_matrices[idx];
+        return (handle.generation & 1)
+            && handle.index < m_generations.size()
+            && handle.generation == m_generations[handle.index];
     }
 
-    const glm::mat4& at(std::size_t idx) const
+    glm::mat4& at(Handle handle)
     {
-        XY_ASSERT(idx < MaxMatrices, "Index out of range!");
-        return m_matrices[idx];
+        XY_ASSERT(valid(handle), "Stale or invalid matrix handle!");
+        return (*m_pages[handle.index / PageSize])[handle.index % PageSize];
     }
 
+    const glm::mat4& at(Handle handle) const
+    {
+        XY_ASSERT(valid(handle), "Stale or invalid matrix handle!");
+        return (*m_pages[handle.index / PageSize])[handle.index % PageSize];
+    }
+
+    std::size_t getAllocatedCount() const { return m_generations.size() - m_freeIndices.size(); }
+
 private:
-    static constexpr std::size_t MaxMatrices = 1024;
-    std::array<glm::mat4, MaxMatrices> m_matrices = {};
-    std::array<std::size_t, MaxMatrices> m_freeIndices;
-    std::size_t m_nextFreeIndex;
-};
\ No newline at end of file
+    static constexpr std::size_t PageSize = 256;
+    using Page = std::array<glm::mat4, PageSize>;
+    std::vector<std::unique_ptr<Page>> m_pages;
+
+    //odd generations are allocated, even are free
+    std::vector<std::uint32_t> m_generations;
+    std::vector<std::uint32_t> m_freeIndices;
+
+    void addPage();
+};
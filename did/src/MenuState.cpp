@@ -33,6 +33,7 @@ Copyright 2019 Matt Marchant
 #include "WaveSystem.hpp"
 #include "FlappySailSystem.hpp"
 #include "KeyMapping.hpp"
+#include "GameState.hpp"
 #include "ButtonHighlightSystem.hpp"
 
 #include <xyginext/ecs/components/Camera.hpp>
@@ -82,6 +83,40 @@ namespace
     const std::string ButtonsFile("buttons.set");
     const std::string SpriteFile("sprite.set");
 
+    //decoded on the asset loader's threads while the shaders compile
+    const std::vector<std::string> MenuImages =
+    {
+        "assets/images/sea.png",
+        "assets/images/background.png",
+        "assets/images/menu_island.png",
+        "assets/images/menu_island_normal.png",
+        "assets/images/menu_island_waves.png",
+        "assets/images/menu_trees.png",
+        "assets/images/player.png",
+        "assets/images/player_one.png",
+        "assets/images/player_two.png",
+        "assets/images/player_three.png",
+        "assets/images/player_four.png",
+        "assets/images/blinken.png",
+        "assets/images/controls_bg.png",
+        "assets/images/button_highlight.png"
+    };
+
+    const std::vector<std::string> MenuSpriteSheets =
+    {
+        "assets/sprites/lobby.spt",
+        "assets/sprites/menu_ui.spt",
+        "assets/sprites/barrel.spt",
+        "assets/sprites/water_details.spt",
+        "assets/sprites/boat.spt",
+        "assets/sprites/foliage.spt",
+        "assets/sprites/players.spt",
+        "assets/sprites/weapons.spt"
+    };
+
+    //time spent each frame creating game textures from decoded images
+    const sf::Time UploadBudget = sf::milliseconds(2);
+
     const std::vector<std::string> names =
     {
         "Cleftwisp", "Old Sam", "Lou Baker",
@@ -105,6 +140,17 @@ MenuState::MenuState(xy::StateStack& ss, xy::State::Context ctx, SharedData& sd)
 {
     launchLoadingScreen();
 
+    auto& assetLoader = *m_sharedData.assetLoader;
+    for (const auto& path : MenuImages)
+    {
+        assetLoader.queueImage(path, AssetLoader::Menu);
+    }
+    for (const auto& path : MenuSpriteSheets)
+    {
+        assetLoader.queueSpriteSheet(path, AssetLoader::Menu);
+    }
+    assetLoader.install(m_resources, AssetLoader::Menu);
+
     //this member is a union so there's no
     //default value
     m_activeMapping.keyDest = nullptr;
@@ -140,6 +186,10 @@ MenuState::MenuState(xy::StateStack& ss, xy::State::Context ctx, SharedData& sd)
     ent.addComponent<xy::Transform>().setScale(xy::DefaultSceneSize);
     ent.addComponent<xy::Sprite>(m_resources.get<sf::Texture>(idx));*/
 
+    //start decoding the game assets so they can be
+    //uploaded while the lobby is waiting for players
+    GameState::queueAssets(assetLoader);
+
     quitLoadingScreen();
 }
 
@@ -303,6 +353,8 @@ bool MenuState::update(float dt)
 
     updateBackground(dt);
 
+    m_sharedData.assetLoader->upload(*m_sharedData.gameResources, AssetLoader::Game, UploadBudget);
+
     m_uiScene.update(dt);
     m_gameScene.update(dt);
 
@@ -966,6 +1018,7 @@ void MenuState::handlePacket(const xy::NetEvent& evt)
             requestStackPush(StateID::Game);
 
             m_gameLaunched = true;
+            m_sharedData.launchClock.restart();
         }
         break;
     }
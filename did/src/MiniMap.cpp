@@ -25,6 +25,11 @@ Copyright 2019 Matt Marchant
 #include <xyginext/util/Vector.hpp>
 #include <xyginext/util/Math.hpp>
 
+#include <SFML/Graphics/Sprite.hpp>
+
+#include <algorithm>
+#include <cmath>
+
 namespace
 {
     const float Scalar = 3.f;
@@ -32,6 +37,12 @@ namespace
     const float ViewRadius = 60.f;
     const float ViewRadiusSqr = ViewRadius * ViewRadius;
 
+    const std::uint32_t BackgroundShade = 230; //so halo won't bleach
+    const sf::Uint8 HaloBrightness = 25;
+    const sf::Color FogColour(72, 64, 56);
+    const std::uint32_t FogStrength = 210; //opacity of fully fogged tiles
+    const std::size_t MaxDirtyRects = 8; //after which they're merged into one
+
     const std::string MapShader = 
         R"(
         #version 120
@@ -56,34 +67,90 @@ namespace
 
             gl_FragColor = colour;
         })";
+
+
+    //the two fog tiles, and the weight of the second, that a
+    //row or column of texels is bilinearly filtered from
+    struct FogSample final
+    {
+        std::size_t first = 0;
+        std::size_t second = 0;
+        std::uint32_t weight = 0; //out of 256
+    };
+
+    FogSample getFogSample(std::int32_t texel, float tileSize, std::size_t tileCount)
+    {
+        auto position = ((static_cast<float>(texel) + 0.5f) / tileSize) - 0.5f;
+        position = xy::Util::Math::clamp(position, 0.f, static_cast<float>(tileCount - 1));
+
+        FogSample sample;
+        sample.first = static_cast<std::size_t>(position);
+        sample.second = std::min(sample.first + 1, tileCount - 1);
+        sample.weight = static_cast<std::uint32_t>((position - static_cast<float>(sample.first)) * 256.f);
+        return sample;
+    }
+
+    //same result as drawing with sf::BlendAlpha
+    void blend(sf::Uint8* dst, sf::Color src)
+    {
+        const std::uint32_t alpha = src.a;
+        const std::uint32_t inverse = 255 - alpha;
+        dst[0] = static_cast<sf::Uint8>((src.r * alpha + dst[0] * inverse) / 255);
+        dst[1] = static_cast<sf::Uint8>((src.g * alpha + dst[1] * inverse) / 255);
+        dst[2] = static_cast<sf::Uint8>((src.b * alpha + dst[2] * inverse) / 255);
+        dst[3] = static_cast<sf::Uint8>(alpha + (dst[3] * inverse) / 255);
+    }
+
+    sf::IntRect getBounds(sf::FloatRect rect)
+    {
+        const auto left = static_cast<std::int32_t>(std::floor(rect.left));
+        const auto top = static_cast<std::int32_t>(std::floor(rect.top));
+        const auto right = static_cast<std::int32_t>(std::ceil(rect.left + rect.width));
+        const auto bottom = static_cast<std::int32_t>(std::ceil(rect.top + rect.height));
+        return { left, top, right - left, bottom - top };
+    }
+
+    sf::IntRect getUnion(const sf::IntRect& a, const sf::IntRect& b)
+    {
+        const auto left = std::min(a.left, b.left);
+        const auto top = std::min(a.top, b.top);
+        const auto right = std::max(a.left + a.width, b.left + b.width);
+        const auto bottom = std::max(a.top + a.height, b.top + b.height);
+        return { left, top, right - left, bottom - top };
+    }
 }
 
 MiniMap::MiniMap(xy::TextureResource& tr)
     : m_textureResource (tr),
-    m_localPlayer       (0)
+    m_localPlayer       (0),
+    m_fogOfWar          (Global::TileCountX, Global::TileCountY, Global::TileSize / Scalar),
+    m_viewStamp         (0),
+    m_lastRevealTile    (-1, -1),
+    m_fullRedraw        (false),
+    m_uploadedTexelCount(0)
 {
     auto textureSize = sf::Vector2u(Global::IslandSize / Scalar);
-    m_outputBuffer.create(textureSize.x, textureSize.y);
     m_backgroundTexture.create(textureSize.x, textureSize.y);
+    m_outputTexture.create(textureSize.x, textureSize.y);
+    m_background.resize(textureSize.x * textureSize.y * 4, 0);
 
-    m_backgroundSprite.setTexture(m_backgroundTexture.getTexture());
-    m_backgroundSprite.setColor({ 230, 230, 230 }); //so halo won't bleach
-
-    m_crossTexture = &m_textureResource.get("assets/images/cross.png");
+    m_crossImage = m_textureResource.get("assets/images/cross.png").copyToImage();
 
     m_mapShader.loadFromMemory(MapShader, sf::Shader::Fragment);
 
     int i = 0;
     for (auto& p : m_playerPoints)
     {
-        p.setFillColor(Global::PlayerColours[i++]);
-        p.setRadius(IconSize);
-        p.setOrigin(IconSize, IconSize);
+        p.colour = Global::PlayerColours[i++];
+        p.radius = IconSize;
     }
 
-    m_halo.setRadius(ViewRadius);
-    m_halo.setOrigin(ViewRadius, ViewRadius);
-    m_halo.setFillColor({ 25, 25, 25 });
+    m_halo.radius = ViewRadius;
+    m_halo.colour = { HaloBrightness, HaloBrightness, HaloBrightness };
+
+    m_viewStamp = m_fogOfWar.addStamp(ViewRadius);
+
+    addDirtyRect({ 0, 0, static_cast<std::int32_t>(textureSize.x), static_cast<std::int32_t>(textureSize.y) });
 }
 
 void MiniMap::setTexture(const sf::Texture& texture)
@@ -106,11 +173,25 @@ void MiniMap::setTexture(const sf::Texture& texture)
     scrollSpr.setTextureRect({ 128,0,128,128 });
     m_backgroundTexture.draw(scrollSpr);
     m_backgroundTexture.display();
+
+    //read back once so the map can be composited on the CPU
+    auto image = m_backgroundTexture.getTexture().copyToImage();
+    const auto* pixels = image.getPixelsPtr();
+    for (auto i = 0u; i < m_background.size(); i += 4)
+    {
+        m_background[i] = static_cast<sf::Uint8>((pixels[i] * BackgroundShade) / 255);
+        m_background[i + 1] = static_cast<sf::Uint8>((pixels[i + 1] * BackgroundShade) / 255);
+        m_background[i + 2] = static_cast<sf::Uint8>((pixels[i + 2] * BackgroundShade) / 255);
+        m_background[i + 3] = pixels[i + 3];
+    }
+
+    auto size = m_outputTexture.getSize();
+    addDirtyRect({ 0, 0, static_cast<std::int32_t>(size.x), static_cast<std::int32_t>(size.y) });
 }
 
 const sf::Texture& MiniMap::getTexture() const
 {
-    return m_outputBuffer.getTexture();
+    return m_outputTexture;
 }
 
 void MiniMap::handleMessage(const xy::Message& msg)
@@ -118,38 +199,42 @@ void MiniMap::handleMessage(const xy::Message& msg)
     if (msg.id == MessageID::MiniMapUpdate)
     {
         const auto& data = msg.getData<MiniMapEvent>();
-        m_playerPoints[data.actorID - Actor::ID::PlayerOne].setPosition(data.position / Scalar);
+        setPlayerPosition(data.actorID - Actor::ID::PlayerOne, data.position);
     }
 }
 
 void MiniMap::updateTexture()
 {
-    //TODO update FOW texture
-
-    m_outputBuffer.clear(sf::Color::Transparent);
-
-    //draw background
-    m_outputBuffer.draw(m_backgroundSprite);
-    
-    //draw halo over player
-    m_outputBuffer.draw(m_halo, sf::BlendAdd);
-
-    //crosses
-    m_outputBuffer.draw(m_crossVerts.data(), m_crossVerts.size(), sf::Quads, m_crossTexture);
-
-    for (const auto& p : m_playerPoints)
+    //a texel is filtered from the neighbouring fog tiles too,
+    //so the area to redraw is expanded by a tile on each side
+    auto fogRect = m_fogOfWar.getDirtyRect();
+    if (fogRect.width > 0)
     {
-        m_outputBuffer.draw(p);
+        const auto tileSize = m_fogOfWar.getTileSize();
+        addDirtyRect(getBounds({ (fogRect.left - 1) * tileSize, (fogRect.top - 1) * tileSize,
+            (fogRect.width + 2) * tileSize, (fogRect.height + 2) * tileSize }));
+        m_fogOfWar.clearDirtyRect();
     }
 
-    //TODO draw FOW - requires some double buffering..
+    if (m_fullRedraw)
+    {
+        auto size = m_outputTexture.getSize();
+        m_dirtyRects.clear();
+        m_dirtyRects.emplace_back(0, 0, static_cast<std::int32_t>(size.x), static_cast<std::int32_t>(size.y));
+    }
 
-    m_outputBuffer.display();
+    m_uploadedTexelCount = 0;
+    for (const auto& rect : m_dirtyRects)
+    {
+        drawRect(rect);
+    }
+    m_dirtyRects.clear();
 }
 
 void MiniMap::update()
 {
-    m_halo.setPosition(m_playerPoints[m_localPlayer].getPosition());
+    const auto& localPlayer = m_playerPoints[m_localPlayer];
+    m_halo.position = localPlayer.position;
 
     for (auto i = 0u; i < m_playerPoints.size(); ++i)
     {
@@ -158,16 +243,36 @@ void MiniMap::update()
             auto colour = Global::PlayerColours[i];
 
             //measure distance to point and set to transparent if too far
-            auto len2 = xy::Util::Vector::lengthSquared(m_playerPoints[i].getPosition() - m_playerPoints[m_localPlayer].getPosition());
+            auto len2 = xy::Util::Vector::lengthSquared(m_playerPoints[i].position - localPlayer.position);
             if (len2 > ViewRadiusSqr)
             {
                 float diff = len2 - ViewRadiusSqr;
                 float alpha = 1.f - xy::Util::Math::clamp(diff / 2000.f, 0.f, 1.f);
                 colour.a = static_cast<sf::Uint8>(255.f * alpha);
             }
-            m_playerPoints[i].setFillColor(colour);
+            m_playerPoints[i].colour = colour;
+        }
+    }
+
+    //the stamp is centred on a tile so only needs
+    //reapplying when the player moves to a new one
+    if (localPlayer.placed)
+    {
+        sf::Vector2i tile(static_cast<std::int32_t>(std::floor(localPlayer.position.x / m_fogOfWar.getTileSize())),
+            static_cast<std::int32_t>(std::floor(localPlayer.position.y / m_fogOfWar.getTileSize())));
+
+        if (tile != m_lastRevealTile)
+        {
+            m_fogOfWar.reveal(localPlayer.position, m_viewStamp);
+            m_lastRevealTile = tile;
         }
     }
+
+    updateIcon(m_halo);
+    for (auto& p : m_playerPoints)
+    {
+        updateIcon(p);
+    }
 }
 
 void MiniMap::setLocalPlayer(std::size_t p)
@@ -179,17 +284,11 @@ void MiniMap::setLocalPlayer(std::size_t p)
 
     if (pos.x < (xy::DefaultSceneSize.x / Scalar) / 2.f)
     {
-        m_crossVerts.emplace_back(sf::Vector2f(-10.f, -10.f) + pos, sf::Vector2f(16.f, 0.f));
-        m_crossVerts.emplace_back(sf::Vector2f(54.f, -10.f) + pos, sf::Vector2f(48.f, 0.f));
-        m_crossVerts.emplace_back(sf::Vector2f(54.f, 22.f) + pos, sf::Vector2f(48.f, 16.f));
-        m_crossVerts.emplace_back(sf::Vector2f(-10.f, 22.f) + pos, sf::Vector2f(16.f, 16.f));
+        addCrossQuad({ pos.x - 10.f, pos.y - 10.f, 64.f, 32.f }, { 16.f, 0.f, 32.f, 16.f });
     }
     else
     {
-        m_crossVerts.emplace_back(sf::Vector2f(-54.f, -10.f) + pos, sf::Vector2f(16.f, 0.f));
-        m_crossVerts.emplace_back(sf::Vector2f(10.f, -10.f) + pos, sf::Vector2f(48.f, 0.f));
-        m_crossVerts.emplace_back(sf::Vector2f(10.f, 22.f) + pos, sf::Vector2f(48.f, 16.f));
-        m_crossVerts.emplace_back(sf::Vector2f(-54.f, 22.f) + pos, sf::Vector2f(16.f, 16.f));
+        addCrossQuad({ pos.x - 54.f, pos.y - 10.f, 64.f, 32.f }, { 16.f, 0.f, 32.f, 16.f });
     }
 }
 
@@ -198,24 +297,224 @@ void MiniMap::addCross(sf::Vector2f position)
     position /= Scalar;
 
     static const float CrossSize = 8.f;
-    static const std::array<sf::Vector2f, 4u> CrossPositions =
+    addCrossQuad({ position.x - CrossSize, position.y - CrossSize, CrossSize * 2.f, CrossSize * 2.f },
+        { 0.f, 0.f, CrossSize * 2.f, CrossSize * 2.f });
+}
+
+void MiniMap::setPlayerPosition(std::size_t player, sf::Vector2f position)
+{
+    m_playerPoints[player].position = position / Scalar;
+    m_playerPoints[player].placed = true;
+}
+
+//private
+void MiniMap::addCrossQuad(sf::FloatRect bounds, sf::FloatRect textureRect)
+{
+    m_crosses.push_back({ bounds, textureRect });
+    addDirtyRect(getBounds(bounds));
+}
+
+void MiniMap::updateIcon(Icon& icon)
+{
+    if (icon.position != icon.drawnPosition
+        || icon.colour != icon.drawnColour
+        || icon.drawnBounds.width == 0)
     {
-        sf::Vector2f(-CrossSize, -CrossSize),
-        sf::Vector2f(CrossSize, -CrossSize),
-        sf::Vector2f(CrossSize, CrossSize),
-        sf::Vector2f(-CrossSize, CrossSize)
-    };
+        //erase the old position as well as drawing the new one
+        addDirtyRect(icon.drawnBounds);
 
-    static const std::array<sf::Vector2f, 4u> UVs = 
+        icon.drawnBounds = getBounds({ icon.position.x - icon.radius, icon.position.y - icon.radius, icon.radius * 2.f, icon.radius * 2.f });
+        icon.drawnPosition = icon.position;
+        icon.drawnColour = icon.colour;
+
+        addDirtyRect(icon.drawnBounds);
+    }
+}
+
+void MiniMap::addDirtyRect(sf::IntRect rect)
+{
+    auto size = m_outputTexture.getSize();
+    const auto left = std::max(rect.left, 0);
+    const auto top = std::max(rect.top, 0);
+    const auto right = std::min(rect.left + rect.width, static_cast<std::int32_t>(size.x));
+    const auto bottom = std::min(rect.top + rect.height, static_cast<std::int32_t>(size.y));
+    if (right <= left || bottom <= top)
     {
-        sf::Vector2f(),
-        sf::Vector2f(CrossSize * 2.f, 0.f),
-        sf::Vector2f(CrossSize * 2.f, CrossSize * 2.f),
-        sf::Vector2f(0.f, CrossSize * 2.f)
+        return;
+    }
+    sf::IntRect area(left, top, right - left, bottom - top);
+
+    //merge overlapping areas so that no texel is uploaded twice
+    for (auto i = 0u; i < m_dirtyRects.size();)
+    {
+        if (m_dirtyRects[i].intersects(area))
+        {
+            area = getUnion(area, m_dirtyRects[i]);
+            m_dirtyRects[i] = m_dirtyRects.back();
+            m_dirtyRects.pop_back();
+            i = 0;
+        }
+        else
+        {
+            i++;
+        }
+    }
+    m_dirtyRects.push_back(area);
+
+    if (m_dirtyRects.size() > MaxDirtyRects)
+    {
+        for (auto i = 1u; i < m_dirtyRects.size(); ++i)
+        {
+            m_dirtyRects[0] = getUnion(m_dirtyRects[0], m_dirtyRects[i]);
+        }
+        m_dirtyRects.resize(1);
+    }
+}
+
+void MiniMap::drawRect(const sf::IntRect& rect)
+{
+    const auto textureWidth = static_cast<std::int32_t>(m_outputTexture.getSize().x);
+    const auto width = static_cast<std::size_t>(rect.width);
+    const auto height = static_cast<std::size_t>(rect.height);
+    m_pixels.resize(width * height * 4);
+
+    const auto& fog = m_fogOfWar.getValues();
+    const auto fogWidth = m_fogOfWar.getWidth();
+    const auto tileSize = m_fogOfWar.getTileSize();
+
+    std::vector<FogSample> columns(width);
+    for (auto x = 0u; x < width; ++x)
+    {
+        columns[x] = getFogSample(rect.left + static_cast<std::int32_t>(x), tileSize, fogWidth);
+    }
+
+    //icons are drawn where they were when the dirty rects were last updated
+    const auto haloRadiusSqr = m_halo.radius * m_halo.radius;
+
+    //background, fog and halo
+    const std::uint32_t fogRed = FogColour.r, fogGreen = FogColour.g, fogBlue = FogColour.b;
+    std::vector<std::uint32_t> fogRow(fogWidth);
+    for (auto y = 0u; y < height; ++y)
+    {
+        //filter the fog vertically once per row, and horizontally per texel
+        const auto row = getFogSample(rect.top + static_cast<std::int32_t>(y), tileSize, m_fogOfWar.getHeight());
+        const auto* fogTop = &fog[row.first * fogWidth];
+        const auto* fogBottom = &fog[row.second * fogWidth];
+        for (auto i = columns.front().first; i <= columns.back().second; ++i)
+        {
+            fogRow[i] = fogTop[i] * (256 - row.weight) + fogBottom[i] * row.weight;
+        }
+
+        const auto* src = &m_background[((rect.top + y) * textureWidth + rect.left) * 4];
+        auto* dst = &m_pixels[y * width * 4];
+
+        //everything is read into locals before writing, else the compiler
+        //has to assume each write through dst may have changed it
+        for (auto x = 0u; x < width; ++x, src += 4, dst += 4)
+        {
+            const auto column = columns[x];
+            const std::uint32_t fogAmount = (((fogRow[column.first] * (256 - column.weight) + fogRow[column.second] * column.weight) >> 16) * FogStrength) / 255;
+            const std::uint32_t inverse = 255 - fogAmount;
+            const std::uint32_t red = src[0], green = src[1], blue = src[2], alpha = src[3];
+
+            dst[0] = static_cast<sf::Uint8>((red * inverse + fogRed * fogAmount) / 255);
+            dst[1] = static_cast<sf::Uint8>((green * inverse + fogGreen * fogAmount) / 255);
+            dst[2] = static_cast<sf::Uint8>((blue * inverse + fogBlue * fogAmount) / 255);
+            dst[3] = static_cast<sf::Uint8>(alpha);
+        }
+
+        //same as drawing with sf::BlendAdd. Covers the texels
+        //on this row whose centres are inside the halo
+        const auto haloY = (static_cast<float>(rect.top + y) + 0.5f) - m_halo.drawnPosition.y;
+        const auto haloYSqr = haloY * haloY;
+        if (haloYSqr <= haloRadiusSqr)
+        {
+            const auto halfWidth = std::sqrt(haloRadiusSqr - haloYSqr);
+            const auto start = std::max(rect.left, static_cast<std::int32_t>(std::ceil(m_halo.drawnPosition.x - halfWidth - 0.5f)));
+            const auto end = std::min(rect.left + rect.width, static_cast<std::int32_t>(std::floor(m_halo.drawnPosition.x + halfWidth - 0.5f)) + 1);
+
+            dst = &m_pixels[y * width * 4];
+            for (auto x = start - rect.left; x < end - rect.left; ++x)
+            {
+                auto* texel = dst + x * 4;
+                texel[0] = static_cast<sf::Uint8>(std::min(255, texel[0] + m_halo.colour.r));
+                texel[1] = static_cast<sf::Uint8>(std::min(255, texel[1] + m_halo.colour.g));
+                texel[2] = static_cast<sf::Uint8>(std::min(255, texel[2] + m_halo.colour.b));
+                texel[3] = 255;
+            }
+        }
+    }
+
+    //returns the part of the given bounds which overlap this rect, relative to it
+    const auto clip = [&rect](sf::IntRect bounds, std::int32_t& startX, std::int32_t& startY, std::int32_t& endX, std::int32_t& endY)
+    {
+        startX = std::max(bounds.left, rect.left) - rect.left;
+        startY = std::max(bounds.top, rect.top) - rect.top;
+        endX = std::min(bounds.left + bounds.width, rect.left + rect.width) - rect.left;
+        endY = std::min(bounds.top + bounds.height, rect.top + rect.height) - rect.top;
+        return (endX > startX && endY > startY);
     };
 
-    for (auto i = 0u; i < CrossPositions.size(); ++i)
+    std::int32_t startX = 0, startY = 0, endX = 0, endY = 0;
+
+    //crosses
+    const auto crossSize = m_crossImage.getSize();
+    for (const auto& cross : m_crosses)
     {
-        m_crossVerts.emplace_back(position + CrossPositions[i], UVs[i]);
+        if (!clip(getBounds(cross.bounds), startX, startY, endX, endY))
+        {
+            continue;
+        }
+
+        const auto scaleX = cross.textureRect.width / cross.bounds.width;
+        const auto scaleY = cross.textureRect.height / cross.bounds.height;
+
+        for (auto y = startY; y < endY; ++y)
+        {
+            const auto positionY = static_cast<float>(rect.top + y) + 0.5f;
+            if (positionY < cross.bounds.top || positionY >= cross.bounds.top + cross.bounds.height)
+            {
+                continue;
+            }
+            const auto v = std::min(static_cast<std::uint32_t>(cross.textureRect.top + (positionY - cross.bounds.top) * scaleY), crossSize.y - 1);
+
+            for (auto x = startX; x < endX; ++x)
+            {
+                const auto positionX = static_cast<float>(rect.left + x) + 0.5f;
+                if (positionX < cross.bounds.left || positionX >= cross.bounds.left + cross.bounds.width)
+                {
+                    continue;
+                }
+                const auto u = std::min(static_cast<std::uint32_t>(cross.textureRect.left + (positionX - cross.bounds.left) * scaleX), crossSize.x - 1);
+
+                blend(&m_pixels[(y * width + x) * 4], m_crossImage.getPixel(u, v));
+            }
+        }
     }
-}
\ No newline at end of file
+
+    //player icons
+    for (const auto& p : m_playerPoints)
+    {
+        if (!clip(p.drawnBounds, startX, startY, endX, endY))
+        {
+            continue;
+        }
+
+        const auto radiusSqr = p.radius * p.radius;
+        for (auto y = startY; y < endY; ++y)
+        {
+            const auto offsetY = (static_cast<float>(rect.top + y) + 0.5f) - p.drawnPosition.y;
+            for (auto x = startX; x < endX; ++x)
+            {
+                const auto offsetX = (static_cast<float>(rect.left + x) + 0.5f) - p.drawnPosition.x;
+                if (offsetX * offsetX + offsetY * offsetY <= radiusSqr)
+                {
+                    blend(&m_pixels[(y * width + x) * 4], p.drawnColour);
+                }
+            }
+        }
+    }
+
+    m_outputTexture.update(m_pixels.data(), rect.width, rect.height, rect.left, rect.top);
+    m_uploadedTexelCount += width * height;
+}
@@ -18,11 +18,13 @@ Copyright 2019 Matt Marchant
 
 #pragma once
 
+#include "FogOfWar.hpp"
+
 #include <SFML/Graphics/RenderTexture.hpp>
-#include <SFML/Graphics/Sprite.hpp>
-#include <SFML/Graphics/CircleShape.hpp> //TODO could consolidate these into a vert array
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Image.hpp>
 #include <SFML/Graphics/Shader.hpp>
-#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Color.hpp>
 
 #include <vector>
 #include <array>
@@ -33,6 +35,11 @@ namespace xy
     class Message;
 }
 
+/*
+The map is composited on the CPU - the island background, fog of war,
+view halo, crosses and player icons - and only the rectangles which
+changed since the last update are uploaded to the output texture.
+*/
 class MiniMap final
 {
 public:
@@ -46,6 +53,7 @@ public:
 
     void handleMessage(const xy::Message&);
 
+    //uploads any part of the map which changed since the last call
     void updateTexture();
 
     void update();
@@ -54,21 +62,60 @@ public:
 
     void addCross(sf::Vector2f);
 
+    //sets the position of the given player's icon, in world units
+    void setPlayerPosition(std::size_t, sf::Vector2f);
+
+    //redraws the entire texture on every update, for comparison
+    void setFullRedraw(bool full) { m_fullRedraw = full; }
+
+    //number of texels uploaded by the most recent call to updateTexture()
+    std::size_t getUploadedTexelCount() const { return m_uploadedTexelCount; }
+
+    const FogOfWar& getFogOfWar() const { return m_fogOfWar; }
+
 private:
 
     xy::TextureResource& m_textureResource;
-    std::array<sf::CircleShape, 4u> m_playerPoints;
-    sf::CircleShape m_halo;
+
+    struct Icon final
+    {
+        sf::Vector2f position;
+        sf::Color colour;
+        float radius = 0.f;
+        bool placed = false; //received a position
+        sf::IntRect drawnBounds; //as of the last update
+        sf::Vector2f drawnPosition;
+        sf::Color drawnColour;
+    };
+    std::array<Icon, 4u> m_playerPoints;
+    Icon m_halo;
     std::size_t m_localPlayer;
 
-    sf::RenderTexture m_outputBuffer;
-    sf::RenderTexture m_backgroundTexture;
-    //sf::RenderTexture m_fowTexture;
+    FogOfWar m_fogOfWar;
+    std::size_t m_viewStamp;
+    sf::Vector2i m_lastRevealTile;
 
+    sf::RenderTexture m_backgroundTexture;
     sf::Shader m_mapShader;
 
-    sf::Texture* m_crossTexture;
-    std::vector<sf::Vertex> m_crossVerts;
-
-    sf::Sprite m_backgroundSprite;
-};
\ No newline at end of file
+    sf::Texture m_outputTexture;
+    std::vector<sf::Uint8> m_background;
+    std::vector<sf::Uint8> m_pixels;
+
+    struct Cross final
+    {
+        sf::FloatRect bounds;
+        sf::FloatRect textureRect;
+    };
+    sf::Image m_crossImage;
+    std::vector<Cross> m_crosses;
+
+    std::vector<sf::IntRect> m_dirtyRects;
+    bool m_fullRedraw;
+    std::size_t m_uploadedTexelCount;
+
+    void addCrossQuad(sf::FloatRect bounds, sf::FloatRect textureRect);
+    void updateIcon(Icon&);
+    void addDirtyRect(sf::IntRect);
+    void drawRect(const sf::IntRect&);
+};
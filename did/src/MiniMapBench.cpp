@@ -0,0 +1,144 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "MiniMapBench.hpp"
+#include "MiniMap.hpp"
+#include "GlobalConsts.hpp"
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/Graphics/Image.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+    const float FrameTime = 1.f / 60.f;
+    const float WalkSpeed = 80.f; //same as the player
+
+    //walks back and forth between the player's boat, the middle
+    //of the island and the next player's boat
+    struct Walk final
+    {
+        std::vector<sf::Vector2f> points;
+
+        sf::Vector2f getPosition(float time) const
+        {
+            auto distance = time * WalkSpeed;
+            for (auto i = 0u; ; i = (i + 1) % points.size())
+            {
+                const auto& start = points[i];
+                const auto& end = points[(i + 1) % points.size()];
+                const auto diff = end - start;
+                const auto length = std::sqrt((diff.x * diff.x) + (diff.y * diff.y));
+                if (distance <= length)
+                {
+                    return start + diff * (distance / length);
+                }
+                distance -= length;
+            }
+        }
+    };
+
+    struct RunResult final
+    {
+        float time = 0.f;
+        float peak = 0.f;
+        float texels = 0.f;
+        float revealed = 0.f;
+        sf::Image output;
+    };
+
+    RunResult run(xy::TextureResource& textureResource, const sf::Texture& islandTexture, float duration, bool fullRedraw)
+    {
+        std::vector<Walk> walks(Global::BoatPositions.size());
+        const auto centre = Global::IslandSize / 2.f;
+        for (auto i = 0u; i < walks.size(); ++i)
+        {
+            const auto& next = Global::BoatPositions[(i + 1) % Global::BoatPositions.size()];
+            walks[i].points = { Global::BoatPositions[i], centre, next, centre };
+        }
+
+        MiniMap miniMap(textureResource);
+        miniMap.setTexture(islandTexture);
+        miniMap.setLocalPlayer(0);
+        miniMap.addCross(centre);
+        miniMap.setFullRedraw(fullRedraw);
+        miniMap.updateTexture();
+
+        RunResult result;
+        sf::Int64 totalTime = 0;
+        sf::Int64 peakTime = 0;
+        std::size_t totalTexels = 0;
+        std::size_t frameCount = 0;
+
+        for (auto time = 0.f; time < duration; time += FrameTime)
+        {
+            for (auto i = 0u; i < walks.size(); ++i)
+            {
+                miniMap.setPlayerPosition(i, walks[i].getPosition(time));
+            }
+
+            sf::Clock timer;
+            miniMap.update();
+            miniMap.updateTexture();
+            auto frameTime = timer.getElapsedTime().asMicroseconds();
+
+            totalTime += frameTime;
+            peakTime = std::max(peakTime, frameTime);
+            totalTexels += miniMap.getUploadedTexelCount();
+            frameCount++;
+        }
+
+        if (frameCount)
+        {
+            result.time = static_cast<float>(totalTime) / frameCount;
+            result.texels = static_cast<float>(totalTexels) / frameCount;
+        }
+        result.peak = static_cast<float>(peakTime);
+
+        const auto& fog = miniMap.getFogOfWar().getValues();
+        result.revealed = static_cast<float>(std::count_if(fog.begin(), fog.end(), [](std::uint8_t v) { return v < 128; })) / fog.size();
+        result.output = miniMap.getTexture().copyToImage();
+
+        return result;
+    }
+}
+
+MiniMapBenchResult runMiniMapBench(xy::TextureResource& textureResource, const sf::Texture& islandTexture, float duration)
+{
+    const auto partial = run(textureResource, islandTexture, duration, false);
+    const auto full = run(textureResource, islandTexture, duration, true);
+
+    MiniMapBenchResult result;
+    result.partialTime = partial.time;
+    result.partialPeak = partial.peak;
+    result.partialTexels = partial.texels;
+    result.fullTime = full.time;
+    result.fullPeak = full.peak;
+    result.fullTexels = full.texels;
+    result.revealed = partial.revealed;
+
+    const auto size = partial.output.getSize();
+    result.matches = (size == full.output.getSize())
+        && std::memcmp(partial.output.getPixelsPtr(), full.output.getPixelsPtr(), size.x * size.y * 4) == 0;
+
+    return result;
+}
@@ -0,0 +1,52 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+namespace xy
+{
+    class TextureResource;
+}
+
+namespace sf
+{
+    class Texture;
+}
+
+/*
+Walks all four players around the island on a scripted route for the
+given duration at 60 frames per second, and updates a minimap each frame
+both with partial updates and with full redraws, to compare the cost of
+each. The final textures of both are compared, as they should be identical.
+Requires a GL context, so it can only be run from the game.
+*/
+struct MiniMapBenchResult final
+{
+    float partialTime = 0.f; //average us per frame
+    float partialPeak = 0.f;
+    float partialTexels = 0.f; //average uploaded per frame
+    float fullTime = 0.f;
+    float fullPeak = 0.f;
+    float fullTexels = 0.f;
+    float revealed = 0.f; //proportion of the map revealed by the local player
+    bool matches = false;
+};
+
+MiniMapBenchResult runMiniMapBench(xy::TextureResource&, const sf::Texture& islandTexture, float duration = 60.f);
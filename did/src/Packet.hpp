@@ -54,6 +54,7 @@ namespace PacketID
         TreasureUpdate, //uint8 number of treasure remaining
         DebugUpdate, //contains state and entity ID
         ItemDespawn, //if item timed out or wa collected, and position
+        BotStats, //server side AI timings, debug builds only
         //PhysicsUpdate, //data for client side physics interp
         //PhysicsSync, //data to sync physics state on the client
 
@@ -132,6 +132,12 @@ struct DebugState final
     std::int8_t target = -1;
 };
 
+struct BotStats final
+{
+    std::int32_t processTime = 0; //us
+    float decisionLatency = 0.f; //ms
+};
+
 struct ItemState final
 {
     float x = 0.f;
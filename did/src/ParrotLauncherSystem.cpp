@@ -23,6 +23,7 @@ Copyright 2019 Matt Marchant
 #include "Server.hpp"
 #include "MessageIDs.hpp"
 #include "GlobalConsts.hpp"
+#include "ServerProfiler.hpp"
 
 ParrotLauncherSystem::ParrotLauncherSystem(xy::MessageBus& mb, Server::SharedStateData& sd)
     : xy::System(mb, typeid(ParrotLauncherSystem)),
@@ -49,6 +50,8 @@ void ParrotLauncherSystem::handleMessage(const xy::Message& msg)
 
 void ParrotLauncherSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::ParrotLauncherSystem);
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
@@ -64,7 +64,8 @@ namespace
 
 PathFinder::PathFinder()
     : m_thread(&PathFinder::processQueue, this),
-    m_threadRunning(true)
+    m_threadRunning(true),
+    m_async(true)
 {
     m_thread.launch();
 }
@@ -164,6 +165,12 @@ std::vector<sf::Vector2f> PathFinder::plotPath(const sf::Vector2i& start, const
 
 void PathFinder::plotPathAsync(const sf::Vector2i& start, const sf::Vector2i& end, std::vector<sf::Vector2f>& dest)
 {
+    if (!m_async)
+    {
+        dest = plotPath(start, end);
+        return;
+    }
+
     Job job;
     job.start = start;
     job.end = end;
@@ -54,6 +54,9 @@ public:
     std::vector<sf::Vector2f> plotPath(const sf::Vector2i&, const sf::Vector2i&) const;
     //plots a path asyncronously to prevent blocking
     void plotPathAsync(const sf::Vector2i&, const sf::Vector2i&, std::vector<sf::Vector2f>&);
+    //when disabled plotPathAsync() writes the path immediately, so that
+    //paths always arrive on the same tick when a match is recorded or replayed
+    void setAsync(bool async) { m_async = async; }
 
     //returns true if a ray collides with the grid
     //params are world coords.
@@ -90,6 +93,7 @@ private:
     sf::Thread m_thread;
     sf::Mutex m_mutex;
     std::atomic_bool m_threadRunning;
+    bool m_async;
     void processQueue();
 
     struct Job final
@@ -27,6 +27,7 @@ Copyright 2019 Matt Marchant
 #include "CarriableSystem.hpp"
 #include "SkullShieldSystem.hpp"
 #include "QuadTreeFilter.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/core/App.hpp>
 #include <xyginext/ecs/components/Transform.hpp>
@@ -57,6 +58,8 @@ PlayerSystem::PlayerSystem(xy::MessageBus& mb)
 //public
 void PlayerSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::PlayerSystem);
+
     auto& entities = getEntities();
 
     for (auto entity : entities)
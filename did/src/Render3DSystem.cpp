@@ -32,8 +32,26 @@ Copyright 2019 Matt Marchant
 #include <algorithm>
 #include <cmath>
 
+namespace
+{
+    //insertion sort gives up once this many moves per item have been made
+    const std::size_t MaxInsertionMoves = 4;
+
+    const float ViewDistance = Global::IslandSize.y + Global::PlayerCameraOffset;
+
+    //maps signed depth to an unsigned key which sorts in the same order
+    std::uint32_t depthKey(std::int32_t depth)
+    {
+        return static_cast<std::uint32_t>(depth) ^ 0x80000000;
+    }
+}
+
 Render3DSystem::Render3DSystem(xy::MessageBus& mb)
-    : xy::System(mb, typeid(Render3DSystem))
+    : xy::System(mb, typeid(Render3DSystem)),
+    m_frame         (0),
+    m_cullTime      (0),
+    m_sortTime      (0),
+    m_radixSorted   (false)
 {
     requireComponent<xy::Drawable>();
     requireComponent<xy::Transform>();
@@ -42,64 +60,75 @@ Render3DSystem::Render3DSystem(xy::MessageBus& mb)
 //public
 void Render3DSystem::process(float)
 {
-    m_drawList.clear();
+    m_timer.restart();
+    m_frame++;
+
     auto camPos = getScene()->getActiveCamera().getComponent<xy::Transform>().getWorldPosition();
     camPos.y += Global::PlayerCameraOffset;
 
+    //mark everything visible this frame
+    std::size_t newCount = 0;
     auto& entities = getEntities();
     for (auto entity : entities)
     {
-        const auto& tx = entity.getComponent<xy::Transform>();
-        auto pos = tx.getWorldPosition();
-
-        //if we're behind the camera cull immediately
-        static const float ViewDistance = Global::IslandSize.y + Global::PlayerCameraOffset;
-        if (pos.y > camPos.y || pos.y < (camPos.y - ViewDistance))
+        if (!cull(entity, camPos))
         {
             continue;
         }
 
-        //point line test. if either of the top corners of the drawable
-        //bounds lie between the frustum lines it must be visible
-        const auto& drawable = entity.getComponent<xy::Drawable>();
-        auto worldBounds = tx.getWorldTransform().transformRect(drawable.getLocalBounds());
-
-        sf::Vector2f posA(worldBounds.left, worldBounds.top + worldBounds.height);
-        posA -= camPos;
-
-        float resultALeft = lineSide(m_frustum.left, posA);
-        float resultARight = lineSide(m_frustum.right, posA);
-        if (resultALeft < 0 && resultARight > 0)
+        auto idx = entity.getIndex();
+        if (idx >= m_slots.size())
         {
-            m_drawList.push_back(entity);
-            continue;
+            m_slots.resize(idx + 1);
         }
 
-        sf::Vector2f posB(worldBounds.left + worldBounds.width, worldBounds.top + worldBounds.height);
-        posB -= camPos;
+        auto& slot = m_slots[idx];
+        slot.entity = entity;
+        slot.frame = m_frame;
+        slot.key = depthKey(entity.getComponent<xy::Drawable>().getDepth());
 
-        float resultBLeft = lineSide(m_frustum.left, posB);
-        float resultBRight = lineSide(m_frustum.right, posB);
-        if (resultBLeft < 0 && resultBRight > 0)
+        if (!slot.listed)
         {
-            m_drawList.push_back(entity);
-            continue;
+            newCount++;
         }
+    }
 
-        //else if both the points straddle the frustum then the drawable passes right across it
-        if (resultALeft > 0 && resultBRight < 0)
+    //keep last frame's order for anything still visible,
+    //and append anything which has come into view
+    std::size_t count = 0;
+    for (auto& item : m_drawList)
+    {
+        auto& slot = m_slots[item.index];
+        if (slot.frame == m_frame)
         {
-            m_drawList.push_back(entity);
-            continue;
+            item.key = slot.key;
+            m_drawList[count++] = item;
+        }
+        else
+        {
+            slot.listed = false;
         }
     }
+    m_drawList.resize(count);
 
-    //depth sort drawlist
-    std::sort(m_drawList.begin(), m_drawList.end(),
-        [](const xy::Entity& entA, const xy::Entity& entB)
+    if (newCount)
     {
-        return entA.getComponent<xy::Drawable>().getDepth() < entB.getComponent<xy::Drawable>().getDepth();
-    });
+        for (auto entity : entities)
+        {
+            auto idx = entity.getIndex();
+            if (idx < m_slots.size()
+                && m_slots[idx].frame == m_frame
+                && !m_slots[idx].listed)
+            {
+                m_slots[idx].listed = true;
+                m_drawList.push_back({ m_slots[idx].key, static_cast<std::uint32_t>(idx) });
+            }
+        }
+    }
+    m_cullTime = m_timer.restart().asMicroseconds();
+
+    sortDrawList();
+    m_sortTime = m_timer.getElapsedTime().asMicroseconds();
 }
 
 void Render3DSystem::setFOV(float fov)
@@ -112,15 +141,122 @@ void Render3DSystem::setFOV(float fov)
 }
 
 //private
-float Render3DSystem::lineSide(sf::Vector2f line, sf::Vector2f point)
+bool Render3DSystem::cull(xy::Entity entity, sf::Vector2f camPos) const
+{
+    const auto& tx = entity.getComponent<xy::Transform>();
+    auto pos = tx.getWorldPosition();
+
+    //if we're behind the camera cull immediately
+    if (pos.y > camPos.y || pos.y < (camPos.y - ViewDistance))
+    {
+        return false;
+    }
+
+    //point line test. if either of the top corners of the drawable
+    //bounds lie between the frustum lines it must be visible
+    const auto& drawable = entity.getComponent<xy::Drawable>();
+    auto worldBounds = tx.getWorldTransform().transformRect(drawable.getLocalBounds());
+
+    sf::Vector2f posA(worldBounds.left, worldBounds.top + worldBounds.height);
+    posA -= camPos;
+
+    float resultALeft = lineSide(m_frustum.left, posA);
+    float resultARight = lineSide(m_frustum.right, posA);
+    if (resultALeft < 0 && resultARight > 0)
+    {
+        return true;
+    }
+
+    sf::Vector2f posB(worldBounds.left + worldBounds.width, worldBounds.top + worldBounds.height);
+    posB -= camPos;
+
+    float resultBLeft = lineSide(m_frustum.left, posB);
+    float resultBRight = lineSide(m_frustum.right, posB);
+    if (resultBLeft < 0 && resultBRight > 0)
+    {
+        return true;
+    }
+
+    //else if both the points straddle the frustum then the drawable passes right across it
+    return (resultALeft > 0 && resultBRight < 0);
+}
+
+void Render3DSystem::sortDrawList()
+{
+    //depth is mostly based on y position which changes very little
+    //between frames, so the list is usually nearly sorted and an
+    //insertion sort is close to linear. If too much has moved
+    //(eg the first frame, or a lot of new items) fall back to radix
+    m_radixSorted = false;
+    const std::size_t maxMoves = m_drawList.size() * MaxInsertionMoves;
+    std::size_t moves = 0;
+
+    for (auto i = 1u; i < m_drawList.size(); ++i)
+    {
+        auto item = m_drawList[i];
+        auto j = i;
+        while (j > 0 && m_drawList[j - 1].key > item.key)
+        {
+            m_drawList[j] = m_drawList[j - 1];
+            --j;
+
+            if (++moves > maxMoves)
+            {
+                m_drawList[j] = item;
+                radixSort();
+                return;
+            }
+        }
+        m_drawList[j] = item;
+    }
+}
+
+void Render3DSystem::radixSort()
+{
+    m_radixSorted = true;
+    m_sortBuffer.resize(m_drawList.size());
+
+    //LSD, 8 bits at a time
+    for (auto shift = 0u; shift < 32; shift += 8)
+    {
+        std::size_t counts[256] = {};
+        for (const auto& item : m_drawList)
+        {
+            counts[(item.key >> shift) & 0xff]++;
+        }
+
+        //all keys share this byte so the pass won't change anything
+        if (counts[(m_drawList[0].key >> shift) & 0xff] == m_drawList.size())
+        {
+            continue;
+        }
+
+        std::size_t offset = 0;
+        for (auto& count : counts)
+        {
+            auto c = count;
+            count = offset;
+            offset += c;
+        }
+
+        for (const auto& item : m_drawList)
+        {
+            m_sortBuffer[counts[(item.key >> shift) & 0xff]++] = item;
+        }
+        m_drawList.swap(m_sortBuffer);
+    }
+}
+
+float Render3DSystem::lineSide(sf::Vector2f line, sf::Vector2f point) const
 {
     return (line.y * point.x) - (line.x * point.y);
 }
 
 void Render3DSystem::draw(sf::RenderTarget& rt, sf::RenderStates states) const
 {
-    for (auto entity : m_drawList)
+    for (const auto& item : m_drawList)
     {
+        auto entity = m_slots[item.index].entity;
         const auto& drawable = entity.getComponent<xy::Drawable>();
         const auto& tx = entity.getComponent<xy::Transform>().getWorldTransform();
 
@@ -134,4 +270,4 @@ void Render3DSystem::draw(sf::RenderTarget& rt, sf::RenderStates states) const
 
         rt.draw(drawable, states);
     }
-}
\ No newline at end of file
+}
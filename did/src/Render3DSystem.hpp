@@ -21,6 +21,10 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/System.hpp>
 
 #include <SFML/Graphics/Drawable.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include <cstdint>
+#include <vector>
 
 class Render3DSystem final : public xy::System, public sf::Drawable
 {
@@ -31,6 +35,16 @@ public:
 
     void setFOV(float);
 
+    //time taken to cull and sort the draw list
+    //during the last update, in microseconds
+    std::int64_t getCullTime() const { return m_cullTime; }
+    std::int64_t getSortTime() const { return m_sortTime; }
+
+    //true if the last sort fell back to a radix sort
+    bool getRadixSorted() const { return m_radixSorted; }
+
+    std::size_t getDrawCount() const { return m_drawList.size(); }
+
 private:
 
     struct Frustum final
@@ -40,8 +54,36 @@ private:
         sf::Vector2f right;
     }m_frustum;
 
-    std::vector<xy::Entity> m_drawList;
+    //indexed by entity index
+    struct Slot final
+    {
+        xy::Entity entity;
+        std::uint32_t frame = 0; //frame in which this entity was last visible
+        std::uint32_t key = 0;
+        bool listed = false;
+    };
+    std::vector<Slot> m_slots;
+    std::uint32_t m_frame;
+
+    //the draw list persists between frames so that
+    //it's already nearly sorted when next updated
+    struct DrawItem final
+    {
+        std::uint32_t key = 0;
+        std::uint32_t index = 0;
+    };
+    std::vector<DrawItem> m_drawList;
+    std::vector<DrawItem> m_sortBuffer;
+
+    sf::Clock m_timer;
+    std::int64_t m_cullTime;
+    std::int64_t m_sortTime;
+    bool m_radixSorted;
+
+    bool cull(xy::Entity, sf::Vector2f) const;
+    void sortDrawList();
+    void radixSort();
 
-    float lineSide(sf::Vector2f, sf::Vector2f);
+    float lineSide(sf::Vector2f, sf::Vector2f) const;
     void draw(sf::RenderTarget&, sf::RenderStates) const override;
 };
\ No newline at end of file
@@ -36,6 +36,10 @@ using namespace Server;
 
 namespace
 {
+    const float LogicStep = 1.f / 60.f;
+    const float NetworkStep = 1.f / 30.f;
+    const std::uint64_t NetworkInterval = 2; //logic ticks per network update
+
     std::vector<const char*> RandomSeeds =
     {
         "buns", "flaps", "luminescence", "speef",
@@ -50,6 +54,14 @@ GameServer::GameServer()
     : m_thread          (&GameServer::run, this),
     m_running           (false),
     m_maxPlayers        (4),
+    m_port              (Global::GamePort),
+    m_dedicated         (false),
+    m_headless          (false),
+    m_resetRequested    (false),
+    m_tickCount         (0),
+    m_lastTickTime      (0),
+    m_peakTickTime      (0),
+    m_stateTickCount    (0),
     m_nextFreeID        (0)
 {
     m_sharedStateData.gameServer = this;
@@ -71,16 +83,19 @@ GameServer::~GameServer()
 //public
 void GameServer::start()
 {
-    if (!m_host.start("", Global::GamePort, 4, Global::NetworkChannels))
+    if (!m_host.start("", m_port, 4, Global::NetworkChannels))
     {
-        xy::Logger::log("Failed to start network host :(", xy::Logger::Type::Error);
+        xy::Logger::log("Failed to start network host on port " + std::to_string(m_port) + " :(", xy::Logger::Type::Error);
     }
     else
     {
-        xy::Logger::log("Launching Server Instance...", xy::Logger::Type::Info);
+        xy::Logger::log("Launching Server Instance on port " + std::to_string(m_port) + "...", xy::Logger::Type::Info);
 
         m_currentState = std::make_unique<LobbyState>(m_sharedStateData);
         m_running = true;
+        m_resetRequested = false;
+        m_tickCount = 0;
+        m_stateTickCount = 0;
 
         m_thread.launch();
     }
@@ -106,6 +121,70 @@ void GameServer::stop()
     }
 }
 
+ReplayResult GameServer::replay(const std::string& path)
+{
+    ReplayResult result;
+    if (m_running)
+    {
+        xy::Logger::log("Can't replay a match while the server is running", xy::Logger::Type::Error);
+        return result;
+    }
+
+    MatchReplay matchReplay;
+    if (!matchReplay.load(path))
+    {
+        return result;
+    }
+    result.loaded = true;
+    result.recordedTicks = matchReplay.getEndTick();
+
+    m_headless = true;
+    matchReplay.apply(m_sharedStateData);
+    m_sharedStateData.replay = &matchReplay;
+    m_tickCount = 0;
+    m_stateTickCount = 0;
+    m_peakTickTime = 0;
+
+    Server::Profiler::setActive(&m_profiler);
+
+    sf::Clock replayClock;
+
+    auto state = std::make_unique<GameState>(m_sharedStateData);
+    auto& gameState = *state;
+    m_currentState = std::move(state);
+
+    //keep ticking after the round ends, as the live server did
+    //until the state was changed, so that the tick counts match
+    while (!matchReplay.finished())
+    {
+        gameState.applyRecordedEvents();
+        if (!matchReplay.finished())
+        {
+            tick();
+        }
+    }
+
+    result.duration = replayClock.getElapsedTime().asMicroseconds();
+    result.ticks = static_cast<std::uint32_t>(m_tickCount);
+    result.peakTickTime = m_peakTickTime;
+    result.checksumCount = matchReplay.getChecksumCount();
+    result.mismatchCount = matchReplay.getMismatchCount();
+    result.firstMismatch = matchReplay.getFirstMismatch();
+
+    m_currentState.reset();
+    while (!m_messageBus.empty())
+    {
+        m_messageBus.poll();
+    }
+
+    Server::Profiler::setActive(nullptr);
+    m_sharedStateData.replay = nullptr;
+    m_sharedStateData.connectedClients.clear();
+    m_headless = false;
+
+    return result;
+}
+
 //private
 bool GameServer::pollNetwork(xy::NetEvent& evt)
 {
@@ -202,26 +281,31 @@ void GameServer::clientDisconnect(const xy::NetEvent& evt)
         m_freeIDs = { 0,1,2,3 };
         m_nextFreeID = 0;
 
-        m_running = false;
+        if (m_dedicated)
+        {
+            //go back to waiting for players
+            m_resetRequested = true;
+        }
+        else
+        {
+            m_running = false;
+        }
     }
 }
 
 void GameServer::run()
 {
-    static const float NetworkStep = 1.f / 30.f;
-    static const float LogicStep = 1.f / 60.f;
-
     sf::Clock pingClock;
 
-    sf::Clock networkClock;
-    float networkAccumulator = 0.f;
-
     sf::Clock logicClock;
     float logicAccumulator = 0.f;
 
     static const std::uint8_t MaxUpdates = 4;
     std::uint8_t getOutClause = MaxUpdates;
 
+    //any systems running on this thread report to our profiler
+    Server::Profiler::setActive(&m_profiler);
+
     while (m_running)
     {
         //if (pingClock.getElapsedTime().asMilliseconds() > 5000)
@@ -241,30 +325,13 @@ void GameServer::run()
             }
         }
 
-        //network tick updates (usually broadcasts)
-        networkAccumulator += networkClock.restart().asSeconds();
-        while (networkAccumulator > NetworkStep
-            && getOutClause--)
-        {
-            networkAccumulator -= NetworkStep;
-              
-            m_currentState->networkUpdate(NetworkStep);
-        }
-        getOutClause = MaxUpdates;
-
-        //logic updates
+        //logic updates, followed by network updates (usually broadcasts)
         logicAccumulator += logicClock.restart().asSeconds();
         while (logicAccumulator > LogicStep
             && getOutClause--)
         {
             logicAccumulator -= LogicStep;
-
-            while (!m_messageBus.empty())
-            {
-                m_currentState->handleMessage(m_messageBus.poll());
-            }
-
-            m_currentState->logicUpdate(LogicStep);
+            tick();
         }
         getOutClause = MaxUpdates;
 
@@ -286,6 +353,23 @@ void GameServer::run()
                 break;
             }
             m_serverTime.restart();
+            m_stateTickCount = 0;
+        }
+
+        if (m_resetRequested)
+        {
+            //dedicated server lost all its clients
+            while (!m_messageBus.empty())
+            {
+                m_messageBus.poll();
+            }
+
+            m_currentState = std::make_unique<LobbyState>(m_sharedStateData);
+            m_serverTime.restart();
+            m_stateTickCount = 0;
+            m_resetRequested = false;
+
+            xy::Logger::log("All clients left, server on port " + std::to_string(m_port) + " returned to lobby", xy::Logger::Type::Info);
         }
     }
 
@@ -302,3 +386,40 @@ void GameServer::run()
 
     m_host.stop();
 }
+
+void GameServer::tick()
+{
+    sf::Clock tickClock;
+
+    {
+        Server::ProfileScope profile(Server::ProfileID::MessageHandling);
+        while (!m_messageBus.empty())
+        {
+            m_currentState->handleMessage(m_messageBus.poll());
+        }
+    }
+
+    {
+        Server::ProfileScope profile(Server::ProfileID::LogicUpdate);
+        m_currentState->logicUpdate(LogicStep);
+    }
+
+    auto tickTime = tickClock.getElapsedTime().asMicroseconds();
+    m_profiler.addSample(Server::ProfileID::Tick, tickTime);
+    m_profiler.update(LogicStep);
+
+    m_lastTickTime = tickTime;
+    if (tickTime > m_peakTickTime)
+    {
+        m_peakTickTime = tickTime;
+    }
+    m_tickCount++;
+
+    //network updates are counted in logic ticks rather than timed
+    //separately, so that a replayed match sees them on the same ticks
+    if (++m_stateTickCount % NetworkInterval == 0)
+    {
+        Server::ProfileScope profile(Server::ProfileID::NetworkUpdate);
+        m_currentState->networkUpdate(NetworkStep);
+    }
+}
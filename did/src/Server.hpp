@@ -20,6 +20,8 @@ Copyright 2019 Matt Marchant
 
 #include "ServerState.hpp"
 #include "ServerSharedStateData.hpp"
+#include "ServerProfiler.hpp"
+#include "ServerMatchRecording.hpp"
 
 #include <xyginext/core/MessageBus.hpp>
 #include <xyginext/network/NetHost.hpp>
@@ -48,9 +50,47 @@ public:
 
     void setMaxPlayers(std::uint8_t maxPlayers) { m_maxPlayers = maxPlayers; }
 
+    //sets the port on which to listen. Must be set before calling start()
+    void setPort(std::uint16_t port) { m_port = port; }
+    std::uint16_t getPort() const { return m_port; }
+
+    //dedicated servers return to the lobby when the last client
+    //disconnects, rather than shutting down
+    void setDedicated(bool dedicated) { m_dedicated = dedicated; }
+
+    //generated islands are cached in this directory and reused when
+    //a match is started with the same seed. Must be set before calling start()
+    void setMapCacheDirectory(const std::string& path) { m_sharedStateData.mapCacheDirectory = path; }
+
+    //each match is recorded to a file in this directory, for replaying
+    //with replay(). Recorded matches find bot paths synchronously and
+    //don't limit bot AI time, so that they can be reproduced exactly
+    void setRecordDirectory(const std::string& path) { m_sharedStateData.recordDirectory = path; }
+
+    //re-simulates a recorded match as fast as possible on the calling
+    //thread, without a network host. The server must not be running
+    Server::ReplayResult replay(const std::string& path);
+
+    //number of logic ticks processed since the server was started
+    std::uint64_t getTickCount() const { return m_tickCount; }
+
+    //duration of the most recent logic tick, in microseconds
+    std::int64_t getLastTickTime() const { return m_lastTickTime; }
+
+    //returns the longest logic tick, in microseconds, since the last time this was called
+    std::int64_t resetPeakTickTime() { return m_peakTickTime.exchange(0); }
+
+    //system timings and outgoing traffic. Only use this from the server
+    //thread once the server has started
+    Server::Profiler& getProfiler() { return m_profiler; }
+
     inline void sendData(std::uint8_t packetID, const void* data, std::size_t size, std::uint64_t destination, xy::NetFlag sendType, std::uint8_t channel = 0)
     {
-        m_host.sendPacket(m_sharedStateData.connectedClients[destination].peer, packetID, data, size, sendType, channel);
+        if (!m_headless)
+        {
+            m_host.sendPacket(m_sharedStateData.connectedClients[destination].peer, packetID, data, size, sendType, channel);
+        }
+        m_profiler.addPacket(packetID, size + sizeof(packetID));
     }
 
     template <typename T>
@@ -58,7 +98,11 @@ public:
 
     inline void broadcastData(std::uint8_t packetID, const void* data, std::size_t size, xy::NetFlag sendType, std::uint8_t channel = 0)
     {
-        m_host.broadcastPacket(packetID, data, size, sendType, channel);
+        if (!m_headless)
+        {
+            m_host.broadcastPacket(packetID, data, size, sendType, channel);
+        }
+        m_profiler.addPacket(packetID, size + sizeof(packetID), m_sharedStateData.connectedClients.size());
     }
 
     template <typename T>
@@ -81,6 +125,17 @@ private:
     xy::NetHost m_host;
 
     std::size_t m_maxPlayers; //why is this a var? it's fixed at 4...
+    std::uint16_t m_port;
+    bool m_dedicated;
+    bool m_headless; //replaying, so there is no host to send to
+    std::atomic<bool> m_resetRequested;
+
+    std::atomic<std::uint64_t> m_tickCount;
+    std::atomic<std::int64_t> m_lastTickTime;
+    std::atomic<std::int64_t> m_peakTickTime;
+    std::uint64_t m_stateTickCount;
+
+    Server::Profiler m_profiler;
 
     std::array<std::uint8_t, 4u> m_freeIDs = {};
     std::size_t m_nextFreeID;
@@ -91,6 +146,7 @@ private:
     void clientDisconnect(const xy::NetEvent&);
 
     void run();
+    void tick();
 };
 
 namespace Server
@@ -31,11 +31,19 @@ inline void GameServer::sendData(std::uint8_t packetID, const T& data, std::uint
     }
 #endif
 
-    m_host.sendPacket(m_sharedStateData.connectedClients[destination].peer, packetID, data, sendType, channel);
+    if (!m_headless)
+    {
+        m_host.sendPacket(m_sharedStateData.connectedClients[destination].peer, packetID, data, sendType, channel);
+    }
+    m_profiler.addPacket(packetID, sizeof(T) + sizeof(packetID));
 }
 
 template <typename T>
 inline void GameServer::broadcastData(std::uint8_t packetID, const T& data, xy::NetFlag sendType, std::uint8_t channel)
 {
-    m_host.broadcastPacket(packetID, data, sendType, channel);
+    if (!m_headless)
+    {
+        m_host.broadcastPacket(packetID, data, sendType, channel);
+    }
+    m_profiler.addPacket(packetID, sizeof(T) + sizeof(packetID), m_sharedStateData.connectedClients.size());
 }
\ No newline at end of file
@@ -72,6 +72,8 @@ using namespace Server;
 namespace
 {
     const float DayNightUpdateFrequency = 5.f;
+    const std::uint32_t ChecksumInterval = 60; //logic ticks
+    const std::uint32_t BotStatsInterval = 60; //logic ticks
     const std::array<sf::Vector2f, 4u> SpawnPositions = 
     {
         sf::Vector2f(7.f * Global::TileSize, 7.f * Global::TileSize),
@@ -107,13 +109,28 @@ namespace
 GameState::GameState(SharedStateData& sd)
     : m_sharedData      (sd),
     m_scene             (sd.gameServer->getMessageBus(), 512),
+    m_dayNightTime      (0.f),
     m_dayNightUpdateTime(0.f),
-    m_remainingTreasure (std::numeric_limits<std::size_t>::max())
+    m_remainingTreasure (std::numeric_limits<std::size_t>::max()),
+    m_tickCount         (0),
+    m_replay            (sd.replay)
 {
-    Server::rndEngine = std::mt19937();
-    Server::rndEngine.seed(sd.seedData.hash);
+    m_randomStreams.seed(sd.seedData.hash);
 
+    if (!m_replay && !sd.recordDirectory.empty())
+    {
+        m_recorder.open(sd.recordDirectory, sd);
+    }
+
+    if (m_recorder.isOpen() || m_replay)
+    {
+        //paths must arrive on the same tick every time
+        m_pathFinder.setAsync(false);
+    }
+
+    m_islandGenerator.setCacheDirectory(sd.mapCacheDirectory);
     m_islandGenerator.generate(sd.seedData.hash);
+    LOG("Island generated in " + std::to_string(m_islandGenerator.getGenerationTime()) + "us" + (m_islandGenerator.loadedFromCache() ? " (cached)" : ""), xy::Logger::Type::Info);
     m_mapData = m_islandGenerator.getMapData();
     m_remainingTreasure = m_islandGenerator.getTreasureCount();
     LOG("Spawned " + std::to_string(m_remainingTreasure) + " treasures", xy::Logger::Type::Info);
@@ -138,8 +155,13 @@ GameState::GameState(SharedStateData& sd)
     xy::Logger::log("Server switched to running state");
 }
 
+GameState::~GameState()
+{
+    m_recorder.close(m_tickCount);
+}
+
 //public
-void GameState::networkUpdate(float dt)
+void GameState::networkUpdate(float)
 {
     //broadcast scene state - TODO will this be more efficient
     //to send only the visible actors to each player?
@@ -209,20 +231,45 @@ void GameState::networkUpdate(float dt)
             client.sendStatsUpdate = false;
         }   
     }
+}
+
+void GameState::logicUpdate(float dt)
+{
+    m_scene.update(dt);
+    m_roundTimer.update(dt);
+
+    if (m_roundTimer.started())
+    {
+        if (/*m_remainingTreasure == 0
+            ||*/ m_roundTimer.getTime() == 0)
+        {
+            endGame();
+        }
+    }
+    else
+    {
+        if (m_remainingTreasure == 1)
+        {
+            m_scene.getSystem<BotSystem>().resetDigSpots();
+
+            m_roundTimer.start();
+            //start client timers
+            m_sharedData.gameServer->broadcastData(PacketID::ServerMessage, Server::Message::OneTreasureRemaining, xy::NetFlag::Reliable, Global::ReliableChannel);
+        }
+    }
 
-    //occasionally update the day/night cycle time
+    //occasionally update the day/night cycle time. This is timed by logic
+    //updates so that a replayed match sees the same time of day each tick
     if (m_dayNightUpdateTime > DayNightUpdateFrequency)
     {
         m_dayNightUpdateTime = 0.f;
 
-        float dayNightTime = m_dayNightClock.getElapsedTime().asSeconds();
-        if (dayNightTime > Global::DayNightSeconds)
+        if (m_dayNightTime > Global::DayNightSeconds)
         {
-            dayNightTime = 0.f;
-            m_dayNightClock.restart();
+            m_dayNightTime = 0.f;
         }
 
-        float dayPosition = dayNightTime / Global::DayNightSeconds;
+        float dayPosition = m_dayNightTime / Global::DayNightSeconds;
         //this is a kludge to offset the game start into the morning
         dayPosition = std::fmod(dayPosition + Global::DayCycleOffset, 1.f);
         m_sharedData.gameServer->broadcastData(PacketID::DayNightUpdate, dayPosition);
@@ -238,31 +285,26 @@ void GameState::networkUpdate(float dt)
         }
     }
     m_dayNightUpdateTime += dt;
-}
+    m_dayNightTime += dt;
 
-void GameState::logicUpdate(float dt)
-{
-    m_scene.update(dt);
-
-    if (m_roundTimer.started())
+    m_tickCount++;
+    if (m_recorder.isOpen()
+        && m_tickCount % ChecksumInterval == 0)
     {
-        if (/*m_remainingTreasure == 0
-            ||*/ m_roundTimer.getTime() == 0)
-        {
-            endGame();
-        }
+        m_recorder.addEvent(m_tickCount, RecordEvent::Checksum, getChecksum());
     }
-    else
-    {
-        if (m_remainingTreasure == 1)
-        {
-            m_scene.getSystem<BotSystem>().resetDigSpots();
 
-            m_roundTimer.start();
-            //start client timers
-            m_sharedData.gameServer->broadcastData(PacketID::ServerMessage, Server::Message::OneTreasureRemaining, xy::NetFlag::Reliable, Global::ReliableChannel);
-        }
+#ifdef XY_DEBUG
+    //bots only run here, so clients print these rather than their own
+    if (m_tickCount % BotStatsInterval == 0)
+    {
+        const auto& botSystem = m_scene.getSystem<BotSystem>();
+        BotStats stats;
+        stats.processTime = static_cast<std::int32_t>(botSystem.getProcessTime());
+        stats.decisionLatency = botSystem.getDecisionLatency();
+        m_sharedData.gameServer->broadcastData(PacketID::BotStats, stats, xy::NetFlag::Unreliable, Global::LowPriorityChannel);
     }
+#endif
 }
 
 void GameState::handlePacket(const xy::NetEvent& evt)
@@ -274,25 +316,25 @@ void GameState::handlePacket(const xy::NetEvent& evt)
         m_sharedData.gameServer->sendData(PacketID::MapData, m_mapData.tileData.data, Global::TileCount, evt.peer.getID(), xy::NetFlag::Reliable, Global::ReliableChannel);
         break;
     case PacketID::RequestPlayer:
+        m_recorder.addEvent(m_tickCount, RecordEvent::SpawnPlayer, evt.peer.getID());
         spawnPlayer(evt.peer.getID());
         break;
     case PacketID::ClientInput:
     {
         auto ip = evt.packet.as<InputUpdate>();
-
-        auto& playerIp = m_playerSlots[ip.playerNumber].gameEntity.getComponent<InputComponent>();
-
-        //update player input history
-        playerIp.history[playerIp.currentInput].input.mask = ip.input;
-        playerIp.history[playerIp.currentInput].input.timestamp = ip.clientTime;
-        playerIp.history[playerIp.currentInput].input.acceleration = ip.acceleration;
-        playerIp.currentInput = (playerIp.currentInput + 1) % playerIp.history.size();
+        m_recorder.addEvent(m_tickCount, RecordEvent::Input, ip);
+        applyInput(ip);
     }
         break;
     case PacketID::ConCommand:
         if (evt.peer == m_sharedData.hostClient)
         {
-            doConCommand(evt.packet.as<ConCommand::Data>());
+            const auto& data = evt.packet.as<ConCommand::Data>();
+            if (data.commandID != ConCommand::Profile)
+            {
+                m_recorder.addEvent(m_tickCount, RecordEvent::ConCommand, data);
+            }
+            doConCommand(data);
         }
         break;
     }
@@ -624,6 +666,8 @@ void GameState::handleMessage(const xy::Message& msg)
         const auto& data = msg.getData<ServerEvent>();
         if (data.type == ServerEvent::ClientDisconnected)
         {
+            m_recorder.addEvent(m_tickCount, RecordEvent::Disconnect, data.id);
+
             Actor::ID id = Actor::None;
 
             //remove from active list
@@ -651,6 +695,41 @@ void GameState::handleMessage(const xy::Message& msg)
     m_scene.forwardMessage(msg);
 }
 
+void GameState::applyRecordedEvents()
+{
+    if (!m_replay)
+    {
+        return;
+    }
+
+    while (const auto* event = m_replay->nextEvent(m_tickCount))
+    {
+        switch (event->type)
+        {
+        default: break;
+        case RecordEvent::Input:
+            applyInput(m_replay->getData<InputUpdate>(*event));
+            break;
+        case RecordEvent::SpawnPlayer:
+            spawnPlayer(m_replay->getData<std::uint64_t>(*event));
+            break;
+        case RecordEvent::ConCommand:
+            doConCommand(m_replay->getData<ConCommand::Data>(*event));
+            break;
+        case RecordEvent::Disconnect:
+        {
+            auto* msg = m_sharedData.gameServer->getMessageBus().post<ServerEvent>(MessageID::ServerMessage);
+            msg->type = ServerEvent::ClientDisconnected;
+            msg->id = m_replay->getData<std::uint64_t>(*event);
+        }
+            break;
+        case RecordEvent::Checksum:
+            m_replay->verifyChecksum(m_tickCount, m_replay->getData<std::uint64_t>(*event), getChecksum());
+            break;
+        }
+    }
+}
+
 //private
 void GameState::createScene()
 {
@@ -660,27 +739,32 @@ void GameState::createScene()
     m_scene.addSystem<xy::CallbackSystem>(mb);
     m_scene.addSystem<CrabSystem>(mb);
     m_scene.addSystem<CollisionSystem>(mb, true).setTileData(m_mapData.tileData);
-    m_scene.addSystem<SkeletonSystem>(mb, m_sharedData, m_pathFinder);
+    m_scene.addSystem<SkeletonSystem>(mb, m_sharedData, m_pathFinder, m_randomStreams.get(RandomStream::Skeletons));
     m_scene.addSystem<CarriableSystem>(mb, m_sharedData);
     m_scene.addSystem<ActorSystem>(mb);
     m_scene.addSystem<PlayerSystem>(mb);
     m_scene.addSystem<BoatSystem>(mb);
     m_scene.addSystem<BeeSystem>(mb);
-    m_scene.addSystem<BotSystem>(mb, m_pathFinder, m_sharedData.seedData.hash);
-    m_scene.addSystem<CollectibleSystem>(mb, m_sharedData);
+    m_scene.addSystem<BotSystem>(mb, m_pathFinder, m_randomStreams.getSeed(RandomStream::Bots));
+    m_scene.addSystem<CollectibleSystem>(mb, m_sharedData, m_randomStreams.get(RandomStream::Collectibles));
     m_scene.addSystem<InventorySystem>(mb, m_sharedData);
     m_scene.addSystem<ParrotLauncherSystem>(mb, m_sharedData);
-    m_scene.addSystem<BarrelSystem>(mb);
+    m_scene.addSystem<BarrelSystem>(mb, m_randomStreams.get(RandomStream::Barrels));
     m_scene.addSystem<DecoySystem>(mb);
     m_scene.addSystem<TimedCarriableSystem>(mb, m_sharedData);
-    m_scene.addSystem<FlareSystem>(mb);
+    m_scene.addSystem<FlareSystem>(mb, m_randomStreams.get(RandomStream::Flares));
     m_scene.addSystem<SkullShieldSystem>(mb);
 
     m_scene.addDirector<DigDirector>(m_sharedData);
     m_scene.addDirector<ServerWeaponDirector>(m_sharedData);
-    m_scene.addDirector<StormDirector>(m_sharedData);
+    m_scene.addDirector<StormDirector>(m_sharedData, m_randomStreams.get(RandomStream::Storm));
 
     m_scene.setSystemActive<BotSystem>(false);
+    if (m_recorder.isOpen() || m_replay)
+    {
+        //don't let sweeps depend on how long the AI takes
+        m_scene.getSystem<BotSystem>().setTimeBudget(sf::Time::Zero);
+    }
 
     //set up player slots
     for (auto i = 0u; i < m_playerSlots.size(); ++i)
@@ -823,6 +907,8 @@ void GameState::createPlayerEntity(std::size_t idx)
 
 void GameState::spawnMapActors()
 {
+    auto& rndEngine = m_randomStreams.get(RandomStream::Spawns);
+
     const auto& actors = m_islandGenerator.getActorSpawns();
     for (const auto& spawn : actors)
     {
@@ -841,9 +927,9 @@ void GameState::spawnMapActors()
         default: break;
         case Actor::Crab:
             entity.addComponent<Crab>().spawnPosition = spawn.position;
-            entity.getComponent<Crab>().state = static_cast<Crab::State>(Server::getRandomInt(0, 2));
-            entity.getComponent<Crab>().maxTravel += Server::getRandomFloat(-10.f, 10.f);
-            entity.getComponent<Crab>().thinkTime += Server::getRandomFloat(-0.5f, 0.5f);
+            entity.getComponent<Crab>().state = static_cast<Crab::State>(Server::getRandomInt(rndEngine, 0, 2));
+            entity.getComponent<Crab>().maxTravel += Server::getRandomFloat(rndEngine, -10.f, 10.f);
+            entity.getComponent<Crab>().thinkTime += Server::getRandomFloat(rndEngine, -0.5f, 0.5f);
             break;
         case Actor::AmmoSpawn:
         case Actor::TreasureSpawn:
@@ -903,6 +989,8 @@ void GameState::spawnMapActors()
 
 xy::Entity GameState::spawnActor(sf::Vector2f position, std::int32_t id)
 {
+    auto& rndEngine = m_randomStreams.get(RandomStream::Spawns);
+
     auto correctPosition = [&](sf::Vector2f p)->sf::Vector2f
     {
         if (m_islandGenerator.isEdgeTile(p))
@@ -963,26 +1051,26 @@ xy::Entity GameState::spawnActor(sf::Vector2f position, std::int32_t id)
         if (velocity.x > 0)
         {
             position.x = -(Global::TileSize * 10.f);
-            position.y = Server::getRandomInt(11, Global::TileCountY - 11) * Global::TileSize;
-            position.y += Server::getRandomFloat(-Global::TileSize, Global::TileSize);
+            position.y = Server::getRandomInt(rndEngine, 11, Global::TileCountY - 11) * Global::TileSize;
+            position.y += Server::getRandomFloat(rndEngine, -Global::TileSize, Global::TileSize);
         }
         else if (velocity.x < 0)
         {
             position.x = Global::IslandSize.x + (Global::TileSize * 10.f);
-            position.y = Server::getRandomInt(11, Global::TileCountY - 11) * Global::TileSize;
-            position.y += Server::getRandomFloat(-Global::TileSize, Global::TileSize);
+            position.y = Server::getRandomInt(rndEngine, 11, Global::TileCountY - 11) * Global::TileSize;
+            position.y += Server::getRandomFloat(rndEngine, -Global::TileSize, Global::TileSize);
         }
         else if (velocity.y > 0)
         {
             position.y = -(Global::TileSize * 10.f);
-            position.x = Server::getRandomInt(11, Global::TileCountX - 11) * Global::TileSize;
-            position.x += Server::getRandomFloat(-Global::TileSize, Global::TileSize);
+            position.x = Server::getRandomInt(rndEngine, 11, Global::TileCountX - 11) * Global::TileSize;
+            position.x += Server::getRandomFloat(rndEngine, -Global::TileSize, Global::TileSize);
         }
         else
         {
             position.y = Global::IslandSize.y + (Global::TileSize * 10.f);
-            position.x = Server::getRandomInt(11, Global::TileCountX - 11) * Global::TileSize;
-            position.x += Server::getRandomFloat(-Global::TileSize, Global::TileSize);
+            position.x = Server::getRandomInt(rndEngine, 11, Global::TileCountX - 11) * Global::TileSize;
+            position.x += Server::getRandomFloat(rndEngine, -Global::TileSize, Global::TileSize);
         }
 
         entity.addComponent<CollisionComponent>().bounds = Global::PlayerBounds;
@@ -991,13 +1079,13 @@ xy::Entity GameState::spawnActor(sf::Vector2f position, std::int32_t id)
         entity.getComponent<xy::BroadphaseComponent>().setFilterFlags(QuadTreeFilter::Barrel | QuadTreeFilter::BotQuery);
         entity.addComponent<Inventory>().health = 1;
         //use inventory properties to define what's in the barrel (mostly items)
-        if (Server::getRandomInt(0, 8) == 0)
+        if (Server::getRandomInt(rndEngine, 0, 8) == 0)
         {
             entity.getComponent<Inventory>().weapon = Barrel::Explosive;
         }
         else
         {
-            Server::getRandomInt(0, 6) == 0 ?
+            Server::getRandomInt(rndEngine, 0, 6) == 0 ?
                 entity.getComponent<Inventory>().weapon = Barrel::Gold :
                 entity.getComponent<Inventory>().weapon = Barrel::Item;
         }
@@ -1016,7 +1104,7 @@ xy::Entity GameState::spawnActor(sf::Vector2f position, std::int32_t id)
         break;
     case Actor::Crab:
         entity.addComponent<Crab>().spawnPosition = position;
-        entity.getComponent<Crab>().maxTravel += Server::getRandomFloat(-10.f, 10.f);
+        entity.getComponent<Crab>().maxTravel += Server::getRandomFloat(rndEngine, -10.f, 10.f);
         break;
     case Actor::Decoy:
         position = correctPosition(position);
@@ -1050,7 +1138,7 @@ xy::Entity GameState::spawnActor(sf::Vector2f position, std::int32_t id)
         entity.addComponent<CollisionComponent>().bounds = Global::CollectibleBounds;
         entity.getComponent<CollisionComponent>().collidesTerrain = false;
         entity.addComponent<Collectible>().type = Collectible::Type::Ammo;
-        entity.getComponent<Collectible>().value = Server::getRandomInt(3, 5);
+        entity.getComponent<Collectible>().value = Server::getRandomInt(rndEngine, 3, 5);
     }
         break;
     case Actor::Food:
@@ -1060,7 +1148,7 @@ xy::Entity GameState::spawnActor(sf::Vector2f position, std::int32_t id)
         entity.addComponent<CollisionComponent>().bounds = Global::CollectibleBounds;
         entity.getComponent<CollisionComponent>().collidesTerrain = false;
         entity.addComponent<Collectible>().type = Collectible::Type::Food;
-        entity.getComponent<Collectible>().value = Server::getRandomInt(12, 22);
+        entity.getComponent<Collectible>().value = Server::getRandomInt(rndEngine, 12, 22);
     }
     break;
     case Actor::Coin:
@@ -1070,7 +1158,7 @@ xy::Entity GameState::spawnActor(sf::Vector2f position, std::int32_t id)
         entity.addComponent<CollisionComponent>().bounds = Global::CollectibleBounds;
         entity.getComponent<CollisionComponent>().collidesTerrain = false;
         entity.addComponent<Collectible>().type = Collectible::Type::Coin;
-        entity.getComponent<Collectible>().value = (Server::getRandomInt(0, 2) == 0) ? 3 : 1;
+        entity.getComponent<Collectible>().value = (Server::getRandomInt(rndEngine, 0, 2) == 0) ? 3 : 1;
     }
     break;
     case Actor::Treasure:
@@ -1204,6 +1292,44 @@ void GameState::endGame()
     setNextState(Server::StateID::Lobby); //set this to drop players back into lobby
 }
 
+void GameState::applyInput(const InputUpdate& ip)
+{
+    auto& playerIp = m_playerSlots[ip.playerNumber].gameEntity.getComponent<InputComponent>();
+
+    //update player input history
+    playerIp.history[playerIp.currentInput].input.mask = ip.input;
+    playerIp.history[playerIp.currentInput].input.timestamp = ip.clientTime;
+    playerIp.history[playerIp.currentInput].input.acceleration = ip.acceleration;
+    playerIp.currentInput = (playerIp.currentInput + 1) % playerIp.history.size();
+}
+
+std::uint64_t GameState::getChecksum()
+{
+    //FNV-1a
+    std::uint64_t hash = 0xcbf29ce484222325;
+    const auto add = [&hash](const void* data, std::size_t size)
+    {
+        const auto* bytes = static_cast<const std::uint8_t*>(data);
+        for (auto i = 0u; i < size; ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001b3;
+        }
+    };
+
+    const auto& actors = m_scene.getSystem<ActorSystem>().getActors();
+    for (const auto& actor : actors)
+    {
+        const auto& actorComponent = actor.getComponent<Actor>();
+        const auto position = actor.getComponent<xy::Transform>().getPosition();
+        add(&actorComponent.serverID, sizeof(actorComponent.serverID));
+        add(&actorComponent.id, sizeof(actorComponent.id));
+        add(&position, sizeof(position));
+    }
+    add(&m_remainingTreasure, sizeof(m_remainingTreasure));
+
+    return hash;
+}
+
 void GameState::doConCommand(const ConCommand::Data& data)
 {
     switch (data.commandID)
@@ -1228,5 +1354,30 @@ void GameState::doConCommand(const ConCommand::Data& data)
             }
         }
         break;
+    case ConCommand::BotPerception:
+        if (data.value.asFloat > 0)
+        {
+            m_scene.getSystem<BotSystem>().setPerceptionRate(data.value.asFloat);
+        }
+        break;
+    case ConCommand::Profile:
+    {
+        auto& profiler = m_sharedData.gameServer->getProfiler();
+        if (data.value.asInt == 0)
+        {
+            xy::Logger::log("Server stats:\n" + profiler.getSummary(), xy::Logger::Type::Info);
+        }
+        else if (data.value.asInt > 0)
+        {
+            const auto path = "server_profile_" + std::to_string(m_sharedData.gameServer->getPort()) + ".csv";
+            profiler.setDumpFile(path, static_cast<float>(data.value.asInt));
+            xy::Logger::log("Writing server stats to " + path, xy::Logger::Type::Info);
+        }
+        else
+        {
+            profiler.setDumpFile({}, 0.f);
+        }
+    }
+        break;
     }
 }
\ No newline at end of file
@@ -23,9 +23,13 @@ Copyright 2019 Matt Marchant
 #include "PlayerStats.hpp"
 #include "PathFinder.hpp"
 #include "ServerRoundTimer.hpp"
+#include "ServerRandom.hpp"
+#include "ServerMatchRecording.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 
+struct InputUpdate;
+
 namespace Server
 {
     namespace ConCommand
@@ -37,6 +41,10 @@ namespace Server
     {
     public:
         explicit GameState(SharedStateData&);
+        ~GameState();
+
+        GameState(const GameState&) = delete;
+        GameState& operator = (const GameState&) = delete;
 
         std::int32_t getID() const override { return StateID::Running; }
 
@@ -48,14 +56,19 @@ namespace Server
 
         void handleMessage(const xy::Message&) override;
 
+        //when replaying a recorded match applies the events
+        //recorded before the next logic update
+        void applyRecordedEvents();
+
     private:
         SharedStateData& m_sharedData;
         IslandGenerator m_islandGenerator;
         MapData m_mapData;
 
+        RandomStreams m_randomStreams;
         xy::Scene m_scene;
 
-        sf::Clock m_dayNightClock;
+        float m_dayNightTime;
         float m_dayNightUpdateTime;
 
         struct PlayerSlot final
@@ -72,6 +85,10 @@ namespace Server
 
         PathFinder m_pathFinder;
 
+        std::uint32_t m_tickCount;
+        MatchRecorder m_recorder;
+        MatchReplay* m_replay;
+
         void createScene();
         void spawnPlayer(std::uint64_t);
         void createPlayerEntity(std::size_t);
@@ -79,6 +96,10 @@ namespace Server
         xy::Entity spawnActor(sf::Vector2f, std::int32_t); //also broadcasts to clients
         void endGame();
 
+        void applyInput(const InputUpdate&);
         void doConCommand(const Server::ConCommand::Data&);
+
+        //hash of all actor positions, to check a replay matches its recording
+        std::uint64_t getChecksum();
     };
 }
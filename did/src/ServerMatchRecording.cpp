@@ -0,0 +1,266 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "ServerMatchRecording.hpp"
+#include "ServerSharedStateData.hpp"
+#include "Server.hpp"
+
+#include <xyginext/core/Log.hpp>
+#include <xyginext/core/FileSystem.hpp>
+
+#include <atomic>
+#include <ctime>
+
+using namespace Server;
+
+namespace
+{
+    const std::uint16_t RecordingVersion = 2; //2: 64 bit input timestamps
+    const std::uint32_t RecordingIdent = 0x52444944; //DIDR
+
+    struct RecordingHeader final
+    {
+        std::uint32_t ident = RecordingIdent;
+        std::uint16_t version = RecordingVersion;
+        std::uint16_t clientCount = 0;
+        std::uint64_t seedHash = 0;
+        char seed[SeedData::MaxChar] = {};
+    };
+
+    struct RecordedClient final
+    {
+        std::uint64_t clientID = 0;
+        std::uint32_t xp = 0;
+        std::uint8_t playerID = 0;
+        std::uint8_t spriteIndex = 0;
+        std::uint8_t hatIndex = 0;
+        std::uint8_t padding = 0;
+    };
+
+    struct EventHeader final
+    {
+        std::uint32_t tick = 0;
+        std::uint8_t type = 0;
+        std::uint8_t size = 0;
+        std::uint16_t padding = 0;
+    };
+
+    //several servers may start a match in the same second
+    std::atomic<std::uint32_t> matchCount(0);
+}
+
+//recorder
+bool MatchRecorder::open(const std::string& directory, const SharedStateData& sharedData)
+{
+    if (!xy::FileSystem::directoryExists(directory)
+        && !xy::FileSystem::createDirectory(directory))
+    {
+        xy::Logger::log("Failed creating recording directory " + directory, xy::Logger::Type::Error);
+        return false;
+    }
+
+    //std::localtime() isn't thread safe and each server has its own thread
+    char timeString[20] = {};
+    auto time = std::time(nullptr);
+    std::tm localTime = {};
+#ifdef _WIN32
+    localtime_s(&localTime, &time);
+#else
+    localtime_r(&time, &localTime);
+#endif
+    std::strftime(timeString, sizeof(timeString), "%Y%m%d_%H%M%S", &localTime);
+
+    m_path = directory + "match_" + std::to_string(sharedData.gameServer->getPort()) + "_" + timeString
+        + "_" + std::to_string(matchCount++) + ".didr";
+    m_file.open(m_path, std::ios::binary);
+    if (!m_file.is_open())
+    {
+        xy::Logger::log("Failed opening " + m_path + " for recording", xy::Logger::Type::Error);
+        return false;
+    }
+
+    RecordingHeader header;
+    header.clientCount = static_cast<std::uint16_t>(sharedData.connectedClients.size());
+    header.seedHash = sharedData.seedData.hash;
+    std::memcpy(header.seed, sharedData.seedData.str, SeedData::MaxChar);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    for (const auto& [id, client] : sharedData.connectedClients)
+    {
+        RecordedClient recorded;
+        recorded.clientID = id;
+        recorded.xp = client.xp;
+        recorded.playerID = client.playerID;
+        recorded.spriteIndex = client.spriteIndex;
+        recorded.hatIndex = client.hatIndex;
+        m_file.write(reinterpret_cast<const char*>(&recorded), sizeof(recorded));
+    }
+
+    xy::Logger::log("Recording match to " + m_path, xy::Logger::Type::Info);
+    return true;
+}
+
+void MatchRecorder::addEvent(std::uint32_t tick, RecordEvent::Type type, const void* data, std::uint8_t size)
+{
+    if (!m_file.is_open())
+    {
+        return;
+    }
+
+    EventHeader header;
+    header.tick = tick;
+    header.type = type;
+    header.size = size;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(static_cast<const char*>(data), size);
+}
+
+void MatchRecorder::close(std::uint32_t tick)
+{
+    if (m_file.is_open())
+    {
+        addEvent(tick, RecordEvent::End, nullptr, 0);
+        m_file.close();
+    }
+}
+
+//replay
+bool MatchReplay::load(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        xy::Logger::log("Failed opening recording " + path, xy::Logger::Type::Error);
+        return false;
+    }
+
+    RecordingHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || header.ident != RecordingIdent
+        || header.version != RecordingVersion)
+    {
+        xy::Logger::log(path + " is not a valid recording", xy::Logger::Type::Error);
+        return false;
+    }
+
+    m_seedHash = header.seedHash;
+    header.seed[SeedData::MaxChar - 1] = 0;
+    m_seed = header.seed;
+
+    m_clients.clear();
+    for (auto i = 0u; i < header.clientCount; ++i)
+    {
+        RecordedClient recorded;
+        if (!file.read(reinterpret_cast<char*>(&recorded), sizeof(recorded)))
+        {
+            xy::Logger::log(path + ": missing client data", xy::Logger::Type::Error);
+            return false;
+        }
+
+        Client client;
+        client.clientID = recorded.clientID;
+        client.xp = recorded.xp;
+        client.playerID = recorded.playerID;
+        client.spriteIndex = recorded.spriteIndex;
+        client.hatIndex = recorded.hatIndex;
+        m_clients.push_back(client);
+    }
+
+    m_events.clear();
+    m_payload.clear();
+    m_nextEvent = 0;
+
+    EventHeader eventHeader;
+    while (file.read(reinterpret_cast<char*>(&eventHeader), sizeof(eventHeader)))
+    {
+        Event event;
+        event.tick = eventHeader.tick;
+        event.type = static_cast<RecordEvent::Type>(eventHeader.type);
+        event.size = eventHeader.size;
+        event.offset = m_payload.size();
+
+        m_payload.resize(m_payload.size() + event.size);
+        if (event.size > 0
+            && !file.read(reinterpret_cast<char*>(m_payload.data() + event.offset), event.size))
+        {
+            break;
+        }
+        m_events.push_back(event);
+    }
+
+    //a server which was killed won't have written the end of the
+    //recording, but everything up to that point can still be replayed
+    if (m_events.empty() || m_events.back().type != RecordEvent::End)
+    {
+        xy::Logger::log(path + " is incomplete, replaying the first " + std::to_string(getEndTick()) + " ticks", xy::Logger::Type::Warning);
+
+        Event event;
+        event.tick = getEndTick();
+        event.offset = m_payload.size();
+        m_events.push_back(event);
+    }
+
+    return true;
+}
+
+void MatchReplay::apply(SharedStateData& sharedData) const
+{
+    std::memset(sharedData.seedData.str, 0, SeedData::MaxChar);
+    std::strncpy(sharedData.seedData.str, m_seed.c_str(), SeedData::MaxChar - 1);
+    sharedData.seedData.hash = static_cast<std::size_t>(m_seedHash);
+
+    sharedData.connectedClients.clear();
+    for (const auto& client : m_clients)
+    {
+        auto& data = sharedData.connectedClients[client.clientID];
+        data.xp = client.xp;
+        data.playerID = client.playerID;
+        data.spriteIndex = client.spriteIndex;
+        data.hatIndex = client.hatIndex;
+        data.ready = true;
+    }
+}
+
+const MatchReplay::Event* MatchReplay::nextEvent(std::uint32_t tick)
+{
+    if (m_nextEvent < m_events.size()
+        && m_events[m_nextEvent].tick <= tick)
+    {
+        return &m_events[m_nextEvent++];
+    }
+    return nullptr;
+}
+
+void MatchReplay::verifyChecksum(std::uint32_t tick, std::uint64_t recorded, std::uint64_t replayed)
+{
+    m_checksumCount++;
+    if (recorded != replayed)
+    {
+        if (m_mismatchCount == 0)
+        {
+            m_firstMismatch = tick;
+            xy::Logger::log("Replay diverged from recording at tick " + std::to_string(tick), xy::Logger::Type::Error);
+        }
+        m_mismatchCount++;
+    }
+}
+
+std::uint32_t MatchReplay::getEndTick() const
+{
+    return m_events.empty() ? 0 : m_events.back().tick;
+}
@@ -0,0 +1,149 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Server
+{
+    struct SharedStateData;
+
+    namespace RecordEvent
+    {
+        enum Type : std::uint8_t
+        {
+            Input, //InputUpdate
+            SpawnPlayer, //client ID
+            ConCommand, //ConCommand::Data
+            Disconnect, //player ID
+            Checksum, //hash of actor positions
+            End
+        };
+    }
+
+    /*!
+    \brief Writes the seed and clients present at the start of a match,
+    followed by every event from a client which affects the simulation,
+    tagged with the number of logic ticks completed when it was applied.
+    */
+    class MatchRecorder final
+    {
+    public:
+        //creates a new file in the given directory named after the seed
+        bool open(const std::string& directory, const SharedStateData&);
+        bool isOpen() const { return m_file.is_open(); }
+        const std::string& getPath() const { return m_path; }
+
+        void addEvent(std::uint32_t tick, RecordEvent::Type, const void* data, std::uint8_t size);
+
+        template <typename T>
+        void addEvent(std::uint32_t tick, RecordEvent::Type type, const T& data)
+        {
+            static_assert(sizeof(T) < 256, "");
+            addEvent(tick, type, &data, static_cast<std::uint8_t>(sizeof(T)));
+        }
+
+        //writes the End event and closes the file
+        void close(std::uint32_t tick);
+
+    private:
+        std::ofstream m_file;
+        std::string m_path;
+    };
+
+    struct ReplayResult final
+    {
+        bool loaded = false;
+        std::uint32_t ticks = 0;
+        std::uint32_t recordedTicks = 0;
+        std::int64_t duration = 0; //microseconds
+        std::int64_t peakTickTime = 0;
+        std::size_t checksumCount = 0;
+        std::size_t mismatchCount = 0;
+        std::uint32_t firstMismatch = 0; //tick
+    };
+
+    /*!
+    \brief Loads a match recorded with MatchRecorder so that the
+    server GameState can re-apply its events.
+    */
+    class MatchReplay final
+    {
+    public:
+        struct Event final
+        {
+            std::uint32_t tick = 0;
+            RecordEvent::Type type = RecordEvent::End;
+            std::uint8_t size = 0;
+            std::size_t offset = 0;
+        };
+
+        bool load(const std::string& path);
+
+        //sets the seed and connected clients as they were when recorded
+        void apply(SharedStateData&) const;
+
+        //returns the next event if it is due on the given tick, else nullptr
+        const Event* nextEvent(std::uint32_t tick);
+
+        template <typename T>
+        T getData(const Event& event) const
+        {
+            T data;
+            std::memcpy(&data, m_payload.data() + event.offset, std::min(sizeof(T), static_cast<std::size_t>(event.size)));
+            return data;
+        }
+
+        std::uint32_t getEndTick() const;
+        bool finished() const { return m_nextEvent == m_events.size(); }
+
+        //compares a checksum of the replayed state with the recorded one
+        void verifyChecksum(std::uint32_t tick, std::uint64_t recorded, std::uint64_t replayed);
+        std::size_t getChecksumCount() const { return m_checksumCount; }
+        std::size_t getMismatchCount() const { return m_mismatchCount; }
+        std::uint32_t getFirstMismatch() const { return m_firstMismatch; }
+
+    private:
+        struct Client final
+        {
+            std::uint64_t clientID = 0;
+            std::uint32_t xp = 0;
+            std::uint8_t playerID = 0;
+            std::uint8_t spriteIndex = 0;
+            std::uint8_t hatIndex = 0;
+        };
+
+        std::uint64_t m_seedHash = 0;
+        std::string m_seed;
+        std::vector<Client> m_clients;
+
+        std::vector<Event> m_events;
+        std::vector<std::uint8_t> m_payload;
+        std::size_t m_nextEvent = 0;
+
+        std::size_t m_checksumCount = 0;
+        std::size_t m_mismatchCount = 0;
+        std::uint32_t m_firstMismatch = 0;
+    };
+}
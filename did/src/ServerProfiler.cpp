@@ -0,0 +1,250 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "ServerProfiler.hpp"
+
+#include <xyginext/core/Assert.hpp>
+#include <xyginext/core/Log.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace Server;
+
+namespace
+{
+    thread_local Profiler* activeProfiler = nullptr;
+
+    const std::array<std::string, ProfileID::Count> ProfileNames =
+    {
+        "Tick", "MessageHandling", "LogicUpdate", "NetworkUpdate",
+        "ActorSystem", "BarrelSystem", "BeeSystem", "BotSystem", "CarriableSystem",
+        "CollectibleSystem", "CollisionSystem", "CrabSystem", "DecoySystem", "FlareSystem",
+        "InventorySystem", "ParrotLauncherSystem", "PlayerSystem", "SkeletonSystem",
+        "SkullShieldSystem", "TimedCarriableSystem",
+        "DigDirector", "StormDirector", "StormMessages", "WeaponDirector"
+    };
+
+    const float BinTime = 1.f;
+}
+
+Profiler::Profiler()
+    : m_traffic     (),
+    m_currentBin    (0),
+    m_binTime       (0.f),
+    m_binCount      (1),
+    m_dumpInterval  (0.f),
+    m_dumpTime      (0.f),
+    m_uptime        (0.f)
+{
+    m_sortBuffer.reserve(SampleCount);
+}
+
+//public
+void Profiler::addSample(std::int32_t id, std::int64_t microseconds)
+{
+    XY_ASSERT(id >= 0 && id < ProfileID::Count, "Invalid profile ID");
+
+    auto& samples = m_samples[id];
+    samples.values[samples.head] = microseconds;
+    samples.head = (samples.head + 1) % SampleCount;
+    samples.count = std::min(samples.count + 1, SampleCount);
+}
+
+void Profiler::addPacket(std::uint8_t packetID, std::size_t bytes, std::size_t packetCount)
+{
+    auto& traffic = m_traffic[m_currentBin][packetID];
+    traffic.bytes += bytes * packetCount;
+    traffic.packets += packetCount;
+}
+
+void Profiler::update(float dt)
+{
+    m_uptime += dt;
+
+    m_binTime += dt;
+    if (m_binTime > BinTime)
+    {
+        m_binTime -= BinTime;
+        m_currentBin = (m_currentBin + 1) % TrafficBins;
+        m_traffic[m_currentBin] = {};
+        m_binCount = std::min(m_binCount + 1, TrafficBins);
+    }
+
+    if (m_dumpInterval > 0)
+    {
+        m_dumpTime += dt;
+        if (m_dumpTime > m_dumpInterval)
+        {
+            m_dumpTime = 0.f;
+            dump();
+        }
+    }
+}
+
+std::string Profiler::getSummary()
+{
+    std::stringstream ss;
+    ss << std::setw(22) << "timer (us)" << std::setw(8) << "p50" << std::setw(8) << "p95" << std::setw(8) << "p99" << std::setw(8) << "max\n";
+    for (auto i = 0; i < ProfileID::Count; ++i)
+    {
+        if (m_samples[i].count == 0)
+        {
+            continue;
+        }
+
+        auto p = getPercentiles(i);
+        ss << std::setw(22) << ProfileNames[i] << std::setw(8) << p.p50 << std::setw(8) << p.p95 << std::setw(8) << p.p99 << std::setw(8) << p.max << "\n";
+    }
+
+    std::size_t totalBytes = 0;
+    ss << std::setw(22) << "packet ID" << std::setw(10) << "B/s" << std::setw(10) << "pkt/s\n";
+    for (auto i = 0u; i < 256u; ++i)
+    {
+        auto traffic = getTraffic(i);
+        if (traffic.packets == 0)
+        {
+            continue;
+        }
+
+        totalBytes += traffic.bytes;
+        ss << std::setw(22) << i << std::setw(10) << traffic.bytes << std::setw(10) << traffic.packets << "\n";
+    }
+    ss << std::setw(22) << "total" << std::setw(10) << totalBytes << "\n";
+
+    return ss.str();
+}
+
+void Profiler::setDumpFile(const std::string& path, float interval)
+{
+    m_dumpPath = path;
+    m_dumpInterval = std::max(0.f, interval);
+    m_dumpTime = 0.f;
+
+    if (m_dumpInterval > 0)
+    {
+        std::ofstream file(m_dumpPath);
+        if (file.is_open())
+        {
+            file << "time,kind,name,p50_us,p95_us,p99_us,max_us,bytes_per_sec,packets_per_sec\n";
+        }
+        else
+        {
+            xy::Logger::log("Failed opening " + m_dumpPath + " for writing", xy::Logger::Type::Error);
+            m_dumpInterval = 0.f;
+        }
+    }
+}
+
+void Profiler::setActive(Profiler* profiler)
+{
+    activeProfiler = profiler;
+}
+
+Profiler* Profiler::getActive()
+{
+    return activeProfiler;
+}
+
+//private
+Profiler::Percentiles Profiler::getPercentiles(std::int32_t id)
+{
+    const auto& samples = m_samples[id];
+    m_sortBuffer.assign(samples.values.begin(), samples.values.begin() + samples.count);
+
+    auto percentile = [&](float p)
+    {
+        auto idx = static_cast<std::size_t>(p * static_cast<float>(m_sortBuffer.size() - 1));
+        std::nth_element(m_sortBuffer.begin(), m_sortBuffer.begin() + idx, m_sortBuffer.end());
+        return m_sortBuffer[idx];
+    };
+
+    Percentiles retVal;
+    retVal.p50 = percentile(0.5f);
+    retVal.p95 = percentile(0.95f);
+    retVal.p99 = percentile(0.99f);
+    retVal.max = percentile(1.f);
+    return retVal;
+}
+
+Profiler::Traffic Profiler::getTraffic(std::size_t packetID) const
+{
+    //the current bin is only partially filled, so is included in the time
+    Traffic retVal;
+    for (const auto& bin : m_traffic)
+    {
+        retVal.bytes += bin[packetID].bytes;
+        retVal.packets += bin[packetID].packets;
+    }
+
+    const float seconds = static_cast<float>(m_binCount - 1) * BinTime + m_binTime;
+    if (seconds > 0)
+    {
+        retVal.bytes = static_cast<std::size_t>(static_cast<float>(retVal.bytes) / seconds);
+        retVal.packets = static_cast<std::size_t>(static_cast<float>(retVal.packets) / seconds);
+    }
+    return retVal;
+}
+
+void Profiler::dump()
+{
+    std::ofstream file(m_dumpPath, std::ios::app);
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    const auto time = std::to_string(m_uptime);
+    for (auto i = 0; i < ProfileID::Count; ++i)
+    {
+        if (m_samples[i].count == 0)
+        {
+            continue;
+        }
+
+        auto p = getPercentiles(i);
+        file << time << ",timer," << ProfileNames[i] << "," << p.p50 << "," << p.p95 << "," << p.p99 << "," << p.max << ",,\n";
+    }
+
+    for (auto i = 0u; i < 256u; ++i)
+    {
+        auto traffic = getTraffic(i);
+        if (traffic.packets == 0)
+        {
+            continue;
+        }
+        file << time << ",packet," << i << ",,,,," << traffic.bytes << "," << traffic.packets << "\n";
+    }
+}
+
+ProfileScope::ProfileScope(std::int32_t id)
+    : m_profiler(Profiler::getActive()),
+    m_id        (id)
+{
+
+}
+
+ProfileScope::~ProfileScope()
+{
+    if (m_profiler)
+    {
+        m_profiler->addSample(m_id, m_clock.getElapsedTime().asMicroseconds());
+    }
+}
@@ -0,0 +1,154 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <SFML/System/Clock.hpp>
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace Server
+{
+    namespace ProfileID
+    {
+        enum
+        {
+            Tick,
+            MessageHandling,
+            LogicUpdate,
+            NetworkUpdate,
+
+            ActorSystem,
+            BarrelSystem,
+            BeeSystem,
+            BotSystem,
+            CarriableSystem,
+            CollectibleSystem,
+            CollisionSystem,
+            CrabSystem,
+            DecoySystem,
+            FlareSystem,
+            InventorySystem,
+            ParrotLauncherSystem,
+            PlayerSystem,
+            SkeletonSystem,
+            SkullShieldSystem,
+            TimedCarriableSystem,
+
+            DigDirector,
+            StormDirector,
+            StormMessages,
+            WeaponDirector,
+
+            Count
+        };
+    }
+
+    /*!
+    \brief Collects timings of the server systems and traffic counts
+    per packet ID. Each GameServer owns one and makes it active for
+    its thread, so systems shared with the client don't record anything
+    when they run client side.
+    */
+    class Profiler final
+    {
+    public:
+        Profiler();
+
+        //adds a timing in microseconds for the given ProfileID
+        void addSample(std::int32_t id, std::int64_t microseconds);
+
+        //counts bytes sent with the given packet ID
+        void addPacket(std::uint8_t packetID, std::size_t bytes, std::size_t packetCount = 1);
+
+        //advances the traffic window and writes any pending dump
+        void update(float dt);
+
+        //returns a table of timer percentiles over the last few
+        //seconds, and the average traffic per packet ID
+        std::string getSummary();
+
+        //appends the summary in CSV format to the given file
+        //every interval seconds. An interval of 0 stops dumping
+        void setDumpFile(const std::string& path, float interval);
+
+        static void setActive(Profiler*);
+        static Profiler* getActive();
+
+    private:
+        static constexpr std::size_t SampleCount = 300; //5 seconds of logic updates
+        struct Samples final
+        {
+            std::array<std::int64_t, SampleCount> values = {};
+            std::size_t head = 0;
+            std::size_t count = 0;
+        };
+        std::array<Samples, ProfileID::Count> m_samples;
+
+        //traffic is counted in one second bins
+        static constexpr std::size_t TrafficBins = 5;
+        struct Traffic final
+        {
+            std::size_t bytes = 0;
+            std::size_t packets = 0;
+        };
+        std::array<std::array<Traffic, 256u>, TrafficBins> m_traffic;
+        std::size_t m_currentBin;
+        float m_binTime;
+        std::size_t m_binCount;
+
+        std::string m_dumpPath;
+        float m_dumpInterval;
+        float m_dumpTime;
+        float m_uptime;
+
+        std::vector<std::int64_t> m_sortBuffer;
+
+        struct Percentiles final
+        {
+            std::int64_t p50 = 0;
+            std::int64_t p95 = 0;
+            std::int64_t p99 = 0;
+            std::int64_t max = 0;
+        };
+        Percentiles getPercentiles(std::int32_t);
+        Traffic getTraffic(std::size_t) const;
+
+        void dump();
+    };
+
+    //records the time between construction and destruction
+    //with the active profiler, if there is one
+    class ProfileScope final
+    {
+    public:
+        explicit ProfileScope(std::int32_t id);
+        ~ProfileScope();
+
+        ProfileScope(const ProfileScope&) = delete;
+        ProfileScope& operator = (const ProfileScope&) = delete;
+
+    private:
+        Profiler* m_profiler;
+        std::int32_t m_id;
+        sf::Clock m_clock;
+    };
+}
@@ -18,23 +18,66 @@ Copyright 2019 Matt Marchant
 
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <random>
 
 namespace Server
 {
-    static std::mt19937 rndEngine;
+    namespace RandomStream
+    {
+        enum ID
+        {
+            Spawns,
+            Bots,
+            Barrels,
+            Collectibles,
+            Flares,
+            Skeletons,
+            Storm,
+
+            Count
+        };
+    }
+
+    //a separate random engine for each subsystem, owned by the GameState
+    //and seeded from the match seed. Each system always draws from the
+    //same stream regardless of how many numbers the others use, so a
+    //match with the same seed and inputs plays out the same way
+    class RandomStreams final
+    {
+    public:
+        void seed(std::uint64_t matchSeed)
+        {
+            for (auto i = 0u; i < m_engines.size(); ++i)
+            {
+                std::seed_seq seq = { static_cast<std::uint32_t>(matchSeed), static_cast<std::uint32_t>(matchSeed >> 32), i };
+                seq.generate(m_seeds.begin() + i, m_seeds.begin() + i + 1);
+                m_engines[i].seed(m_seeds[i]);
+            }
+        }
+
+        std::mt19937& get(RandomStream::ID id) { return m_engines[id]; }
+
+        //for systems which own their engine
+        std::uint32_t getSeed(RandomStream::ID id) const { return m_seeds[id]; }
+
+    private:
+        std::array<std::mt19937, RandomStream::Count> m_engines;
+        std::array<std::uint32_t, RandomStream::Count> m_seeds = {};
+    };
 
-    static inline float getRandomFloat(float begin, float end)
+    static inline float getRandomFloat(std::mt19937& rndEngine, float begin, float end)
     {
         //XY_ASSERT(begin < end, "first value is not less than last value");
         std::uniform_real_distribution<float> dist(begin, end);
         return dist(rndEngine);
     }
 
-    static inline int getRandomInt(int begin, int end)
+    static inline int getRandomInt(std::mt19937& rndEngine, int begin, int end)
     {
         //XY_ASSERT(begin < end, "first value is not less than last value");
         std::uniform_int_distribution<int> dist(begin, end);
         return dist(rndEngine);
     }
-}
\ No newline at end of file
+}
@@ -27,16 +27,24 @@ namespace
 
 std::int32_t RoundTimer::getTime() const
 {
-    return std::max(0, Timeout - static_cast<std::int32_t>(m_clock.getElapsedTime().asSeconds()));
+    return std::max(0, Timeout - static_cast<std::int32_t>(m_elapsed));
 }
 
 void RoundTimer::start()
 {
-    m_clock.restart();
+    m_elapsed = 0.f;
     m_started = true;
 }
 
 bool RoundTimer::started() const
 {
     return m_started;
+}
+
+void RoundTimer::update(float dt)
+{
+    if (m_started)
+    {
+        m_elapsed += dt;
+    }
 }
\ No newline at end of file
@@ -18,8 +18,6 @@ Copyright 2019 Matt Marchant
 
 #pragma once
 
-#include <SFML/System/Clock.hpp>
-
 #include <cstdint>
 
 class RoundTimer final
@@ -32,8 +30,12 @@ public:
 
     bool started() const;
 
+    //advances the timer by the logic time step, so that
+    //a replayed match ends on the same tick
+    void update(float);
+
 private:
 
     bool m_started = false;
-    sf::Clock m_clock;
+    float m_elapsed = 0.f;
 };
\ No newline at end of file
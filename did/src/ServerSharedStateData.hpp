@@ -23,10 +23,13 @@ Copyright 2019 Matt Marchant
 #include <SFML/System/String.hpp>
 
 #include <map>
+#include <string>
 
 class GameServer;
 namespace Server
 {
+    class MatchReplay;
+
     struct SeedData final
     {
         static constexpr std::size_t MaxChar = 16;
@@ -51,5 +54,8 @@ namespace Server
         GameServer* gameServer = nullptr;
         std::map<std::uint64_t, ClientData> connectedClients;
         SeedData seedData;
+        std::string mapCacheDirectory;
+        std::string recordDirectory; //matches are recorded if this is set
+        MatchReplay* replay = nullptr; //set while a recording is being replayed
     };
 }
\ No newline at end of file
@@ -24,6 +24,7 @@ Copyright 2019 Matt Marchant
 #include "GlobalConsts.hpp"
 #include "MessageIDs.hpp"
 #include "Actor.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/util/Random.hpp>
 
@@ -44,17 +45,20 @@ namespace
     };
 }
 
-StormDirector::StormDirector(Server::SharedStateData& sd)
+StormDirector::StormDirector(Server::SharedStateData& sd, std::mt19937& rndEngine)
     : m_sharedData      (sd),
+    m_rndEngine         (rndEngine),
     m_strikePointIndex  (0),
-    m_strikeTimeIndex   (Server::getRandomInt(0, LightningTimes.size() - 1)),
+    m_strikeTimeIndex   (Server::getRandomInt(rndEngine, 0, LightningTimes.size() - 1)),
+    m_strikeTime        (0.f),
     m_state             (StormDirector::Dry),
-    m_stateIndex        (Server::getRandomInt(0, WeatherTimes.size() - 1))
+    m_stateTime         (0.f),
+    m_stateIndex        (Server::getRandomInt(rndEngine, 0, WeatherTimes.size() - 1))
 {
     //poisson sample strike points
     m_strikePoints = xy::Util::Random::poissonDiscDistribution(
         { 0.f, 0.f, static_cast<float>(Global::TileCountX), static_cast<float>(Global::TileCountY) },
-        8.f, 18, Server::rndEngine);
+        8.f, 18, m_rndEngine);
 
     //scale up from tile coords
     for (auto& point : m_strikePoints)
@@ -66,6 +70,8 @@ StormDirector::StormDirector(Server::SharedStateData& sd)
 //public
 void StormDirector::handleMessage(const xy::Message& msg)
 {
+    Server::ProfileScope profile(Server::ProfileID::StormMessages);
+
     if (msg.id == MessageID::SceneMessage)
     {
         const auto& data = msg.getData<SceneEvent>();
@@ -76,24 +82,27 @@ void StormDirector::handleMessage(const xy::Message& msg)
     }
 }
 
-void StormDirector::process(float)
+void StormDirector::process(float dt)
 {
-    if (m_stateClock.getElapsedTime().asSeconds() >
-        WeatherTimes[m_stateIndex])
+    Server::ProfileScope profile(Server::ProfileID::StormDirector);
+
+    m_stateTime += dt;
+    m_strikeTime += dt;
+
+    if (m_stateTime > WeatherTimes[m_stateIndex])
     {
         m_stateIndex = (m_stateIndex + 1) % WeatherTimes.size();
         
-        auto state = (m_state == Dry) ? static_cast<State>(Wet + Server::getRandomInt(0, 1)) : Dry;
+        auto state = (m_state == Dry) ? static_cast<State>(Wet + Server::getRandomInt(m_rndEngine, 0, 1)) : Dry;
         setWeather(state);
     }
 
     if (m_state == State::Stormy)
     {
         //LIGHTNING!!
-        if (m_strikeClock.getElapsedTime().asSeconds() >
-            LightningTimes[m_strikeTimeIndex])
+        if (m_strikeTime > LightningTimes[m_strikeTimeIndex])
         {
-            m_strikeClock.restart();
+            m_strikeTime = 0.f;
             m_strikeTimeIndex = (m_strikeTimeIndex + 1) % LightningTimes.size();
 
             auto pos = m_strikePoints[m_strikePointIndex];
@@ -112,8 +121,8 @@ void StormDirector::setWeather(State state)
 {
     m_state = state;
 
-    m_stateClock.restart();
-    m_strikeClock.restart();
+    m_stateTime = 0.f;
+    m_strikeTime = 0.f;
 
     m_sharedData.gameServer->broadcastData(PacketID::WeatherUpdate, std::uint8_t(m_state), xy::NetFlag::Reliable, Global::ReliableChannel);
     LOG("Set weather to " + std::to_string(m_state), xy::Logger::Type::Info);
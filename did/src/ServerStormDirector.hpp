@@ -20,6 +20,7 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/ecs/Director.hpp>
 #include <SFML/System/Vector2.hpp>
+#include <random>
 #include <vector>
 
 namespace Server
@@ -30,7 +31,7 @@ namespace Server
 class StormDirector final : public xy::Director
 {
 public:
-    explicit StormDirector(Server::SharedStateData&);
+    StormDirector(Server::SharedStateData&, std::mt19937&);
 
     void handleMessage(const xy::Message&) override;
     void handleEvent(const sf::Event&) override{}
@@ -45,15 +46,16 @@ public:
     };
 private:
     Server::SharedStateData& m_sharedData;
+    std::mt19937& m_rndEngine;
     std::vector<sf::Vector2f> m_strikePoints;
 
     std::size_t m_strikePointIndex;
     std::size_t m_strikeTimeIndex;
-    sf::Clock m_strikeClock;
+    float m_strikeTime;
 
     State m_state = Dry;
 
-    sf::Clock m_stateClock;
+    float m_stateTime; //accumulated from logic updates so replays match
     std::size_t m_stateIndex;
 
     void setWeather(State);
@@ -28,6 +28,7 @@ Copyright 2019 Matt Marchant
 #include "Packet.hpp"
 #include "PacketTypes.hpp"
 #include "Server.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
@@ -73,6 +74,8 @@ ServerWeaponDirector::ServerWeaponDirector(Server::SharedStateData& sd)
 //public
 void ServerWeaponDirector::handleMessage(const xy::Message& msg)
 {
+    Server::ProfileScope profile(Server::ProfileID::WeaponDirector);
+
     if (msg.id == MessageID::PlayerMessage)
     {
         const auto& data = msg.getData<PlayerEvent>();
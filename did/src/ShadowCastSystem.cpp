@@ -32,15 +32,30 @@ Copyright 2019 Matt Marchant
 #include <xyginext/util/Vector.hpp>
 #include <xyginext/resources/ShaderResource.hpp>
 
+#include <algorithm>
+
 namespace
 {
     const float ShadowRadius = Global::LightRadius;// *0.89f;
     const float ShadowRadiusSqr = ShadowRadius * ShadowRadius;
+
+    const std::int32_t GridWidth = static_cast<std::int32_t>(Global::IslandSize.x / ShadowRadius) + 1;
+    const std::int32_t GridHeight = static_cast<std::int32_t>(Global::IslandSize.y / ShadowRadius) + 1;
+
+    //anything outside the island is clamped to the edge cells, which
+    //is safe because clamping never moves two points further apart
+    std::int32_t cellCoord(float position, std::int32_t cellCount)
+    {
+        return std::max(0, std::min(cellCount - 1, static_cast<std::int32_t>(std::floor(position / ShadowRadius))));
+    }
 }
 
 ShadowCastSystem::ShadowCastSystem(xy::MessageBus& mb, xy::ShaderResource& sr)
-    : xy::System(mb, typeid(ShadowCastSystem)),
-    m_prepCount (2)
+    : xy::System    (mb, typeid(ShadowCastSystem)),
+    m_prepCount     (2),
+    m_processTime   (0),
+    m_pairCount     (0),
+    m_rebuiltCount  (0)
 {
     requireComponent<ShadowCaster>();
     requireComponent<xy::Transform>();
@@ -53,6 +68,13 @@ ShadowCastSystem::ShadowCastSystem(xy::MessageBus& mb, xy::ShaderResource& sr)
 void ShadowCastSystem::process(float)
 {
     prepShader();
+
+    m_timer.restart();
+    m_pairCount = 0;
+    m_rebuiltCount = 0;
+
+    binLights();
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
@@ -64,64 +86,110 @@ void ShadowCastSystem::process(float)
             continue;
         }
 
-        auto& drawable = entity.getComponent<xy::Drawable>();
-        auto& verts = drawable.getVertices();
-        verts.clear();
-
         auto bounds = caster.parent.getComponent<xy::Sprite>().getTextureBounds();
         bounds = caster.parent.getComponent<xy::Transform>().getTransform().transformRect(bounds);
 
         auto entPos = caster.parent.getComponent<xy::Transform>().getPosition();
         entPos.y -= caster.parent.getComponent<Sprite3D>().verticalOffset;
 
+        auto textureRect = caster.parent.getComponent<xy::Sprite>().getTextureRect();
+
+        auto& cache = m_casterCache[entity.getIndex()];
+        bool casterMoved = (!cache.valid || cache.position != entPos
+            || cache.bounds != bounds || cache.textureRect != textureRect);
+
+        cache.position = entPos;
+        cache.bounds = bounds;
+        cache.textureRect = textureRect;
+        cache.valid = true;
+
+        //find nearby lights, kept in the order they were added
+        //so the output is the same as testing every light
+        m_nearbyLights.clear();
+        auto cellX = cellCoord(entPos.x, GridWidth);
+        auto cellY = cellCoord(entPos.y, GridHeight);
+        for (auto y = std::max(0, cellY - 1); y <= std::min(GridHeight - 1, cellY + 1); ++y)
+        {
+            for (auto x = std::max(0, cellX - 1); x <= std::min(GridWidth - 1, cellX + 1); ++x)
+            {
+                auto cell = y * GridWidth + x;
+                for (auto i = m_cellStart[cell]; i < m_cellStart[cell + 1]; ++i)
+                {
+                    auto light = m_cellEntries[i];
+                    if (xy::Util::Vector::lengthSquared(m_lightPositions[light] - entPos) < ShadowRadiusSqr)
+                    {
+                        m_nearbyLights.push_back(light);
+                    }
+                }
+            }
+        }
+        std::sort(m_nearbyLights.begin(), m_nearbyLights.end());
+
+        std::swap(cache.pairs, cache.previousPairs);
+        cache.pairs.clear();
+
+        bool dirty = casterMoved || (m_nearbyLights.size() != cache.previousPairs.size());
+        if (casterMoved)
+        {
+            cache.previousPairs.clear();
+        }
+
         sf::Vector2f pointA(bounds.left, entPos.y);
         //point B is entPos
         sf::Vector2f pointC(bounds.left + bounds.width, entPos.y);
+        const std::array<sf::Vector2f, 3u> points = { pointA, entPos, pointC };
 
-        bounds = caster.parent.getComponent<xy::Sprite>().getTextureRect();
         std::array<sf::Vector2f, 6u> texCoords = 
         {
-            sf::Vector2f(bounds.left, bounds.top + bounds.height),
-            sf::Vector2f(bounds.left, bounds.top),
-            sf::Vector2f(bounds.left + (bounds.width / 2.f), bounds.top + bounds.height),
-            sf::Vector2f(bounds.left + (bounds.width / 2.f), bounds.top),
-            sf::Vector2f(bounds.left + bounds.width, bounds.top + bounds.height),
-            sf::Vector2f(bounds.left + bounds.width, bounds.top)
+            sf::Vector2f(textureRect.left, textureRect.top + textureRect.height),
+            sf::Vector2f(textureRect.left, textureRect.top),
+            sf::Vector2f(textureRect.left + (textureRect.width / 2.f), textureRect.top + textureRect.height),
+            sf::Vector2f(textureRect.left + (textureRect.width / 2.f), textureRect.top),
+            sf::Vector2f(textureRect.left + textureRect.width, textureRect.top + textureRect.height),
+            sf::Vector2f(textureRect.left + textureRect.width, textureRect.top)
         };
 
-        for (auto light : m_lights)
+        for (auto i = 0u; i < m_nearbyLights.size(); ++i)
         {
-            //get distance to light and skip if not nearby
-            auto lightPos = light.getComponent<xy::Transform>().getPosition();
-            auto lightDir2 = xy::Util::Vector::lengthSquared(lightPos - entPos);
+            auto light = m_lights[m_nearbyLights[i]].getIndex();
+            auto lightPos = m_lightPositions[m_nearbyLights[i]];
+
+            auto result = std::find_if(cache.previousPairs.begin(), cache.previousPairs.end(),
+                [light](const ShadowPair& pair) { return pair.light == light; });
 
-            if (lightDir2 < ShadowRadiusSqr)
+            if (result != cache.previousPairs.end()
+                && result->lightPosition == lightPos)
             {
-                auto[rayA, shadowAmountA] = getRay(lightPos, pointA);
-                auto[rayB, shadowAmountB] = getRay(lightPos, entPos);
-                auto[rayC, shadowAmountC] = getRay(lightPos, pointC);
-
-                auto lightnessA = static_cast<sf::Uint8>(255.f * shadowAmountA);
-                auto lightnessB = static_cast<sf::Uint8>(255.f * shadowAmountB);
-                auto lightnessC = static_cast<sf::Uint8>(255.f * shadowAmountC);
-
-                //abs placed because no model matrix in shader
-                verts.push_back({ pointA, sf::Color(lightnessA, lightnessA, lightnessA), texCoords[0] });
-                verts.push_back({ pointA + rayA, sf::Color::White, texCoords[1] });
-                verts.back().texCoords.y += shadowAmountA * bounds.height;
-
-                verts.push_back({ entPos, sf::Color(lightnessB, lightnessB, lightnessB), texCoords[2] });
-                verts.push_back({ entPos + rayB, sf::Color::White, texCoords[3] });
-                verts.back().texCoords.y += shadowAmountB * bounds.height;
-
-                verts.push_back({ pointC, sf::Color(lightnessC, lightnessC, lightnessC), texCoords[4] });
-                verts.push_back({ pointC + rayC, sf::Color::White, texCoords[5] });
-                verts.back().texCoords.y += shadowAmountC * bounds.height;
+                cache.pairs.push_back(*result);
+                dirty = dirty || (std::distance(cache.previousPairs.begin(), result) != static_cast<std::ptrdiff_t>(i));
+            }
+            else
+            {
+                auto& pair = cache.pairs.emplace_back();
+                pair.light = light;
+                pair.lightPosition = lightPos;
+                buildPair(pair, lightPos, points, texCoords, textureRect.height);
+
+                m_rebuiltCount++;
+                dirty = true;
             }
         }
+        m_pairCount += cache.pairs.size();
 
-        drawable.updateLocalBounds();
+        if (dirty)
+        {
+            auto& drawable = entity.getComponent<xy::Drawable>();
+            auto& verts = drawable.getVertices();
+            verts.clear();
+
+            for (const auto& pair : cache.pairs)
+            {
+                verts.insert(verts.end(), pair.vertices.begin(), pair.vertices.end());
+            }
+            drawable.updateLocalBounds();
+        }
     }
+    m_processTime = m_timer.getElapsedTime().asMicroseconds();
 
     //update from camera settings
     const auto camEnt = getScene()->getActiveCamera();
@@ -142,6 +210,13 @@ void ShadowCastSystem::addLight(xy::Entity entity)
 
 void ShadowCastSystem::onEntityAdded(xy::Entity entity)
 {
+    if (entity.getIndex() >= m_casterCache.size())
+    {
+        m_casterCache.resize(entity.getIndex() + 1);
+    }
+    m_casterCache[entity.getIndex()].valid = false;
+    m_casterCache[entity.getIndex()].pairs.clear();
+
     entity.getComponent<xy::Drawable>().setPrimitiveType(sf::TriangleStrip);
     entity.getComponent<xy::Drawable>().setShader(m_shader);
     entity.getComponent<xy::Drawable>().setBlendMode(sf::BlendMultiply);
@@ -165,6 +240,55 @@ void ShadowCastSystem::prepShader()
     }
 }
 
+void ShadowCastSystem::binLights()
+{
+    //remove any lights which have since been destroyed
+    m_lights.erase(std::remove_if(m_lights.begin(), m_lights.end(),
+        [](xy::Entity e) { return !e.isValid() || e.destroyed(); }), m_lights.end());
+
+    //counting sort into cells. After the prefix sum each cell
+    //holds its end, which is decremented as entries are added
+    const std::size_t cellCount = GridWidth * GridHeight;
+    m_cellStart.assign(cellCount + 1, 0);
+    m_lightPositions.resize(m_lights.size());
+    m_lightCells.resize(m_lights.size());
+
+    for (auto i = 0u; i < m_lights.size(); ++i)
+    {
+        auto position = m_lights[i].getComponent<xy::Transform>().getPosition();
+        m_lightPositions[i] = position;
+        m_lightCells[i] = cellCoord(position.y, GridHeight) * GridWidth + cellCoord(position.x, GridWidth);
+        m_cellStart[m_lightCells[i]]++;
+    }
+
+    for (auto i = 1u; i < cellCount; ++i)
+    {
+        m_cellStart[i] += m_cellStart[i - 1];
+    }
+    m_cellStart[cellCount] = static_cast<std::uint32_t>(m_lights.size());
+
+    m_cellEntries.resize(m_lights.size());
+    for (auto i = m_lights.size(); i > 0; --i)
+    {
+        m_cellEntries[--m_cellStart[m_lightCells[i - 1]]] = static_cast<std::uint32_t>(i - 1);
+    }
+}
+
+void ShadowCastSystem::buildPair(ShadowPair& pair, sf::Vector2f lightPos, const std::array<sf::Vector2f, 3u>& points,
+                                    const std::array<sf::Vector2f, 6u>& texCoords, float textureHeight)
+{
+    for (auto i = 0u; i < points.size(); ++i)
+    {
+        auto [ray, shadowAmount] = getRay(lightPos, points[i]);
+        auto lightness = static_cast<sf::Uint8>(255.f * shadowAmount);
+
+        //abs placed because no model matrix in shader
+        pair.vertices[i * 2] = { points[i], sf::Color(lightness, lightness, lightness), texCoords[i * 2] };
+        pair.vertices[(i * 2) + 1] = { points[i] + ray, sf::Color::White, texCoords[(i * 2) + 1] };
+        pair.vertices[(i * 2) + 1].texCoords.y += shadowAmount * textureHeight;
+    }
+}
+
 std::pair<sf::Vector2f, float> ShadowCastSystem::getRay(sf::Vector2f lightPos, sf::Vector2f basePos)
 {
     auto ray = basePos - lightPos;
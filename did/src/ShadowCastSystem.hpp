@@ -20,6 +20,11 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/ecs/System.hpp>
 
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/System/Clock.hpp>
+
+#include <array>
 #include <vector>
 
 namespace sf
@@ -48,6 +53,14 @@ public:
 
     void addLight(xy::Entity);
 
+    //time taken to update the shadow geometry in the
+    //last frame, in microseconds
+    std::int64_t getProcessTime() const { return m_processTime; }
+
+    //number of caster/light pairs, and how many of those were rebuilt last frame
+    std::size_t getPairCount() const { return m_pairCount; }
+    std::size_t getRebuiltCount() const { return m_rebuiltCount; }
+
 private:
 
     std::vector<xy::Entity> m_lights;
@@ -56,5 +69,42 @@ private:
     std::size_t m_prepCount;
     void prepShader();
 
+    //lights are binned each frame into a grid with cells
+    //the size of the shadow radius, so casters only need
+    //to check the cells surrounding them
+    std::vector<sf::Vector2f> m_lightPositions;
+    std::vector<std::uint32_t> m_cellStart;
+    std::vector<std::uint32_t> m_cellEntries;
+    std::vector<std::uint32_t> m_lightCells;
+    std::vector<std::uint32_t> m_nearbyLights;
+    void binLights();
+
+    //shadow geometry is cached per caster/light pair and
+    //only rebuilt when either of them moves. Storage is
+    //indexed by caster entity and reused as entities are
+    struct ShadowPair final
+    {
+        std::uint32_t light = 0;
+        sf::Vector2f lightPosition;
+        std::array<sf::Vertex, 6u> vertices;
+    };
+
+    struct CasterCache final
+    {
+        sf::Vector2f position;
+        sf::FloatRect bounds;
+        sf::FloatRect textureRect;
+        std::vector<ShadowPair> pairs;
+        std::vector<ShadowPair> previousPairs;
+        bool valid = false;
+    };
+    std::vector<CasterCache> m_casterCache;
+
+    sf::Clock m_timer;
+    std::int64_t m_processTime;
+    std::size_t m_pairCount;
+    std::size_t m_rebuiltCount;
+
     std::pair<sf::Vector2f, float> getRay(sf::Vector2f, sf::Vector2f);
+    void buildPair(ShadowPair&, sf::Vector2f, const std::array<sf::Vector2f, 3u>&, const std::array<sf::Vector2f, 6u>&, float);
 };
\ No newline at end of file
@@ -23,10 +23,13 @@ Copyright 2019 Matt Marchant
 #include "ServerSharedStateData.hpp"
 #include "Server.hpp"
 #include "LoadingScreen.hpp"
+#include "AssetLoader.hpp"
 
 #include <xyginext/network/NetClient.hpp>
+#include <xyginext/resources/ResourceHandler.hpp>
 
 #include <SFML/System/Thread.hpp>
+#include <SFML/System/Clock.hpp>
 #include <SFML/Graphics/RenderTexture.hpp>
 
 #include <memory>
@@ -50,6 +53,14 @@ struct SharedData final
     //struct to be std::any compatible
     std::shared_ptr<GameServer> gameServer;
     std::shared_ptr<xy::NetClient> netClient;
+
+    //game assets are decoded by the loader while the menu is
+    //active and uploaded a few at a time into gameResources
+    std::shared_ptr<AssetLoader> assetLoader;
+    std::shared_ptr<xy::ResourceHandler> gameResources;
+
+    //restarted when the game is launched from the lobby
+    sf::Clock launchClock;
 };
 
 namespace xy
@@ -34,6 +34,7 @@ Copyright 2019 Matt Marchant
 #include "ServerRandom.hpp"
 #include "CarriableSystem.hpp"
 #include "BoatSystem.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 #include <xyginext/ecs/components/Transform.hpp>
@@ -41,7 +42,6 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
 #include <xyginext/util/Vector.hpp>
 #include <xyginext/util/Math.hpp>
-#include <xyginext/util/Random.hpp>
 
 #include <array>
 
@@ -80,10 +80,11 @@ namespace
     const float Speed = 36.f;
 }
 
-SkeletonSystem::SkeletonSystem(xy::MessageBus& mb, Server::SharedStateData& sd, PathFinder& pf)
+SkeletonSystem::SkeletonSystem(xy::MessageBus& mb, Server::SharedStateData& sd, PathFinder& pf, std::mt19937& rndEngine)
     : xy::System        (mb, typeid(SkeletonSystem)),
     m_sharedData        (sd),
     m_pathFinder        (pf),
+    m_rndEngine         (rndEngine),
     m_dayPosition       (0.8f),
     m_spawnTimeIndex    (0),
     m_spawnPositionIndex(0),
@@ -115,6 +116,8 @@ void SkeletonSystem::handleMessage(const xy::Message& msg)
 
 void SkeletonSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::SkeletonSystem);
+
     //check spawn time
     m_spawnTime += dt;
     if (m_spawnTime > spawnSpacing[m_spawnTimeIndex])
@@ -423,7 +426,7 @@ void SkeletonSystem::updateDying(xy::Entity entity, float dt)
         auto position = entity.getComponent<xy::Transform>().getPosition();
 
         //chance to spawn a coin or two
-        auto chance = Server::getRandomInt(0, 3);
+        auto chance = Server::getRandomInt(m_rndEngine, 0, 3);
         if (chance == 0 && /*!isDayTime() &&*/ entity.getComponent<CollisionComponent>().water == 0)
         {
             auto* msg = postMessage<ActorEvent>(MessageID::ActorMessage);
@@ -432,7 +435,7 @@ void SkeletonSystem::updateDying(xy::Entity entity, float dt)
             msg->type = ActorEvent::RequestSpawn;
 
             //second coin if we're lucky
-            if (xy::Util::Random::value(0, 5) == 0)
+            if (Server::getRandomInt(m_rndEngine, 0, 5) == 0)
             {
                 msg = postMessage<ActorEvent>(MessageID::ActorMessage);
                 msg->id = Actor::ID::Coin;
@@ -646,7 +649,7 @@ void SkeletonSystem::setRandomPath(xy::Entity entity)
     if (skeleton.pathRequested || !skeleton.pathPoints.empty()) return;
 
     sf::Vector2i start(static_cast<int>(pos.x / Global::TileSize), static_cast<int>(pos.y / Global::TileSize));
-    sf::Vector2i end(Server::getRandomInt(8, Global::TileCountX - 16), Server::getRandomInt(8, Global::TileCountY - 16));
+    sf::Vector2i end(Server::getRandomInt(m_rndEngine, 8, Global::TileCountX - 16), Server::getRandomInt(m_rndEngine, 8, Global::TileCountY - 16));
     m_pathFinder.plotPathAsync(start, end, skeleton.pathPoints);
     skeleton.pathRequested = true;
     LOG("Skeleton got random path", xy::Logger::Type::Info);
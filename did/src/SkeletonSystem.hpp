@@ -20,6 +20,7 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/ecs/System.hpp>
 
+#include <random>
 #include <vector>
 
 namespace Server
@@ -57,7 +58,7 @@ struct Skeleton final
 class SkeletonSystem final : public xy::System
 {
 public:
-    SkeletonSystem(xy::MessageBus&, Server::SharedStateData&, PathFinder&);
+    SkeletonSystem(xy::MessageBus&, Server::SharedStateData&, PathFinder&, std::mt19937&);
 
     void handleMessage(const xy::Message&) override;
     void process(float) override;
@@ -66,6 +67,7 @@ private:
     Server::SharedStateData& m_sharedData;
     std::vector<sf::Vector2f> m_spawnPoints;
     PathFinder& m_pathFinder;
+    std::mt19937& m_rndEngine;
 
     float m_dayPosition;
     std::size_t m_spawnTimeIndex;
@@ -22,6 +22,7 @@ Copyright 2019 Matt Marchant
 #include "QuadTreeFilter.hpp"
 #include "PlayerSystem.hpp"
 #include "Actor.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/components/BroadPhaseComponent.hpp>
 #include <xyginext/ecs/Scene.hpp>
@@ -43,6 +44,8 @@ SkullShieldSystem::SkullShieldSystem(xy::MessageBus& mb)
 //public
 void SkullShieldSystem::process(float dt)
 {
+    Server::ProfileScope profile(Server::ProfileID::SkullShieldSystem);
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
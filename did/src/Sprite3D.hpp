@@ -26,6 +26,8 @@ Responsible for creating the 3D matrix used for drawing sprites
 
 #include <xyginext/ecs/System.hpp>
 
+#include <SFML/System/Clock.hpp>
+
 #include <vector>
 #include <map>
 
@@ -40,14 +42,13 @@ public:
     Sprite3D()
         : verticalOffset    (0.f),
         needsCorrection     (true),
-        m_pool              (nullptr),
-        m_matrixIdx         (0){}
+        m_pool              (nullptr){}
 
     explicit Sprite3D(MatrixPool& pool)
         : verticalOffset(0.f),
         needsCorrection (true),
         m_pool          (&pool),
-        m_matrixIdx     (pool.allocate())
+        m_matrixHandle  (pool.allocate())
     {
     
     }
@@ -56,18 +57,17 @@ public:
     {
         if (m_pool)
         {
-            m_pool->deallocate(m_matrixIdx);
+            m_pool->deallocate(m_matrixHandle);
         }
     }
 
     Sprite3D(Sprite3D&& other)
-        : m_pool    (nullptr),
-        m_matrixIdx (0)
+        : m_pool    (nullptr)
     {
         std::swap(verticalOffset, other.verticalOffset);
         std::swap(needsCorrection, other.needsCorrection);
         std::swap(m_pool, other.m_pool);
-        std::swap(m_matrixIdx, other.m_matrixIdx);
+        std::swap(m_matrixHandle, other.m_matrixHandle);
     }
 
     Sprite3D& operator = (Sprite3D&& other)
@@ -75,7 +75,7 @@ public:
         std::swap(verticalOffset, other.verticalOffset);
         std::swap(needsCorrection, other.needsCorrection);
         std::swap(m_pool, other.m_pool);
-        std::swap(m_matrixIdx, other.m_matrixIdx);
+        std::swap(m_matrixHandle, other.m_matrixHandle);
 
         return *this;
     }
@@ -83,13 +83,13 @@ public:
     glm::mat4& getMatrix()
     {
         XY_ASSERT(m_pool, "Created with missing construction parameter!");
-        return m_pool->at(m_matrixIdx);
+        return m_pool->at(m_matrixHandle);
     }
 
     const glm::mat4& getMatrix() const
     {
         XY_ASSERT(m_pool, "Created with missing construction parameter!");
-        return m_pool->at(m_matrixIdx);
+        return m_pool->at(m_matrixHandle);
     }
 
     float verticalOffset;
@@ -98,7 +98,7 @@ public:
 
 private:
     MatrixPool* m_pool;
-    std::size_t m_matrixIdx;
+    MatrixPool::Handle m_matrixHandle;
 };
 
 class Sprite3DSystem final : public xy::System
@@ -108,10 +108,54 @@ public:
 
     void process(float) override;
 
+    //number of matrices rebuilt during the last update
+    std::size_t getUpdateCount() const { return m_dirty.size(); }
+
+    //time taken by the last update, in microseconds
+    std::int64_t getProcessTime() const { return m_processTime; }
+
 private:
     const std::vector<sf::Shader*> m_spriteShaders;
 
     std::map<std::uint32_t, std::int32_t> m_uniformMap;
 
+    //matrix components for every entity, in the order of
+    //getEntities(). These are calculated in a single pass
+    //and compared with the previous values, indexed by entity,
+    //so that only matrices which changed are rebuilt
+    struct MatrixBatch final
+    {
+        std::vector<float> posX;
+        std::vector<float> posY;
+        std::vector<float> scaleX;
+        std::vector<float> scaleY;
+        std::vector<float> height; //only used if corrected, else 0
+        std::vector<float> offset;
+        std::vector<float> correction; //1 if needsCorrection else 0
+
+        std::vector<float> translateX;
+        std::vector<float> translateY;
+        std::vector<float> scaleZ;
+
+        void resize(std::size_t);
+        void calculate(std::size_t);
+    }m_batch;
+
+    struct CachedMatrix final
+    {
+        float translateX = 0.f;
+        float translateY = 0.f;
+        float translateZ = 0.f;
+        float scaleX = 0.f;
+        float scaleY = 0.f;
+        bool valid = false;
+    };
+    std::vector<CachedMatrix> m_cache;
+    std::vector<std::size_t> m_dirty;
+
+    sf::Clock m_timer;
+    std::int64_t m_processTime;
+
     void onEntityAdded(xy::Entity) override;
+    void onEntityRemoved(xy::Entity) override;
 };
\ No newline at end of file
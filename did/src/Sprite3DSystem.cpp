@@ -36,7 +36,8 @@ Copyright 2019 Matt Marchant
 
 Sprite3DSystem::Sprite3DSystem(xy::MessageBus& mb, const std::vector<sf::Shader*>& spriteShaders)
     : xy::System    (mb, typeid(Sprite3DSystem)),
-    m_spriteShaders (spriteShaders)
+    m_spriteShaders (spriteShaders),
+    m_processTime   (0)
 {
     requireComponent<Sprite3D>();
     requireComponent<xy::Drawable>();
@@ -46,32 +47,42 @@ Sprite3DSystem::Sprite3DSystem(xy::MessageBus& mb, const std::vector<sf::Shader*
 //public
 void Sprite3DSystem::process(float)
 {
+    m_timer.restart();
+
     auto& entities = getEntities();
-    for (auto& entity : entities)
+    m_batch.resize(entities.size());
+
+    //gather the transform data
+    for (auto i = 0u; i < entities.size(); ++i)
     {
+        auto entity = entities[i];
         const auto& tx = entity.getComponent<xy::Transform>();
         auto position = tx.getWorldPosition();
-        auto& spr = entity.getComponent<Sprite3D>();
+        const auto& spr = entity.getComponent<Sprite3D>();
         auto& drawable = entity.getComponent<xy::Drawable>();
 
-        //we're also flipping the sprites vertically with a negative scale  
-        float height = tx.getTransform().transformRect(drawable.getLocalBounds()).height;
+        m_batch.posX[i] = position.x;
+        m_batch.posY[i] = position.y;
+        m_batch.offset[i] = spr.verticalOffset;
 
         //SFML 'optimises' by pre-transforming verts if there are 4 or fewer
-        auto& matrix = spr.getMatrix();
         if (spr.needsCorrection)
         {
-            matrix = glm::translate(glm::mat4(1.f), glm::vec3(0.f, height - position.y - spr.verticalOffset, position.y));
+            //we're also flipping the sprites vertically with a negative scale
+            m_batch.height[i] = tx.getTransform().transformRect(drawable.getLocalBounds()).height;
+            m_batch.scaleX[i] = 1.f;
+            m_batch.scaleY[i] = 1.f;
+            m_batch.correction[i] = 1.f;
         }
         else
         {
             auto scale = tx.getScale(); //sadly not world (combined) scale
-
-            matrix = glm::translate(glm::mat4(1.f), glm::vec3(position.x, -spr.verticalOffset, position.y));
-            matrix = glm::scale(matrix, glm::vec3(scale.x, scale.y, (scale.x + scale.y) / 2.f));
+            m_batch.height[i] = 0.f;
+            m_batch.scaleX[i] = scale.x;
+            m_batch.scaleY[i] = scale.y;
+            m_batch.correction[i] = 0.f;
         }
 
-
         if (drawable.getDepth() > Global::MaxSortingDepth)
         {
             sf::Int32 zDepth = static_cast<sf::Int32>((position.y));
@@ -79,6 +90,51 @@ void Sprite3DSystem::process(float)
         }
     }
 
+    const auto count = entities.size();
+    m_batch.calculate(count);
+
+    const float* posY = m_batch.posY.data();
+    const float* scaleX = m_batch.scaleX.data();
+    const float* scaleY = m_batch.scaleY.data();
+    const float* translateX = m_batch.translateX.data();
+    const float* translateY = m_batch.translateY.data();
+    const float* scaleZ = m_batch.scaleZ.data();
+
+    //only rebuild matrices which have changed
+    m_dirty.clear();
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto& cached = m_cache[entities[i].getIndex()];
+        if (!cached.valid
+            || cached.translateX != translateX[i]
+            || cached.translateY != translateY[i]
+            || cached.translateZ != posY[i]
+            || cached.scaleX != scaleX[i]
+            || cached.scaleY != scaleY[i])
+        {
+            cached.translateX = translateX[i];
+            cached.translateY = translateY[i];
+            cached.translateZ = posY[i];
+            cached.scaleX = scaleX[i];
+            cached.scaleY = scaleY[i];
+            cached.valid = true;
+
+            m_dirty.push_back(i);
+        }
+    }
+
+    //same as glm::scale(glm::translate(glm::mat4(1.f), t), s)
+    for (auto i : m_dirty)
+    {
+        auto& matrix = entities[i].getComponent<Sprite3D>().getMatrix();
+        matrix = glm::mat4(1.f);
+        matrix[0][0] = scaleX[i];
+        matrix[1][1] = scaleY[i];
+        matrix[2][2] = scaleZ[i];
+        matrix[3] = glm::vec4(translateX[i], translateY[i], posY[i], 1.f);
+    }
+    m_processTime = m_timer.getElapsedTime().asMicroseconds();
+
     //update the shader with the camera world position
     auto camEnt = getScene()->getActiveCamera();
     const auto& camera = camEnt.getComponent<Camera3D>();
@@ -100,8 +156,15 @@ void Sprite3DSystem::process(float)
     glUseProgram(0);
 }
 
-void Sprite3DSystem::onEntityAdded(xy::Entity)
+void Sprite3DSystem::onEntityAdded(xy::Entity entity)
 {
+    auto idx = entity.getIndex();
+    if (idx >= m_cache.size())
+    {
+        m_cache.resize(idx + 1);
+    }
+    m_cache[idx].valid = false;
+
     //we do this here as a delayed operation
     //because apparently at the time of this system's
     //construction the shaders return incorrect uniform locations
@@ -114,4 +177,56 @@ void Sprite3DSystem::onEntityAdded(xy::Entity)
             m_uniformMap.insert(std::make_pair(s->getNativeHandle(), loc));
         }
     }
-}
\ No newline at end of file
+}
+
+void Sprite3DSystem::onEntityRemoved(xy::Entity entity)
+{
+    m_cache[entity.getIndex()].valid = false;
+}
+
+void Sprite3DSystem::MatrixBatch::resize(std::size_t size)
+{
+    posX.resize(size);
+    posY.resize(size);
+    scaleX.resize(size);
+    scaleY.resize(size);
+    height.resize(size);
+    offset.resize(size);
+    correction.resize(size);
+
+    translateX.resize(size);
+    translateY.resize(size);
+    scaleZ.resize(size);
+}
+
+void Sprite3DSystem::MatrixBatch::calculate(std::size_t count)
+{
+    //no branches or component access so these loops vectorise.
+    //they're split so that each has few enough pointers for
+    //the compiler's aliasing checks
+    const float* inPosX = posX.data();
+    const float* inPosY = posY.data();
+    const float* inScaleX = scaleX.data();
+    const float* inScaleY = scaleY.data();
+    const float* inHeight = height.data();
+    const float* inOffset = offset.data();
+    const float* inCorrection = correction.data();
+
+    float* outTranslateX = translateX.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        outTranslateX[i] = inPosX[i] - (inPosX[i] * inCorrection[i]);
+    }
+
+    float* outTranslateY = translateY.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        outTranslateY[i] = inHeight[i] - (inPosY[i] * inCorrection[i]) - inOffset[i];
+    }
+
+    float* outScaleZ = scaleZ.data();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        outScaleZ[i] = (inScaleX[i] + inScaleY[i]) / 2.f;
+    }
+}
@@ -21,6 +21,7 @@ Copyright 2019 Matt Marchant
 #include "CarriableSystem.hpp"
 #include "ServerSharedStateData.hpp"
 #include "PacketTypes.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/System.hpp>
 #include <xyginext/ecs/Scene.hpp>
@@ -46,6 +47,8 @@ public:
 
     void process(float dt) override
     {
+        Server::ProfileScope profile(Server::ProfileID::TimedCarriableSystem);
+
         auto& entities = getEntities();
         for (auto entity : entities)
         {
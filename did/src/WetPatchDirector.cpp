@@ -28,6 +28,7 @@ Copyright 2019 Matt Marchant
 #include "PacketTypes.hpp"
 #include "Packet.hpp"
 #include "Server.hpp"
+#include "ServerProfiler.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 #include <xyginext/ecs/components/Transform.hpp>
@@ -47,6 +48,8 @@ DigDirector::DigDirector(Server::SharedStateData& sd)
 //public
 void DigDirector::handleMessage(const xy::Message& msg)
 {
+    Server::ProfileScope profile(Server::ProfileID::DigDirector);
+
     if (msg.id == MessageID::PlayerMessage)
     {
         const auto& data = msg.getData<PlayerEvent>();
@@ -25,6 +25,7 @@ struct AIDriver final
     xy::Entity currentWaypoint;
     sf::Vector2f target;
     std::int32_t timestamp = 0;
+    float stepAccumulator = 0.f;
     enum Skill
     {
         Excellent, Good, Bad
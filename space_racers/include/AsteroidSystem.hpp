@@ -22,7 +22,8 @@ Copyright 2019 Matt Marchant
 #include <xyginext/util/Const.hpp>
 
 #include <cmath>
-#include <set>
+#include <cstdint>
+#include <vector>
 
 //roid component. Looks a bit complicated but only
 //because we want to make sure the mass is accurate
@@ -71,8 +72,30 @@ public:
     void setMapSize(sf::FloatRect ms) { m_mapSize = ms; }
     void setSpawnPosition(sf::Vector2f position) { m_spawnPosition = position; }
 
+    //number of overlapping pairs found by the last update
+    std::size_t getCollisionCount() const { return m_collisionPairs.size(); }
+
 private:
     sf::FloatRect m_mapSize;
     sf::Vector2f m_spawnPosition;
-    std::set<std::pair<xy::Entity, xy::Entity>> m_collisionPairs;
+
+    //roids are kept sorted by the left edge of their bounds. This
+    //barely changes from one tick to the next so an insertion sort
+    //is close to linear. The rest of the arrays are in the same order.
+    std::vector<xy::Entity> m_sortedEntities;
+    std::vector<float> m_minX;
+    std::vector<float> m_maxX;
+    std::vector<float> m_positionX;
+    std::vector<float> m_positionY;
+    std::vector<float> m_radius;
+    std::vector<std::int32_t> m_overlaps;
+
+    //indices into the sorted arrays
+    std::vector<std::pair<std::size_t, std::size_t>> m_collisionPairs;
+
+    void sortAndSweep();
+    void resolveCollision(xy::Entity, xy::Entity);
+
+    void onEntityAdded(xy::Entity) override;
+    void onEntityRemoved(xy::Entity) override;
 };
@@ -0,0 +1,75 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/*
+Packs values into a buffer using only as many bits as they need.
+Bits are written least significant first, so the reader must read
+the values back with the same bit counts in the same order.
+*/
+class BitWriter final
+{
+public:
+    BitWriter();
+
+    //writes the lowest bitCount bits (up to 32) of the value
+    void write(std::uint32_t value, std::uint32_t bitCount);
+
+    void writeBool(bool value) { write(value ? 1 : 0, 1); }
+
+    //writes a signed value using as few bits as its magnitude
+    //needs, or a single bit if it's zero
+    void writeDelta(std::int32_t value);
+
+    void clear();
+
+    const std::vector<std::uint8_t>& getData() const { return m_data; }
+    std::size_t getBitCount() const { return m_bitCount; }
+
+private:
+    std::vector<std::uint8_t> m_data;
+    std::size_t m_bitCount;
+};
+
+class BitReader final
+{
+public:
+    BitReader(const void* data, std::size_t size);
+
+    //returns 0 if there are not enough bits left, and
+    //marks the reader as having failed
+    std::uint32_t read(std::uint32_t bitCount);
+
+    bool readBool() { return read(1) != 0; }
+
+    std::int32_t readDelta();
+
+    //true if an attempt was made to read past the end of the data
+    bool failed() const { return m_failed; }
+
+private:
+    const std::uint8_t* m_data;
+    std::size_t m_size;
+    std::size_t m_bitCount;
+    bool m_failed;
+};
@@ -0,0 +1,79 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+Races the given number of AI driven cars around a map in a headless scene
+at the server tick rate, and records the time spent by the VehicleSystem
+in collision detection each tick. Cars which fall off the track or explode
+are respawned at their last waypoint, as the server would. Only the map's
+collision is loaded so no GL context is required.
+*/
+struct CollisionBenchResult final
+{
+    float collisionTime = 0.f; //average us per tick for all vehicles
+    float collisionPeak = 0.f;
+    std::size_t staticCount = 0; //number of baked collision objects on the map
+    std::size_t respawnCount = 0;
+    bool loaded = false;
+};
+
+//AceOfSpace has the most collision objects of the current maps
+CollisionBenchResult runCollisionBench(const std::string& map = "assets/maps/AceOfSpace.tmx", std::size_t vehicleCount = 8, float duration = 60.f);
+
+
+/*
+Tests every pair of a set of randomised convex polygons with the scalar
+and SIMD separating axis tests, and counts the pairs where the results
+differ - including the penetration vector, which should match exactly.
+Also measures the throughput of each, and of the SIMD version when the
+separating axis of each pair is cached between repeats.
+*/
+struct SatBenchResult final
+{
+    std::size_t pairCount = 0;
+    std::size_t intersectCount = 0;
+    std::size_t mismatchCount = 0;
+    float scalarRate = 0.f; //pairs per us
+    float simdRate = 0.f;
+    float cachedRate = 0.f;
+    bool simdEnabled = false;
+};
+
+SatBenchResult runSatBench(std::size_t polygonCount = 500, std::size_t repeatCount = 4);
+
+
+/*
+Fills a map with the given number of asteroids, placed and sized as the
+server does, and measures the time taken by the server scene to update
+them each tick - both moving and colliding them and updating the dynamic
+tree which the vehicles use to find them.
+*/
+struct AsteroidBenchResult final
+{
+    float tickTime = 0.f; //average us per tick
+    float tickPeak = 0.f;
+    float collisionCount = 0.f; //average overlapping pairs per tick
+    bool loaded = false;
+};
+
+AsteroidBenchResult runAsteroidBench(std::size_t asteroidCount, const std::string& map = "assets/maps/AceOfSpace.tmx", float duration = 30.f);
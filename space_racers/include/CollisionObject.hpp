@@ -23,11 +23,14 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/components/Transform.hpp>
 
 #include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/Transform.hpp>
 
 #include <utility>
 #include <vector>
 #include <optional>
 #include <limits>
+#include <cstdint>
 
 using Segment = std::pair<sf::Vector2f, sf::Vector2f>;
 
@@ -68,26 +71,61 @@ struct CollisionObject final
         Count
     }type = Collision;
 
-    //we'll do all these in local space for now, but a potential
-    //optimisation is to move static objects to world space so
-    //that collision doesn't have to needlessly transform the
-    //points every test...
     std::vector<sf::Vector2f> vertices; //clockwise winding
     std::vector<sf::Vector2f> normals; //direction of the face created by the current vert and next clockwise vert
 
+    //world space copies of the above which are what the collision tests
+    //actually use. Static map objects are baked once when the map is loaded,
+    //dynamic objects are updated by the VehicleSystem when they move, or
+    //at most once a frame if moved by something else
+    std::vector<sf::Vector2f> worldVertices;
+    std::vector<sf::Vector2f> worldNormals;
+    sf::FloatRect worldBounds;
+
+    //the world space data split into components for the SIMD tests. These
+    //are padded to a multiple of 4 by repeating the last element, which
+    //doesn't affect the result, so that no lanes need to be masked.
+    std::vector<float> vertexX;
+    std::vector<float> vertexY;
+    std::vector<float> normalX;
+    std::vector<float> normalY;
+    std::vector<float> faceOffsets; //each face projected on to its own normal
+
+    std::uint32_t worldFrame = 0;
+    bool isStatic = false;
+
     void applyVertices(const std::vector<sf::Vector2f>& points);
+
+    void updateWorldSpace(const sf::Transform&);
+
+    //rebuilds the SIMD data and bounds from the world space vertices
+    //and normals. Called by updateWorldSpace(), or directly when the
+    //world space data is already known, eg from a baked track
+    void updateWorldData();
 };
 
+//identifies a face of either object in a collision test, so that a
+//separating axis can be tested first the next time the pair are tested
+namespace SeparatingAxis
+{
+    enum : std::uint32_t
+    {
+        Second = 0x80000000, //the face belongs to the second object
+        None = 0xffffffff
+    };
+}
+
 struct Manifold final
 {
     sf::Vector2f normal;
     float penetration = -std::numeric_limits<float>::max();
+    std::uint32_t axis = SeparatingAxis::None;
 };
 
 static inline bool contains(sf::Vector2f point, xy::Entity entity)
 {
-    const auto& tx = entity.getComponent<xy::Transform>().getTransform();
-    const auto& points = entity.getComponent<CollisionObject>().vertices;
+    //assumes the world space vertices are up to date
+    const auto& points = entity.getComponent<CollisionObject>().worldVertices;
 
     //check if enough poly points
     if (points.size() < 3) return false;
@@ -99,8 +137,8 @@ static inline bool contains(sf::Vector2f point, xy::Entity entity)
 
     for (i = 0, j = points.size() - 1; i < points.size(); j = i++)
     {
-        sf::Vector2f pointI = tx.transformPoint(points[i]);
-        sf::Vector2f pointJ = tx.transformPoint(points[j]);
+        const auto& pointI = points[i];
+        const auto& pointJ = points[j];
 
         if (((pointI.y > point.y) != (pointJ.y > point.y))
             && (point.x < (pointJ.x - pointI.x) * (point.y - pointI.y) / (pointJ.y - pointI.y) + pointI.x))
@@ -118,6 +156,25 @@ Manifold minimumPenetration(xy::Entity, xy::Entity);
 
 std::optional<Manifold> intersects(xy::Entity, xy::Entity);
 
+//as above, but if the given axis is valid it's tested first as the
+//pair are most likely still separated along it. Updated with the
+//separating axis if one is found.
+std::optional<Manifold> intersects(xy::Entity, xy::Entity, std::uint32_t& separatingAxis);
+
+//these work directly on the world space data. minimumPenetration() uses
+//SSE2 where it's available and the scalar version everywhere else, which
+//is kept so that the results can be compared.
+namespace Sat
+{
+    bool simdEnabled();
+
+    Manifold minimumPenetration(const CollisionObject&, const CollisionObject&);
+
+    Manifold minimumPenetrationScalar(const CollisionObject&, const CollisionObject&);
+
+    std::optional<Manifold> intersects(const CollisionObject&, const CollisionObject&, std::uint32_t& separatingAxis, bool scalar = false);
+}
+
 //from Andre LaMothe's black art of game programming
 static inline std::optional<Manifold> intersects(const Segment& segOne, const Segment& segTwo)
 {
@@ -24,10 +24,11 @@ Copyright 2019 Matt Marchant
 
 struct DeadReckon final
 {
-    VehicleActorUpdate update; //this has the same fields as a roid update so can be used for both
+    VehicleActorUpdate update; //used for both vehicles and roids
     bool hasUpdate = false;
     std::int32_t prevTimestamp = 0;
     std::int32_t lastExtrapolatedTimestamp = 0;
+    float stepAccumulator = 0.f;
 };
 
 class DeadReckoningSystem final : public xy::System
@@ -109,7 +109,8 @@ private:
         FloatToInt(&i, f);
         if (i < 0)
         {
-            return m_table[(-((-i) & MASK_MAX_CIRCLE_ANGLE)) + MAX_CIRCLE_ANGLE];
+            //masked again as multiples of the circle would index one past the end
+            return m_table[(MAX_CIRCLE_ANGLE - ((-i) & MASK_MAX_CIRCLE_ANGLE)) & MASK_MAX_CIRCLE_ANGLE];
         }
         else
         {
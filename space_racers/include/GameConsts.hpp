@@ -158,5 +158,8 @@ namespace GameConst
 
     static const float LapArchOffset = 512.f;
 
+    //benchmarks seed their random generators with this so that runs are comparable
+    static const std::uint32_t BenchSeed = 1234;
+
     const std::string AppName("space_racers");
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <SFML/System/Thread.hpp>
+#include <SFML/System/Vector2.hpp>
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+
+struct GhostPoint final
+{
+    GhostPoint() = default;
+    GhostPoint(sf::Vector2f position, float rot, float sc)
+        : x(position.x), y(position.y), rotation(rot), scale(sc) {}
+
+    float x = 0.f;
+    float y = 0.f;
+    float rotation = 0.f;
+    float scale = 1.f;
+};
+
+/*
+Ghost files start with a header containing the format version and lap
+time, followed by the points of the lap. The first point of each second
+is stored as a keyframe of raw floats, and the points between are
+quantised to a fraction of a pixel (or degree) relative to that keyframe. Each point
+is then written as the difference from where the previous two predict
+it will be, using as few bits as possible. Quantising against the
+keyframe rather than the previous point means the error never builds
+up along the lap. The file ends with a checksum of the rest of the data.
+
+Files written before the format was versioned are a raw dump of the lap
+time followed by MaxPoints points, and can still be read.
+*/
+namespace Ghost
+{
+    static constexpr std::size_t SampleRate = 60;
+    static constexpr float SampleTime = 1.f / SampleRate;
+    static constexpr std::size_t MaxPoints = SampleRate * 120; //120 seconds
+
+    //quantisation steps of the points between keyframes
+    static constexpr float PositionStep = 1.f / 16.f;
+    static constexpr float RotationStep = 1.f / 32.f;
+    static constexpr float ScaleStep = 1.f / 256.f;
+
+    std::vector<std::uint8_t> encode(const std::vector<GhostPoint>&, float lapTime);
+
+    //returns false if the data is corrupt or an unknown version
+    bool decode(const std::vector<std::uint8_t>&, std::vector<GhostPoint>&, float& lapTime);
+
+    bool save(const std::string& path, const std::vector<GhostPoint>&, float lapTime);
+    bool load(const std::string& path, std::vector<GhostPoint>&, float& lapTime);
+
+    //returns the point at the given time into the lap, interpolating
+    //between the recorded points, or the last point once it has ended
+    GhostPoint getPoint(const std::vector<GhostPoint>&, std::size_t index, float interp);
+}
+
+/*
+Reads and decodes ghost files on a worker thread, so that they can be
+loaded while the race countdown is running.
+*/
+class GhostLoader final
+{
+public:
+    struct Result final
+    {
+        std::string path;
+        std::vector<GhostPoint> points;
+        float lapTime = 0.f;
+        bool loaded = false;
+    };
+
+    GhostLoader();
+    ~GhostLoader();
+
+    GhostLoader(const GhostLoader&) = delete;
+    GhostLoader& operator = (const GhostLoader&) = delete;
+
+    //starts loading the given files, replacing any previous results
+    void load(const std::vector<std::string>& paths);
+
+    bool ready() const { return !m_busy; }
+
+    //only valid once ready() returns true
+    std::vector<Result>& getResults() { return m_results; }
+
+private:
+    sf::Thread m_thread;
+    std::vector<Result> m_results;
+    std::atomic<bool> m_busy;
+
+    void threadFunc();
+};
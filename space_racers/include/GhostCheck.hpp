@@ -0,0 +1,45 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+Round trips laps through the ghost format and checks that every point
+comes back within the quantisation error, and that corrupting the data
+is detected. The laps are one driven by the AI in a headless scene, plus
+every ghost saved to the config directory by time trials. The sizes are
+compared with the old format, which always stored 120 seconds of raw
+floats.
+*/
+struct GhostCheckResult final
+{
+    std::size_t lapCount = 0;
+    std::size_t pointCount = 0;
+    std::size_t failCount = 0; //laps which didn't round trip, or where corruption went undetected
+    std::size_t rawSize = 0; //bytes in the old format
+    std::size_t encodedSize = 0;
+    float positionError = 0.f; //largest error of any point, in pixels
+    float rotationError = 0.f; //degrees
+    float scaleError = 0.f;
+    bool loaded = false;
+};
+
+GhostCheckResult runGhostCheck(const std::string& map = "assets/maps/AceOfSpace.tmx");
@@ -0,0 +1,62 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include "VehicleSystem.hpp"
+
+#include <array>
+#include <cstddef>
+
+class BitWriter;
+class BitReader;
+
+/*
+Clients send their most recent inputs in every packet, so that the server
+still receives an input as long as any one of the packets carrying it
+arrives. The timestamp of the oldest input is sent in full and the rest
+as the difference from a fixed step, which is usually a single bit. The
+analogue multipliers are quantised to 8 bits, so the client must apply
+quantiseMultiplier() to its own input for its prediction to match.
+*/
+class InputBatch final
+{
+public:
+    static constexpr std::size_t MaxInputs = 8;
+
+    InputBatch();
+
+    //adds an input, replacing the oldest if the batch is full
+    void push(const Input&);
+
+    void write(BitWriter&) const;
+
+    std::size_t size() const { return m_count; }
+
+    //reads a batch into the vehicle history, skipping any inputs which are
+    //not newer than the last one in the history. Returns the number of
+    //inputs added, or 0 if the batch was malformed.
+    static std::size_t read(BitReader&, Vehicle&);
+
+    static float quantiseMultiplier(float);
+
+private:
+    std::array<Input, MaxInputs> m_inputs;
+    std::size_t m_count;
+    std::size_t m_nextFree;
+};
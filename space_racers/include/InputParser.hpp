@@ -18,11 +18,16 @@ Copyright 2019 Matt Marchant
 
 #pragma once
 
+#include "InputBatch.hpp"
+#include "BitStream.hpp"
+
 #include <xyginext/ecs/Entity.hpp>
 
 #include <SFML/System/Clock.hpp>
 #include <SFML/Window/Event.hpp>
 
+#include <algorithm>
+
 struct InputBinding;
 
 namespace xy
@@ -43,6 +48,11 @@ public:
     void setPlayerEntity(xy::Entity e) { m_playerEntity = e; }
     xy::Entity getPlayerEntity() const { return m_playerEntity; }
 
+    //number of simulation steps between input packets sent to the server.
+    //each packet carries up to InputBatch::MaxInputs of the latest inputs
+    //so that lost packets are covered by the next ones to arrive
+    void setPacketInterval(std::size_t steps) { m_packetInterval = std::max(std::size_t(1), steps); }
+
 private:
     const InputBinding& m_inputBinding;
     xy::NetClient* m_netClient;
@@ -52,4 +62,10 @@ private:
 
     std::uint16_t m_currentInput;
     std::int32_t m_timeAccumulator;
+    float m_stepAccumulator;
+
+    InputBatch m_inputBatch;
+    BitWriter m_packetWriter;
+    std::size_t m_packetInterval;
+    std::size_t m_stepCount;
 };
\ No newline at end of file
@@ -20,8 +20,7 @@ Copyright 2019 Matt Marchant
 
 #include "LightningSystem.hpp"
 #include "ResourceIDs.hpp"
-
-#include <tmxlite/Map.hpp>
+#include "TrackCache.hpp"
 
 #include <SFML/Graphics/Color.hpp>
 #include <SFML/System/Vector2.hpp>
@@ -30,6 +29,7 @@ Copyright 2019 Matt Marchant
 #include <string>
 #include <array>
 #include <vector>
+#include <memory>
 
 namespace MapConst
 {
@@ -58,36 +58,43 @@ namespace xy
     class ResourceHandler;
 }
 
-namespace tmx
-{
-    class TileLayer;
-}
-
 class MapParser final
 {
 public:
     explicit MapParser(xy::Scene&);
 
-    bool load(const std::string&);
+    //loads the baked copy of the map if it's up to date, else parses
+    //the tmx file and bakes it. Pass false to always parse the tmx.
+    bool load(const std::string&, bool useCache = true);
+
+    bool loadedFromCache() const
+    {
+        return m_loadedFromCache;
+    }
+
+    const TrackData& getTrackData() const
+    {
+        return m_track;
+    }
 
     std::int32_t getWaypointCount() const
     {
-        return m_waypointCount;
+        return static_cast<std::int32_t>(m_track.waypoints.size());
     }
 
     std::pair<sf::Vector2f, float> getStartPosition() const
     {
-        return std::make_pair(m_startPosition, m_startRotation);
+        return std::make_pair(m_track.startPosition, m_track.startRotation);
     }
 
     sf::Vector2f getSize() const
     {
-        return m_size;
+        return m_track.size;
     }
 
     float getTrackLength() const
     {
-        return m_trackLength;
+        return m_track.trackLength;
     }
 
     void renderLayers(std::array<sf::RenderTexture, 2u>&) const;
@@ -97,34 +104,11 @@ public:
 private:
     xy::Scene& m_scene;
 
-    std::int32_t m_waypointCount;
-    sf::Vector2f m_startPosition;
-    float m_startRotation;
-    float m_trackLength;
-    sf::Vector2f m_size;
-
-    std::vector<Lightning> m_fences;
-    std::vector<std::pair<sf::Vector2f, sf::Vector2f>> m_chevrons;
-    std::vector<std::pair<sf::Vector2f, sf::Vector2f>> m_barriers;
-    std::vector<sf::Vector2f> m_pylons;
-    std::vector<sf::Vector2f> m_bollards;
-
-    tmx::Map m_map;
-    enum LayerID
-    {
-        Track, Detail,
-        Normal,
-        Neon,
-
-        Count
-    };
-    std::array<const tmx::TileLayer*, Count> m_layers = {};
+    TrackData m_track;
+    bool m_loadedFromCache;
 
-    struct TilesetInfo final
-    {
-        std::vector<std::unique_ptr<sf::Texture>> textures;
-        const std::vector<tmx::Tileset>* tileSets = nullptr;
-    };
+    bool parse(const std::string&, TrackData&) const;
+    void createEntities();
 
-    void renderLayer(sf::RenderTarget&, const tmx::TileLayer*, const TilesetInfo&) const;
+    void renderLayer(sf::RenderTarget&, const std::vector<std::uint32_t>&, const std::vector<std::unique_ptr<sf::Texture>>&) const;
 };
\ No newline at end of file
@@ -68,10 +68,10 @@ namespace PacketID
         ErrorServerFull, //lobby is full or already in game
         ErrorServerDisconnect, //server was closed, clients should disconnect
 
-        ClientInput, //packet contains controller input from client (InputUpdate)
+        ClientInput, //packet contains the latest controller input from client (InputBatch)
         ClientUpdate, //update for the client to reconcile (from server)
-        ActorUpdate, //actor update for client side interpolation
-        VehicleActorUpdate, //vehicle update for client side interpolation
+        Snapshot, //delta compressed state of all actors for client side interpolation
+        SnapshotAck, //ID of the latest snapshot received by the client (uint16)
 
         DebugPosition, //packet contains position info for debug
     };
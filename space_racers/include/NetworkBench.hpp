@@ -0,0 +1,66 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+Races AI driven cars around a map in a headless server scene, along with
+the roids the server would create, and writes a snapshot for one client
+at the server's network rate. Each snapshot is read back by a decoder
+as the client would, acknowledging it a few network ticks later, and
+compared with what was written. The size of the snapshots is compared
+with the individual roid and vehicle update packets they replace, and
+with the snapshot sent in full without a baseline.
+*/
+struct SnapshotBenchResult final
+{
+    std::size_t actorCount = 0; //vehicles plus roids
+    std::size_t snapshotCount = 0;
+    std::size_t mismatchCount = 0; //snapshots which didn't read back correctly
+    float updateBytes = 0.f; //average bytes per network tick
+    float fullBytes = 0.f;
+    float deltaBytes = 0.f;
+    bool loaded = false;
+};
+
+SnapshotBenchResult runSnapshotBench(const std::string& map = "assets/maps/AceOfSpace.tmx", std::size_t vehicleCount = 8, float duration = 60.f, std::size_t ackDelay = 3);
+
+
+/*
+Sends a stream of random input from a client to two servers in input
+batches. One server receives every packet, in order, and the other loses
+packets at the given rate and receives the rest with up to two steps of
+jitter, so that some arrive out of order. The input histories of both
+servers are then compared.
+*/
+struct InputBenchResult final
+{
+    std::size_t inputCount = 0; //inputs sent by the client
+    std::size_t packetCount = 0;
+    std::size_t lostCount = 0; //packets dropped
+    std::size_t missingCount = 0; //inputs which never reached the lossy server
+    std::size_t mismatchCount = 0; //inputs which differ between the servers
+    float packetBytes = 0.f; //average packet size
+    float bytesPerSecond = 0.f;
+    float updateBytesPerSecond = 0.f; //sending an InputUpdate every step
+};
+
+InputBenchResult runInputBench(std::size_t stepCount = 10000, float packetLoss = 0.1f, std::size_t packetInterval = 2);
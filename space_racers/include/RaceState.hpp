@@ -24,6 +24,7 @@ Copyright 2019 Matt Marchant
 #include "MapParser.hpp"
 #include "MatrixPool.hpp"
 #include "RenderPath.hpp"
+#include "Snapshot.hpp"
 
 #include <xyginext/core/State.hpp>
 #include <xyginext/ecs/Scene.hpp>
@@ -67,6 +68,8 @@ private:
     xy::AudioScape m_raceSounds;
     
     MapParser m_mapParser;
+    SnapshotQuantiser m_snapshotQuantiser;
+    SnapshotDecoder m_snapshotDecoder;
     xy::ResourceHolder m_resources;
     std::array<std::size_t, TextureID::Game::Count> m_textureIDs;
 
@@ -96,6 +99,7 @@ private:
 
     void spawnVehicle(const VehicleData&);
     void spawnActor(const ActorData&);
+    void readSnapshot(const void*, std::size_t);
     void updateActor(const VehicleActorUpdate&);
     void reconcile(const ClientUpdate&);
 
@@ -41,7 +41,8 @@ namespace ShaderID
         MonitorScreen,
         Lightbar,
         Text,
-        Shield
+        Shield,
+        Skid
     };
 }
 
@@ -58,12 +58,40 @@ namespace sv
         Server(Server&&) = delete;
         Server& operator = (Server&&) = delete;
 
-        void run(std::int32_t);
+        //starts the host and launches the server thread with the given
+        //state. Returns false if the host could not be started
+        bool run(std::int32_t);
         void quit();
 
+        bool running() const { return m_running; }
+
+        //must be set before calling run()
+        void setPort(std::uint16_t port) { m_port = port; }
+        std::uint16_t getPort() const { return m_port; }
+
+        //a dedicated server keeps running when all the clients have left
+        void setDedicated(bool dedicated) { m_dedicated = dedicated; }
+
+        //number of logic updates performed so far and the time in
+        //microseconds taken by the last one, for profiling. These
+        //are safe to read from another thread
+        std::uint64_t getTickCount() const { return m_tickCount; }
+        std::int64_t getLastTickTime() const { return m_lastTickTime; }
+        std::int64_t getLastNetTime() const { return m_lastNetTime; }
+
+        //returns the longest logic update since the last call
+        std::int64_t resetPeakTickTime() { return m_peakTickTime.exchange(0); }
+
     private:
 
         std::atomic_bool m_running;
+        std::uint16_t m_port;
+        bool m_dedicated;
+
+        std::atomic<std::uint64_t> m_tickCount;
+        std::atomic<std::int64_t> m_lastTickTime;
+        std::atomic<std::int64_t> m_lastNetTime;
+        std::atomic<std::int64_t> m_peakTickTime;
 
         sf::Time m_netAccumulator;
         sf::Clock m_netClock;
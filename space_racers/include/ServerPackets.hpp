@@ -65,7 +65,8 @@ struct ActorData final
     std::uint8_t colourID = 0;
 };
 
-struct ActorUpdate
+//actor state read from a snapshot
+struct VehicleActorUpdate final
 {
     float x = 0.f;
     float y = 0.f;
@@ -73,24 +74,9 @@ struct ActorUpdate
     float velY = 0.f;
     std::int32_t timestamp = 0;
     std::uint16_t serverID = 0;
-};
-
-struct VehicleActorUpdate final : ActorUpdate
-{
     float rotation = 0.f;
     std::uint16_t lastInput = 0;
     std::uint8_t stateFlags = 1;
-
-    VehicleActorUpdate() = default;
-    VehicleActorUpdate(const ActorUpdate& other)
-    {
-        x = other.x;
-        y = other.y;
-        velX = other.velX;
-        velY = other.velY;
-        timestamp = other.timestamp;
-        serverID = other.serverID;
-    }
 };
 
 //server state sent for reconciliation
@@ -102,6 +88,7 @@ struct ClientUpdate final
     float velX = 0.f;
     float velY = 0.f;
     float velRot = 0.f;
+    float accelerationMultiplier = 0.f;
     std::int32_t clientTimestamp = 0;
     std::uint16_t collisionFlags = 0;
     std::uint8_t stateFlags = 1;
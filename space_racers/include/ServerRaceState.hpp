@@ -20,13 +20,14 @@ Copyright 2019 Matt Marchant
 
 #include "ServerStates.hpp"
 #include "MapParser.hpp"
+#include "Snapshot.hpp"
+#include "BitStream.hpp"
 
 #include <xyginext/ecs/Scene.hpp>
 #include <xyginext/network/NetData.hpp>
 
 #include <unordered_map>
 
-struct InputUpdate;
 
 
 namespace sv
@@ -37,6 +38,7 @@ namespace sv
         xy::Entity entity;
         bool ready = false; //client has signalled game loaded
         std::uint8_t lapCount = 0;
+        SnapshotEncoder snapshots;
     };
 
     class RaceState final : public State
@@ -56,6 +58,8 @@ namespace sv
         std::int32_t m_nextState;
 
         MapParser m_mapParser;
+        SnapshotQuantiser m_snapshotQuantiser;
+        BitWriter m_snapshotWriter;
 
         std::unordered_map<std::uint64_t, ClientConnection> m_players;
 
@@ -78,6 +82,6 @@ namespace sv
         bool createPlayers();
 
         void sendPlayerData(const xy::NetPeer&);
-        void updatePlayerInput(xy::Entity, const InputUpdate&);
+        void updatePlayerInput(xy::Entity, const void*, std::size_t);
     };
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/*
+Checks that the vehicle simulation is deterministic by running the same
+race several times in headless scenes and comparing a hash of the vehicle
+state after every tick. The first run is driven by AI and records the
+input, which is then replayed by the other runs:
+ - The server path replays every vehicle's input, as a race replay would
+ - The client path replays the first vehicle on its own, predicting as
+   a client does and regularly reconciling with the state from a server
+   simulation a few ticks behind. After each reconciliation this is
+   compared with the server simulation of that vehicle on its own, as
+   the other vehicles wouldn't be predicted by a client.
+*/
+struct SimulationCheckResult final
+{
+    std::size_t tickCount = 0;
+    std::size_t replayMismatch = 0; //the first tick which differs, or 0
+    std::size_t clientMismatch = 0;
+    std::size_t reconcileCount = 0;
+    std::uint64_t finalHash = 0;
+    bool loaded = false;
+};
+
+SimulationCheckResult runSimulationCheck(const std::string& map = "assets/maps/AceOfSpace.tmx", std::size_t tickCount = 10000);
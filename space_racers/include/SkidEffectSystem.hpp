@@ -20,15 +20,16 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/ecs/System.hpp>
 
-#include <SFML/System/Clock.hpp>
+#include <SFML/System/Vector2.hpp>
 
 #include <vector>
+#include <limits>
 
 struct Skidmark final
 {
     sf::Vector2f position;
     float rotation = 0.f;
-    float lifetime = 0.f;
+    float timestamp = -DefaultLifeTime; //system time when the mark was made
     static constexpr float DefaultLifeTime = 4.f;
 };
 
@@ -36,13 +37,23 @@ struct SkidEffect final
 {
     std::size_t wheelCount = 2;
     xy::Entity parent;
-    sf::Clock releaseTimer;
-    sf::Clock soundTimer;
+    float releaseTime = 0.f; //system time of the last mark
+    float soundTime = 0.f;
     std::vector<Skidmark> skidmarks;
     std::size_t currentSkidmark = 0;
     static constexpr std::size_t MaxSkids = 56;
+
+    //index of this effect's vertices in the batch
+    std::size_t slot = std::numeric_limits<std::size_t>::max();
 };
 
+/*
+Every skid mark is drawn in a single batch, in which each effect has a
+fixed number of quads used as a ring buffer. A mark's quads are written
+once when it's made, and faded out by the skid shader based on the time
+the mark was made. The batch entity requires a drawable with the skid
+shader applied, and must be set before any skid effects are created.
+*/
 class SkidEffectSystem final : public xy::System 
 {
 public:
@@ -50,6 +61,23 @@ public:
 
     void process(float) override;
 
+    void setBatchEntity(xy::Entity);
+
+    //total bytes written to the vertex array since the system was created
+    std::size_t getBytesWritten() const { return m_bytesWritten; }
+
 private:
+    xy::Entity m_batchEntity;
+    std::vector<std::size_t> m_freeSlots;
+    float m_time;
+    std::size_t m_bytesWritten;
+
+    sf::Vector2f m_boundsMin;
+    sf::Vector2f m_boundsMax;
+    bool m_boundsChanged;
+
+    void writeSkidmark(const SkidEffect&, std::size_t);
+
     void onEntityAdded(xy::Entity) override;
+    void onEntityRemoved(xy::Entity) override;
 };
@@ -0,0 +1,128 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include "ServerPackets.hpp"
+
+#include <SFML/Graphics/Rect.hpp>
+
+#include <array>
+#include <vector>
+#include <cstdint>
+
+namespace xy
+{
+    class Entity;
+}
+
+class BitWriter;
+class BitReader;
+
+namespace SnapshotConst
+{
+    static constexpr float BorderSize = 1000.f; //roids may wander this far outside the map
+    static constexpr float PositionScale = 16.f; //fixed point units per pixel
+    static constexpr float VelocityScale = 16.f; //16 bits gives +/- 2048 pixels per second
+    static constexpr std::uint32_t RotationBits = 10;
+    static constexpr std::size_t HistorySize = 32; //snapshots kept for delta encoding
+}
+
+//the state of a single net actor quantised for sending
+struct ActorSnapshot final
+{
+    std::uint32_t x = 0;
+    std::uint32_t y = 0;
+    std::int16_t velX = 0;
+    std::int16_t velY = 0;
+    std::uint16_t rotation = 0;
+    std::uint16_t lastInput = 0;
+    std::uint16_t serverID = 0;
+    std::uint8_t stateFlags = 1;
+    bool vehicle = false;
+};
+
+//all the net actors at a point in server time
+struct Snapshot final
+{
+    std::uint16_t id = 0;
+    std::int32_t timestamp = 0;
+    std::vector<ActorSnapshot> actors; //sorted by server ID
+};
+
+//converts actor state to and from fixed point within the area
+//covered by the map, plus a border for any roids outside it
+class SnapshotQuantiser final
+{
+public:
+    SnapshotQuantiser();
+
+    void setMapSize(sf::Vector2f);
+    sf::FloatRect getBounds() const { return m_bounds; }
+
+    //number of bits used for each axis of the position
+    std::uint32_t getPositionBits() const { return m_positionBits; }
+
+    //creates a snapshot of the given net actors
+    Snapshot quantise(const std::vector<xy::Entity>&, std::int32_t timestamp) const;
+
+    VehicleActorUpdate dequantise(const ActorSnapshot&, std::int32_t timestamp) const;
+
+private:
+    sf::FloatRect m_bounds;
+    std::uint32_t m_positionBits;
+    std::uint32_t m_maxPosition;
+};
+
+//writes snapshots for a single client. Each one is delta encoded
+//against the most recent snapshot the client has acknowledged, or
+//sent in full if there's no such snapshot still in the history.
+class SnapshotEncoder final
+{
+public:
+    SnapshotEncoder();
+
+    //assigns the snapshot the next ID and writes it to the stream
+    void write(Snapshot&, const SnapshotQuantiser&, BitWriter&);
+
+    void acknowledge(std::uint16_t id);
+
+private:
+    std::uint16_t m_nextID;
+    std::uint16_t m_ackedID;
+    bool m_hasAck;
+    std::array<Snapshot, SnapshotConst::HistorySize> m_history;
+};
+
+//reads snapshots on the client, keeping a history of
+//those received to use as the baseline for deltas
+class SnapshotDecoder final
+{
+public:
+    SnapshotDecoder();
+
+    //returns false if the snapshot couldn't be read, for example
+    //if its baseline is missing, or if it's older than one already read
+    bool read(BitReader&, const SnapshotQuantiser&, Snapshot& dst);
+
+private:
+    std::uint16_t m_latestID;
+    bool m_hasLatest;
+    std::array<Snapshot, SnapshotConst::HistorySize> m_history;
+    std::array<bool, SnapshotConst::HistorySize> m_valid = {};
+};
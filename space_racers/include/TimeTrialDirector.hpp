@@ -19,6 +19,7 @@ Copyright 2019 Matt Marchant
 #pragma once
 
 #include "ResourceIDs.hpp"
+#include "Ghost.hpp"
 
 #include <xyginext/ecs/Director.hpp>
 #include <xyginext/ecs/Entity.hpp>
@@ -65,34 +66,32 @@ private:
     std::int32_t m_vehicleType;
     SharedData& m_sharedData;
 
-    struct Point final
+    //recording and playback of every ghost share the same cursor,
+    //the time since the lap started, so they're always in step
+    float m_ghostTime;
+    std::vector<GhostPoint> m_recordedPoints;
+
+    //the player's own best lap is always first, followed by
+    //the best laps of the other vehicles, if there are any
+    struct GhostTrack final
     {
-        Point() = default;
-        Point(sf::Vector2f position, float rot, float sc)
-            : x(position.x), y(position.y), rotation(rot), scale(sc) {}
-
-        float x = 0.f;
-        float y = 0.f;
-        float rotation = 0.f;
-        float scale = 1.f;
+        std::vector<GhostPoint> points;
+        std::int32_t vehicleType = 0;
+        xy::Entity entity;
     };
-    static constexpr std::size_t MaxPoints = 60 * 120; //60Hz, 120 seconds
-    std::vector<Point> m_recordedPoints;
-    std::size_t m_recordingIndex;
-
-    std::vector<Point> m_playbackPoints;
-    std::size_t m_playbackIndex;
+    std::vector<GhostTrack> m_ghosts;
+    GhostLoader m_ghostLoader;
+    bool m_ghostsLoaded;
 
-    xy::Entity m_ghostEntity;
     xy::Entity m_playerEntity;
 
     bool m_ghostEnabled;
 
-    void createGhost();
+    void createGhost(GhostTrack&);
 
-    void loadGhost();
+    void loadGhosts();
     void saveGhost();
-    std::string getGhostPath() const;
+    std::string getGhostPath(std::int32_t) const;
 
     void updateScoreboard();
 };
\ No newline at end of file
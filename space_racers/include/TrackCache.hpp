@@ -0,0 +1,114 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include "WayPoint.hpp"
+#include "LightningSystem.hpp"
+
+#include <SFML/System/Vector2.hpp>
+#include <SFML/Graphics/Rect.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+Everything the MapParser reads from a tmx file, in the form in which
+it's used to build the scene. Collision objects are stored with their
+world space data already applied, and waypoints with the distances
+along the track already calculated.
+*/
+struct TrackData final
+{
+    struct Object final
+    {
+        std::int32_t type = 0; //CollisionObject::Type
+        std::int32_t waypoint = -1; //index into the waypoints if this is one
+        sf::Vector2f position;
+        sf::FloatRect area; //local space broadphase area
+
+        std::vector<sf::Vector2f> vertices;
+        std::vector<sf::Vector2f> normals;
+        std::vector<sf::Vector2f> worldVertices;
+        std::vector<sf::Vector2f> worldNormals;
+    };
+    std::vector<Object> objects; //in the order they appear in the map
+    std::vector<WayPoint> waypoints;
+
+    sf::Vector2f startPosition;
+    float startRotation = 0.f;
+    float trackLength = 0.f;
+    sf::Vector2f size;
+
+    //props
+    std::vector<Lightning> fences;
+    std::vector<std::pair<sf::Vector2f, sf::Vector2f>> chevrons;
+    std::vector<std::pair<sf::Vector2f, sf::Vector2f>> barriers;
+    std::vector<sf::Vector2f> pylons;
+    std::vector<sf::Vector2f> bollards;
+
+    //tile layers, only used by clients to render the track
+    struct TileSet final
+    {
+        std::string imagePath; //relative to the resource directory
+        std::uint32_t firstGID = 0;
+        std::uint32_t lastGID = 0;
+        std::uint32_t columnCount = 0;
+        sf::Vector2u tileSize;
+    };
+    std::vector<TileSet> tileSets;
+    sf::Vector2u tileCount;
+    sf::Vector2u tileSize;
+
+    enum TileLayer
+    {
+        Track, Detail,
+        Normal,
+        Neon,
+
+        LayerCount
+    };
+    std::array<std::vector<std::uint32_t>, LayerCount> tileLayers; //tile IDs
+};
+
+/*
+Baked copies of parsed maps are saved to the config directory the first
+time each map is loaded, and read back in a single read on subsequent
+loads. The tmx file remains the source of truth: the cache stores a hash
+of the tmx it was baked from and is ignored if this no longer matches.
+The cache is written in the native byte order so isn't portable between
+machines, which it doesn't need to be.
+*/
+namespace TrackCache
+{
+    //path is the map path relative to the resource directory
+    std::string getCachePath(const std::string& path);
+
+    //returns 0 if the map can't be read
+    std::uint64_t hashMap(const std::string& path);
+
+    //returns false if there's no cache, or it's out of date or corrupt
+    bool load(const std::string& path, TrackData&);
+
+    bool save(const std::string& path, const TrackData&);
+
+    //true if every value of both is exactly the same
+    bool equal(const TrackData&, const TrackData&);
+}
@@ -0,0 +1,42 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+/*
+Loads a map both by parsing the tmx file and from its baked cache, and
+checks that both produce exactly the same track data, and scenes with
+exactly the same map entities. Also measures the average time taken by
+each to load the map and create its entities.
+*/
+struct TrackCheckResult final
+{
+    std::size_t entityCount = 0;
+    std::size_t mismatchCount = 0; //entities which differ between the scenes
+    std::size_t cacheSize = 0; //bytes
+    float parseTime = 0.f; //average ms per load
+    float cacheTime = 0.f;
+    bool dataMatches = false;
+    bool cacheUsed = false;
+    bool loaded = false;
+};
+
+TrackCheckResult runTrackCheck(const std::string& map = "assets/maps/AceOfSpace.tmx", std::size_t repeatCount = 20);
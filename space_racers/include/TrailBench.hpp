@@ -0,0 +1,38 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+#include <cstddef>
+
+/*
+Drives the given number of vehicles round in circles with the steering
+held, so that they leave trails and skid marks, in a headless scene. Then
+measures the bytes written to the trail and skid vertex batches each frame
+and compares them with the bytes needed to rebuild every live trail and
+skid mark each frame, as was done before they were batched.
+*/
+struct TrailBenchResult final
+{
+    float trailBytes = 0.f; //average bytes written per frame
+    float skidBytes = 0.f;
+    float rebuildBytes = 0.f; //both trails and skids
+    std::size_t vertexCount = 0; //in both batches
+};
+
+TrailBenchResult runTrailBench(std::size_t vehicleCount = 8, float duration = 10.f);
@@ -24,13 +24,17 @@ Copyright 2019 Matt Marchant
 #include <SFML/Graphics/Color.hpp>
 
 #include <array>
+#include <vector>
+#include <limits>
 
 struct Trail final
 {
     struct Point final
     {
         sf::Vector2f position;
+        sf::Vector2f normal; //offset of the trail edge from the position
         float lifetime = 0.f;
+        float timestamp = 0.f; //system time when the point was placed
         bool sleeping = false;
         static constexpr float MaxLifetime = 0.4f;
     };
@@ -38,7 +42,7 @@ struct Trail final
     std::array<Point, 6u> points;
 
     //make sure to track the index of the
-    //oldest point as the vert array will start here
+    //oldest point as the trail starts here
     std::size_t oldestPoint = 0;
 
     //when the sleep count reaches array size destoy this trail
@@ -51,8 +55,18 @@ struct Trail final
     sf::Vector2f parentLastPosition;
 
     sf::Color colour = sf::Color::White;
+
+    //index of this trail's vertices in the batch
+    std::size_t slot = std::numeric_limits<std::size_t>::max();
 };
 
+/*
+Every trail is drawn in a single batch, stored as a quad per point. The
+vertices are only written when a point moves, and are faded out by the
+trail shader based on the time the point was placed. The batch entity
+requires a drawable with the trail texture and shader applied, and must
+be set before any trails are created.
+*/
 class TrailSystem final : public xy::System 
 {
 public:
@@ -60,6 +74,23 @@ public:
 
     void process(float) override;
 
+    void setBatchEntity(xy::Entity);
+
+    //total bytes written to the vertex array since the system was created
+    std::size_t getBytesWritten() const { return m_bytesWritten; }
+
 private:
+    xy::Entity m_batchEntity;
+    std::vector<std::size_t> m_freeSlots;
+    float m_time;
+    std::size_t m_bytesWritten;
+
+    sf::Vector2f m_boundsMin;
+    sf::Vector2f m_boundsMax;
+    bool m_boundsChanged;
+
+    void writeSegment(const Trail&, std::size_t);
+
     void onEntityAdded(xy::Entity) override;
+    void onEntityRemoved(xy::Entity) override;
 };
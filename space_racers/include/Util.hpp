@@ -23,6 +23,8 @@ Copyright 2019 Matt Marchant
 
 #include <string>
 #include <array>
+#include <cstdint>
+#include <cstddef>
 
 //uses the fast trig sin/cos lookup table
 //based on the source of sf::Transform
@@ -71,3 +73,8 @@ private:
 };
 
 std::string formatTimeString(float t);
+
+//64 bit FNV-1a, used by anything which stores or compares a checksum.
+//Data can be hashed in parts by passing in the result of the last call
+static const std::uint64_t FNVOffsetBasis = 14695981039346656037ull;
+std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t hash = FNVOffsetBasis);
@@ -0,0 +1,37 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#pragma once
+
+namespace xy
+{
+    class Scene;
+    class ShaderResource;
+}
+
+namespace sf
+{
+    class Texture;
+}
+
+//preloads the trail and skid mark shaders used by createVehicleEffectBatches()
+void loadVehicleEffectShaders(xy::ShaderResource&);
+
+//creates the entities which draw all the vehicle trails, and all the skid marks,
+//in a single batch each and passes them to the scene's TrailSystem and SkidEffectSystem
+void createVehicleEffectBatches(xy::Scene&, xy::ShaderResource&, const sf::Texture& trailTexture);
@@ -22,8 +22,11 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/ecs/System.hpp>
 
+#include <SFML/System/Clock.hpp>
+
 #include <array>
 #include <vector>
+#include <unordered_map>
 
 struct Input final
 {
@@ -98,13 +101,22 @@ struct Vehicle final
     float waypointDistance = 0.f; //total of current passed waypoints
     float totalDistance = 0.f; //above plus distance toward next waypoint
 
-    sf::Clock afkTimer;
+    //these timers count simulation time rather than using
+    //a clock so that the results are always the same
+    float afkTime = 0.f;
     static constexpr float AfkTime = 30.f;
     static constexpr float AfkTimeout = 60.f;
 
     //amount of time before respawning vehicle
     static constexpr float RespawnDuration = 1.5f;
-    sf::Clock respawnClock;
+    float respawnTime = 0.f;
+
+    std::size_t celebrationIndex = 0;
+
+    //the physics are always advanced by this much for each input
+    //so that the client and server give identical results
+    static constexpr float StepTime = 1.f / 60.f;
+    static constexpr std::int32_t StepMicroseconds = 16667; //input timestamps are in microseconds
 
     bool client = false;
 };
@@ -119,15 +131,28 @@ public:
 
     void reconcile(const ClientUpdate&, xy::Entity);
 
+    //time spent in collision detection during the last update
+    sf::Time getCollisionTime() const { return m_collisionTime; }
+
 private:
+    //used to update the world space collision of any dynamic
+    //objects not owned by this system at most once per frame
+    std::uint32_t m_frame;
 
-    void processVehicle(xy::Entity, float);
+    sf::Clock m_collisionClock;
+    sf::Time m_collisionTime;
 
-    void processInput(xy::Entity, float);
-    void applyInput(xy::Entity, float);
+    //the last separating axis found for each vehicle and the objects
+    //it was tested against, keyed by the entity indices of the pair
+    std::unordered_map<std::uint64_t, std::uint32_t> m_separatingAxes;
+
+    void processVehicle(xy::Entity, const Input&);
 
-    float getDelta(const History&, std::size_t);
+    void processInput(xy::Entity, const Input&, float);
+    void applyInput(xy::Entity, float);
 
+    void updateWorldSpace(xy::Entity);
+    std::uint32_t& getSeparatingAxis(xy::Entity, xy::Entity);
     void doCollision(xy::Entity);
     void resolveCollision(xy::Entity, xy::Entity, Manifold);
 
@@ -21,7 +21,7 @@ Copyright 2019 Matt Marchant
 #include <SFML/Graphics/Rect.hpp>
 #include <SFML/System/Vector2.hpp>
 
-#include <cstdlib>
+#include <cstdint>
 
 struct WayPoint final
 {
@@ -45,13 +45,17 @@ AIDriverSystem::AIDriverSystem(xy::MessageBus& mb)
 //public
 void AIDriverSystem::process(float dt)
 {
-    auto frameTime = static_cast<std::int32_t>(dt * 1000000.f);
-
     auto& entities = getEntities();
     for (auto entity : entities)
     {
+        //vehicles are simulated with a fixed step so
+        //we need an input for every step which has passed
         auto& ai = entity.getComponent<AIDriver>();
-        ai.timestamp += frameTime;
+        ai.stepAccumulator += dt;
+        if (ai.stepAccumulator < Vehicle::StepTime)
+        {
+            continue;
+        }
 
         //get target
         auto& vehicle = entity.getComponent<Vehicle>();
@@ -119,9 +123,14 @@ void AIDriverSystem::process(float dt)
         //TODO faux acceleration by modifying input? Could use this for differing types of AI
 
         //update timestamp and apply input to vehicle
-        input.timestamp = ai.timestamp;
+        while (ai.stepAccumulator >= Vehicle::StepTime)
+        {
+            ai.stepAccumulator -= Vehicle::StepTime;
+            ai.timestamp += Vehicle::StepMicroseconds;
+            input.timestamp = ai.timestamp;
 
-        vehicle.history[vehicle.currentInput] = input;
-        vehicle.currentInput = (vehicle.currentInput + 1) % vehicle.history.size();
+            vehicle.history[vehicle.currentInput] = input;
+            vehicle.currentInput = (vehicle.currentInput + 1) % vehicle.history.size();
+        }
     }
 }
\ No newline at end of file
@@ -17,21 +17,16 @@ Copyright 2019 Matt Marchant
 *********************************************************************/
 
 #include "AsteroidSystem.hpp"
-#include "CollisionObject.hpp"
 
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/ecs/components/BroadPhaseComponent.hpp>
 
-#include <xyginext/ecs/Scene.hpp>
-#include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
-
 #include <xyginext/util/Vector.hpp>
 
+#include <algorithm>
+
 namespace
 {
-    //area around a roid to search for collisions
-    const sf::FloatRect SearchArea(0.f, 0.f, 200.f, 200.f);
-
     //area around start point to avoid
     const float StartRadius = 384.f;
 
@@ -102,30 +97,6 @@ void AsteroidSystem::process(float dt)
             roid.setVelocity(xy::Util::Vector::reflect(roid.getVelocity(), normal));
         }
 
-
-        //collision detection broadphase
-        auto searchArea = SearchArea;
-        searchArea.left += position.x;
-        searchArea.top += position.y;
-
-        auto aabb = entity.getComponent<xy::BroadphaseComponent>().getArea();
-        aabb = tx.getTransform().transformRect(aabb);
-
-        auto nearby = getScene()->getSystem<xy::DynamicTreeSystem>().query(searchArea, CollisionFlags::Asteroid);
-        for (auto other : nearby)
-        {
-            if (other != entity)
-            {
-                auto otherAabb = other.getComponent<xy::BroadphaseComponent>().getArea();
-                otherAabb = other.getComponent<xy::Transform>().getTransform().transformRect(otherAabb);
-
-                if (otherAabb.intersects(aabb))
-                {
-                    m_collisionPairs.insert(std::minmax(other, entity));
-                }
-            }
-        }
-
         //attempt to clamp velocity
         auto vel = xy::Util::Vector::lengthSquared(roid.getVelocity());
         if (vel > MaxVelSqr)
@@ -135,45 +106,135 @@ void AsteroidSystem::process(float dt)
         }
     }
 
-    //collision narrow phase
-    for (auto& [a, b] : m_collisionPairs)
-    {
-        //copy these because a and b are const...
-        auto entA = a;
-        auto entB = b;
+    sortAndSweep();
 
-        auto& txA = entA.getComponent<xy::Transform>();
-        auto& txB = entB.getComponent<xy::Transform>();
+    for (auto [a, b] : m_collisionPairs)
+    {
+        resolveCollision(m_sortedEntities[a], m_sortedEntities[b]);
+    }
+}
 
-        auto& roidA = entA.getComponent<Asteroid>();
-        auto& roidB = entB.getComponent<Asteroid>();
+//private
+void AsteroidSystem::sortAndSweep()
+{
+    const auto count = m_sortedEntities.size();
+    m_minX.resize(count);
+    m_maxX.resize(count);
+    m_positionX.resize(count);
+    m_positionY.resize(count);
+    m_radius.resize(count);
+    m_overlaps.resize(count);
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        const auto entity = m_sortedEntities[i];
+        m_minX[i] = entity.getComponent<xy::Transform>().getPosition().x - entity.getComponent<Asteroid>().getRadius();
+    }
 
-        auto diff = txA.getPosition() - txB.getPosition();
-        auto dist = roidA.getRadius() + roidB.getRadius();
-        auto dist2 = dist * dist;
+    //roids only move a little each tick so the order from the
+    //last tick is nearly correct and this does very few swaps
+    for (auto i = 1u; i < count; ++i)
+    {
+        const auto key = m_minX[i];
+        const auto entity = m_sortedEntities[i];
 
-        //check for overlap
-        auto len2 = xy::Util::Vector::lengthSquared(diff);
-        if (len2 < dist2)
+        auto j = i;
+        while (j > 0 && m_minX[j - 1] > key)
         {
-            //separate if overlapping
-            auto len = std::sqrt(len2);
-            auto penetration = dist - len;
-            auto normal = diff / len;
+            m_minX[j] = m_minX[j - 1];
+            m_sortedEntities[j] = m_sortedEntities[j - 1];
+            --j;
+        }
+        m_minX[j] = key;
+        m_sortedEntities[j] = entity;
+    }
 
-            txA.move(normal * (penetration));
-            txB.move(-normal * (penetration));
+    for (auto i = 0u; i < count; ++i)
+    {
+        const auto entity = m_sortedEntities[i];
+        const auto position = entity.getComponent<xy::Transform>().getPosition();
+        m_positionX[i] = position.x;
+        m_positionY[i] = position.y;
+        m_radius[i] = entity.getComponent<Asteroid>().getRadius();
+        m_maxX[i] = position.x + m_radius[i];
+    }
 
-            //calc new vectors using each mass to update momentum
-            float vA = xy::Util::Vector::dot(roidA.getVelocity(), normal);
-            float vB = xy::Util::Vector::dot(roidB.getVelocity(), normal);
-            float momentum = (2.f * (vA - vB)) / (roidA.getMass() + roidB.getMass());
+    //only roids further along the sorted list are tested against
+    //each roid, so every pair is found exactly once
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto end = i + 1;
+        while (end < count && m_minX[end] <= m_maxX[i])
+        {
+            end++;
+        }
 
-            sf::Vector2f velA = roidA.getVelocity() - (normal * (momentum * roidB.getMass()));
-            sf::Vector2f velB = roidB.getVelocity() + (normal * (momentum * roidA.getMass()));
+        //no branches or entity lookups in here so this can be vectorised
+        const float x = m_positionX[i];
+        const float y = m_positionY[i];
+        const float radius = m_radius[i];
+        for (auto j = i + 1; j < end; ++j)
+        {
+            const float dx = m_positionX[j] - x;
+            const float dy = m_positionY[j] - y;
+            const float dist = m_radius[j] + radius;
+            m_overlaps[j] = static_cast<std::int32_t>((dx * dx) + (dy * dy) < (dist * dist));
+        }
 
-            roidA.setVelocity(velA);
-            roidB.setVelocity(velB);
+        for (auto j = i + 1; j < end; ++j)
+        {
+            if (m_overlaps[j])
+            {
+                m_collisionPairs.emplace_back(i, j);
+            }
         }
     }
-}
\ No newline at end of file
+}
+
+void AsteroidSystem::resolveCollision(xy::Entity entA, xy::Entity entB)
+{
+    auto& txA = entA.getComponent<xy::Transform>();
+    auto& txB = entB.getComponent<xy::Transform>();
+
+    auto& roidA = entA.getComponent<Asteroid>();
+    auto& roidB = entB.getComponent<Asteroid>();
+
+    //an earlier collision this tick may have moved either roid
+    //so the overlap is tested again on the current positions
+    auto diff = txA.getPosition() - txB.getPosition();
+    auto dist = roidA.getRadius() + roidB.getRadius();
+    auto dist2 = dist * dist;
+
+    auto len2 = xy::Util::Vector::lengthSquared(diff);
+    if (len2 < dist2)
+    {
+        //separate if overlapping
+        auto len = std::sqrt(len2);
+        auto penetration = dist - len;
+        auto normal = diff / len;
+
+        txA.move(normal * (penetration));
+        txB.move(-normal * (penetration));
+
+        //calc new vectors using each mass to update momentum
+        float vA = xy::Util::Vector::dot(roidA.getVelocity(), normal);
+        float vB = xy::Util::Vector::dot(roidB.getVelocity(), normal);
+        float momentum = (2.f * (vA - vB)) / (roidA.getMass() + roidB.getMass());
+
+        sf::Vector2f velA = roidA.getVelocity() - (normal * (momentum * roidB.getMass()));
+        sf::Vector2f velB = roidB.getVelocity() + (normal * (momentum * roidA.getMass()));
+
+        roidA.setVelocity(velA);
+        roidB.setVelocity(velB);
+    }
+}
+
+void AsteroidSystem::onEntityAdded(xy::Entity entity)
+{
+    m_sortedEntities.push_back(entity);
+}
+
+void AsteroidSystem::onEntityRemoved(xy::Entity entity)
+{
+    m_sortedEntities.erase(std::remove(m_sortedEntities.begin(), m_sortedEntities.end(), entity), m_sortedEntities.end());
+}
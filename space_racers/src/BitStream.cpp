@@ -0,0 +1,141 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "BitStream.hpp"
+
+#include <xyginext/core/Assert.hpp>
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace
+{
+    const std::uint32_t DeltaLengthBits = 5;
+
+    std::uint32_t bitWidth(std::uint32_t value)
+    {
+        std::uint32_t count = 0;
+        while (value)
+        {
+            count++;
+            value >>= 1;
+        }
+        return count;
+    }
+}
+
+BitWriter::BitWriter()
+    : m_bitCount(0)
+{
+
+}
+
+//public
+void BitWriter::write(std::uint32_t value, std::uint32_t bitCount)
+{
+    XY_ASSERT(bitCount <= 32, "Too many bits");
+
+    while (bitCount)
+    {
+        const auto offset = static_cast<std::uint32_t>(m_bitCount % 8);
+        if (offset == 0)
+        {
+            m_data.push_back(0);
+        }
+
+        const auto count = std::min(8 - offset, bitCount);
+        const auto mask = (1u << count) - 1;
+        m_data.back() |= static_cast<std::uint8_t>((value & mask) << offset);
+
+        value >>= count;
+        bitCount -= count;
+        m_bitCount += count;
+    }
+}
+
+void BitWriter::writeDelta(std::int32_t value)
+{
+    writeBool(value != 0);
+    if (value != 0)
+    {
+        //stored as the sign, the number of bits in the
+        //magnitude less one, then the magnitude itself
+        const auto magnitude = static_cast<std::uint32_t>(std::abs(static_cast<std::int64_t>(value)));
+        const auto width = bitWidth(magnitude);
+
+        writeBool(value < 0);
+        write(width - 1, DeltaLengthBits);
+        write(magnitude, width);
+    }
+}
+
+void BitWriter::clear()
+{
+    m_data.clear();
+    m_bitCount = 0;
+}
+
+BitReader::BitReader(const void* data, std::size_t size)
+    : m_data    (static_cast<const std::uint8_t*>(data)),
+    m_size      (size),
+    m_bitCount  (0),
+    m_failed    (false)
+{
+
+}
+
+//public
+std::uint32_t BitReader::read(std::uint32_t bitCount)
+{
+    XY_ASSERT(bitCount <= 32, "Too many bits");
+
+    if (m_bitCount + bitCount > m_size * 8)
+    {
+        m_failed = true;
+        m_bitCount = m_size * 8;
+        return 0;
+    }
+
+    std::uint32_t value = 0;
+    std::uint32_t shift = 0;
+    while (shift < bitCount)
+    {
+        const auto offset = static_cast<std::uint32_t>(m_bitCount % 8);
+        const auto count = std::min(8 - offset, bitCount - shift);
+        const auto mask = (1u << count) - 1;
+
+        value |= ((m_data[m_bitCount / 8] >> offset) & mask) << shift;
+
+        shift += count;
+        m_bitCount += count;
+    }
+    return value;
+}
+
+std::int32_t BitReader::readDelta()
+{
+    if (!readBool())
+    {
+        return 0;
+    }
+
+    const bool negative = readBool();
+    const auto width = read(DeltaLengthBits) + 1;
+    const auto magnitude = static_cast<std::int64_t>(read(width));
+    return static_cast<std::int32_t>(negative ? -magnitude : magnitude);
+}
@@ -0,0 +1,340 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "CollisionBench.hpp"
+#include "CollisionObject.hpp"
+#include "VehicleSystem.hpp"
+#include "VehicleDefs.hpp"
+#include "AIDriverSystem.hpp"
+#include "AsteroidSystem.hpp"
+#include "MapParser.hpp"
+#include "MessageIDs.hpp"
+#include "GameConsts.hpp"
+#include "WayPoint.hpp"
+
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/BroadPhaseComponent.hpp>
+#include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
+#include <xyginext/util/Const.hpp>
+
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+#include <random>
+#include <cmath>
+
+namespace
+{
+    const float TickTime = 1.f / 60.f; //same as the server
+
+    //random points around a circle, sorted by angle, are always convex
+    CollisionObject createPolygon(std::mt19937& rng)
+    {
+        std::uniform_real_distribution<float> dist(0.f, 1.f);
+
+        std::vector<float> angles(3 + rng() % 10);
+        for (auto& angle : angles)
+        {
+            angle = dist(rng) * xy::Util::Const::TAU;
+        }
+        std::sort(angles.begin(), angles.end());
+
+        const float radius = 20.f + (dist(rng) * 80.f);
+        std::vector<sf::Vector2f> points;
+        for (auto angle : angles)
+        {
+            points.emplace_back(std::cos(angle) * radius, std::sin(angle) * radius);
+        }
+
+        CollisionObject collision;
+        collision.applyVertices(points);
+
+        sf::Transform tx;
+        tx.translate(dist(rng) * 200.f, dist(rng) * 200.f);
+        tx.rotate(dist(rng) * 360.f);
+        collision.updateWorldSpace(tx);
+
+        return collision;
+    }
+}
+
+CollisionBenchResult runCollisionBench(const std::string& map, std::size_t vehicleCount, float duration)
+{
+    CollisionBenchResult result;
+
+    xy::MessageBus messageBus;
+    xy::Scene scene(messageBus);
+    scene.addSystem<AIDriverSystem>(messageBus);
+    auto& vehicleSystem = scene.addSystem<VehicleSystem>(messageBus);
+    scene.addSystem<xy::DynamicTreeSystem>(messageBus);
+
+    MapParser mapParser(scene);
+    if (!mapParser.load(map))
+    {
+        return result;
+    }
+    result.loaded = true;
+
+    //line the cars up on the grid in rows of 4
+    auto [position, rotation] = mapParser.getStartPosition();
+    sf::Transform offsetTransform;
+    offsetTransform.rotate(rotation);
+
+    for (auto i = 0u; i < vehicleCount; ++i)
+    {
+        auto offset = GameConst::SpawnPositions[i % GameConst::SpawnPositions.size()];
+        offset.x -= GameConst::CarSize.width * 1.5f * static_cast<float>(i / GameConst::SpawnPositions.size());
+
+        auto entity = scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(position + offsetTransform.transformPoint(offset));
+        entity.getComponent<xy::Transform>().setRotation(rotation);
+        entity.addComponent<Vehicle>().waypointCount = mapParser.getWaypointCount();
+        entity.getComponent<Vehicle>().settings = Definition::car;
+        entity.getComponent<Vehicle>().stateFlags = (1 << Vehicle::Normal);
+        entity.addComponent<CollisionObject>().type = CollisionObject::Vehicle;
+        entity.getComponent<CollisionObject>().applyVertices(GameConst::CarPoints);
+        entity.addComponent<xy::BroadphaseComponent>().setArea(GameConst::CarSize);
+        entity.getComponent<xy::BroadphaseComponent>().setFilterFlags(CollisionFlags::Vehicle);
+        entity.addComponent<AIDriver>().target = position;
+        entity.getComponent<AIDriver>().skill = static_cast<AIDriver::Skill>(i % 3);
+    }
+
+    std::size_t tickCount = 0;
+    std::int64_t totalTime = 0;
+
+    const auto totalTicks = static_cast<std::size_t>(duration / TickTime);
+    for (auto tick = 0u; tick < totalTicks; ++tick)
+    {
+        scene.update(TickTime);
+
+        while (!messageBus.empty())
+        {
+            const auto& msg = messageBus.poll();
+            scene.forwardMessage(msg);
+
+            if (msg.id == MessageID::VehicleMessage)
+            {
+                const auto& data = msg.getData<VehicleEvent>();
+                if (data.type == VehicleEvent::RequestRespawn)
+                {
+                    auto entity = data.entity;
+                    auto& vehicle = entity.getComponent<Vehicle>();
+                    auto& tx = entity.getComponent<xy::Transform>();
+
+                    vehicle.velocity = {};
+                    vehicle.anglularVelocity = {};
+                    vehicle.stateFlags = (1 << Vehicle::Normal);
+                    vehicle.invincibleTime = GameConst::InvincibleTime;
+
+                    if (vehicle.currentWaypoint.isValid())
+                    {
+                        tx.setPosition(vehicle.currentWaypoint.getComponent<xy::Transform>().getPosition());
+                        tx.setRotation(vehicle.currentWaypoint.getComponent<WayPoint>().rotation);
+                    }
+                    else
+                    {
+                        tx.setPosition(position);
+                        tx.setRotation(rotation);
+                    }
+                    tx.setScale(1.f, 1.f);
+
+                    result.respawnCount++;
+                }
+            }
+        }
+
+        //the first tick adds the map and vehicles to the scene
+        if (tick == 0)
+        {
+            continue;
+        }
+
+        const auto collisionTime = vehicleSystem.getCollisionTime().asMicroseconds();
+        totalTime += collisionTime;
+        result.collisionPeak = std::max(result.collisionPeak, static_cast<float>(collisionTime));
+        tickCount++;
+    }
+
+    if (tickCount)
+    {
+        result.collisionTime = static_cast<float>(totalTime) / tickCount;
+    }
+
+    //count what the map parser baked
+    auto query = scene.getSystem<xy::DynamicTreeSystem>().query(sf::FloatRect(sf::Vector2f(), mapParser.getSize()), CollisionFlags::Static);
+    result.staticCount = query.size();
+
+    return result;
+}
+
+SatBenchResult runSatBench(std::size_t polygonCount, std::size_t repeatCount)
+{
+    SatBenchResult result;
+    result.simdEnabled = Sat::simdEnabled();
+
+    std::mt19937 rng(GameConst::BenchSeed);
+    std::vector<CollisionObject> polygons;
+    for (auto i = 0u; i < polygonCount; ++i)
+    {
+        polygons.push_back(createPolygon(rng));
+    }
+
+    for (auto i = 0u; i < polygons.size(); ++i)
+    {
+        for (auto j = 0u; j < polygons.size(); ++j)
+        {
+            if (i == j)
+            {
+                continue;
+            }
+
+            std::uint32_t scalarAxis = SeparatingAxis::None;
+            std::uint32_t simdAxis = SeparatingAxis::None;
+            auto scalar = Sat::intersects(polygons[i], polygons[j], scalarAxis, true);
+            auto simd = Sat::intersects(polygons[i], polygons[j], simdAxis, false);
+
+            //the cached axis should never change the result
+            auto cached = Sat::intersects(polygons[i], polygons[j], simdAxis, false);
+
+            result.pairCount++;
+            if (scalar.has_value() != simd.has_value()
+                || simd.has_value() != cached.has_value())
+            {
+                result.mismatchCount++;
+            }
+            else if (scalar)
+            {
+                result.intersectCount++;
+                if (scalar->penetration != simd->penetration
+                    || scalar->normal != simd->normal)
+                {
+                    result.mismatchCount++;
+                }
+            }
+        }
+    }
+
+    std::vector<std::uint32_t> axes(polygons.size() * polygons.size(), SeparatingAxis::None);
+    auto measure = [&](bool scalar, bool cacheAxes)
+    {
+        sf::Clock clock;
+        for (auto r = 0u; r < repeatCount; ++r)
+        {
+            for (auto i = 0u; i < polygons.size(); ++i)
+            {
+                for (auto j = 0u; j < polygons.size(); ++j)
+                {
+                    std::uint32_t axis = SeparatingAxis::None;
+                    auto& separatingAxis = cacheAxes ? axes[i * polygons.size() + j] : axis;
+                    Sat::intersects(polygons[i], polygons[j], separatingAxis, scalar);
+                }
+            }
+        }
+        auto elapsed = static_cast<float>(std::max(sf::Int64(1), clock.getElapsedTime().asMicroseconds()));
+        return static_cast<float>(repeatCount * polygons.size() * polygons.size()) / elapsed;
+    };
+
+    result.scalarRate = measure(true, false);
+    result.simdRate = measure(false, false);
+    result.cachedRate = measure(false, true);
+
+    return result;
+}
+
+AsteroidBenchResult runAsteroidBench(std::size_t asteroidCount, const std::string& map, float duration)
+{
+    AsteroidBenchResult result;
+
+    xy::MessageBus messageBus;
+    xy::Scene scene(messageBus);
+    auto& asteroidSystem = scene.addSystem<AsteroidSystem>(messageBus);
+    scene.addSystem<xy::DynamicTreeSystem>(messageBus);
+
+    MapParser mapParser(scene);
+    if (!mapParser.load(map))
+    {
+        return result;
+    }
+    result.loaded = true;
+
+    //same area as ServerRaceState
+    sf::FloatRect bounds(sf::Vector2f(), mapParser.getSize());
+    bounds.left -= 1000.f;
+    bounds.top -= 1000.f;
+    bounds.width += 2000.f;
+    bounds.height += 2000.f;
+    asteroidSystem.setMapSize(bounds);
+    asteroidSystem.setSpawnPosition(mapParser.getStartPosition().first);
+
+    std::mt19937 rng(GameConst::BenchSeed);
+    std::uniform_real_distribution<float> dist(0.f, 1.f);
+    for (auto i = 0u; i < asteroidCount; ++i)
+    {
+        auto entity = scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(bounds.left + (dist(rng) * bounds.width), bounds.top + (dist(rng) * bounds.height));
+
+        const float angle = dist(rng) * xy::Util::Const::TAU;
+        const float speed = 200.f + (dist(rng) * 100.f);
+        entity.addComponent<Asteroid>().setVelocity(sf::Vector2f(std::cos(angle), std::sin(angle)) * speed);
+
+        sf::FloatRect aabb(0.f, 0.f, 100.f, 100.f);
+        auto radius = aabb.width / 2.f;
+        entity.getComponent<xy::Transform>().setOrigin(radius, radius);
+        auto scale = 0.5f + (dist(rng) * 2.f);
+        entity.getComponent<xy::Transform>().setScale(scale, scale);
+        entity.getComponent<Asteroid>().setRadius(radius * scale);
+
+        entity.addComponent<xy::BroadphaseComponent>().setArea(aabb);
+        entity.getComponent<xy::BroadphaseComponent>().setFilterFlags(CollisionFlags::Asteroid);
+    }
+
+    //the first tick adds everything to the scene
+    scene.update(TickTime);
+
+    std::size_t tickCount = 0;
+    std::int64_t totalTime = 0;
+    std::size_t totalCollisions = 0;
+
+    const auto totalTicks = static_cast<std::size_t>(duration / TickTime);
+    for (auto tick = 0u; tick < totalTicks; ++tick)
+    {
+        sf::Clock clock;
+        scene.update(TickTime);
+        const auto tickTime = clock.getElapsedTime().asMicroseconds();
+
+        while (!messageBus.empty())
+        {
+            scene.forwardMessage(messageBus.poll());
+        }
+
+        totalTime += tickTime;
+        result.tickPeak = std::max(result.tickPeak, static_cast<float>(tickTime));
+        totalCollisions += asteroidSystem.getCollisionCount();
+        tickCount++;
+    }
+
+    if (tickCount)
+    {
+        result.tickTime = static_cast<float>(totalTime) / tickCount;
+        result.collisionCount = static_cast<float>(totalCollisions) / tickCount;
+    }
+
+    return result;
+}
@@ -21,6 +21,51 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/util/Vector.hpp>
 
+#include <algorithm>
+#include <array>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    std::size_t paddedSize(std::size_t size)
+    {
+        return (size + 3) & ~std::size_t(3);
+    }
+
+    //returns the penetration of the other object along the given face of the owner
+    float projectFace(const CollisionObject& owner, std::size_t face, const CollisionObject& other)
+    {
+        const float normalX = owner.normalX[face];
+        const float normalY = owner.normalY[face];
+
+#ifdef SAT_SSE2
+        //4 vertices at a time
+        const auto nx = _mm_set1_ps(normalX);
+        const auto ny = _mm_set1_ps(normalY);
+        auto projection = _mm_set1_ps(std::numeric_limits<float>::max());
+        for (auto i = 0u; i < other.vertexX.size(); i += 4)
+        {
+            const auto dot = _mm_add_ps(_mm_mul_ps(nx, _mm_loadu_ps(&other.vertexX[i])), _mm_mul_ps(ny, _mm_loadu_ps(&other.vertexY[i])));
+            projection = _mm_min_ps(projection, dot);
+        }
+        projection = _mm_min_ps(projection, _mm_shuffle_ps(projection, projection, _MM_SHUFFLE(1, 0, 3, 2)));
+        projection = _mm_min_ps(projection, _mm_shuffle_ps(projection, projection, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_cvtss_f32(projection) - owner.faceOffsets[face];
+#else
+        float projection = std::numeric_limits<float>::max();
+        for (auto i = 0u; i < other.vertexX.size(); ++i)
+        {
+            projection = std::min(projection, normalX * other.vertexX[i] + normalY * other.vertexY[i]);
+        }
+        return projection - owner.faceOffsets[face];
+#endif //SAT_SSE2
+    }
+}
+
 void CollisionObject::applyVertices(const std::vector<sf::Vector2f>& points)
 {
     //clockwise if > 0
@@ -76,24 +121,71 @@ void CollisionObject::applyVertices(const std::vector<sf::Vector2f>& points)
     }
 }
 
-sf::Vector2f getSupportPoint(xy::Entity entity, sf::Vector2f axis)
+void CollisionObject::updateWorldSpace(const sf::Transform& tx)
 {
-    //this assumes the input axis is already in world coords
+    worldVertices.resize(vertices.size());
+    worldNormals.resize(normals.size());
+
+    //only apply rotation to normals, remove any translation.
+    const auto origin = tx.transformPoint({});
+
+    for (auto i = 0u; i < vertices.size(); ++i)
+    {
+        worldVertices[i] = tx.transformPoint(vertices[i]);
+        worldNormals[i] = tx.transformPoint(normals[i]) - origin;
+    }
+
+    updateWorldData();
+}
 
-    auto tx = entity.getComponent<xy::Transform>().getWorldTransform();
-    const auto& vertices = entity.getComponent<CollisionObject>().vertices;
+void CollisionObject::updateWorldData()
+{
+    vertexX.resize(paddedSize(worldVertices.size()));
+    vertexY.resize(vertexX.size());
+    normalX.resize(paddedSize(worldNormals.size()));
+    normalY.resize(normalX.size());
+    faceOffsets.resize(normalX.size());
+
+    for (auto i = 0u; i < vertexX.size(); ++i)
+    {
+        const auto& vert = worldVertices[std::min<std::size_t>(i, worldVertices.size() - 1)];
+        vertexX[i] = vert.x;
+        vertexY[i] = vert.y;
+    }
+
+    for (auto i = 0u; i < normalX.size(); ++i)
+    {
+        auto idx = std::min<std::size_t>(i, worldNormals.size() - 1);
+        normalX[i] = worldNormals[idx].x;
+        normalY[i] = worldNormals[idx].y;
+        faceOffsets[i] = xy::Util::Vector::dot(worldNormals[idx], worldVertices[idx]);
+    }
+
+    if (!worldVertices.empty())
+    {
+        auto [minX, maxX] = std::minmax_element(worldVertices.begin(), worldVertices.end(),
+            [](sf::Vector2f a, sf::Vector2f b) { return a.x < b.x; });
+        auto [minY, maxY] = std::minmax_element(worldVertices.begin(), worldVertices.end(),
+            [](sf::Vector2f a, sf::Vector2f b) { return a.y < b.y; });
 
-    auto support = tx.transformPoint(vertices[0]);
+        worldBounds = { minX->x, minY->y, maxX->x - minX->x, maxY->y - minY->y };
+    }
+}
 
+sf::Vector2f getSupportPoint(xy::Entity entity, sf::Vector2f axis)
+{
+    //this assumes the input axis is already in world coords
+    const auto& vertices = entity.getComponent<CollisionObject>().worldVertices;
+
+    auto support = vertices[0];
     float maxProjection = xy::Util::Vector::dot(support, axis);
 
     for (auto i = 1u; i < vertices.size(); i++)
     {
-        auto txPoint = tx.transformPoint(vertices[i]);
-        float projection = xy::Util::Vector::dot(txPoint, axis);
+        float projection = xy::Util::Vector::dot(vertices[i], axis);
         if (projection > maxProjection)
         {
-            support = txPoint;
+            support = vertices[i];
             maxProjection = projection;
         }
     }
@@ -102,54 +194,158 @@ sf::Vector2f getSupportPoint(xy::Entity entity, sf::Vector2f axis)
 
 Manifold minimumPenetration(xy::Entity first, xy::Entity second)
 {
-    Manifold retVal;
-
-    const auto& tx = first.getComponent<xy::Transform>();
-    const auto& vertices = first.getComponent<CollisionObject>().vertices;
-    const auto& normals = first.getComponent<CollisionObject>().normals;
-
-    //end early if we ever observe separation
-    for (auto i = 0u; retVal.penetration < 0 && i < normals.size(); i++) 
-    {
-        //only apply rotation to normal, remove any translation.
-        auto normal = tx.getWorldTransform().transformPoint(normals[i]) - tx.getWorldPosition();
-        auto support = getSupportPoint(second, -normal);
+    return Sat::minimumPenetration(first.getComponent<CollisionObject>(), second.getComponent<CollisionObject>());
+}
 
-        auto vert = tx.getWorldTransform().transformPoint(vertices[i]);
+std::optional<Manifold> intersects(xy::Entity a, xy::Entity b)
+{
+    std::uint32_t separatingAxis = SeparatingAxis::None;
+    return intersects(a, b, separatingAxis);
+}
 
-        float projection = xy::Util::Vector::dot(normal, support - vert);
-        if (projection > retVal.penetration) 
-        {
-            retVal.penetration = projection;
-            retVal.normal = normal;
-        }
-    }
-    return retVal;
+std::optional<Manifold> intersects(xy::Entity a, xy::Entity b, std::uint32_t& separatingAxis)
+{
+    return Sat::intersects(a.getComponent<CollisionObject>(), b.getComponent<CollisionObject>(), separatingAxis);
 }
 
-std::optional<Manifold> intersects(xy::Entity a, xy::Entity b)
+namespace Sat
 {
-    auto manA = minimumPenetration(a, b);
-    if (manA.penetration > 0)
+    bool simdEnabled()
     {
-        return std::nullopt;
+#ifdef SAT_SSE2
+        return true;
+#else
+        return false;
+#endif
     }
 
-    auto manB = minimumPenetration(b, a);
-    if (manB.penetration > 0)
+    Manifold minimumPenetration(const CollisionObject& first, const CollisionObject& second)
     {
-        return std::nullopt;
+#ifdef SAT_SSE2
+        Manifold retVal;
+
+        const auto faceCount = first.normals.size();
+        const auto vertexCount = second.vertices.size();
+
+        //projects 4 of the first object's faces at a time on to each of the second's
+        //vertices. The smallest projection on to each face is the same as projecting
+        //the support point found along the reverse of the face normal.
+        for (auto i = 0u; retVal.penetration < 0 && i < faceCount; i += 4)
+        {
+            const auto normalX = _mm_loadu_ps(&first.normalX[i]);
+            const auto normalY = _mm_loadu_ps(&first.normalY[i]);
+
+            auto projection = _mm_set1_ps(std::numeric_limits<float>::max());
+            for (auto j = 0u; j < vertexCount; ++j)
+            {
+                const auto vertX = _mm_set1_ps(second.vertexX[j]);
+                const auto vertY = _mm_set1_ps(second.vertexY[j]);
+                projection = _mm_min_ps(projection, _mm_add_ps(_mm_mul_ps(normalX, vertX), _mm_mul_ps(normalY, vertY)));
+            }
+
+            alignas(16) std::array<float, 4u> penetration = {};
+            _mm_store_ps(penetration.data(), _mm_sub_ps(projection, _mm_loadu_ps(&first.faceOffsets[i])));
+
+            //padded lanes are copies of the last face, and never
+            //replace it because they're not greater than it
+            for (auto lane = 0u; lane < penetration.size(); ++lane)
+            {
+                if (penetration[lane] > retVal.penetration)
+                {
+                    retVal.penetration = penetration[lane];
+                    retVal.axis = static_cast<std::uint32_t>(std::min<std::size_t>(i + lane, faceCount - 1));
+                }
+            }
+        }
+
+        if (retVal.axis != SeparatingAxis::None)
+        {
+            retVal.normal = first.worldNormals[retVal.axis];
+        }
+        return retVal;
+#else
+        return minimumPenetrationScalar(first, second);
+#endif //SAT_SSE2
     }
 
-    if (manA.penetration > manB.penetration)
+    Manifold minimumPenetrationScalar(const CollisionObject& first, const CollisionObject& second)
     {
-        return manA;
+        Manifold retVal;
+
+        const auto& normals = first.worldNormals;
+        const auto& vertices = second.worldVertices;
+
+        //end early if we ever observe separation
+        for (auto i = 0u; retVal.penetration < 0 && i < normals.size(); i++)
+        {
+            //find the support point along the reverse of the normal
+            auto support = vertices[0];
+            float maxProjection = xy::Util::Vector::dot(support, -normals[i]);
+            for (auto j = 1u; j < vertices.size(); j++)
+            {
+                float projection = xy::Util::Vector::dot(vertices[j], -normals[i]);
+                if (projection > maxProjection)
+                {
+                    support = vertices[j];
+                    maxProjection = projection;
+                }
+            }
+
+            //same as dot(normal, support - vert)
+            float projection = xy::Util::Vector::dot(normals[i], support) - first.faceOffsets[i];
+            if (projection > retVal.penetration)
+            {
+                retVal.penetration = projection;
+                retVal.normal = normals[i];
+                retVal.axis = i;
+            }
+        }
+        return retVal;
     }
-    else
+
+    std::optional<Manifold> intersects(const CollisionObject& a, const CollisionObject& b, std::uint32_t& separatingAxis, bool scalar)
     {
-        //this makes sure the normal is always the 
-        //same direction relative to entity a
-        manB.normal *= -1.f;
-        return manB;
+        //pairs which were separated the last time they were tested
+        //most likely still are, so try the axis which separated them
+        if (separatingAxis != SeparatingAxis::None)
+        {
+            const auto& owner = (separatingAxis & SeparatingAxis::Second) ? b : a;
+            const auto& other = (separatingAxis & SeparatingAxis::Second) ? a : b;
+            const auto face = separatingAxis & ~SeparatingAxis::Second;
+
+            if (face < owner.normals.size()
+                && projectFace(owner, face, other) > 0)
+            {
+                return std::nullopt;
+            }
+        }
+
+        auto manA = scalar ? minimumPenetrationScalar(a, b) : minimumPenetration(a, b);
+        if (manA.penetration > 0)
+        {
+            separatingAxis = manA.axis;
+            return std::nullopt;
+        }
+
+        auto manB = scalar ? minimumPenetrationScalar(b, a) : minimumPenetration(b, a);
+        if (manB.penetration > 0)
+        {
+            separatingAxis = manB.axis | SeparatingAxis::Second;
+            return std::nullopt;
+        }
+
+        separatingAxis = SeparatingAxis::None;
+        if (manA.penetration > manB.penetration)
+        {
+            return manA;
+        }
+        else
+        {
+            //this makes sure the normal is always the 
+            //same direction relative to entity a
+            manB.normal *= -1.f;
+            manB.axis |= SeparatingAxis::Second;
+            return manB;
+        }
     }
-}
\ No newline at end of file
+}
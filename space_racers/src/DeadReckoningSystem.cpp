@@ -107,10 +107,16 @@ void DeadReckoningSystem::process(float dt)
 
             if (entity.getComponent<NetActor>().actorID != ActorID::Roid)
             {
-                dr.lastExtrapolatedTimestamp += static_cast<std::int32_t>(dt * 1000000.f);
+                //vehicles are simulated with a fixed step
                 auto& vehicle = entity.getComponent<Vehicle>();
-
-                updateInput(vehicle, dr);
+                dr.stepAccumulator += dt;
+                while (dr.stepAccumulator >= Vehicle::StepTime)
+                {
+                    dr.stepAccumulator -= Vehicle::StepTime;
+                    dr.lastExtrapolatedTimestamp += Vehicle::StepMicroseconds;
+
+                    updateInput(vehicle, dr);
+                }
             }
         }
     }
@@ -0,0 +1,238 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+/*
+Headless dedicated server. Hosts one or more independent races in a
+single process, each listening on its own port and running on its own
+thread. No window or graphics context is created, and the servers keep
+running when all their clients have left. A watchdog on the main thread
+reports any race whose logic tick exceeds the given budget, or which
+stops ticking. Maps are loaded from assets/maps in the resource
+directory, which defaults to the working directory.
+
+Usage: space_racers_server [-m <race count>] [-p <first port>] [-b <tick budget ms>] [-r <resource directory>]
+*/
+
+#include "Server.hpp"
+#include "ServerStates.hpp"
+#include "NetConsts.hpp"
+
+#include <xyginext/core/Log.hpp>
+#include <xyginext/core/FileSystem.hpp>
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::atomic<bool> running(true);
+
+    void onSignal(int)
+    {
+        running = false;
+    }
+
+    struct Options final
+    {
+        std::size_t raceCount = 1;
+        std::uint16_t basePort = NetConst::Port;
+        std::int64_t tickBudget = 16000; //microseconds. A logic step is 1/60th sec
+        std::string resourceDirectory;
+    };
+
+    const sf::Time WatchdogInterval = sf::seconds(1.f);
+    const sf::Time StallTimeout = sf::seconds(5.f);
+    const std::size_t MaxRaces = 64;
+
+    struct Race final
+    {
+        std::unique_ptr<sv::Server> server;
+        std::uint64_t lastTickCount = 0;
+        sf::Clock stallClock;
+        bool stalled = false;
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: space_racers_server [-m <race count>] [-p <first port>] [-b <tick budget ms>] [-r <resource directory>]\n";
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+
+            if (arg == "-r")
+            {
+                options.resourceDirectory = argv[++i];
+                continue;
+            }
+
+            auto value = std::atoi(argv[++i]);
+            if (arg == "-m")
+            {
+                if (value < 1 || value > static_cast<int>(MaxRaces))
+                {
+                    return false;
+                }
+                options.raceCount = value;
+            }
+            else if (arg == "-p")
+            {
+                if (value < 1 || value > 0xffff)
+                {
+                    return false;
+                }
+                options.basePort = static_cast<std::uint16_t>(value);
+            }
+            else if (arg == "-b")
+            {
+                if (value < 1)
+                {
+                    return false;
+                }
+                options.tickBudget = value * 1000;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.basePort + options.raceCount > 0xffff)
+    {
+        xy::Logger::log("Port range exceeds 65535", xy::Logger::Type::Error);
+        return 1;
+    }
+
+    if (!options.resourceDirectory.empty())
+    {
+        xy::FileSystem::setResourceDirectory(options.resourceDirectory);
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::size_t failedCount = 0;
+    std::vector<Race> races(options.raceCount);
+    for (auto i = 0u; i < races.size(); ++i)
+    {
+        const auto port = static_cast<std::uint16_t>(options.basePort + i);
+
+        auto& race = races[i];
+        race.server = std::make_unique<sv::Server>();
+        race.server->setPort(port);
+        race.server->setDedicated(true);
+        if (!race.server->run(sv::StateID::Lobby))
+        {
+            xy::Logger::log("Race " + std::to_string(i) + " could not be hosted on port " + std::to_string(port), xy::Logger::Type::Error);
+            failedCount++;
+        }
+    }
+
+    //a server with only some of its races running is
+    //easily missed, so fail outright and let the caller retry
+    if (failedCount > 0)
+    {
+        xy::Logger::log(std::to_string(failedCount) + " of " + std::to_string(races.size()) + " races failed to start", xy::Logger::Type::Error);
+        for (auto& race : races)
+        {
+            race.server->quit();
+        }
+        return 1;
+    }
+
+    //watchdog
+    sf::Clock watchdogClock;
+    while (running)
+    {
+        sf::sleep(sf::milliseconds(100));
+
+        if (watchdogClock.getElapsedTime() < WatchdogInterval)
+        {
+            continue;
+        }
+        watchdogClock.restart();
+
+        for (auto& race : races)
+        {
+            if (!race.server->running())
+            {
+                continue;
+            }
+
+            const auto port = std::to_string(race.server->getPort());
+            auto peak = race.server->resetPeakTickTime();
+            if (peak > options.tickBudget)
+            {
+                xy::Logger::log("Race on port " + port + " exceeded tick budget: " + std::to_string(peak) + "us", xy::Logger::Type::Warning);
+            }
+
+            auto tickCount = race.server->getTickCount();
+            if (tickCount != race.lastTickCount)
+            {
+                race.lastTickCount = tickCount;
+                race.stallClock.restart();
+
+                if (race.stalled)
+                {
+                    race.stalled = false;
+                    xy::Logger::log("Race on port " + port + " recovered", xy::Logger::Type::Info);
+                }
+            }
+            else if (!race.stalled
+                && race.stallClock.getElapsedTime() > StallTimeout)
+            {
+                race.stalled = true;
+                xy::Logger::log("Race on port " + port + " has not ticked in " + std::to_string(StallTimeout.asSeconds()) + " seconds", xy::Logger::Type::Error);
+            }
+        }
+    }
+
+    for (auto& race : races)
+    {
+        race.server->quit();
+    }
+
+    return 0;
+}
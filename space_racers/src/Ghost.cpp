@@ -0,0 +1,351 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "Ghost.hpp"
+#include "BitStream.hpp"
+#include "Util.hpp"
+
+#include <xyginext/core/Log.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+    const std::uint32_t Magic = 0x54534847; //GHST
+    const std::uint32_t Version = 1;
+
+    //the unversioned format is the lap time followed by every point
+    const std::size_t LegacySize = sizeof(float) + (Ghost::MaxPoints * sizeof(GhostPoint));
+
+    //keeps the predicted values from overflowing
+    const float MaxQuantised = static_cast<float>(1 << 28);
+
+    std::uint32_t toBits(float value)
+    {
+        std::uint32_t bits = 0;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    float fromBits(std::uint32_t bits)
+    {
+        float value = 0.f;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    std::int32_t quantise(float value, float step)
+    {
+        return static_cast<std::int32_t>(std::round(std::max(-MaxQuantised, std::min(MaxQuantised, value / step))));
+    }
+
+    //returns the angle in the range -180 to 180
+    float shortestAngle(float angle)
+    {
+        angle = std::fmod(angle, 360.f);
+        if (angle > 180.f)
+        {
+            angle -= 360.f;
+        }
+        else if (angle < -180.f)
+        {
+            angle += 360.f;
+        }
+        return angle;
+    }
+
+    float wrapAngle(float angle)
+    {
+        angle = std::fmod(angle, 360.f);
+        return angle < 0.f ? angle + 360.f : angle;
+    }
+
+    //x, y, rotation and scale
+    using Quantised = std::array<std::int32_t, 4u>;
+}
+
+std::vector<std::uint8_t> Ghost::encode(const std::vector<GhostPoint>& points, float lapTime)
+{
+    const auto count = std::min(points.size(), MaxPoints);
+
+    BitWriter writer;
+    writer.write(Magic, 32);
+    writer.write(Version, 8);
+    writer.write(toBits(lapTime), 32);
+    writer.write(static_cast<std::uint32_t>(count), 32);
+
+    GhostPoint keyframe;
+    float rotation = 0.f; //unwrapped, relative to the keyframe
+    Quantised previous = {};
+    Quantised previous2 = {};
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        const auto& point = points[i];
+        if (i % SampleRate == 0)
+        {
+            writer.write(toBits(point.x), 32);
+            writer.write(toBits(point.y), 32);
+            writer.write(toBits(point.rotation), 32);
+            writer.write(toBits(point.scale), 32);
+
+            keyframe = point;
+            rotation = 0.f;
+            previous = {};
+            previous2 = {};
+        }
+        else
+        {
+            //follow the rotation past 360 so that spinning
+            //doesn't make the values jump back and forth
+            rotation += shortestAngle(point.rotation - points[i - 1].rotation);
+
+            const Quantised values =
+            {
+                quantise(point.x - keyframe.x, PositionStep),
+                quantise(point.y - keyframe.y, PositionStep),
+                quantise(rotation, RotationStep),
+                quantise(point.scale - keyframe.scale, ScaleStep)
+            };
+
+            for (auto j = 0u; j < values.size(); ++j)
+            {
+                const auto prediction = (previous[j] * 2) - previous2[j];
+                writer.writeDelta(values[j] - prediction);
+            }
+            previous2 = previous;
+            previous = values;
+        }
+    }
+
+    auto data = writer.getData();
+    const auto hash = fnv1a(data.data(), data.size());
+    for (auto i = 0u; i < sizeof(hash); ++i)
+    {
+        data.push_back(static_cast<std::uint8_t>(hash >> (i * 8)));
+    }
+    return data;
+}
+
+bool Ghost::decode(const std::vector<std::uint8_t>& data, std::vector<GhostPoint>& points, float& lapTime)
+{
+    if (data.size() >= sizeof(Magic))
+    {
+        std::uint32_t magic = 0;
+        for (auto i = 0u; i < 4u; ++i)
+        {
+            magic |= (static_cast<std::uint32_t>(data[i]) << (i * 8));
+        }
+
+        if (magic != Magic)
+        {
+            if (data.size() != LegacySize)
+            {
+                return false;
+            }
+
+            std::memcpy(&lapTime, data.data(), sizeof(float));
+            points.resize(MaxPoints);
+            std::memcpy(points.data(), data.data() + sizeof(float), MaxPoints * sizeof(GhostPoint));
+            return true;
+        }
+    }
+
+    std::uint64_t hash = 0;
+    if (data.size() < sizeof(Magic) + sizeof(hash))
+    {
+        return false;
+    }
+
+    const auto size = data.size() - sizeof(hash);
+    for (auto i = 0u; i < sizeof(hash); ++i)
+    {
+        hash |= (static_cast<std::uint64_t>(data[size + i]) << (i * 8));
+    }
+
+    if (hash != fnv1a(data.data(), size))
+    {
+        return false;
+    }
+
+    BitReader reader(data.data(), size);
+    reader.read(32);
+    if (reader.read(8) != Version)
+    {
+        return false;
+    }
+
+    const auto time = fromBits(reader.read(32));
+    const auto count = reader.read(32);
+    if (count > MaxPoints)
+    {
+        return false;
+    }
+
+    std::vector<GhostPoint> result(count);
+    GhostPoint keyframe;
+    Quantised previous = {};
+    Quantised previous2 = {};
+
+    for (auto i = 0u; i < count && !reader.failed(); ++i)
+    {
+        auto& point = result[i];
+        if (i % SampleRate == 0)
+        {
+            point.x = fromBits(reader.read(32));
+            point.y = fromBits(reader.read(32));
+            point.rotation = fromBits(reader.read(32));
+            point.scale = fromBits(reader.read(32));
+
+            keyframe = point;
+            previous = {};
+            previous2 = {};
+        }
+        else
+        {
+            Quantised values = {};
+            for (auto j = 0u; j < values.size(); ++j)
+            {
+                const auto prediction = (previous[j] * 2) - previous2[j];
+                values[j] = reader.readDelta() + prediction;
+            }
+            previous2 = previous;
+            previous = values;
+
+            point.x = keyframe.x + (static_cast<float>(values[0]) * PositionStep);
+            point.y = keyframe.y + (static_cast<float>(values[1]) * PositionStep);
+            point.rotation = wrapAngle(keyframe.rotation + (static_cast<float>(values[2]) * RotationStep));
+            point.scale = keyframe.scale + (static_cast<float>(values[3]) * ScaleStep);
+        }
+    }
+
+    if (reader.failed())
+    {
+        return false;
+    }
+
+    points.swap(result);
+    lapTime = time;
+    return true;
+}
+
+bool Ghost::save(const std::string& path, const std::vector<GhostPoint>& points, float lapTime)
+{
+    const auto data = encode(points, lapTime);
+
+    std::ofstream file(path, std::ios::binary);
+    if (file.is_open() && file.good())
+    {
+        file.write(reinterpret_cast<const char*>(data.data()), data.size());
+        return file.good();
+    }
+
+    xy::Logger::log("Failed writing ghost to " + path, xy::Logger::Type::Error);
+    return false;
+}
+
+bool Ghost::load(const std::string& path, std::vector<GhostPoint>& points, float& lapTime)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open() || !file.good())
+    {
+        return false;
+    }
+
+    file.seekg(0, file.end);
+    const auto fileSize = static_cast<std::size_t>(file.tellg());
+    file.seekg(0, file.beg);
+
+    std::vector<std::uint8_t> data(fileSize);
+    file.read(reinterpret_cast<char*>(data.data()), fileSize);
+    if (!file.good())
+    {
+        return false;
+    }
+
+    if (!decode(data, points, lapTime))
+    {
+        xy::Logger::log(path + ": invalid ghost data", xy::Logger::Type::Warning);
+        return false;
+    }
+    return true;
+}
+
+GhostPoint Ghost::getPoint(const std::vector<GhostPoint>& points, std::size_t index, float interp)
+{
+    if (points.empty())
+    {
+        return {};
+    }
+
+    if (index + 1 >= points.size())
+    {
+        return points.back();
+    }
+
+    const auto& a = points[index];
+    const auto& b = points[index + 1];
+
+    GhostPoint point;
+    point.x = a.x + ((b.x - a.x) * interp);
+    point.y = a.y + ((b.y - a.y) * interp);
+    point.rotation = a.rotation + (shortestAngle(b.rotation - a.rotation) * interp);
+    point.scale = a.scale + ((b.scale - a.scale) * interp);
+    return point;
+}
+
+GhostLoader::GhostLoader()
+    : m_thread  (&GhostLoader::threadFunc, this),
+    m_busy      (false)
+{
+
+}
+
+GhostLoader::~GhostLoader()
+{
+    m_thread.wait();
+}
+
+//public
+void GhostLoader::load(const std::vector<std::string>& paths)
+{
+    m_thread.wait();
+
+    m_results.clear();
+    for (const auto& path : paths)
+    {
+        m_results.emplace_back().path = path;
+    }
+
+    m_busy = true;
+    m_thread.launch();
+}
+
+//private
+void GhostLoader::threadFunc()
+{
+    for (auto& result : m_results)
+    {
+        result.loaded = Ghost::load(result.path, result.points, result.lapTime);
+    }
+    m_busy = false;
+}
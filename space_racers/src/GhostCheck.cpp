@@ -0,0 +1,219 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "GhostCheck.hpp"
+#include "Ghost.hpp"
+#include "CollisionObject.hpp"
+#include "VehicleSystem.hpp"
+#include "VehicleDefs.hpp"
+#include "AIDriverSystem.hpp"
+#include "MapParser.hpp"
+#include "MessageIDs.hpp"
+#include "GameConsts.hpp"
+#include "WayPoint.hpp"
+
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/core/FileSystem.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/BroadPhaseComponent.hpp>
+#include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace
+{
+    //size of the unversioned format, which was the same for every lap
+    const std::size_t RawSize = sizeof(float) + (Ghost::MaxPoints * sizeof(GhostPoint));
+
+    //drives a single AI car from the start line until it crosses it again
+    std::vector<GhostPoint> recordLap(const std::string& map, bool& loaded)
+    {
+        std::vector<GhostPoint> points;
+
+        xy::MessageBus messageBus;
+        xy::Scene scene(messageBus);
+        scene.addSystem<AIDriverSystem>(messageBus);
+        scene.addSystem<VehicleSystem>(messageBus);
+        scene.addSystem<xy::DynamicTreeSystem>(messageBus);
+
+        MapParser mapParser(scene);
+        loaded = mapParser.load(map);
+        if (!loaded)
+        {
+            return points;
+        }
+
+        auto [position, rotation] = mapParser.getStartPosition();
+
+        auto entity = scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(position);
+        entity.getComponent<xy::Transform>().setRotation(rotation);
+        entity.addComponent<Vehicle>().waypointCount = mapParser.getWaypointCount();
+        entity.getComponent<Vehicle>().settings = Definition::car;
+        entity.getComponent<Vehicle>().stateFlags = (1 << Vehicle::Normal);
+        entity.addComponent<CollisionObject>().type = CollisionObject::Vehicle;
+        entity.getComponent<CollisionObject>().applyVertices(GameConst::CarPoints);
+        entity.addComponent<xy::BroadphaseComponent>().setArea(GameConst::CarSize);
+        entity.getComponent<xy::BroadphaseComponent>().setFilterFlags(CollisionFlags::Vehicle);
+        entity.addComponent<AIDriver>().target = position;
+        entity.getComponent<AIDriver>().skill = AIDriver::Skill::Excellent;
+
+        bool finished = false;
+        while (!finished && points.size() < Ghost::MaxPoints)
+        {
+            scene.update(Ghost::SampleTime);
+
+            const auto& tx = entity.getComponent<xy::Transform>();
+            points.emplace_back(tx.getPosition(), tx.getRotation(), tx.getScale().x);
+
+            while (!messageBus.empty())
+            {
+                const auto& msg = messageBus.poll();
+                scene.forwardMessage(msg);
+
+                if (msg.id == MessageID::VehicleMessage)
+                {
+                    const auto& data = msg.getData<VehicleEvent>();
+                    if (data.type == VehicleEvent::LapLine)
+                    {
+                        finished = true;
+                    }
+                    else if (data.type == VehicleEvent::RequestRespawn)
+                    {
+                        auto& vehicle = entity.getComponent<Vehicle>();
+                        auto& vehicleTx = entity.getComponent<xy::Transform>();
+
+                        vehicle.velocity = {};
+                        vehicle.anglularVelocity = {};
+                        vehicle.stateFlags = (1 << Vehicle::Normal);
+                        vehicle.invincibleTime = GameConst::InvincibleTime;
+
+                        if (vehicle.currentWaypoint.isValid())
+                        {
+                            vehicleTx.setPosition(vehicle.currentWaypoint.getComponent<xy::Transform>().getPosition());
+                            vehicleTx.setRotation(vehicle.currentWaypoint.getComponent<WayPoint>().rotation);
+                        }
+                        else
+                        {
+                            vehicleTx.setPosition(position);
+                            vehicleTx.setRotation(rotation);
+                        }
+                        vehicleTx.setScale(1.f, 1.f);
+                    }
+                }
+            }
+        }
+
+        return points;
+    }
+
+    void checkLap(const std::vector<GhostPoint>& points, GhostCheckResult& result)
+    {
+        result.lapCount++;
+        result.pointCount += points.size();
+        result.rawSize += RawSize;
+
+        const float lapTime = static_cast<float>(points.size()) * Ghost::SampleTime;
+        auto data = Ghost::encode(points, lapTime);
+        result.encodedSize += data.size();
+
+        std::vector<GhostPoint> decoded;
+        float decodedTime = 0.f;
+        if (!Ghost::decode(data, decoded, decodedTime)
+            || decoded.size() != points.size()
+            || decodedTime != lapTime)
+        {
+            result.failCount++;
+            return;
+        }
+
+        float positionError = 0.f;
+        float rotationError = 0.f;
+        float scaleError = 0.f;
+        for (auto i = 0u; i < points.size(); ++i)
+        {
+            positionError = std::max(positionError, std::abs(points[i].x - decoded[i].x));
+            positionError = std::max(positionError, std::abs(points[i].y - decoded[i].y));
+
+            const float rotation = std::fmod(std::abs(points[i].rotation - decoded[i].rotation), 360.f);
+            rotationError = std::max(rotationError, std::min(rotation, 360.f - rotation));
+
+            scaleError = std::max(scaleError, std::abs(points[i].scale - decoded[i].scale));
+        }
+        result.positionError = std::max(result.positionError, positionError);
+        result.rotationError = std::max(result.rotationError, rotationError);
+        result.scaleError = std::max(result.scaleError, scaleError);
+
+        //allow a little for float precision on top of the half step rounding
+        bool failed = positionError > Ghost::PositionStep
+            || rotationError > Ghost::RotationStep
+            || scaleError > Ghost::ScaleStep;
+
+        //flipping any bit should fail the checksum
+        data[data.size() / 2] ^= 0x01;
+        if (Ghost::decode(data, decoded, decodedTime))
+        {
+            failed = true;
+        }
+
+        if (failed)
+        {
+            result.failCount++;
+        }
+    }
+}
+
+GhostCheckResult runGhostCheck(const std::string& map)
+{
+    GhostCheckResult result;
+
+    auto lap = recordLap(map, result.loaded);
+    if (!result.loaded)
+    {
+        return result;
+    }
+    checkLap(lap, result);
+
+    //every ghost saved by time trials
+    const auto configDir = xy::FileSystem::getConfigDirectory(GameConst::AppName);
+    for (const auto& dir : xy::FileSystem::listDirectories(configDir))
+    {
+        for (const auto& file : xy::FileSystem::listFiles(configDir + dir))
+        {
+            if (xy::FileSystem::getFileExtension(file) == ".gst")
+            {
+                std::vector<GhostPoint> points;
+                float lapTime = 0.f;
+                if (Ghost::load(configDir + dir + "/" + file, points, lapTime))
+                {
+                    checkLap(points, result);
+                }
+                else
+                {
+                    result.lapCount++;
+                    result.failCount++;
+                }
+            }
+        }
+    }
+
+    return result;
+}
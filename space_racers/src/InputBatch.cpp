@@ -0,0 +1,177 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "InputBatch.hpp"
+#include "BitStream.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const std::uint32_t CountBits = 3; //stored as count - 1
+    const std::uint32_t TimestampBits = 32;
+    const std::uint32_t FlagBits = 5;
+    const std::uint32_t MultiplierBits = 8;
+    const float MultiplierSteps = static_cast<float>((1 << MultiplierBits) - 1);
+
+    static_assert(InputBatch::MaxInputs <= (1 << CountBits), "Too many inputs for count bits");
+
+    std::uint32_t toFixed(float multiplier)
+    {
+        return static_cast<std::uint32_t>(std::round(std::min(1.f, std::max(0.f, multiplier)) * MultiplierSteps));
+    }
+
+    float fromFixed(std::uint32_t value)
+    {
+        return static_cast<float>(value) / MultiplierSteps;
+    }
+
+    //timestamps may wrap around
+    bool isNewer(std::int32_t a, std::int32_t b)
+    {
+        return static_cast<std::int32_t>(static_cast<std::uint32_t>(a) - static_cast<std::uint32_t>(b)) > 0;
+    }
+}
+
+InputBatch::InputBatch()
+    : m_count   (0),
+    m_nextFree  (0)
+{
+
+}
+
+//public
+void InputBatch::push(const Input& input)
+{
+    m_inputs[m_nextFree] = input;
+    m_nextFree = (m_nextFree + 1) % m_inputs.size();
+    m_count = std::min(m_count + 1, m_inputs.size());
+}
+
+void InputBatch::write(BitWriter& writer) const
+{
+    if (m_count == 0)
+    {
+        return;
+    }
+
+    writer.write(static_cast<std::uint32_t>(m_count - 1), CountBits);
+
+    //oldest first
+    auto idx = (m_nextFree + m_inputs.size() - m_count) % m_inputs.size();
+    const Input* previous = nullptr;
+    for (auto i = 0u; i < m_count; ++i)
+    {
+        const auto& input = m_inputs[idx];
+        if (previous)
+        {
+            writer.writeDelta(input.timestamp - previous->timestamp - Vehicle::StepMicroseconds);
+        }
+        else
+        {
+            writer.write(static_cast<std::uint32_t>(input.timestamp), TimestampBits);
+        }
+
+        writer.write(static_cast<std::uint16_t>(input.flags), FlagBits);
+
+        //analogue values rarely change between steps
+        const auto steering = toFixed(input.steeringMultiplier);
+        const auto acceleration = toFixed(input.accelerationMultiplier);
+
+        const bool steeringChanged = !previous || steering != toFixed(previous->steeringMultiplier);
+        writer.writeBool(steeringChanged);
+        if (steeringChanged)
+        {
+            writer.write(steering, MultiplierBits);
+        }
+
+        const bool accelerationChanged = !previous || acceleration != toFixed(previous->accelerationMultiplier);
+        writer.writeBool(accelerationChanged);
+        if (accelerationChanged)
+        {
+            writer.write(acceleration, MultiplierBits);
+        }
+
+        previous = &input;
+        idx = (idx + 1) % m_inputs.size();
+    }
+}
+
+std::size_t InputBatch::read(BitReader& reader, Vehicle& vehicle)
+{
+    const auto count = reader.read(CountBits) + 1;
+
+    std::array<Input, MaxInputs> inputs;
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto& input = inputs[i];
+        if (i == 0)
+        {
+            input.timestamp = static_cast<std::int32_t>(reader.read(TimestampBits));
+        }
+        else
+        {
+            input.timestamp = inputs[i - 1].timestamp + Vehicle::StepMicroseconds + reader.readDelta();
+        }
+
+        input.flags = static_cast<std::int16_t>(reader.read(FlagBits));
+
+        if (reader.readBool())
+        {
+            input.steeringMultiplier = fromFixed(reader.read(MultiplierBits));
+        }
+        else if (i > 0)
+        {
+            input.steeringMultiplier = inputs[i - 1].steeringMultiplier;
+        }
+
+        if (reader.readBool())
+        {
+            input.accelerationMultiplier = fromFixed(reader.read(MultiplierBits));
+        }
+        else if (i > 0)
+        {
+            input.accelerationMultiplier = inputs[i - 1].accelerationMultiplier;
+        }
+    }
+
+    if (reader.failed())
+    {
+        return 0;
+    }
+
+    //drop anything already received from an earlier packet
+    std::size_t added = 0;
+    for (auto i = 0u; i < count; ++i)
+    {
+        const auto& latest = vehicle.history[(vehicle.currentInput + vehicle.history.size() - 1) % vehicle.history.size()];
+        if (isNewer(inputs[i].timestamp, latest.timestamp))
+        {
+            vehicle.history[vehicle.currentInput] = inputs[i];
+            vehicle.currentInput = (vehicle.currentInput + 1) % vehicle.history.size();
+            added++;
+        }
+    }
+    return added;
+}
+
+float InputBatch::quantiseMultiplier(float multiplier)
+{
+    return fromFixed(toFixed(multiplier));
+}
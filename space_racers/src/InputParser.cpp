@@ -38,7 +38,10 @@ InputParser::InputParser(const InputBinding& binding, xy::NetClient* netClient)
     m_steeringMultiplier    (1.f),
     m_accelerationMultiplier(1.f),
     m_currentInput          (0),
-    m_timeAccumulator       (0)
+    m_timeAccumulator       (0),
+    m_stepAccumulator       (0.f),
+    m_packetInterval        (2),
+    m_stepCount             (0)
 {
 
 }
@@ -182,46 +185,57 @@ void InputParser::handleEvent(const sf::Event& evt)
 
 void InputParser::update(float dt)
 {
-    //this just works better than sf::Clock - I don't know why.
-    m_timeAccumulator += static_cast<std::int32_t>(dt * 1000000.f);
+    //vehicles are simulated with a fixed step, so
+    //send an input for every step which has passed
+    m_stepAccumulator += dt;
 
-    if (m_playerEntity.isValid())
+    while (m_stepAccumulator >= Vehicle::StepTime)
     {
-        //set local player input
-        auto& vehicle = m_playerEntity.getComponent<Vehicle>();
-
-        Input input;
-        input.flags = m_currentInput;
-        input.timestamp = m_timeAccumulator;
-        input.steeringMultiplier = std::min(1.f, m_steeringMultiplier);
-        input.accelerationMultiplier = std::min(1.f, m_accelerationMultiplier);
-
-        //update player input history
-        vehicle.history[vehicle.currentInput] = input;
-        vehicle.currentInput = (vehicle.currentInput + 1) % vehicle.history.size();
-
-        //reset analogue multiplier
-        //this has to be set at one for keyboard input
-        if ((m_currentInput & (InputFlag::Left | InputFlag::Right)) == 0)
-        {
-            m_steeringMultiplier = 1.f;
-        }
+        m_stepAccumulator -= Vehicle::StepTime;
+        m_timeAccumulator += Vehicle::StepMicroseconds;
 
-        if ((m_currentInput & InputFlag::Accelerate) == 0)
+        if (m_playerEntity.isValid())
         {
-            m_accelerationMultiplier = 1.f;
-        }
+            //set local player input
+            auto& vehicle = m_playerEntity.getComponent<Vehicle>();
 
-        //send input to server - remember this might be nullptr for local games!
-        if (m_netClient)
-        {
-            InputUpdate iu; //TODO this is the same as the Input struct?
-            iu.timestamp = input.timestamp;
-            iu.inputFlags = input.flags;
-            iu.steeringMultiplier = input.steeringMultiplier;
-            iu.accelerationMultiplier = input.accelerationMultiplier;
+            Input input;
+            input.flags = m_currentInput;
+            input.timestamp = m_timeAccumulator;
+            input.steeringMultiplier = InputBatch::quantiseMultiplier(m_steeringMultiplier);
+            input.accelerationMultiplier = InputBatch::quantiseMultiplier(m_accelerationMultiplier);
+
+            //update player input history
+            vehicle.history[vehicle.currentInput] = input;
+            vehicle.currentInput = (vehicle.currentInput + 1) % vehicle.history.size();
+
+            //send input to server - remember this might be nullptr for local games!
+            if (m_netClient)
+            {
+                m_inputBatch.push(input);
+                if (++m_stepCount >= m_packetInterval)
+                {
+                    m_stepCount = 0;
+
+                    m_packetWriter.clear();
+                    m_inputBatch.write(m_packetWriter);
 
-            m_netClient->sendPacket<InputUpdate>(PacketID::ClientInput, iu, xy::NetFlag::Unreliable, 0);
+                    const auto& data = m_packetWriter.getData();
+                    m_netClient->sendPacket(PacketID::ClientInput, data.data(), data.size(), xy::NetFlag::Unreliable, 0);
+                }
+            }
         }
-    } 
+    }
+
+    //reset analogue multiplier
+    //this has to be set at one for keyboard input
+    if ((m_currentInput & (InputFlag::Left | InputFlag::Right)) == 0)
+    {
+        m_steeringMultiplier = 1.f;
+    }
+
+    if ((m_currentInput & InputFlag::Accelerate) == 0)
+    {
+        m_accelerationMultiplier = 1.f;
+    }
 }
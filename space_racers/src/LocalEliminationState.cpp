@@ -35,6 +35,7 @@ Copyright 2019 Matt Marchant
 #include "NixieDisplay.hpp"
 #include "AIDriverSystem.hpp"
 #include "SkidEffectSystem.hpp"
+#include "VehicleEffects.hpp"
 #include "EliminationDirector.hpp"
 #include "LapDotSystem.hpp"
 #include "EliminationDotSystem.hpp"
@@ -502,7 +503,7 @@ void LocalEliminationState::loadResources()
     m_shaders.preload(ShaderID::Globe, GlobeFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Asteroid, GlobeFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Vehicle, VehicleVertex, VehicleFrag);
-    m_shaders.preload(ShaderID::Trail, VehicleTrail, sf::Shader::Fragment);
+    loadVehicleEffectShaders(m_shaders);
     m_shaders.preload(ShaderID::Lightbar, LightbarFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Shield, ShieldFragment, sf::Shader::Fragment);
 
@@ -579,6 +580,8 @@ bool LocalEliminationState::loadMap()
     m_gameScene.setActiveCamera(camEnt);
     m_gameScene.setActiveListener(camEnt);
 
+    createVehicleEffectBatches(m_gameScene, m_shaders, m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
+
     //dem starrs
     std::array<std::size_t, 3u> IDs =
     {
@@ -832,7 +835,6 @@ void LocalEliminationState::spawnVehicle()
             {
                 auto skidEntity = m_gameScene.createEntity();
                 skidEntity.addComponent<xy::Transform>();
-                skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
                 skidEntity.addComponent<SkidEffect>().parent = entity;
             }
             break;
@@ -845,7 +847,6 @@ void LocalEliminationState::spawnVehicle()
             {
                 auto skidEntity = m_gameScene.createEntity();
                 skidEntity.addComponent<xy::Transform>();
-                skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
                 skidEntity.addComponent<SkidEffect>().parent = entity;
                 skidEntity.getComponent<SkidEffect>().wheelCount = 1;
             }
@@ -931,10 +932,6 @@ void LocalEliminationState::spawnTrail(xy::Entity parent, sf::Color colour)
 {
     auto trailEnt = m_gameScene.createEntity();
     trailEnt.addComponent<xy::Transform>();
-    trailEnt.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
-    trailEnt.getComponent<xy::Drawable>().setTexture(&m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
-    trailEnt.getComponent<xy::Drawable>().setShader(&m_shaders.get(ShaderID::Trail));
-    trailEnt.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
     trailEnt.addComponent<Trail>().parent = parent;
     trailEnt.getComponent<Trail>().colour = colour;
     trailEnt.addComponent<xy::CommandTarget>().ID = CommandID::Game::Trail;
@@ -34,6 +34,7 @@ Copyright 2019 Matt Marchant
 #include "WayPoint.hpp"
 #include "NixieDisplay.hpp"
 #include "SkidEffectSystem.hpp"
+#include "VehicleEffects.hpp"
 #include "EngineAudioSystem.hpp"
 #include "SoundEffectsDirector.hpp"
 #include "LapDotSystem.hpp"
@@ -492,7 +493,7 @@ void LocalRaceState::loadResources()
     m_shaders.preload(ShaderID::Globe, GlobeFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Asteroid, GlobeFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Vehicle, VehicleVertex, VehicleFrag);
-    m_shaders.preload(ShaderID::Trail, VehicleTrail, sf::Shader::Fragment);
+    loadVehicleEffectShaders(m_shaders);
     m_shaders.preload(ShaderID::Lightbar, LightbarFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Shield, ShieldFragment, sf::Shader::Fragment);
 
@@ -557,6 +558,8 @@ bool LocalRaceState::loadMap()
     m_gameScene.setActiveCamera(camEnt);
     m_gameScene.setActiveListener(camEnt);
 
+    createVehicleEffectBatches(m_gameScene, m_shaders, m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
+
     //background stars / planets are also added to the corresponding scene based on cam count (below)
 
     m_mapParser.addProps(m_matrixPool, m_audioResource, m_shaders, m_resources, m_textureIDs);
@@ -803,7 +806,6 @@ void LocalRaceState::spawnVehicle()
             {
                 auto skidEntity = m_gameScene.createEntity();
                 skidEntity.addComponent<xy::Transform>();
-                skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
                 skidEntity.addComponent<SkidEffect>().parent = entity;
             }
             break;
@@ -816,7 +818,6 @@ void LocalRaceState::spawnVehicle()
             {
                 auto skidEntity = m_gameScene.createEntity();
                 skidEntity.addComponent<xy::Transform>();
-                skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
                 skidEntity.addComponent<SkidEffect>().parent = entity;
                 skidEntity.getComponent<SkidEffect>().wheelCount = 1;
             }
@@ -1084,10 +1085,6 @@ void LocalRaceState::spawnTrail(xy::Entity parent, sf::Color colour)
 {
     auto trailEnt = m_gameScene.createEntity();
     trailEnt.addComponent<xy::Transform>();
-    trailEnt.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
-    trailEnt.getComponent<xy::Drawable>().setTexture(&m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
-    trailEnt.getComponent<xy::Drawable>().setShader(&m_shaders.get(ShaderID::Trail));
-    trailEnt.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
     trailEnt.addComponent<Trail>().parent = parent;
     trailEnt.getComponent<Trail>().colour = colour;
     trailEnt.addComponent<xy::CommandTarget>().ID = CommandID::Game::Trail;
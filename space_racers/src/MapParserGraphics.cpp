@@ -0,0 +1,321 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "MapParser.hpp"
+#include "Sprite3D.hpp"
+#include "Camera3D.hpp"
+#include "CommandIDs.hpp"
+#include "GameConsts.hpp"
+#include "VertexFunctions.hpp"
+#include "MatrixPool.hpp"
+#include "AnimationCallbacks.hpp"
+
+#include <xyginext/ecs/Scene.hpp>
+
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/Drawable.hpp>
+#include <xyginext/ecs/components/CommandTarget.hpp>
+#include <xyginext/ecs/components/Callback.hpp>
+
+#include <xyginext/resources/ResourceHandler.hpp>
+#include <xyginext/resources/ShaderResource.hpp>
+
+#include <xyginext/util/Vector.hpp>
+#include <xyginext/audio/AudioScape.hpp>
+
+#include <xyginext/core/FileSystem.hpp>
+
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Sprite.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/OpenGL.hpp>
+
+//the parts of the map parser which create the visual representation
+//of the map. These are kept apart from MapParser.cpp as they require a
+//graphics context, which the dedicated server doesn't have
+
+//public
+void MapParser::renderLayers(std::array<sf::RenderTexture, 2u>& targets) const
+{
+    //TODO instead of rendering HUGE textures which eat all the VRAM, use the
+    //tilemap shader implemented in the platformer project? This will save considerably
+    //on VRAM but will actually increase the complexity and number of draw calls...
+    //for example the track layer will have to be rendered 3 times, and carry the
+    //overhead of texture switching and extra shader binding
+
+    //tileset data
+    std::vector<std::unique_ptr<sf::Texture>> textures;
+    for (const auto& ts : m_track.tileSets)
+    {
+        std::unique_ptr<sf::Texture> tex = std::make_unique<sf::Texture>();
+        if (!tex->loadFromFile(xy::FileSystem::getResourcePath() + ts.imagePath))
+        {
+            xy::Logger::log("failed loading tile set image " + ts.imagePath);
+            return;
+        }
+        else
+        {
+            textures.push_back(std::move(tex));
+        }
+    }
+
+
+    auto mapSize = sf::Vector2u(m_track.tileCount.x * m_track.tileSize.x, m_track.tileCount.y * m_track.tileSize.y);
+
+    targets[0].create(mapSize.x, mapSize.y);
+    targets[0].clear(sf::Color::Transparent);
+    renderLayer(targets[0], m_track.tileLayers[TrackData::Track], textures);
+    renderLayer(targets[0], m_track.tileLayers[TrackData::Detail], textures);
+    renderLayer(targets[0], m_track.tileLayers[TrackData::Neon], textures);
+    targets[0].display();
+
+    //targets[1].create(mapSize.x, mapSize.y);
+    //targets[1].clear(sf::Color::Transparent);
+    //renderLayer(targets[1], m_track.tileLayers[TrackData::Neon], textures);
+    //targets[1].display();
+
+    targets[1].create(mapSize.x, mapSize.y);
+    targets[1].clear(sf::Color::Transparent);
+    renderLayer(targets[1], m_track.tileLayers[TrackData::Normal], textures);
+    targets[1].display();
+}
+
+void MapParser::addProps(MatrixPool& matrixPool, xy::AudioResource& ar, xy::ShaderResource& shaders, xy::ResourceHandler& resources, const std::array<std::size_t, TextureID::Game::Count>& textureIDs)
+{
+    //auto cameraEntity = m_scene.getActiveCamera();
+
+    xy::AudioScape audioScape(ar);
+    audioScape.loadFromFile("assets/sound/map.xas");
+
+    //NOTE viewProj matrices are now set in the render path class
+
+    //electric fences
+    const auto& fences = m_track.fences;
+    const auto& fenceTexture = resources.get<sf::Texture>(textureIDs[TextureID::Game::Fence]);
+    auto texSize = sf::Vector2f(fenceTexture.getSize());
+
+    for (const auto& f : fences)
+    {
+        auto entity = m_scene.createEntity();
+        entity.addComponent<xy::Transform>(); //points are in world space.
+        entity.addComponent<xy::Drawable>().setFilterFlags(GameConst::FilterFlags::All);
+        entity.addComponent<Lightning>() = f;
+
+        entity = m_scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(f.start);
+        entity.addComponent<xy::Drawable>().setDepth(1000);
+        entity.getComponent<xy::Drawable>().addGlFlag(GL_DEPTH_TEST);
+        entity.getComponent<xy::Drawable>().setTexture(&fenceTexture);
+        entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Sprite3DTextured));
+        entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+        entity.addComponent<Sprite3D>(matrixPool).depth = GameConst::FenceHeight;
+        //entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
+        entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
+
+        entity.getComponent<xy::Drawable>().getVertices() = createBillboard(f.start, f.end, entity.getComponent<Sprite3D>().depth, texSize);
+        entity.getComponent<xy::Drawable>().updateLocalBounds();
+
+        entity.addComponent<xy::AudioEmitter>() = audioScape.getEmitter("fence");
+        entity.getComponent<xy::AudioEmitter>().play();
+        entity.addComponent<xy::CommandTarget>().ID = CommandID::Game::Audio;
+    }
+
+    //chevrons
+    const auto& chevrons = m_track.chevrons;
+    const auto& chevronTexture = resources.get<sf::Texture>(textureIDs[TextureID::Game::Chevron]);
+    texSize = sf::Vector2f(chevronTexture.getSize());
+
+    for (const auto& [start, end] : chevrons)
+    {
+        auto entity = m_scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(start);
+        entity.addComponent<xy::Drawable>().setDepth(1000);
+        entity.getComponent<xy::Drawable>().setTexture(&chevronTexture);
+        entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Sprite3DTextured));
+        entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+        entity.addComponent<Sprite3D>(matrixPool).depth = GameConst::ChevronHeight;
+        //entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
+        entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
+
+        entity.getComponent<xy::Drawable>().getVertices() = createBillboard(start, end, entity.getComponent<Sprite3D>().depth, texSize);
+        entity.getComponent<xy::Drawable>().updateLocalBounds();
+    }
+
+    //race barriers
+    const auto& barriers = m_track.barriers;
+    auto& barrierTexture = resources.get<sf::Texture>(textureIDs[TextureID::Game::Barrier]);
+    barrierTexture.setRepeated(true);
+    texSize = sf::Vector2f(barrierTexture.getSize());
+
+    for (const auto& [start, end] : barriers)
+    {
+        auto entity = m_scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(start);
+        entity.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
+        entity.getComponent<xy::Drawable>().setTexture(&barrierTexture);
+        entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Sprite3DTextured));
+        entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+        entity.addComponent<Sprite3D>(matrixPool).depth = GameConst::BarrierHeight;
+        //entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
+        entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
+
+        entity.getComponent<xy::Drawable>().getVertices() = createBillboard(start, end, entity.getComponent<Sprite3D>().depth, { xy::Util::Vector::length(end - start), texSize.y });
+        entity.getComponent<xy::Drawable>().updateLocalBounds();
+    }
+
+    //electric pylons
+    const auto& pylons = m_track.pylons;
+    auto& pylonTexture = resources.get<sf::Texture>(textureIDs[TextureID::Game::Pylon]);
+    texSize = sf::Vector2f(pylonTexture.getSize());
+    for (auto p : pylons)
+    {
+        auto entity = m_scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(p);
+        entity.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
+        entity.getComponent<xy::Drawable>().addGlFlag(GL_DEPTH_TEST);
+        entity.getComponent<xy::Drawable>().setTexture(&pylonTexture);
+        entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Sprite3DTextured));
+        entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+        entity.addComponent<Sprite3D>(matrixPool).depth = GameConst::PylonHeight;
+        //entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
+        entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
+
+        entity.getComponent<xy::Drawable>().getVertices() = createPylon(texSize);
+
+        entity.getComponent<xy::Drawable>().updateLocalBounds();
+    }
+
+
+    //bollards.
+    const auto& bollards = m_track.bollards;
+    auto& bollardTexture = resources.get<sf::Texture>(textureIDs[TextureID::Game::Bollard]);
+    texSize = sf::Vector2f(bollardTexture.getSize());
+    for (auto b : bollards)
+    {
+        auto entity = m_scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(b);
+        entity.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
+        entity.getComponent<xy::Drawable>().addGlFlag(GL_DEPTH_TEST);
+        entity.getComponent<xy::Drawable>().setTexture(&bollardTexture);
+        entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Sprite3DTextured));
+        entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+        entity.addComponent<Sprite3D>(matrixPool).depth = GameConst::BollardHeight;
+        //entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
+        entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
+
+        entity.getComponent<xy::Drawable>().getVertices() = createCylinder(GameConst::BollardRadius, texSize, GameConst::BollardHeight);
+
+        entity.getComponent<xy::Drawable>().updateLocalBounds();
+    }
+
+    //rings around start area
+    auto temp = resources.load<sf::Texture>("assets/images/start_field.png");
+    resources.get<sf::Texture>(temp).setSmooth(true);
+
+    auto entity = m_scene.createEntity();
+    entity.addComponent<xy::Transform>().setPosition(getStartPosition().first);
+    entity.addComponent<xy::Drawable>().setDepth(1000);
+    entity.getComponent<xy::Drawable>().setFilterFlags(GameConst::Normal);
+    entity.getComponent<xy::Drawable>().setTexture(&resources.get<sf::Texture>(temp));
+    entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Sprite3DTextured));
+    entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+    entity.addComponent<Sprite3D>(matrixPool).depth = 50.f;
+    //entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
+    entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
+
+    texSize = sf::Vector2f(entity.getComponent<xy::Drawable>().getTexture()->getSize());
+    entity.getComponent<xy::Drawable>().getVertices() = createStartField(texSize.x, entity.getComponent<Sprite3D>().depth);
+
+    entity.getComponent<xy::Drawable>().updateLocalBounds();
+    entity.addComponent<xy::Callback>().active = true;
+    entity.getComponent<xy::Callback>().function = StartRingAnimator();
+
+    //lap line
+    auto& lapTexture = resources.get<sf::Texture>(textureIDs[TextureID::Game::LapLine]);
+    texSize = sf::Vector2f(lapTexture.getSize());
+
+    sf::Vector2f offset = xy::Util::Vector::rotate({ GameConst::LapArchOffset, 0.f }, getStartPosition().second);
+
+    entity = m_scene.createEntity();
+    entity.addComponent<xy::Transform>().setPosition(getStartPosition().first + offset);
+    entity.getComponent<xy::Transform>().setRotation(getStartPosition().second);
+    entity.addComponent<xy::Drawable>().setDepth(1000);
+    entity.getComponent<xy::Drawable>().addGlFlag(GL_DEPTH_TEST);
+    entity.getComponent<xy::Drawable>().setTexture(&lapTexture);
+    entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Sprite3DTextured));
+    entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+    entity.addComponent<Sprite3D>(matrixPool).depth = texSize.y / 2.f;
+    //entity.getComponent<xy::Drawable>().bindUniform("u_viewProjMat", &cameraEntity.getComponent<Camera3D>().viewProjectionMatrix[0][0]);
+    entity.getComponent<xy::Drawable>().bindUniform("u_modelMat", &entity.getComponent<Sprite3D>().getMatrix()[0][0]);
+
+    entity.getComponent<xy::Drawable>().getVertices() = createLapLine();
+
+    entity.getComponent<xy::Drawable>().updateLocalBounds();
+    entity.addComponent<xy::CommandTarget>().ID = CommandID::Game::LapLine;
+}
+
+//private
+void MapParser::renderLayer(sf::RenderTarget& target, const std::vector<std::uint32_t>& tiles, const std::vector<std::unique_ptr<sf::Texture>>& textures) const
+{
+    XY_ASSERT(!tiles.empty(), "Map not correctly loaded!");
+    
+    sf::IntRect textureRect(0, 0, (m_track.tileSize.x), (m_track.tileSize.y));
+    sf::Sprite tileSprite;
+
+    //render layer
+    const auto& tileSets = m_track.tileSets;
+
+    for (auto y = 0u; y < m_track.tileCount.y; ++y)
+    {
+        for (auto x = 0u; x < m_track.tileCount.x; ++x)
+        {
+            auto posX = static_cast<float>(x * m_track.tileSize.x);
+            auto posY = static_cast<float>(y * m_track.tileSize.y);
+            sf::Vector2f position(posX, posY);
+
+            tileSprite.setPosition(position);
+
+            auto tileID = tiles[y * m_track.tileCount.x + x];
+
+            if (tileID == 0)
+            {
+                continue; //empty tile
+            }
+
+            std::size_t i = 0;
+            for (; i < tileSets.size(); ++i)
+            {
+                if (tileID >= tileSets[i].firstGID && tileID <= tileSets[i].lastGID)
+                {
+                    break;
+                }
+            }
+
+            auto relativeID = tileID - tileSets[i].firstGID;
+            auto tileX = relativeID % tileSets[i].columnCount;
+            auto tileY = relativeID / tileSets[i].columnCount;
+            textureRect.left = tileX * tileSets[i].tileSize.x;
+            textureRect.top = tileY * tileSets[i].tileSize.y;
+
+            tileSprite.setTexture(*textures[i]);
+            tileSprite.setTextureRect(textureRect);
+
+            target.draw(tileSprite);
+        }
+    }
+}
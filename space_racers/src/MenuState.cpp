@@ -36,8 +36,15 @@ source distribution.
 #include "GameConsts.hpp"
 #include "DigitSystem.hpp"
 #include "InputPreviewSystem.hpp"
+#include "CollisionBench.hpp"
+#include "SimulationCheck.hpp"
+#include "NetworkBench.hpp"
+#include "GhostCheck.hpp"
+#include "TrackCheck.hpp"
+#include "TrailBench.hpp"
 
 #include <xyginext/core/Log.hpp>
+#include <xyginext/core/Console.hpp>
 #include <xyginext/gui/Gui.hpp>
 
 #include <xyginext/ecs/components/Transform.hpp>
@@ -125,6 +132,162 @@ MenuState::MenuState(xy::StateStack& ss, xy::State::Context ctx, SharedData& sd)
             requestStackPush(StateID::Debug);
         });
 
+#ifdef XY_DEBUG
+    //races 8 AI cars around a map for a minute and measures the time spent
+    //in collision detection each tick, eg collision_bench assets/maps/SpaceRace.tmx
+    registerCommand("collision_bench",
+        [](const std::string& param)
+        {
+            auto result = param.empty() ? runCollisionBench() : runCollisionBench(param);
+            if (!result.loaded)
+            {
+                xy::Console::print("Failed to load " + param);
+                return;
+            }
+            xy::Console::print("Collision: " + std::to_string(result.collisionTime) + "us per tick, peak " + std::to_string(result.collisionPeak) + "us");
+            xy::Console::print(std::to_string(result.staticCount) + " static objects, " + std::to_string(result.respawnCount) + " respawns");
+        });
+
+    //compares the scalar and SIMD separating axis tests on random polygons
+    registerCommand("sat_bench",
+        [](const std::string&)
+        {
+            auto result = runSatBench();
+            xy::Console::print(std::to_string(result.mismatchCount) + " of " + std::to_string(result.pairCount) + " pairs differ, " + std::to_string(result.intersectCount) + " intersect");
+            xy::Console::print("Scalar: " + std::to_string(result.scalarRate) + " pairs/us");
+            xy::Console::print(std::string(result.simdEnabled ? "SSE2: " : "SSE2 (disabled): ") + std::to_string(result.simdRate) + " pairs/us, "
+                + std::to_string(result.cachedRate) + " pairs/us with cached axes");
+        });
+
+    //measures the server tick time for 50, 200 and 1000 asteroids
+    //eg asteroid_bench assets/maps/SpaceRace.tmx
+    registerCommand("asteroid_bench",
+        [](const std::string& param)
+        {
+            for (auto count : { 50u, 200u, 1000u })
+            {
+                auto result = param.empty() ? runAsteroidBench(count) : runAsteroidBench(count, param);
+                if (!result.loaded)
+                {
+                    xy::Console::print("Failed to load " + param);
+                    return;
+                }
+                xy::Console::print(std::to_string(count) + " roids: " + std::to_string(result.tickTime) + "us per tick, peak "
+                    + std::to_string(result.tickPeak) + "us, " + std::to_string(result.collisionCount) + " collisions per tick");
+            }
+        });
+
+    //runs a race several times and checks the vehicles always end up
+    //in exactly the same state, eg simulation_check assets/maps/SpaceRace.tmx
+    registerCommand("simulation_check",
+        [](const std::string& param)
+        {
+            auto result = param.empty() ? runSimulationCheck() : runSimulationCheck(param);
+            if (!result.loaded)
+            {
+                xy::Console::print("Failed to load " + param);
+                return;
+            }
+
+            xy::Console::print(std::to_string(result.tickCount) + " ticks, final hash " + std::to_string(result.finalHash));
+            xy::Console::print(result.replayMismatch == 0 ? "Replay: identical"
+                : "Replay: differs from tick " + std::to_string(result.replayMismatch));
+            xy::Console::print(result.clientMismatch == 0 ? "Client: identical after " + std::to_string(result.reconcileCount) + " reconciliations"
+                : "Client: differs from tick " + std::to_string(result.clientMismatch));
+        });
+
+    //round trips an AI lap and any saved time trial ghosts through the
+    //ghost format, eg ghost_check assets/maps/SpaceRace.tmx
+    registerCommand("ghost_check",
+        [](const std::string& param)
+        {
+            auto result = param.empty() ? runGhostCheck() : runGhostCheck(param);
+            if (!result.loaded)
+            {
+                xy::Console::print("Failed to load " + param);
+                return;
+            }
+
+            xy::Console::print(std::to_string(result.failCount) + " of " + std::to_string(result.lapCount) + " laps failed, "
+                + std::to_string(result.pointCount) + " points");
+            xy::Console::print("Max error: " + std::to_string(result.positionError) + "px, " + std::to_string(result.rotationError) + " degrees, "
+                + std::to_string(result.scaleError) + " scale");
+            xy::Console::print(std::to_string(result.encodedSize) + " bytes, was " + std::to_string(result.rawSize) + " bytes");
+        });
+
+    //loads a map from its tmx file and from the baked track cache, and
+    //compares the results, eg track_check assets/maps/SpaceRace.tmx
+    registerCommand("track_check",
+        [](const std::string& param)
+        {
+            auto result = param.empty() ? runTrackCheck() : runTrackCheck(param);
+            if (!result.loaded)
+            {
+                xy::Console::print("Failed to load " + param);
+                return;
+            }
+
+            xy::Console::print(std::to_string(result.mismatchCount) + " of " + std::to_string(result.entityCount) + " entities differ, track data "
+                + (result.dataMatches ? "matches" : "DIFFERS") + (result.cacheUsed ? "" : ", cache was NOT used"));
+            xy::Console::print("Load time: " + std::to_string(result.parseTime) + "ms parsed, " + std::to_string(result.cacheTime) + "ms cached");
+            xy::Console::print("Cache size: " + std::to_string(result.cacheSize) + " bytes");
+        });
+
+    //drives 8 vehicles in circles and measures the bytes written
+    //to the trail and skid mark vertex batches each frame
+    registerCommand("trail_bench",
+        [](const std::string&)
+        {
+            auto result = runTrailBench();
+            xy::Console::print("Bytes per frame: " + std::to_string(result.trailBytes) + " trails, " + std::to_string(result.skidBytes) + " skids, "
+                + std::to_string(result.rebuildBytes) + " to rebuild both");
+            xy::Console::print(std::to_string(result.vertexCount) + " vertices in 2 batches");
+        });
+
+    //compares the size of actor snapshots with the separate update packets
+    //they replace, eg snapshot_bench assets/maps/SpaceRace.tmx
+    registerCommand("snapshot_bench",
+        [](const std::string& param)
+        {
+            auto result = param.empty() ? runSnapshotBench() : runSnapshotBench(param);
+            if (!result.loaded)
+            {
+                xy::Console::print("Failed to load " + param);
+                return;
+            }
+
+            xy::Console::print(std::to_string(result.actorCount) + " actors, " + std::to_string(result.mismatchCount) + " of " + std::to_string(result.snapshotCount) + " snapshots read back incorrectly");
+            xy::Console::print("Bytes per tick: " + std::to_string(result.updateBytes) + " as updates, " + std::to_string(result.fullBytes) + " full, "
+                + std::to_string(result.deltaBytes) + " delta");
+        });
+
+    //sends input batches to a server which loses packets at the given
+    //rate and checks it ends up with the same input, eg input_bench 0.2
+    registerCommand("input_bench",
+        [](const std::string& param)
+        {
+            float loss = 0.1f;
+            if (!param.empty())
+            {
+                try
+                {
+                    loss = std::stof(param);
+                }
+                catch (...)
+                {
+                    xy::Console::print(param + ": not a valid loss rate");
+                    return;
+                }
+            }
+
+            auto result = runInputBench(10000, loss);
+            xy::Console::print(std::to_string(result.lostCount) + " of " + std::to_string(result.packetCount) + " packets lost, "
+                + std::to_string(result.missingCount) + " of " + std::to_string(result.inputCount) + " inputs missing, " + std::to_string(result.mismatchCount) + " differ");
+            xy::Console::print(std::to_string(result.packetBytes) + " bytes per packet, " + std::to_string(result.bytesPerSecond) + " bytes/s ("
+                + std::to_string(result.updateBytesPerSecond) + " bytes/s with an update per input)");
+        });
+#endif
+
     registerConsoleTab("About",
         []()
         {
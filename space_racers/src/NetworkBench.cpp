@@ -0,0 +1,409 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "NetworkBench.hpp"
+#include "Snapshot.hpp"
+#include "BitStream.hpp"
+#include "InputBatch.hpp"
+#include "ServerPackets.hpp"
+#include "CollisionObject.hpp"
+#include "VehicleSystem.hpp"
+#include "VehicleDefs.hpp"
+#include "AIDriverSystem.hpp"
+#include "AsteroidSystem.hpp"
+#include "NetActor.hpp"
+#include "ActorIDs.hpp"
+#include "MapParser.hpp"
+#include "MessageIDs.hpp"
+#include "GameConsts.hpp"
+#include "WayPoint.hpp"
+
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/BroadPhaseComponent.hpp>
+#include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
+#include <xyginext/util/Random.hpp>
+#include <xyginext/util/Vector.hpp>
+
+#include <algorithm>
+#include <deque>
+#include <random>
+
+namespace
+{
+    const float TickTime = 1.f / 60.f; //same as the server
+    const std::size_t NetTickRate = 2; //ticks per network update
+    const std::size_t PacketHeaderSize = 1; //packet ID
+    const std::size_t InputUpdateSize = 16; //the packet which used to be sent for each input
+    const std::size_t RoidUpdateSize = 24; //the packet which used to be sent for each roid
+
+    bool sameActor(const ActorSnapshot& a, const ActorSnapshot& b)
+    {
+        return a.x == b.x && a.y == b.y
+            && a.velX == b.velX && a.velY == b.velY
+            && a.rotation == b.rotation
+            && a.lastInput == b.lastInput
+            && a.serverID == b.serverID
+            && a.stateFlags == b.stateFlags
+            && a.vehicle == b.vehicle;
+    }
+
+    bool sameInput(const Input& a, const Input& b)
+    {
+        return a.timestamp == b.timestamp
+            && a.flags == b.flags
+            && a.steeringMultiplier == b.steeringMultiplier
+            && a.accelerationMultiplier == b.accelerationMultiplier;
+    }
+
+    //reads a packet into the vehicle, and copies any new inputs into the received list
+    void receiveInput(const std::vector<std::uint8_t>& packet, Vehicle& vehicle, std::vector<Input>& received)
+    {
+        BitReader reader(packet.data(), packet.size());
+        auto count = InputBatch::read(reader, vehicle);
+
+        auto idx = (vehicle.currentInput + vehicle.history.size() - count) % vehicle.history.size();
+        while (count--)
+        {
+            received.push_back(vehicle.history[idx]);
+            idx = (idx + 1) % vehicle.history.size();
+        }
+    }
+}
+
+SnapshotBenchResult runSnapshotBench(const std::string& map, std::size_t vehicleCount, float duration, std::size_t ackDelay)
+{
+    SnapshotBenchResult result;
+
+    xy::MessageBus messageBus;
+    xy::Scene scene(messageBus);
+    scene.addSystem<AIDriverSystem>(messageBus);
+    scene.addSystem<VehicleSystem>(messageBus);
+    scene.addSystem<AsteroidSystem>(messageBus);
+    scene.addSystem<NetActorSystem>(messageBus);
+    scene.addSystem<xy::DynamicTreeSystem>(messageBus);
+
+    MapParser mapParser(scene);
+    if (!mapParser.load(map))
+    {
+        return result;
+    }
+    result.loaded = true;
+
+    SnapshotQuantiser quantiser;
+    quantiser.setMapSize(mapParser.getSize());
+
+    //create the roids as the server does
+    auto bounds = quantiser.getBounds();
+    scene.getSystem<AsteroidSystem>().setMapSize(bounds);
+    scene.getSystem<AsteroidSystem>().setSpawnPosition(mapParser.getStartPosition().first);
+
+    auto positions = xy::Util::Random::poissonDiscDistribution(bounds, 1200, 2);
+    for (auto position : positions)
+    {
+        auto entity = scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(position);
+
+        sf::Vector2f velocity = { xy::Util::Random::value(-1.f, 1.f), xy::Util::Random::value(-1.f, 1.f) };
+        entity.addComponent<Asteroid>().setVelocity(xy::Util::Vector::normalise(velocity) * xy::Util::Random::value(200.f, 300.f));
+
+        sf::FloatRect aabb(0.f, 0.f, 100.f, 100.f);
+        auto radius = aabb.width / 2.f;
+        entity.getComponent<xy::Transform>().setOrigin(radius, radius);
+        auto scale = xy::Util::Random::value(0.5f, 2.5f);
+        entity.getComponent<xy::Transform>().setScale(scale, scale);
+        entity.getComponent<Asteroid>().setRadius(radius * scale);
+
+        entity.addComponent<xy::BroadphaseComponent>().setArea(aabb);
+        entity.getComponent<xy::BroadphaseComponent>().setFilterFlags(CollisionFlags::Asteroid);
+        entity.addComponent<NetActor>().actorID = ActorID::Roid;
+        entity.getComponent<NetActor>().serverID = entity.getIndex();
+
+        entity.addComponent<CollisionObject>().type = CollisionObject::Type::Roid;
+        entity.getComponent<CollisionObject>().applyVertices(createCollisionCircle(radius * 0.9f, { radius, radius }));
+    }
+
+    //line the cars up on the grid in rows of 4
+    auto [position, rotation] = mapParser.getStartPosition();
+    sf::Transform offsetTransform;
+    offsetTransform.rotate(rotation);
+
+    xy::Entity clientVehicle;
+    for (auto i = 0u; i < vehicleCount; ++i)
+    {
+        auto offset = GameConst::SpawnPositions[i % GameConst::SpawnPositions.size()];
+        offset.x -= GameConst::CarSize.width * 1.5f * static_cast<float>(i / GameConst::SpawnPositions.size());
+
+        auto entity = scene.createEntity();
+        entity.addComponent<xy::Transform>().setPosition(position + offsetTransform.transformPoint(offset));
+        entity.getComponent<xy::Transform>().setRotation(rotation);
+        entity.addComponent<Vehicle>().waypointCount = mapParser.getWaypointCount();
+        entity.getComponent<Vehicle>().settings = Definition::car;
+        entity.getComponent<Vehicle>().stateFlags = (1 << Vehicle::Normal);
+        entity.addComponent<CollisionObject>().type = CollisionObject::Vehicle;
+        entity.getComponent<CollisionObject>().applyVertices(GameConst::CarPoints);
+        entity.addComponent<xy::BroadphaseComponent>().setArea(GameConst::CarSize);
+        entity.getComponent<xy::BroadphaseComponent>().setFilterFlags(CollisionFlags::Vehicle);
+        entity.addComponent<NetActor>().actorID = ActorID::Car;
+        entity.getComponent<NetActor>().serverID = entity.getIndex();
+        entity.addComponent<AIDriver>().target = position;
+        entity.getComponent<AIDriver>().skill = static_cast<AIDriver::Skill>(i % 3);
+
+        if (i == 0)
+        {
+            clientVehicle = entity;
+        }
+    }
+    result.actorCount = positions.size() + vehicleCount;
+
+    SnapshotEncoder encoder;
+    SnapshotDecoder decoder;
+    BitWriter writer;
+    std::deque<std::pair<std::size_t, std::uint16_t>> acks; //net tick to arrive, snapshot ID
+
+    std::size_t updateBytes = 0;
+    std::size_t fullBytes = 0;
+    std::size_t deltaBytes = 0;
+    std::size_t netTick = 0;
+
+    const auto totalTicks = static_cast<std::size_t>(duration / TickTime);
+    for (auto tick = 0u; tick < totalTicks; ++tick)
+    {
+        scene.update(TickTime);
+
+        while (!messageBus.empty())
+        {
+            const auto& msg = messageBus.poll();
+            scene.forwardMessage(msg);
+
+            if (msg.id == MessageID::VehicleMessage)
+            {
+                const auto& data = msg.getData<VehicleEvent>();
+                if (data.type == VehicleEvent::RequestRespawn)
+                {
+                    auto entity = data.entity;
+                    auto& vehicle = entity.getComponent<Vehicle>();
+                    auto& tx = entity.getComponent<xy::Transform>();
+
+                    vehicle.velocity = {};
+                    vehicle.anglularVelocity = {};
+                    vehicle.stateFlags = (1 << Vehicle::Normal);
+                    vehicle.invincibleTime = GameConst::InvincibleTime;
+
+                    if (vehicle.currentWaypoint.isValid())
+                    {
+                        tx.setPosition(vehicle.currentWaypoint.getComponent<xy::Transform>().getPosition());
+                        tx.setRotation(vehicle.currentWaypoint.getComponent<WayPoint>().rotation);
+                    }
+                    else
+                    {
+                        tx.setPosition(position);
+                        tx.setRotation(rotation);
+                    }
+                    tx.setScale(1.f, 1.f);
+                }
+            }
+        }
+
+        //the first tick adds everything to the scene
+        if (tick == 0 || (tick % NetTickRate) != 0)
+        {
+            continue;
+        }
+
+        const auto& actors = scene.getSystem<NetActorSystem>().getActors();
+        auto timestamp = static_cast<std::int32_t>(tick * TickTime * 1000.f);
+        auto snapshot = quantiser.quantise(actors, timestamp);
+
+        //the old packets went to every client, including its own vehicle
+        for (auto actor : actors)
+        {
+            updateBytes += PacketHeaderSize +
+                (actor.getComponent<NetActor>().actorID == ActorID::Roid ? RoidUpdateSize : sizeof(VehicleActorUpdate));
+        }
+
+        const auto serverID = clientVehicle.getIndex();
+        snapshot.actors.erase(std::remove_if(snapshot.actors.begin(), snapshot.actors.end(),
+            [serverID](const ActorSnapshot& actor)
+            {
+                return actor.serverID == serverID;
+            }), snapshot.actors.end());
+
+        {
+            SnapshotEncoder fullEncoder;
+            auto fullSnapshot = snapshot;
+            writer.clear();
+            fullEncoder.write(fullSnapshot, quantiser, writer);
+            fullBytes += PacketHeaderSize + writer.getData().size();
+        }
+
+        writer.clear();
+        encoder.write(snapshot, quantiser, writer);
+        deltaBytes += PacketHeaderSize + writer.getData().size();
+
+        BitReader reader(writer.getData().data(), writer.getData().size());
+        Snapshot received;
+        if (decoder.read(reader, quantiser, received)
+            && received.id == snapshot.id
+            && received.timestamp == snapshot.timestamp
+            && std::equal(received.actors.begin(), received.actors.end(), snapshot.actors.begin(), snapshot.actors.end(), sameActor))
+        {
+            acks.emplace_back(netTick + ackDelay, received.id);
+        }
+        else
+        {
+            result.mismatchCount++;
+        }
+
+        while (!acks.empty() && acks.front().first <= netTick)
+        {
+            encoder.acknowledge(acks.front().second);
+            acks.pop_front();
+        }
+
+        netTick++;
+    }
+
+    if (netTick)
+    {
+        result.snapshotCount = netTick;
+        result.updateBytes = static_cast<float>(updateBytes) / netTick;
+        result.fullBytes = static_cast<float>(fullBytes) / netTick;
+        result.deltaBytes = static_cast<float>(deltaBytes) / netTick;
+    }
+
+    return result;
+}
+
+InputBenchResult runInputBench(std::size_t stepCount, float packetLoss, std::size_t packetInterval)
+{
+    InputBenchResult result;
+
+    std::mt19937 rng(GameConst::BenchSeed);
+    std::uniform_real_distribution<float> chance(0.f, 1.f);
+
+    InputBatch batch;
+    BitWriter writer;
+    std::int32_t timestamp = 0;
+    Input input;
+
+    Vehicle reliableServer;
+    Vehicle lossyServer;
+    std::vector<Input> reliableInputs;
+    std::vector<Input> lossyInputs;
+
+    std::vector<std::pair<std::size_t, std::vector<std::uint8_t>>> inFlight; //step to arrive, packet
+    std::size_t totalBytes = 0;
+
+    for (auto step = 0u; step < stepCount; ++step)
+    {
+        //hold each input for a while, like a player does
+        if (chance(rng) < 0.05f)
+        {
+            input.flags = static_cast<std::int16_t>(rng() % 32);
+        }
+        if (chance(rng) < 0.02f)
+        {
+            input.steeringMultiplier = InputBatch::quantiseMultiplier(chance(rng));
+        }
+        if (chance(rng) < 0.02f)
+        {
+            input.accelerationMultiplier = InputBatch::quantiseMultiplier(chance(rng));
+        }
+        timestamp += Vehicle::StepMicroseconds;
+        input.timestamp = timestamp;
+
+        batch.push(input);
+        result.inputCount++;
+
+        if ((step + 1) % packetInterval == 0)
+        {
+            writer.clear();
+            batch.write(writer);
+            totalBytes += PacketHeaderSize + writer.getData().size();
+            result.packetCount++;
+
+            receiveInput(writer.getData(), reliableServer, reliableInputs);
+
+            if (chance(rng) < packetLoss)
+            {
+                result.lostCount++;
+            }
+            else
+            {
+                inFlight.emplace_back(step + (rng() % 3), writer.getData());
+            }
+        }
+
+        //deliver in order of arrival
+        std::stable_sort(inFlight.begin(), inFlight.end(),
+            [](const std::pair<std::size_t, std::vector<std::uint8_t>>& a, const std::pair<std::size_t, std::vector<std::uint8_t>>& b)
+            {
+                return a.first < b.first;
+            });
+
+        auto arrived = std::find_if(inFlight.begin(), inFlight.end(),
+            [step](const std::pair<std::size_t, std::vector<std::uint8_t>>& packet)
+            {
+                return packet.first > step;
+            });
+
+        for (auto packet = inFlight.begin(); packet != arrived; ++packet)
+        {
+            receiveInput(packet->second, lossyServer, lossyInputs);
+        }
+        inFlight.erase(inFlight.begin(), arrived);
+    }
+
+    for (const auto& packet : inFlight)
+    {
+        receiveInput(packet.second, lossyServer, lossyInputs);
+    }
+
+    //the lossy history should be the same as the reliable one
+    //but it may have gaps if every packet with an input was lost
+    auto lossy = lossyInputs.cbegin();
+    for (const auto& reliable : reliableInputs)
+    {
+        if (lossy != lossyInputs.cend() && lossy->timestamp == reliable.timestamp)
+        {
+            if (!sameInput(*lossy, reliable))
+            {
+                result.mismatchCount++;
+            }
+            ++lossy;
+        }
+        else
+        {
+            result.missingCount++;
+        }
+    }
+    //anything left over is out of order or duplicated
+    result.mismatchCount += std::distance(lossy, lossyInputs.cend());
+
+    if (result.packetCount)
+    {
+        const float seconds = static_cast<float>(stepCount) * Vehicle::StepTime;
+        result.packetBytes = static_cast<float>(totalBytes) / result.packetCount;
+        result.bytesPerSecond = static_cast<float>(totalBytes) / seconds;
+        result.updateBytesPerSecond = static_cast<float>((PacketHeaderSize + InputUpdateSize) * stepCount) / seconds;
+    }
+
+    return result;
+}
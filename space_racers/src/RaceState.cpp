@@ -41,8 +41,10 @@ Copyright 2019 Matt Marchant
 #include "VertexFunctions.hpp"
 #include "NixieDisplay.hpp"
 #include "SkidEffectSystem.hpp"
+#include "VehicleEffects.hpp"
 #include "EngineAudioSystem.hpp"
 #include "SoundEffectsDirector.hpp"
+#include "BitStream.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 
@@ -355,7 +357,7 @@ void RaceState::loadResources()
     m_shaders.preload(ShaderID::Globe, GlobeFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Asteroid, GlobeFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Vehicle, VehicleVertex, VehicleFrag);
-    m_shaders.preload(ShaderID::Trail, VehicleTrail, sf::Shader::Fragment);
+    loadVehicleEffectShaders(m_shaders);
     m_shaders.preload(ShaderID::Lightbar, LightbarFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Shield, ShieldFragment, sf::Shader::Fragment);
 
@@ -393,6 +395,7 @@ void RaceState::buildWorld()
     bounds.height += 2000.f;
     m_gameScene.getSystem<AsteroidSystem>().setMapSize(bounds);
     m_gameScene.getSystem<AsteroidSystem>().setSpawnPosition(m_mapParser.getStartPosition().first);
+    m_snapshotQuantiser.setMapSize(m_mapParser.getSize());
 
     m_mapParser.renderLayers(m_trackTextures);
     m_renderPath.setNormalTexture(m_trackTextures[GameConst::TrackLayer::Normal].getTexture());
@@ -432,6 +435,8 @@ void RaceState::buildWorld()
     m_gameScene.setActiveCamera(camEnt);
     m_gameScene.setActiveListener(camEnt);
 
+    createVehicleEffectBatches(m_gameScene, m_shaders, m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
+
     //dem starrs
     std::array<std::size_t, 3u> IDs =
     {
@@ -663,11 +668,8 @@ void RaceState::handlePackets()
             case PacketID::ActorData:
                 spawnActor(packet.as<ActorData>());
                 break;
-            case PacketID::ActorUpdate:
-                updateActor(packet.as<ActorUpdate>());
-                break;
-            case PacketID::VehicleActorUpdate:
-                updateActor(packet.as<VehicleActorUpdate>());
+            case PacketID::Snapshot:
+                readSnapshot(packet.getData(), packet.getSize());
                 break;
             case PacketID::DebugPosition:
                 /*if (debugEnt.isValid())
@@ -732,7 +734,6 @@ void RaceState::spawnVehicle(const VehicleData& data)
         {
             auto skidEntity = m_gameScene.createEntity();
             skidEntity.addComponent<xy::Transform>();
-            skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
             skidEntity.addComponent<SkidEffect>().parent = entity;
         }
         break;
@@ -745,7 +746,6 @@ void RaceState::spawnVehicle(const VehicleData& data)
         {
             auto skidEntity = m_gameScene.createEntity();
             skidEntity.addComponent<xy::Transform>();
-            skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
             skidEntity.addComponent<SkidEffect>().parent = entity;
             skidEntity.getComponent<SkidEffect>().wheelCount = 1;
         }
@@ -847,7 +847,6 @@ void RaceState::spawnActor(const ActorData& data)
         {
             auto skidEntity = m_gameScene.createEntity();
             skidEntity.addComponent<xy::Transform>();
-            skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
             skidEntity.addComponent<SkidEffect>().parent = entity;
         }
 
@@ -867,7 +866,6 @@ void RaceState::spawnActor(const ActorData& data)
         {
             auto skidEntity = m_gameScene.createEntity();
             skidEntity.addComponent<xy::Transform>();
-            skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
             skidEntity.addComponent<SkidEffect>().parent = entity;
             skidEntity.getComponent<SkidEffect>().wheelCount = 1;
         }
@@ -1002,6 +1000,22 @@ void RaceState::spawnActor(const ActorData& data)
     m_sharedData.gameData.actorCount--;
 }
 
+void RaceState::readSnapshot(const void* data, std::size_t size)
+{
+    BitReader reader(data, size);
+    Snapshot snapshot;
+    if (m_snapshotDecoder.read(reader, m_snapshotQuantiser, snapshot))
+    {
+        //lets the server delta encode the next snapshot against this one
+        m_sharedData.netClient->sendPacket(PacketID::SnapshotAck, snapshot.id, xy::NetFlag::Unreliable);
+
+        for (const auto& actor : snapshot.actors)
+        {
+            updateActor(m_snapshotQuantiser.dequantise(actor, snapshot.timestamp));
+        }
+    }
+}
+
 void RaceState::updateActor(const VehicleActorUpdate& update)
 {
     xy::Command cmd;
@@ -1168,10 +1182,6 @@ void RaceState::spawnTrail(xy::Entity parent, sf::Color colour)
 {
     auto trailEnt = m_gameScene.createEntity();
     trailEnt.addComponent<xy::Transform>();
-    trailEnt.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
-    trailEnt.getComponent<xy::Drawable>().setTexture(&m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
-    trailEnt.getComponent<xy::Drawable>().setShader(&m_shaders.get(ShaderID::Trail));
-    trailEnt.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
     trailEnt.addComponent<Trail>().parent = parent;
     trailEnt.getComponent<Trail>().colour = colour;
     trailEnt.addComponent<xy::CommandTarget>().ID = CommandID::Game::Trail;
@@ -37,8 +37,14 @@ namespace
 }
 
 Server::Server()
-    : m_running    (false),
-    m_thread    (&Server::threadFunc, this)
+    : m_running     (false),
+    m_port          (NetConst::Port),
+    m_dedicated     (false),
+    m_tickCount     (0),
+    m_lastTickTime  (0),
+    m_lastNetTime   (0),
+    m_peakTickTime  (0),
+    m_thread        (&Server::threadFunc, this)
 {
     registerStates();
 }
@@ -49,13 +55,24 @@ Server::~Server()
 }
 
 //public
-void Server::run(std::int32_t firstState)
+bool Server::run(std::int32_t firstState)
 {
     if (!m_running)
     {
-        m_activeState = m_stateFactory[firstState]();
-        m_thread.launch();
+        //start the host here rather than on the server thread
+        //so that the caller knows if it failed
+        m_running = m_sharedData.netHost.start("", m_port, 4, 2);
+        if (m_running)
+        {
+            m_activeState = m_stateFactory[firstState]();
+            m_thread.launch();
+        }
+        else
+        {
+            xy::Logger::log("Failed to start server on port " + std::to_string(m_port), xy::Logger::Type::Error);
+        }
     }
+    return m_running;
 }
 
 void Server::quit()
@@ -73,8 +90,6 @@ void Server::threadFunc()
 {
     LOG("Server launched!", xy::Logger::Type::Info);
 
-    m_running = m_sharedData.netHost.start("", NetConst::Port, 4, 2);
-
     m_netClock.restart();
     m_netAccumulator = sf::Time::Zero;
 
@@ -122,7 +137,7 @@ void Server::threadFunc()
                     }),
                     m_sharedData.clients.end());
 
-                if (m_sharedData.clients.empty())
+                if (m_sharedData.clients.empty() && !m_dedicated)
                 {
                     LOG("Dropped all clients, server quitting...", xy::Logger::Type::Info);
                     m_running = false;
@@ -142,8 +157,10 @@ void Server::threadFunc()
         while (m_netAccumulator > NetTime)
         {
             //do net update
+            sf::Clock tickClock;
             m_activeState->netUpdate(NetTime.asSeconds());
             m_netAccumulator -= NetTime;
+            m_lastNetTime = tickClock.getElapsedTime().asMicroseconds();
 
             for (const auto& [p,t] : m_timeoutClocks)
             {
@@ -171,6 +188,7 @@ void Server::threadFunc()
         m_updateAccumulator += m_updateClock.restart();
         while (m_updateAccumulator > UpdateTime)
         {
+            sf::Clock tickClock;
             while (!m_messageBus.empty())
             {
                 m_activeState->handleMessage(m_messageBus.poll());
@@ -180,6 +198,14 @@ void Server::threadFunc()
             stateResult = m_activeState->logicUpdate(UpdateTime.asSeconds());
             m_updateAccumulator -= UpdateTime;
 
+            const auto tickTime = tickClock.getElapsedTime().asMicroseconds();
+            m_lastTickTime = tickTime;
+            if (tickTime > m_peakTickTime)
+            {
+                m_peakTickTime = tickTime;
+            }
+            m_tickCount++;
+
             updateCount++;
         }
 
@@ -32,6 +32,7 @@ Copyright 2019 Matt Marchant
 #include "MessageIDs.hpp"
 #include "WayPoint.hpp"
 #include "AIDriverSystem.hpp"
+#include "InputBatch.hpp"
 
 #include <xyginext/network/NetData.hpp>
 #include <xyginext/ecs/components/Transform.hpp>
@@ -170,11 +171,14 @@ void RaceState::handleNetEvent(const xy::NetEvent& evt)
             sendPlayerData(evt.peer);
             break;
         case PacketID::ClientInput:
-            updatePlayerInput(m_players[evt.peer.getID()].entity, packet.as<InputUpdate>());
+            updatePlayerInput(m_players[evt.peer.getID()].entity, packet.getData(), packet.getSize());
             break;
         case PacketID::ClientReady:
             m_players[evt.peer.getID()].ready = true;
             break;
+        case PacketID::SnapshotAck:
+            m_players[evt.peer.getID()].snapshots.acknowledge(packet.as<std::uint16_t>());
+            break;
         }
     }
     else if (evt.type == xy::NetEvent::ClientDisconnect)
@@ -231,68 +235,36 @@ void RaceState::netUpdate(float)
         cu.velX = vehicle.velocity.x;
         cu.velY = vehicle.velocity.y;
         cu.velRot = vehicle.anglularVelocity;
+        cu.accelerationMultiplier = vehicle.accelerationMultiplier;
         cu.clientTimestamp = vehicle.history[vehicle.lastUpdatedInput].timestamp;
         cu.collisionFlags = vehicle.collisionFlags;
         cu.stateFlags = vehicle.stateFlags;
         m_sharedData.netHost.sendPacket(p.second.peer, PacketID::ClientUpdate, cu, xy::NetFlag::Unreliable);
-
-        //send actor updates only for visible
-        /*sf::FloatRect queryBounds = { tx.getPosition() - (xy::DefaultSceneSize / 2.f), xy::DefaultSceneSize };
-        auto actors = m_scene.getSystem<xy::DynamicTreeSystem>().query(queryBounds, CollisionFlags::Vehicle | CollisionFlags::Asteroid);
-        for (auto actor : actors)
-        {
-            const auto& tx = actor.getComponent<xy::Transform>();
-            auto velocity = actor.getComponent<NetActor>().velocity;
-
-            ActorUpdate au;
-            au.serverID = static_cast<std::uint16_t>(actor.getIndex());
-            au.rotation = tx.getRotation();
-            au.x = tx.getPosition().x;
-            au.y = tx.getPosition().y;
-            au.velX = velocity.x;
-            au.velY = velocity.y;
-            au.timestamp = getServerTime();
-
-            m_sharedData.netHost.sendPacket(p.second.peer, PacketID::ActorUpdate, au, xy::NetFlag::Unreliable);
-        }*/
     }
 
-    //broadcast data for each actor
-    const auto& actors = m_scene.getSystem<NetActorSystem>().getActors();
-    for (auto actor : actors)
+    //send the state of every other actor in a single packet to each player
+    auto snapshot = m_snapshotQuantiser.quantise(m_scene.getSystem<NetActorSystem>().getActors(), getServerTime());
+    for (auto& p : m_players)
     {
-        const auto& tx = actor.getComponent<xy::Transform>();
-        auto velocity = actor.getComponent<NetActor>().velocity;
-
-        if (actor.getComponent<NetActor>().actorID == ActorID::Roid)
+        if (!p.second.peer)
         {
-            ActorUpdate au;
-            au.serverID = static_cast<std::uint16_t>(actor.getIndex());
-            au.x = tx.getPosition().x;
-            au.y = tx.getPosition().y;
-            au.velX = velocity.x;
-            au.velY = velocity.y;
-            au.timestamp = getServerTime();
-
-            m_sharedData.netHost.broadcastPacket(PacketID::ActorUpdate, au, xy::NetFlag::Unreliable);
-        }
-        else
-        {
-            VehicleActorUpdate au;
-            au.serverID = static_cast<std::uint16_t>(actor.getIndex());
-            au.rotation = tx.getRotation();
-            au.x = tx.getPosition().x;
-            au.y = tx.getPosition().y;
-            au.velX = velocity.x;
-            au.velY = velocity.y;
-            au.timestamp = getServerTime();
-            au.lastInput = actor.getComponent<NetActor>().lastInput;
-            au.stateFlags = actor.getComponent<Vehicle>().stateFlags;
-
-            m_sharedData.netHost.broadcastPacket(PacketID::VehicleActorUpdate, au, xy::NetFlag::Unreliable);
+            continue; //CPU player
         }
 
+        //the player's own vehicle is updated with the ClientUpdate
+        auto clientSnapshot = snapshot;
+        const auto serverID = p.second.entity.getIndex();
+        clientSnapshot.actors.erase(std::remove_if(clientSnapshot.actors.begin(), clientSnapshot.actors.end(),
+            [serverID](const ActorSnapshot& actor)
+            {
+                return actor.serverID == serverID;
+            }), clientSnapshot.actors.end());
+
+        m_snapshotWriter.clear();
+        p.second.snapshots.write(clientSnapshot, m_snapshotQuantiser, m_snapshotWriter);
 
+        const auto& data = m_snapshotWriter.getData();
+        m_sharedData.netHost.sendPacket(p.second.peer, PacketID::Snapshot, data.data(), data.size(), xy::NetFlag::Unreliable);
     }
 
     //TODO send stats updates such as scores
@@ -418,6 +390,7 @@ bool RaceState::loadMap()
     bounds.height += 2000.f;
     m_scene.getSystem<AsteroidSystem>().setMapSize(bounds);
     m_scene.getSystem<AsteroidSystem>().setSpawnPosition(m_mapParser.getStartPosition().first);
+    m_snapshotQuantiser.setMapSize(m_mapParser.getSize());
 
     //create some roids
     auto positions = xy::Util::Random::poissonDiscDistribution(bounds, 1200, 2);
@@ -585,17 +558,15 @@ void RaceState::sendPlayerData(const xy::NetPeer& peer)
     }
 }
 
-void RaceState::updatePlayerInput(xy::Entity entity, const InputUpdate& iu)
+void RaceState::updatePlayerInput(xy::Entity entity, const void* data, std::size_t size)
 {
-    auto& vehicle = entity.getComponent<Vehicle>();
-
-    Input input; //TODO this is the same as the InputUpdate struct?
-    input.flags = iu.inputFlags;
-    input.timestamp = iu.timestamp;
-    input.steeringMultiplier = iu.steeringMultiplier;
-    input.accelerationMultiplier = iu.accelerationMultiplier;
+    if (!entity.isValid())
+    {
+        return;
+    }
 
-    //update player input history
-    vehicle.history[vehicle.currentInput] = input;
-    vehicle.currentInput = (vehicle.currentInput + 1) % vehicle.history.size();
+    //each packet repeats the most recent inputs, so
+    //only those we haven't yet seen are added to the history
+    BitReader reader(data, size);
+    InputBatch::read(reader, entity.getComponent<Vehicle>());
 }
\ No newline at end of file
@@ -0,0 +1,340 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "SimulationCheck.hpp"
+#include "CollisionObject.hpp"
+#include "VehicleSystem.hpp"
+#include "VehicleDefs.hpp"
+#include "AIDriverSystem.hpp"
+#include "ServerPackets.hpp"
+#include "MapParser.hpp"
+#include "MessageIDs.hpp"
+#include "GameConsts.hpp"
+#include "WayPoint.hpp"
+#include "Util.hpp"
+
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/BroadPhaseComponent.hpp>
+#include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
+
+#include <vector>
+#include <tuple>
+#include <memory>
+
+namespace
+{
+    const std::size_t VehicleCount = 8;
+    const std::size_t ReconcileInterval = 6; //ticks between server updates
+    const std::size_t ReconcileLatency = 4; //age of the server update in ticks
+
+    //hashes the bytes of the value, so that any change
+    //in a float, no matter how small, changes the hash
+    template <typename T>
+    void hashValue(std::uint64_t& hash, const T& value)
+    {
+        hash = fnv1a(&value, sizeof(T), hash);
+    }
+
+    //the state which is corrected by a ClientUpdate
+    void hashPhysics(xy::Entity entity, std::uint64_t& hash)
+    {
+        const auto& tx = entity.getComponent<xy::Transform>();
+        const auto& vehicle = entity.getComponent<Vehicle>();
+
+        hashValue(hash, tx.getPosition().x);
+        hashValue(hash, tx.getPosition().y);
+        hashValue(hash, tx.getRotation());
+        hashValue(hash, vehicle.velocity.x);
+        hashValue(hash, vehicle.velocity.y);
+        hashValue(hash, vehicle.anglularVelocity);
+        hashValue(hash, vehicle.accelerationMultiplier);
+        hashValue(hash, vehicle.stateFlags);
+        hashValue(hash, vehicle.collisionFlags);
+    }
+
+    void hashVehicle(xy::Entity entity, std::uint64_t& hash)
+    {
+        hashPhysics(entity, hash);
+
+        const auto& vehicle = entity.getComponent<Vehicle>();
+        hashValue(hash, entity.getComponent<xy::Transform>().getScale().x);
+        hashValue(hash, vehicle.invincibleTime);
+        hashValue(hash, vehicle.respawnTime);
+        hashValue(hash, vehicle.totalDistance);
+    }
+
+    struct Simulation final
+    {
+        explicit Simulation(bool ai)
+            : scene(messageBus),
+            mapParser(scene)
+        {
+            if (ai)
+            {
+                scene.addSystem<AIDriverSystem>(messageBus);
+            }
+            scene.addSystem<VehicleSystem>(messageBus);
+            scene.addSystem<xy::DynamicTreeSystem>(messageBus);
+        }
+
+        xy::MessageBus messageBus;
+        xy::Scene scene;
+        MapParser mapParser;
+        std::vector<xy::Entity> vehicles;
+        sf::Vector2f startPosition;
+        float startRotation = 0.f;
+
+        bool load(const std::string& map, std::size_t vehicleCount, bool ai)
+        {
+            if (!mapParser.load(map))
+            {
+                return false;
+            }
+
+            //line the cars up on the grid in rows of 4
+            std::tie(startPosition, startRotation) = mapParser.getStartPosition();
+            sf::Transform offsetTransform;
+            offsetTransform.rotate(startRotation);
+
+            for (auto i = 0u; i < vehicleCount; ++i)
+            {
+                auto offset = GameConst::SpawnPositions[i % GameConst::SpawnPositions.size()];
+                offset.x -= GameConst::CarSize.width * 1.5f * static_cast<float>(i / GameConst::SpawnPositions.size());
+
+                auto entity = scene.createEntity();
+                entity.addComponent<xy::Transform>().setPosition(startPosition + offsetTransform.transformPoint(offset));
+                entity.getComponent<xy::Transform>().setRotation(startRotation);
+                entity.addComponent<Vehicle>().waypointCount = mapParser.getWaypointCount();
+                entity.getComponent<Vehicle>().settings = Definition::car;
+                entity.getComponent<Vehicle>().stateFlags = (1 << Vehicle::Normal);
+                entity.addComponent<CollisionObject>().type = CollisionObject::Vehicle;
+                entity.getComponent<CollisionObject>().applyVertices(GameConst::CarPoints);
+                entity.addComponent<xy::BroadphaseComponent>().setArea(GameConst::CarSize);
+                entity.getComponent<xy::BroadphaseComponent>().setFilterFlags(CollisionFlags::Vehicle);
+
+                if (ai)
+                {
+                    entity.addComponent<AIDriver>().target = startPosition;
+                    entity.getComponent<AIDriver>().skill = static_cast<AIDriver::Skill>(i % 3);
+                }
+                vehicles.push_back(entity);
+            }
+            return true;
+        }
+
+        //updates the scene by one step. Respawns are requested from
+        //the server so they're only handled if this is a server scene
+        void step(bool server)
+        {
+            scene.update(Vehicle::StepTime);
+
+            while (!messageBus.empty())
+            {
+                const auto& msg = messageBus.poll();
+                scene.forwardMessage(msg);
+
+                if (msg.id == MessageID::VehicleMessage && server)
+                {
+                    const auto& data = msg.getData<VehicleEvent>();
+                    if (data.type == VehicleEvent::RequestRespawn)
+                    {
+                        auto entity = data.entity;
+                        auto& vehicle = entity.getComponent<Vehicle>();
+                        auto& tx = entity.getComponent<xy::Transform>();
+
+                        vehicle.velocity = {};
+                        vehicle.anglularVelocity = {};
+                        vehicle.stateFlags = (1 << Vehicle::Normal);
+                        vehicle.invincibleTime = GameConst::InvincibleTime;
+
+                        if (vehicle.currentWaypoint.isValid())
+                        {
+                            tx.setPosition(vehicle.currentWaypoint.getComponent<xy::Transform>().getPosition());
+                            tx.setRotation(vehicle.currentWaypoint.getComponent<WayPoint>().rotation);
+                        }
+                        else
+                        {
+                            tx.setPosition(startPosition);
+                            tx.setRotation(startRotation);
+                        }
+                        tx.setScale(1.f, 1.f);
+                    }
+                }
+            }
+        }
+
+        void push(std::size_t index, const std::vector<Input>& inputs)
+        {
+            auto& vehicle = vehicles[index].getComponent<Vehicle>();
+            for (const auto& input : inputs)
+            {
+                vehicle.history[vehicle.currentInput] = input;
+                vehicle.currentInput = (vehicle.currentInput + 1) % vehicle.history.size();
+            }
+        }
+    };
+
+    //inputs[tick][vehicle]
+    using Recording = std::vector<std::vector<std::vector<Input>>>;
+}
+
+SimulationCheckResult runSimulationCheck(const std::string& map, std::size_t tickCount)
+{
+    SimulationCheckResult result;
+
+    //record the AI driving every vehicle
+    Recording recording(tickCount, std::vector<std::vector<Input>>(VehicleCount));
+    std::vector<std::uint64_t> recordedHashes(tickCount);
+    {
+        auto sim = std::make_unique<Simulation>(true);
+        if (!sim->load(map, VehicleCount, true))
+        {
+            return result;
+        }
+        result.loaded = true;
+
+        std::vector<std::size_t> lastInput(VehicleCount);
+        for (auto tick = 0u; tick < tickCount; ++tick)
+        {
+            sim->step(true);
+
+            std::uint64_t hash = FNVOffsetBasis;
+            for (auto i = 0u; i < VehicleCount; ++i)
+            {
+                const auto& vehicle = sim->vehicles[i].getComponent<Vehicle>();
+                while (lastInput[i] != vehicle.currentInput)
+                {
+                    recording[tick][i].push_back(vehicle.history[lastInput[i]]);
+                    lastInput[i] = (lastInput[i] + 1) % vehicle.history.size();
+                }
+                hashVehicle(sim->vehicles[i], hash);
+            }
+            recordedHashes[tick] = hash;
+        }
+        result.finalHash = recordedHashes.back();
+    }
+    result.tickCount = tickCount;
+
+    //replay it on the server path
+    {
+        auto sim = std::make_unique<Simulation>(false);
+        sim->load(map, VehicleCount, false);
+
+        for (auto tick = 0u; tick < tickCount; ++tick)
+        {
+            for (auto i = 0u; i < VehicleCount; ++i)
+            {
+                sim->push(i, recording[tick][i]);
+            }
+            sim->step(true);
+
+            std::uint64_t hash = FNVOffsetBasis;
+            for (auto entity : sim->vehicles)
+            {
+                hashVehicle(entity, hash);
+            }
+
+            if (hash != recordedHashes[tick])
+            {
+                result.replayMismatch = tick + 1;
+                break;
+            }
+        }
+    }
+
+    //simulate the first vehicle on its own as the server would,
+    //and store the update which would be sent to the client
+    std::vector<ClientUpdate> updates(tickCount);
+    std::vector<std::uint64_t> serverHashes(tickCount);
+    std::vector<bool> serverNormal(tickCount);
+    {
+        auto sim = std::make_unique<Simulation>(false);
+        sim->load(map, 1, false);
+        auto entity = sim->vehicles[0];
+
+        for (auto tick = 0u; tick < tickCount; ++tick)
+        {
+            sim->push(0, recording[tick][0]);
+            sim->step(true);
+
+            const auto& tx = entity.getComponent<xy::Transform>();
+            const auto& vehicle = entity.getComponent<Vehicle>();
+            auto& cu = updates[tick];
+            cu.x = tx.getPosition().x;
+            cu.y = tx.getPosition().y;
+            cu.rotation = tx.getRotation();
+            cu.velX = vehicle.velocity.x;
+            cu.velY = vehicle.velocity.y;
+            cu.velRot = vehicle.anglularVelocity;
+            cu.accelerationMultiplier = vehicle.accelerationMultiplier;
+            cu.clientTimestamp = vehicle.history[vehicle.lastUpdatedInput].timestamp;
+            cu.collisionFlags = vehicle.collisionFlags;
+            cu.stateFlags = vehicle.stateFlags;
+
+            serverHashes[tick] = FNVOffsetBasis;
+            hashPhysics(entity, serverHashes[tick]);
+            serverNormal[tick] = (vehicle.stateFlags == (1 << Vehicle::Normal));
+        }
+    }
+
+    //and then predict it as the client would. Respawning isn't part of
+    //the input so the predicted state is only compared when the vehicle
+    //was driving on the server for all of the replayed input
+    {
+        auto sim = std::make_unique<Simulation>(false);
+        sim->load(map, 1, false);
+        auto entity = sim->vehicles[0];
+        auto& vehicleSystem = sim->scene.getSystem<VehicleSystem>();
+
+        std::size_t interrupted = 0; //tick after the vehicle last stopped driving
+        for (auto tick = 0u; tick < tickCount; ++tick)
+        {
+            sim->push(0, recording[tick][0]);
+            sim->step(false);
+
+            if (!serverNormal[tick])
+            {
+                interrupted = tick + 1;
+            }
+
+            if (tick % ReconcileInterval == 0
+                && tick >= ReconcileLatency)
+            {
+                const auto updateTick = tick - ReconcileLatency;
+                vehicleSystem.reconcile(updates[updateTick], entity);
+
+                if (updateTick >= interrupted)
+                {
+                    result.reconcileCount++;
+
+                    std::uint64_t hash = FNVOffsetBasis;
+                    hashPhysics(entity, hash);
+                    if (hash != serverHashes[tick]
+                        && result.clientMismatch == 0)
+                    {
+                        result.clientMismatch = tick + 1;
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
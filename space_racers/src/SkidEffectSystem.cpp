@@ -29,13 +29,15 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/util/Vector.hpp>
 
+#include <algorithm>
+
 namespace
 {
     const float MinVelocity = 940.f;
     const float MinVelocitySqr = MinVelocity * MinVelocity;
 
-    const sf::Time releaseTime = sf::seconds(0.01f);
-    const sf::Time soundTime = sf::seconds(0.6f);
+    const float releaseTime = 0.01f;
+    const float soundTime = 0.6f;
     const sf::Vector2f skidSize(14.f, 6.f);
 
     const std::array<sf::Vector2f, 4u> quad =
@@ -47,26 +49,34 @@ namespace
     };
 
     const float wheelSpacing = 12.f;
+
+    //space is reserved for two wheels regardless of the wheel count
+    const std::size_t VertsPerMark = quad.size() * 2;
+    const std::size_t VertsPerEffect = SkidEffect::MaxSkids * VertsPerMark;
+
+    const sf::Color skidColour(15, 15, 15, 115);
 }
 
 SkidEffectSystem::SkidEffectSystem(xy::MessageBus& mb)
-    : xy::System(mb, typeid(SkidEffectSystem))
+    : xy::System    (mb, typeid(SkidEffectSystem)),
+    m_time          (0.f),
+    m_bytesWritten  (0),
+    m_boundsMin     (std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+    m_boundsMax     (std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()),
+    m_boundsChanged (false)
 {
     requireComponent<SkidEffect>();
-    requireComponent<xy::Drawable>();
 }
 
 //public
 void SkidEffectSystem::process(float dt)
 {
+    m_time += dt;
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
         auto& skid = entity.getComponent<SkidEffect>();
-        for (auto& mark : skid.skidmarks)
-        {
-            mark.lifetime -= dt;
-        }
 
         const auto& vehicle = skid.parent.getComponent<Vehicle>();
         if (vehicle.stateFlags == (1 << Vehicle::Normal))
@@ -78,20 +88,22 @@ void SkidEffectSystem::process(float dt)
             {
                 skid.parent.getComponent<xy::ParticleEmitter>().start();
 
-                if (skid.releaseTimer.getElapsedTime() > releaseTime)
+                if (m_time - skid.releaseTime > releaseTime)
                 {
-                    skid.releaseTimer.restart();
-                    if (skid.skidmarks[skid.currentSkidmark].lifetime < 0)
+                    skid.releaseTime = m_time;
+                    auto& mark = skid.skidmarks[skid.currentSkidmark];
+                    if (m_time - mark.timestamp >= Skidmark::DefaultLifeTime)
                     {
-                        skid.skidmarks[skid.currentSkidmark].lifetime = Skidmark::DefaultLifeTime;
-                        skid.skidmarks[skid.currentSkidmark].position = skid.parent.getComponent<xy::Transform>().getPosition();
-                        skid.skidmarks[skid.currentSkidmark].rotation = skid.parent.getComponent<xy::Transform>().getRotation();
+                        mark.timestamp = m_time;
+                        mark.position = skid.parent.getComponent<xy::Transform>().getPosition();
+                        mark.rotation = skid.parent.getComponent<xy::Transform>().getRotation();
+                        writeSkidmark(skid, skid.currentSkidmark);
                         skid.currentSkidmark = (skid.currentSkidmark + 1) % SkidEffect::MaxSkids;
                     }
                 }
-                if (skid.soundTimer.getElapsedTime() > soundTime)
+                if (m_time - skid.soundTime > soundTime)
                 {
-                    skid.soundTimer.restart();
+                    skid.soundTime = m_time;
                     auto* msg = postMessage<VehicleEvent>(MessageID::VehicleMessage);
                     msg->type = VehicleEvent::Skid;
                     msg->entity = skid.parent;
@@ -106,49 +118,100 @@ void SkidEffectSystem::process(float dt)
         {
             skid.parent.getComponent<xy::ParticleEmitter>().stop();
         }
+    }
 
-        //update the drawable
-        //TODO can we index this by skidmark array and save rebuilding the entire thing each frame?
-        auto& drawable = entity.getComponent<xy::Drawable>();
-        auto& verts = drawable.getVertices();
-        verts.clear();
+    if (m_batchEntity.isValid())
+    {
+        auto& drawable = m_batchEntity.getComponent<xy::Drawable>();
+        drawable.bindUniform("u_time", m_time);
 
-        for (auto& mark : skid.skidmarks)
+        //bounds only ever grow, they're just used for culling
+        if (m_boundsChanged)
         {
-            if (mark.lifetime > 0)
-            {
-                float alpha = mark.lifetime / Skidmark::DefaultLifeTime;
-                alpha *= 115.f;
+            drawable.updateLocalBounds({ m_boundsMin, m_boundsMax - m_boundsMin });
+            m_boundsChanged = false;
+        }
+    }
+}
 
-                sf::Color c(15, 15, 15, static_cast<sf::Uint8>(alpha));
+void SkidEffectSystem::setBatchEntity(xy::Entity entity)
+{
+    XY_ASSERT(entity.hasComponent<xy::Drawable>(), "Skid batch requires a drawable");
+    m_batchEntity = entity;
 
-                Transform tx;
-                tx.setRotation(mark.rotation);
-                float offset = 0.f;
-                if (skid.wheelCount > 1)
-                {
-                    offset = -wheelSpacing;
-                }
-                for (auto i = 0u; i < skid.wheelCount; ++i)
-                {
-                    for (auto& p : quad)
-                    {
-                        verts.emplace_back(tx.transformPoint(p.x, p.y + offset) + mark.position, c);
-                    }
-                    offset += wheelSpacing * 2.f;
-                }
-            }
-        }
+    auto& drawable = entity.getComponent<xy::Drawable>();
+    drawable.setPrimitiveType(sf::Quads);
+    drawable.bindUniform("u_lifetime", Skidmark::DefaultLifeTime);
+    drawable.bindUniform("u_time", m_time);
+}
+
+//private
+void SkidEffectSystem::writeSkidmark(const SkidEffect& skid, std::size_t index)
+{
+    auto& verts = m_batchEntity.getComponent<xy::Drawable>().getVertices();
+    auto* mark = &verts[skid.slot * VertsPerEffect + index * VertsPerMark];
+    const auto& skidmark = skid.skidmarks[index];
+
+    Transform tx;
+    tx.setRotation(skidmark.rotation);
+    float offset = 0.f;
+    if (skid.wheelCount > 1)
+    {
+        offset = -wheelSpacing;
+    }
 
-        if (!verts.empty())
+    const auto wheelCount = std::min(skid.wheelCount, std::size_t(2));
+    for (auto i = 0u; i < wheelCount; ++i)
+    {
+        for (const auto& p : quad)
         {
-            drawable.updateLocalBounds();
+            *mark = sf::Vertex(tx.transformPoint(p.x, p.y + offset) + skidmark.position, skidColour, sf::Vector2f(skidmark.timestamp, 0.f));
+
+            m_boundsMin.x = std::min(m_boundsMin.x, mark->position.x);
+            m_boundsMin.y = std::min(m_boundsMin.y, mark->position.y);
+            m_boundsMax.x = std::max(m_boundsMax.x, mark->position.x);
+            m_boundsMax.y = std::max(m_boundsMax.y, mark->position.y);
+            mark++;
         }
+        offset += wheelSpacing * 2.f;
     }
+    m_boundsChanged = true;
+    m_bytesWritten += wheelCount * quad.size() * sizeof(sf::Vertex);
 }
 
-//private
 void SkidEffectSystem::onEntityAdded(xy::Entity entity)
 {
-    entity.getComponent<SkidEffect>().skidmarks.resize(SkidEffect::MaxSkids);
+    XY_ASSERT(m_batchEntity.isValid(), "Skid batch entity not set");
+
+    auto& skid = entity.getComponent<SkidEffect>();
+    skid.skidmarks.resize(SkidEffect::MaxSkids);
+
+    //reuse the slot of a removed effect if there is one
+    if (m_freeSlots.empty())
+    {
+        auto& verts = m_batchEntity.getComponent<xy::Drawable>().getVertices();
+        skid.slot = verts.size() / VertsPerEffect;
+        verts.resize(verts.size() + VertsPerEffect);
+    }
+    else
+    {
+        skid.slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+}
+
+void SkidEffectSystem::onEntityRemoved(xy::Entity entity)
+{
+    const auto& skid = entity.getComponent<SkidEffect>();
+    if (m_batchEntity.isValid()
+        && skid.slot != std::numeric_limits<std::size_t>::max())
+    {
+        //collapse the slot so it draws nothing until reused
+        auto& verts = m_batchEntity.getComponent<xy::Drawable>().getVertices();
+        auto start = verts.begin() + (skid.slot * VertsPerEffect);
+        std::fill(start, start + VertsPerEffect, sf::Vertex());
+        m_bytesWritten += VertsPerEffect * sizeof(sf::Vertex);
+
+        m_freeSlots.push_back(skid.slot);
+    }
 }
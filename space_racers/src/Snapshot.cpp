@@ -0,0 +1,443 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "Snapshot.hpp"
+#include "BitStream.hpp"
+#include "NetActor.hpp"
+#include "VehicleSystem.hpp"
+#include "ActorIDs.hpp"
+
+#include <xyginext/ecs/Entity.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    const std::uint32_t IDBits = 16;
+    const std::uint32_t TimestampBits = 32;
+    const std::uint32_t CountBits = 16;
+    const std::uint32_t VelocityBits = 16;
+    const std::uint32_t InputBits = 16;
+    const std::uint32_t StateBits = 8;
+
+    const std::int32_t RotationSteps = 1 << SnapshotConst::RotationBits;
+    const std::int32_t MaxPredictionTime = 1000; //ms
+
+    static_assert(SnapshotConst::PositionScale == SnapshotConst::VelocityScale, "Position prediction assumes the same scale");
+
+    //true if a is more recent than b, allowing for wrap around
+    bool isNewer(std::uint16_t a, std::uint16_t b)
+    {
+        return static_cast<std::int16_t>(a - b) > 0;
+    }
+
+    //most actors travel in a straight line between snapshots so their
+    //position is predicted from the velocity in the baseline. This is
+    //integer maths so that the result is the same on both ends.
+    std::int32_t predict(std::uint32_t position, std::int16_t velocity, std::int32_t time)
+    {
+        return static_cast<std::int32_t>(position) + (velocity * time) / 1000;
+    }
+
+    std::int32_t rotationDelta(std::uint16_t rotation, std::uint16_t baseline)
+    {
+        auto delta = (static_cast<std::int32_t>(rotation) - baseline) & (RotationSteps - 1);
+        return delta >= RotationSteps / 2 ? delta - RotationSteps : delta;
+    }
+
+    std::int32_t predictionTime(const Snapshot& snapshot, const Snapshot& baseline)
+    {
+        return std::min(MaxPredictionTime, std::max(0, snapshot.timestamp - baseline.timestamp));
+    }
+
+    void writeActor(const ActorSnapshot& actor, std::uint32_t positionBits, BitWriter& writer)
+    {
+        writer.writeBool(actor.vehicle);
+        writer.write(actor.x, positionBits);
+        writer.write(actor.y, positionBits);
+        writer.write(static_cast<std::uint16_t>(actor.velX), VelocityBits);
+        writer.write(static_cast<std::uint16_t>(actor.velY), VelocityBits);
+
+        if (actor.vehicle)
+        {
+            writer.write(actor.rotation, SnapshotConst::RotationBits);
+            writer.write(actor.lastInput, InputBits);
+            writer.write(actor.stateFlags, StateBits);
+        }
+    }
+
+    void readActor(ActorSnapshot& actor, std::uint32_t positionBits, BitReader& reader)
+    {
+        actor.vehicle = reader.readBool();
+        actor.x = reader.read(positionBits);
+        actor.y = reader.read(positionBits);
+        actor.velX = static_cast<std::int16_t>(reader.read(VelocityBits));
+        actor.velY = static_cast<std::int16_t>(reader.read(VelocityBits));
+
+        if (actor.vehicle)
+        {
+            actor.rotation = static_cast<std::uint16_t>(reader.read(SnapshotConst::RotationBits));
+            actor.lastInput = static_cast<std::uint16_t>(reader.read(InputBits));
+            actor.stateFlags = static_cast<std::uint8_t>(reader.read(StateBits));
+        }
+    }
+
+    void writeActorDelta(const ActorSnapshot& actor, const ActorSnapshot& baseline, std::int32_t time, BitWriter& writer)
+    {
+        const auto dx = static_cast<std::int32_t>(actor.x) - predict(baseline.x, baseline.velX, time);
+        const auto dy = static_cast<std::int32_t>(actor.y) - predict(baseline.y, baseline.velY, time);
+        const auto dvx = actor.velX - baseline.velX;
+        const auto dvy = actor.velY - baseline.velY;
+        const auto dr = rotationDelta(actor.rotation, baseline.rotation);
+
+        const bool changed = dx != 0 || dy != 0 || dvx != 0 || dvy != 0 || dr != 0
+            || actor.lastInput != baseline.lastInput
+            || actor.stateFlags != baseline.stateFlags;
+
+        writer.writeBool(changed);
+        if (changed)
+        {
+            writer.writeDelta(dx);
+            writer.writeDelta(dy);
+            writer.writeDelta(dvx);
+            writer.writeDelta(dvy);
+
+            if (actor.vehicle)
+            {
+                writer.writeDelta(dr);
+
+                writer.writeBool(actor.lastInput != baseline.lastInput);
+                if (actor.lastInput != baseline.lastInput)
+                {
+                    writer.write(actor.lastInput, InputBits);
+                }
+
+                writer.writeBool(actor.stateFlags != baseline.stateFlags);
+                if (actor.stateFlags != baseline.stateFlags)
+                {
+                    writer.write(actor.stateFlags, StateBits);
+                }
+            }
+        }
+    }
+
+    void readActorDelta(ActorSnapshot& actor, const ActorSnapshot& baseline, std::int32_t time, BitReader& reader)
+    {
+        actor = baseline;
+        actor.x = static_cast<std::uint32_t>(predict(baseline.x, baseline.velX, time));
+        actor.y = static_cast<std::uint32_t>(predict(baseline.y, baseline.velY, time));
+
+        if (!reader.readBool())
+        {
+            return;
+        }
+
+        actor.x += reader.readDelta();
+        actor.y += reader.readDelta();
+        actor.velX = static_cast<std::int16_t>(baseline.velX + reader.readDelta());
+        actor.velY = static_cast<std::int16_t>(baseline.velY + reader.readDelta());
+
+        if (actor.vehicle)
+        {
+            actor.rotation = static_cast<std::uint16_t>((baseline.rotation + reader.readDelta()) & (RotationSteps - 1));
+
+            if (reader.readBool())
+            {
+                actor.lastInput = static_cast<std::uint16_t>(reader.read(InputBits));
+            }
+
+            if (reader.readBool())
+            {
+                actor.stateFlags = static_cast<std::uint8_t>(reader.read(StateBits));
+            }
+        }
+    }
+}
+
+SnapshotQuantiser::SnapshotQuantiser()
+    : m_positionBits(0),
+    m_maxPosition(0)
+{
+    setMapSize({});
+}
+
+//public
+void SnapshotQuantiser::setMapSize(sf::Vector2f size)
+{
+    m_bounds = { -SnapshotConst::BorderSize, -SnapshotConst::BorderSize,
+        size.x + (SnapshotConst::BorderSize * 2.f), size.y + (SnapshotConst::BorderSize * 2.f) };
+
+    const auto maxPosition = static_cast<std::uint32_t>(std::ceil(std::max(m_bounds.width, m_bounds.height) * SnapshotConst::PositionScale));
+
+    m_positionBits = 1;
+    while ((maxPosition >> m_positionBits) != 0)
+    {
+        m_positionBits++;
+    }
+    m_maxPosition = (1u << m_positionBits) - 1;
+}
+
+Snapshot SnapshotQuantiser::quantise(const std::vector<xy::Entity>& entities, std::int32_t timestamp) const
+{
+    auto quantisePosition = [&](float position, float origin)
+    {
+        const auto value = std::round((position - origin) * SnapshotConst::PositionScale);
+        return static_cast<std::uint32_t>(std::min(static_cast<float>(m_maxPosition), std::max(0.f, value)));
+    };
+
+    auto quantiseVelocity = [](float velocity)
+    {
+        const auto value = std::round(velocity * SnapshotConst::VelocityScale);
+        return static_cast<std::int16_t>(std::min(32767.f, std::max(-32768.f, value)));
+    };
+
+    Snapshot snapshot;
+    snapshot.timestamp = timestamp;
+    snapshot.actors.reserve(entities.size());
+
+    for (auto entity : entities)
+    {
+        const auto& tx = entity.getComponent<xy::Transform>();
+        const auto& netActor = entity.getComponent<NetActor>();
+
+        auto& actor = snapshot.actors.emplace_back();
+        actor.serverID = static_cast<std::uint16_t>(netActor.serverID);
+        actor.x = quantisePosition(tx.getPosition().x, m_bounds.left);
+        actor.y = quantisePosition(tx.getPosition().y, m_bounds.top);
+        actor.velX = quantiseVelocity(netActor.velocity.x);
+        actor.velY = quantiseVelocity(netActor.velocity.y);
+
+        if (netActor.actorID != ActorID::Roid)
+        {
+            actor.vehicle = true;
+            actor.rotation = static_cast<std::uint16_t>(static_cast<std::int32_t>(std::round(tx.getRotation() / 360.f * RotationSteps)) & (RotationSteps - 1));
+            actor.lastInput = netActor.lastInput;
+            actor.stateFlags = entity.getComponent<Vehicle>().stateFlags;
+        }
+    }
+
+    std::sort(snapshot.actors.begin(), snapshot.actors.end(),
+        [](const ActorSnapshot& a, const ActorSnapshot& b)
+        {
+            return a.serverID < b.serverID;
+        });
+
+    return snapshot;
+}
+
+VehicleActorUpdate SnapshotQuantiser::dequantise(const ActorSnapshot& actor, std::int32_t timestamp) const
+{
+    VehicleActorUpdate update;
+    update.x = m_bounds.left + (static_cast<float>(actor.x) / SnapshotConst::PositionScale);
+    update.y = m_bounds.top + (static_cast<float>(actor.y) / SnapshotConst::PositionScale);
+    update.velX = static_cast<float>(actor.velX) / SnapshotConst::VelocityScale;
+    update.velY = static_cast<float>(actor.velY) / SnapshotConst::VelocityScale;
+    update.timestamp = timestamp;
+    update.serverID = actor.serverID;
+    update.rotation = static_cast<float>(actor.rotation) * (360.f / RotationSteps);
+    update.lastInput = actor.lastInput;
+    update.stateFlags = actor.stateFlags;
+
+    return update;
+}
+
+SnapshotEncoder::SnapshotEncoder()
+    : m_nextID  (0),
+    m_ackedID   (0),
+    m_hasAck    (false)
+{
+
+}
+
+//public
+void SnapshotEncoder::write(Snapshot& snapshot, const SnapshotQuantiser& quantiser, BitWriter& writer)
+{
+    snapshot.id = m_nextID++;
+
+    const Snapshot* baseline = nullptr;
+    if (m_hasAck
+        && static_cast<std::uint16_t>(snapshot.id - m_ackedID) < SnapshotConst::HistorySize)
+    {
+        const auto& acked = m_history[m_ackedID % SnapshotConst::HistorySize];
+        if (acked.id == m_ackedID)
+        {
+            baseline = &acked;
+        }
+    }
+
+    writer.write(snapshot.id, IDBits);
+    writer.write(static_cast<std::uint32_t>(snapshot.timestamp), TimestampBits);
+    writer.writeBool(baseline != nullptr);
+    if (baseline)
+    {
+        writer.write(baseline->id, IDBits);
+    }
+    writer.write(static_cast<std::uint32_t>(snapshot.actors.size()), CountBits);
+
+    const auto time = baseline ? predictionTime(snapshot, *baseline) : 0;
+    const auto positionBits = quantiser.getPositionBits();
+
+    //both lists are sorted so walk them together to find
+    //each actor's baseline, if it has one
+    std::vector<ActorSnapshot>::const_iterator base;
+    if (baseline)
+    {
+        base = baseline->actors.cbegin();
+    }
+
+    std::uint16_t expectedID = 0;
+    for (const auto& actor : snapshot.actors)
+    {
+        //server IDs are often consecutive
+        writer.writeBool(actor.serverID == expectedID);
+        if (actor.serverID != expectedID)
+        {
+            writer.write(actor.serverID, IDBits);
+        }
+        expectedID = actor.serverID + 1;
+
+        bool known = false;
+        if (baseline)
+        {
+            while (base != baseline->actors.cend() && base->serverID < actor.serverID)
+            {
+                ++base;
+            }
+            known = (base != baseline->actors.cend() && base->serverID == actor.serverID && base->vehicle == actor.vehicle);
+        }
+
+        writer.writeBool(known);
+        if (known)
+        {
+            writeActorDelta(actor, *base, time, writer);
+        }
+        else
+        {
+            writeActor(actor, positionBits, writer);
+        }
+    }
+
+    m_history[snapshot.id % SnapshotConst::HistorySize] = snapshot;
+}
+
+void SnapshotEncoder::acknowledge(std::uint16_t id)
+{
+    //acks are unreliable so may arrive out of order
+    if (!m_hasAck || isNewer(id, m_ackedID))
+    {
+        m_ackedID = id;
+        m_hasAck = true;
+    }
+}
+
+SnapshotDecoder::SnapshotDecoder()
+    : m_latestID    (0),
+    m_hasLatest     (false)
+{
+
+}
+
+//public
+bool SnapshotDecoder::read(BitReader& reader, const SnapshotQuantiser& quantiser, Snapshot& dst)
+{
+    dst.id = static_cast<std::uint16_t>(reader.read(IDBits));
+    dst.timestamp = static_cast<std::int32_t>(reader.read(TimestampBits));
+
+    const Snapshot* baseline = nullptr;
+    if (reader.readBool())
+    {
+        const auto baselineID = static_cast<std::uint16_t>(reader.read(IDBits));
+        const auto index = baselineID % SnapshotConst::HistorySize;
+        if (!m_valid[index] || m_history[index].id != baselineID)
+        {
+            return false;
+        }
+        baseline = &m_history[index];
+    }
+
+    const auto count = reader.read(CountBits);
+    if (reader.failed())
+    {
+        return false;
+    }
+
+    const auto time = baseline ? predictionTime(dst, *baseline) : 0;
+    const auto positionBits = quantiser.getPositionBits();
+
+    std::vector<ActorSnapshot>::const_iterator base;
+    if (baseline)
+    {
+        base = baseline->actors.cbegin();
+    }
+
+    dst.actors.clear();
+    dst.actors.reserve(count);
+
+    std::uint16_t expectedID = 0;
+    for (auto i = 0u; i < count; ++i)
+    {
+        const auto serverID = reader.readBool() ? expectedID : static_cast<std::uint16_t>(reader.read(IDBits));
+        expectedID = serverID + 1;
+
+        auto& actor = dst.actors.emplace_back();
+        if (reader.readBool())
+        {
+            if (!baseline)
+            {
+                return false;
+            }
+
+            while (base != baseline->actors.cend() && base->serverID < serverID)
+            {
+                ++base;
+            }
+
+            if (base == baseline->actors.cend() || base->serverID != serverID)
+            {
+                return false;
+            }
+            readActorDelta(actor, *base, time, reader);
+        }
+        else
+        {
+            readActor(actor, positionBits, reader);
+        }
+        actor.serverID = serverID;
+
+        if (reader.failed())
+        {
+            return false;
+        }
+    }
+
+    //keep it as a baseline even if it arrived late
+    const auto index = dst.id % SnapshotConst::HistorySize;
+    m_history[index] = dst;
+    m_valid[index] = true;
+
+    if (m_hasLatest && !isNewer(dst.id, m_latestID))
+    {
+        return false;
+    }
+    m_latestID = dst.id;
+    m_hasLatest = true;
+
+    return true;
+}
@@ -0,0 +1,757 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+/*
+Headless swarm benchmark. Hosts one or more races in process, each on
+its own port, then connects a swarm of dummy clients to them over
+localhost. Each client performs the same lobby handshake as the game
+client, loads the map into a headless scene and has the AI driver
+follow the waypoints, predicting and reconciling its vehicle as the
+game client does. Inputs are sent in batches exactly as InputParser
+sends them, and snapshots are read and acknowledged so that the server
+delta compresses them as it would for a real client. At the end of the
+run the server tick time percentiles, the bandwidth used by each client
+and the input to ack latency are reported. The latency is measured
+from the step on which an input was created until the first ClientUpdate
+to include it arrives, so it includes the time the input spends waiting
+for the next packet and the time until the server next sends an update.
+
+Races are limited to LobbyData::MaxPlayers, so to test dozens of clients
+spread them over several races.
+
+Usage: space_racers_swarm [-m <race count>] [-c <clients per race>] [-t <seconds>]
+                          [-p <first port>] [-i <steps per input packet>]
+                          [-r <resource directory>]
+*/
+
+#include "Server.hpp"
+#include "ServerStates.hpp"
+#include "NetConsts.hpp"
+#include "ClientPackets.hpp"
+#include "ServerPackets.hpp"
+#include "VehicleSystem.hpp"
+#include "VehicleDefs.hpp"
+#include "AIDriverSystem.hpp"
+#include "CollisionObject.hpp"
+#include "GameConsts.hpp"
+#include "MapParser.hpp"
+#include "InputBatch.hpp"
+#include "BitStream.hpp"
+#include "Snapshot.hpp"
+
+#include <xyginext/core/Log.hpp>
+#include <xyginext/core/FileSystem.hpp>
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/BroadPhaseComponent.hpp>
+#include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
+#include <xyginext/network/NetClient.hpp>
+#include <xyginext/network/NetData.hpp>
+
+#include <SFML/System/Clock.hpp>
+#include <SFML/System/Sleep.hpp>
+#include <SFML/System/String.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace
+{
+    std::atomic<bool> running(true);
+
+    void onSignal(int)
+    {
+        running = false;
+    }
+
+    const sf::Time PingTime = sf::seconds(3.f);
+    const sf::Time ReadyInterval = sf::seconds(1.f);
+    const std::size_t MaxRaces = 64;
+
+    struct Options final
+    {
+        std::size_t raceCount = 8;
+        std::size_t clientsPerRace = LobbyData::MaxPlayers;
+        float duration = 60.f;
+        std::uint16_t basePort = NetConst::Port + 100;
+        std::size_t packetInterval = 2;
+        std::string resourceDirectory;
+    };
+
+    template <typename T>
+    T percentile(std::vector<T>& values, float p)
+    {
+        if (values.empty())
+        {
+            return T(0);
+        }
+
+        auto idx = static_cast<std::size_t>(p * static_cast<float>(values.size() - 1));
+        std::nth_element(values.begin(), values.begin() + idx, values.end());
+        return values[idx];
+    }
+
+    //the client side of a single race
+    struct Race final
+    {
+        Race()
+            : scene(messageBus),
+            mapParser(scene)
+        {
+            scene.addSystem<AIDriverSystem>(messageBus);
+            scene.addSystem<VehicleSystem>(messageBus);
+            scene.addSystem<xy::DynamicTreeSystem>(messageBus);
+        }
+
+        xy::MessageBus messageBus;
+        xy::Scene scene;
+        MapParser mapParser;
+        xy::Entity vehicle;
+        std::int32_t actorCount = 0;
+
+        SnapshotQuantiser snapshotQuantiser;
+        SnapshotDecoder snapshotDecoder;
+    };
+
+    //performs the client side of the lobby handshake,
+    //then races using the AI driver to create input
+    class SwarmClient final
+    {
+    public:
+        SwarmClient(std::uint16_t port, std::size_t expectedClients, bool host, std::size_t index, std::size_t packetInterval)
+            : m_port        (port),
+            m_expectedClients(expectedClients),
+            m_host          (host),
+            m_index         (index),
+            m_packetInterval(packetInterval)
+        {
+            m_client.create(2);
+        }
+
+        bool connect()
+        {
+            if (m_client.connect("127.0.0.1", m_port))
+            {
+                m_phase = Phase::Lobby;
+                return true;
+            }
+            return false;
+        }
+
+        void disconnect()
+        {
+            if (m_client.connected())
+            {
+                m_client.disconnect();
+            }
+        }
+
+        void pollNetwork()
+        {
+            xy::NetEvent evt;
+            while (m_client.pollEvent(evt))
+            {
+                if (evt.type == xy::NetEvent::PacketReceived)
+                {
+                    m_bytesIn += evt.packet.getSize() + sizeof(std::uint8_t);
+                    m_packetsIn++;
+
+                    handlePacket(evt);
+                }
+                else if (evt.type == xy::NetEvent::ClientDisconnect)
+                {
+                    m_phase = Phase::Disconnected;
+                }
+            }
+
+            if (m_phase == Phase::Disconnected)
+            {
+                return;
+            }
+
+            if (m_pingClock.getElapsedTime() > PingTime)
+            {
+                send(PacketID::ClientPing, std::uint8_t(0), xy::NetFlag::Unreliable);
+                m_pingClock.restart();
+            }
+
+            //the server resets everyone's ready state when it returns to the lobby
+            //so keep reminding it. The host launches the race once all the
+            //clients which are expected to join are ready
+            if (m_phase == Phase::Lobby
+                && m_readyClock.getElapsedTime() > ReadyInterval)
+            {
+                send(PacketID::ReadyStateToggled, std::uint8_t(1), xy::NetFlag::Reliable);
+
+                if (m_host && !m_mapName.empty()
+                    && std::count_if(m_readyStates.begin(), m_readyStates.end(),
+                        [](const std::pair<const std::uint64_t, bool>& p) { return p.second; }) >= static_cast<std::ptrdiff_t>(m_expectedClients))
+                {
+                    send(PacketID::LaunchGame, std::uint8_t(0), xy::NetFlag::Reliable);
+                }
+                m_readyClock.restart();
+            }
+        }
+
+        //performs a single vehicle step
+        void step()
+        {
+            if (!m_race)
+            {
+                return;
+            }
+
+            m_race->scene.update(Vehicle::StepTime);
+            while (!m_race->messageBus.empty())
+            {
+                m_race->scene.forwardMessage(m_race->messageBus.poll());
+            }
+
+            if (!m_race->vehicle.isValid())
+            {
+                return;
+            }
+
+            //the AI driver adds an input to the history each step. These
+            //are quantised as InputParser does, so that the reconciled
+            //state matches the server, then sent in batches
+            auto& vehicle = m_race->vehicle.getComponent<Vehicle>();
+            const auto now = m_localClock.getElapsedTime().asMicroseconds();
+            while (m_lastInput != vehicle.currentInput)
+            {
+                auto& input = vehicle.history[m_lastInput];
+                input.steeringMultiplier = InputBatch::quantiseMultiplier(input.steeringMultiplier);
+                input.accelerationMultiplier = InputBatch::quantiseMultiplier(input.accelerationMultiplier);
+
+                m_inputBatch.push(input);
+                m_pendingInputs.emplace_back(input.timestamp, now);
+                m_lastInput = (m_lastInput + 1) % vehicle.history.size();
+
+                if (++m_stepCount >= m_packetInterval)
+                {
+                    m_stepCount = 0;
+
+                    m_packetWriter.clear();
+                    m_inputBatch.write(m_packetWriter);
+
+                    const auto& data = m_packetWriter.getData();
+                    send(PacketID::ClientInput, data.data(), data.size(), xy::NetFlag::Unreliable);
+                }
+            }
+        }
+
+        bool racing() const { return m_phase == Phase::Racing; }
+        bool disconnected() const { return m_phase == Phase::Disconnected; }
+
+        std::size_t getBytesIn() const { return m_bytesIn; }
+        std::size_t getBytesOut() const { return m_bytesOut; }
+        std::size_t getPacketsIn() const { return m_packetsIn; }
+        std::size_t getPacketsOut() const { return m_packetsOut; }
+        std::size_t getRaceCount() const { return m_raceCount; }
+        std::vector<std::int64_t>& getLatency() { return m_latency; }
+
+    private:
+        enum class Phase
+        {
+            Idle, Lobby, Loading, Racing, Disconnected
+        }m_phase = Phase::Idle;
+
+        xy::NetClient m_client;
+        std::uint16_t m_port = 0;
+        std::size_t m_expectedClients = 0;
+        bool m_host = false;
+        std::size_t m_index = 0;
+        std::string m_mapName;
+        std::map<std::uint64_t, bool> m_readyStates; //human players only
+        sf::Clock m_readyClock;
+        sf::Clock m_pingClock;
+
+        std::unique_ptr<Race> m_race;
+        std::size_t m_raceCount = 0;
+
+        InputBatch m_inputBatch;
+        BitWriter m_packetWriter;
+        std::size_t m_packetInterval = 2;
+        std::size_t m_stepCount = 0;
+        std::size_t m_lastInput = 0;
+        std::int32_t m_timestamp = 0;
+
+        //timestamp of each input sent and the local time at which it was created
+        sf::Clock m_localClock;
+        std::deque<std::pair<std::int32_t, std::int64_t>> m_pendingInputs;
+        std::vector<std::int64_t> m_latency;
+
+        std::size_t m_bytesIn = 0;
+        std::size_t m_bytesOut = 0;
+        std::size_t m_packetsIn = 0;
+        std::size_t m_packetsOut = 0;
+
+        template <typename T>
+        void send(std::uint8_t id, const T& data, xy::NetFlag flag)
+        {
+            m_client.sendPacket(id, data, flag);
+            m_bytesOut += sizeof(T) + sizeof(std::uint8_t);
+            m_packetsOut++;
+        }
+
+        void send(std::uint8_t id, const void* data, std::size_t size, xy::NetFlag flag)
+        {
+            m_client.sendPacket(id, data, size, flag);
+            m_bytesOut += size + sizeof(std::uint8_t);
+            m_packetsOut++;
+        }
+
+        void handlePacket(const xy::NetEvent& evt)
+        {
+            const auto& packet = evt.packet;
+            switch (packet.getID())
+            {
+            default: break;
+            case PacketID::ErrorServerFull:
+            case PacketID::ErrorServerMap:
+            case PacketID::ErrorServerGeneric:
+            case PacketID::ErrorServerDisconnect:
+                xy::Logger::log("Swarm client " + std::to_string(m_index) + " received server error " + std::to_string(packet.getID()), xy::Logger::Type::Error);
+                m_race.reset();
+                m_phase = Phase::Disconnected;
+                break;
+            case PacketID::RequestPlayerName:
+            {
+                sf::String name = "Swarm " + std::to_string(m_index);
+                auto nameBytes = name.toUtf32();
+                auto size = std::min(nameBytes.size() * sizeof(sf::Uint32), NetConst::MaxNameSize);
+                send(PacketID::NameString, nameBytes.data(), size, xy::NetFlag::Reliable);
+                send(PacketID::VehicleChanged, static_cast<std::uint8_t>(m_index % 3), xy::NetFlag::Reliable);
+            }
+                break;
+            case PacketID::DeliverMapName:
+                m_mapName.assign(static_cast<const char*>(packet.getData()), packet.getSize());
+                break;
+            case PacketID::DeliverPlayerData:
+            {
+                auto data = packet.as<PlayerData>();
+                if (data.peerID <= std::numeric_limits<std::uint32_t>::max())
+                {
+                    m_readyStates[data.peerID] = data.ready;
+                }
+            }
+                break;
+            case PacketID::LeftLobby:
+                m_readyStates.erase(packet.as<std::uint64_t>());
+                break;
+            case PacketID::GameStarted:
+                if (m_phase == Phase::Lobby)
+                {
+                    m_race = std::make_unique<Race>();
+                    if (!m_race->mapParser.load("assets/maps/" + m_mapName))
+                    {
+                        xy::Logger::log("Swarm client " + std::to_string(m_index) + " failed to load " + m_mapName, xy::Logger::Type::Error);
+                        m_race.reset();
+                        m_phase = Phase::Disconnected;
+                        break;
+                    }
+                    m_race->snapshotQuantiser.setMapSize(m_race->mapParser.getSize());
+                    m_race->actorCount = packet.as<GameStart>().actorCount;
+
+                    m_phase = Phase::Loading;
+                    m_readyStates.clear();
+                    send(PacketID::ClientMapLoaded, std::uint8_t(0), xy::NetFlag::Reliable);
+                }
+                break;
+            case PacketID::VehicleData:
+                if (m_race)
+                {
+                    spawnVehicle(packet.as<VehicleData>());
+                    actorReceived();
+                }
+                break;
+            case PacketID::ActorData:
+                if (m_race)
+                {
+                    actorReceived();
+                }
+                break;
+            case PacketID::RaceStarted:
+                if (m_race && m_race->vehicle.isValid())
+                {
+                    m_race->vehicle.getComponent<Vehicle>().stateFlags = (1 << Vehicle::Normal);
+                }
+                break;
+            case PacketID::ClientUpdate:
+                if (m_race && m_race->vehicle.isValid())
+                {
+                    const auto& update = packet.as<ClientUpdate>();
+                    measureLatency(update.clientTimestamp);
+                    m_race->scene.getSystem<VehicleSystem>().reconcile(update, m_race->vehicle);
+                }
+                break;
+            case PacketID::Snapshot:
+                if (m_race)
+                {
+                    BitReader reader(packet.getData(), packet.getSize());
+                    Snapshot snapshot;
+                    if (m_race->snapshotDecoder.read(reader, m_race->snapshotQuantiser, snapshot))
+                    {
+                        send(PacketID::SnapshotAck, snapshot.id, xy::NetFlag::Unreliable);
+                    }
+                }
+                break;
+            case PacketID::RaceFinished:
+                //the server returns to the lobby
+                if (m_race && m_race->vehicle.isValid())
+                {
+                    m_timestamp = m_race->vehicle.getComponent<AIDriver>().timestamp;
+                }
+                m_race.reset();
+                m_phase = Phase::Lobby;
+                break;
+            }
+        }
+
+        void spawnVehicle(const VehicleData& data)
+        {
+            auto entity = m_race->scene.createEntity();
+            entity.addComponent<xy::Transform>().setPosition(data.x, data.y);
+            entity.getComponent<xy::Transform>().setRotation(data.rotation);
+            entity.addComponent<Vehicle>().type = static_cast<Vehicle::Type>(data.vehicleType);
+            entity.getComponent<Vehicle>().waypointCount = m_race->mapParser.getWaypointCount();
+            entity.getComponent<Vehicle>().client = true;
+
+            entity.addComponent<CollisionObject>().type = CollisionObject::Vehicle;
+            entity.addComponent<xy::BroadphaseComponent>().setFilterFlags(CollisionFlags::Vehicle);
+
+            switch (entity.getComponent<Vehicle>().type)
+            {
+            default:
+            case Vehicle::Car:
+                entity.getComponent<Vehicle>().settings = Definition::car;
+                entity.getComponent<CollisionObject>().applyVertices(GameConst::CarPoints);
+                entity.getComponent<xy::BroadphaseComponent>().setArea(GameConst::CarSize);
+                break;
+            case Vehicle::Bike:
+                entity.getComponent<Vehicle>().settings = Definition::bike;
+                entity.getComponent<CollisionObject>().applyVertices(GameConst::BikePoints);
+                entity.getComponent<xy::BroadphaseComponent>().setArea(GameConst::BikeSize);
+                break;
+            case Vehicle::Ship:
+                entity.getComponent<Vehicle>().settings = Definition::ship;
+                entity.getComponent<CollisionObject>().applyVertices(GameConst::ShipPoints);
+                entity.getComponent<xy::BroadphaseComponent>().setArea(GameConst::ShipSize);
+                break;
+            }
+            auto bounds = entity.getComponent<xy::BroadphaseComponent>().getArea();
+            entity.getComponent<xy::Transform>().setOrigin(bounds.width * GameConst::VehicleCentreOffset, bounds.height / 2.f);
+
+            //input timestamps carry on from the last race, as the
+            //game client's do, so the server never sees an old one
+            entity.addComponent<AIDriver>().target = m_race->mapParser.getStartPosition().first;
+            entity.getComponent<AIDriver>().skill = static_cast<AIDriver::Skill>(m_index % 3);
+            entity.getComponent<AIDriver>().timestamp = m_timestamp;
+
+            m_race->vehicle = entity;
+            m_lastInput = 0;
+            m_pendingInputs.clear();
+        }
+
+        void actorReceived()
+        {
+            if (--m_race->actorCount == 0)
+            {
+                send(PacketID::ClientReady, std::uint8_t(0), xy::NetFlag::Reliable);
+                m_phase = Phase::Racing;
+                m_raceCount++;
+            }
+        }
+
+        void measureLatency(std::int32_t timestamp)
+        {
+            const auto now = m_localClock.getElapsedTime().asMicroseconds();
+            while (!m_pendingInputs.empty()
+                && m_pendingInputs.front().first <= timestamp)
+            {
+                if (m_pendingInputs.front().first == timestamp)
+                {
+                    m_latency.push_back((now - m_pendingInputs.front().second) / 1000);
+                }
+                m_pendingInputs.pop_front();
+            }
+        }
+    };
+
+    void printUsage()
+    {
+        std::cout << "Usage: space_racers_swarm [-m <race count>] [-c <clients per race>] [-t <seconds>]\n"
+            << "                          [-p <first port>] [-i <steps per input packet>]\n"
+            << "                          [-r <resource directory>]\n";
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (auto i = 1; i < argc; ++i)
+        {
+            std::string arg(argv[i]);
+            if (i + 1 >= argc)
+            {
+                return false;
+            }
+            std::string value(argv[++i]);
+
+            if (arg == "-m")
+            {
+                auto count = std::atoi(value.c_str());
+                if (count < 1 || count > static_cast<int>(MaxRaces))
+                {
+                    return false;
+                }
+                options.raceCount = count;
+            }
+            else if (arg == "-c")
+            {
+                auto count = std::atoi(value.c_str());
+                if (count < 1 || count > LobbyData::MaxPlayers)
+                {
+                    return false;
+                }
+                options.clientsPerRace = count;
+            }
+            else if (arg == "-t")
+            {
+                options.duration = static_cast<float>(std::atof(value.c_str()));
+                if (options.duration <= 0)
+                {
+                    return false;
+                }
+            }
+            else if (arg == "-p")
+            {
+                auto port = std::atoi(value.c_str());
+                if (port < 1 || port > 0xffff)
+                {
+                    return false;
+                }
+                options.basePort = static_cast<std::uint16_t>(port);
+            }
+            else if (arg == "-i")
+            {
+                auto interval = std::atoi(value.c_str());
+                if (interval < 1 || interval > static_cast<int>(InputBatch::MaxInputs))
+                {
+                    return false;
+                }
+                options.packetInterval = interval;
+            }
+            else if (arg == "-r")
+            {
+                options.resourceDirectory = value;
+            }
+            else
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        printUsage();
+        return 1;
+    }
+
+    if (options.basePort + options.raceCount > 0xffff)
+    {
+        xy::Logger::log("Port range exceeds 65535", xy::Logger::Type::Error);
+        return 1;
+    }
+
+    if (!options.resourceDirectory.empty())
+    {
+        xy::FileSystem::setResourceDirectory(options.resourceDirectory);
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    struct RaceServer final
+    {
+        std::unique_ptr<sv::Server> server;
+        std::uint64_t lastTickCount = 0;
+        std::vector<std::int64_t> tickTimes;
+        std::vector<std::int64_t> netTimes;
+    };
+    std::vector<RaceServer> servers(options.raceCount);
+    std::vector<std::unique_ptr<SwarmClient>> clients;
+
+    for (auto i = 0u; i < servers.size(); ++i)
+    {
+        auto port = static_cast<std::uint16_t>(options.basePort + i);
+
+        auto& server = servers[i];
+        server.server = std::make_unique<sv::Server>();
+        server.server->setPort(port);
+        server.server->setDedicated(true);
+        if (!server.server->run(sv::StateID::Lobby))
+        {
+            return 1;
+        }
+
+        for (auto j = 0u; j < options.clientsPerRace; ++j)
+        {
+            auto idx = clients.size();
+            clients.emplace_back(std::make_unique<SwarmClient>(port, options.clientsPerRace, j == 0, idx, options.packetInterval));
+            if (!clients.back()->connect())
+            {
+                xy::Logger::log("Client " + std::to_string(idx) + " failed to connect to port " + std::to_string(port), xy::Logger::Type::Error);
+            }
+        }
+    }
+
+    xy::Logger::log("Running " + std::to_string(clients.size()) + " clients across " + std::to_string(servers.size()) + " races", xy::Logger::Type::Info);
+
+    sf::Clock runClock;
+    sf::Clock stepClock;
+    float stepAccumulator = 0.f;
+    float racingTime = 0.f;
+
+    while (running
+        && runClock.getElapsedTime().asSeconds() < options.duration)
+    {
+        //sample the server tick times as they change. If the server
+        //has to catch up with several ticks some samples will be missed
+        for (auto& server : servers)
+        {
+            auto tickCount = server.server->getTickCount();
+            if (tickCount != server.lastTickCount)
+            {
+                server.lastTickCount = tickCount;
+                server.tickTimes.push_back(server.server->getLastTickTime());
+                server.netTimes.push_back(server.server->getLastNetTime());
+            }
+        }
+
+        for (auto& client : clients)
+        {
+            client->pollNetwork();
+        }
+
+        auto dt = stepClock.restart().asSeconds();
+        stepAccumulator += dt;
+        while (stepAccumulator >= Vehicle::StepTime)
+        {
+            stepAccumulator -= Vehicle::StepTime;
+            for (auto& client : clients)
+            {
+                client->step();
+            }
+        }
+
+        if (std::any_of(clients.begin(), clients.end(), [](const std::unique_ptr<SwarmClient>& c) {return c->racing(); }))
+        {
+            racingTime += dt;
+        }
+
+        if (std::all_of(clients.begin(), clients.end(), [](const std::unique_ptr<SwarmClient>& c) {return c->disconnected(); }))
+        {
+            xy::Logger::log("All clients disconnected", xy::Logger::Type::Error);
+            break;
+        }
+
+        sf::sleep(sf::milliseconds(1));
+    }
+
+    //report
+    std::vector<std::int64_t> allTicks;
+    std::vector<std::int64_t> allNetTicks;
+    std::cout << "\nServer logic tick time (us)\n";
+    std::cout << std::setw(8) << "race" << std::setw(10) << "ticks" << std::setw(10) << "p50" << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max\n";
+    for (auto i = 0u; i < servers.size(); ++i)
+    {
+        auto& ticks = servers[i].tickTimes;
+        allTicks.insert(allTicks.end(), ticks.begin(), ticks.end());
+        allNetTicks.insert(allNetTicks.end(), servers[i].netTimes.begin(), servers[i].netTimes.end());
+
+        std::cout << std::setw(8) << i << std::setw(10) << ticks.size()
+            << std::setw(10) << percentile(ticks, 0.5f)
+            << std::setw(10) << percentile(ticks, 0.95f)
+            << std::setw(10) << percentile(ticks, 0.99f)
+            << std::setw(10) << percentile(ticks, 1.f) << "\n";
+    }
+    std::cout << std::setw(8) << "all" << std::setw(10) << allTicks.size()
+        << std::setw(10) << percentile(allTicks, 0.5f)
+        << std::setw(10) << percentile(allTicks, 0.95f)
+        << std::setw(10) << percentile(allTicks, 0.99f)
+        << std::setw(10) << percentile(allTicks, 1.f) << "\n";
+    std::cout << "Server net update time (us) p50: " << percentile(allNetTicks, 0.5f)
+        << " p95: " << percentile(allNetTicks, 0.95f)
+        << " p99: " << percentile(allNetTicks, 0.99f)
+        << " max: " << percentile(allNetTicks, 1.f) << "\n";
+
+    const float seconds = std::max(racingTime, 1.f);
+    std::vector<std::int64_t> allLatency;
+    std::cout << "\nPer client traffic (bytes/sec over " << seconds << "s of racing) and input to ack latency (ms)\n";
+    std::cout << std::setw(8) << "client" << std::setw(8) << "races" << std::setw(12) << "in B/s" << std::setw(12) << "out B/s"
+        << std::setw(10) << "pkt in" << std::setw(10) << "pkt out" << std::setw(8) << "p50" << std::setw(8) << "p95" << std::setw(8) << "p99\n";
+    for (auto i = 0u; i < clients.size(); ++i)
+    {
+        auto& client = clients[i];
+        auto& latency = client->getLatency();
+        allLatency.insert(allLatency.end(), latency.begin(), latency.end());
+
+        std::cout << std::setw(8) << i
+            << std::setw(8) << client->getRaceCount()
+            << std::setw(12) << static_cast<std::size_t>(client->getBytesIn() / seconds)
+            << std::setw(12) << static_cast<std::size_t>(client->getBytesOut() / seconds)
+            << std::setw(10) << client->getPacketsIn()
+            << std::setw(10) << client->getPacketsOut()
+            << std::setw(8) << percentile(latency, 0.5f)
+            << std::setw(8) << percentile(latency, 0.95f)
+            << std::setw(8) << percentile(latency, 0.99f) << "\n";
+    }
+    std::cout << "all input to ack latency (ms) p50: " << percentile(allLatency, 0.5f)
+        << " p95: " << percentile(allLatency, 0.95f)
+        << " p99: " << percentile(allLatency, 0.99f)
+        << " max: " << percentile(allLatency, 1.f) << "\n\n";
+
+    for (auto& client : clients)
+    {
+        client->disconnect();
+    }
+
+    for (auto& server : servers)
+    {
+        server.server->quit();
+    }
+
+    return 0;
+}
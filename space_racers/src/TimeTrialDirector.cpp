@@ -38,8 +38,6 @@ Copyright 2019 Matt Marchant
 
 #include <xyginext/core/FileSystem.hpp>
 
-#include <cstring>
-#include <fstream>
 
 namespace
 {
@@ -53,14 +51,36 @@ TimeTrialDirector::TimeTrialDirector(ResourceCollection rc, const std::string& m
     m_mapName       (mapName),
     m_vehicleType   (vt),
     m_sharedData    (sd),
-    m_recordedPoints(MaxPoints),
-    m_recordingIndex(0),
-    m_playbackPoints(MaxPoints),
-    m_playbackIndex (0),
+    m_ghostTime     (0.f),
+    m_ghostsLoaded  (false),
     m_ghostEnabled  (false)
 {
     m_mapName = m_mapName.substr(0, m_mapName.find(".tmx"));
     sd.lapTimes.clear();
+
+    m_recordedPoints.reserve(Ghost::MaxPoints);
+
+    auto directory = xy::FileSystem::getConfigDirectory(GameConst::AppName) + m_mapName;
+    if (!xy::FileSystem::directoryExists(directory))
+    {
+        xy::FileSystem::createDirectory(directory);
+    }
+
+    //start loading the best lap of each vehicle now
+    //so they're ready by the end of the countdown
+    std::vector<std::string> paths;
+    m_ghosts.emplace_back().vehicleType = m_vehicleType;
+    paths.push_back(getGhostPath(m_vehicleType));
+
+    for (auto type : { Vehicle::Car, Vehicle::Bike, Vehicle::Ship })
+    {
+        if (type != m_vehicleType)
+        {
+            m_ghosts.emplace_back().vehicleType = type;
+            paths.push_back(getGhostPath(type));
+        }
+    }
+    m_ghostLoader.load(paths);
 }
 
 //public
@@ -75,7 +95,8 @@ void TimeTrialDirector::handleMessage(const xy::Message& msg)
             m_updateDisplay = true;
             m_ghostEnabled = true;
 
-            loadGhost();
+            m_ghostTime = 0.f;
+            m_recordedPoints.clear();
         }
         else if (data.type == GameEvent::RaceEnded)
         {
@@ -114,17 +135,17 @@ void TimeTrialDirector::handleMessage(const xy::Message& msg)
                 msg2->type = GameEvent::NewBestTime;
                 msg2->position = data.entity.getComponent<xy::Transform>().getPosition();
 
-                m_playbackPoints.swap(m_recordedPoints);
+                m_ghosts.front().points.swap(m_recordedPoints);
                 saveGhost();
             }
 
-            //update ghost
-            m_playbackIndex = 0;
-            m_recordingIndex = 0;
+            //restart the ghosts
+            m_ghostTime = 0.f;
+            m_recordedPoints.clear();
 
-            if (!m_ghostEntity.isValid())
+            if (!m_ghosts.front().entity.isValid())
             {
-                createGhost();
+                createGhost(m_ghosts.front());
             }
 
             //update scoreboard
@@ -166,8 +187,13 @@ void TimeTrialDirector::handleMessage(const xy::Message& msg)
     }
 }
 
-void TimeTrialDirector::process(float)
+void TimeTrialDirector::process(float dt)
 {
+    if (!m_ghostsLoaded && m_ghostLoader.ready())
+    {
+        loadGhosts();
+    }
+
     if (m_updateDisplay)
     {
         //send command to display
@@ -191,32 +217,47 @@ void TimeTrialDirector::process(float)
     //update the ghost data
     if (m_ghostEnabled)
     {
-        //record position
+        //record position at a fixed rate, whatever the frame rate
         const auto& tx = m_playerEntity.getComponent<xy::Transform>();
-        m_recordedPoints[m_recordingIndex] = { tx.getPosition(), tx.getRotation(), tx.getScale().x };
-        m_recordingIndex = (m_recordingIndex + 1) % MaxPoints;
-
-        //update any active ghost
-        if (m_ghostEntity.isValid())
+        while (m_recordedPoints.size() < Ghost::MaxPoints
+            && static_cast<float>(m_recordedPoints.size()) * Ghost::SampleTime <= m_ghostTime)
         {
-            auto& ghostTx = m_ghostEntity.getComponent<xy::Transform>();
-            const auto& point = m_playbackPoints[m_playbackIndex];
+            m_recordedPoints.emplace_back(tx.getPosition(), tx.getRotation(), tx.getScale().x);
+        }
+
+        //update any active ghosts
+        const float position = m_ghostTime / Ghost::SampleTime;
+        const auto index = static_cast<std::size_t>(position);
+        const float interp = position - static_cast<float>(index);
 
-            ghostTx.setPosition(point.x, point.y);
-            ghostTx.setRotation(point.rotation);
-            ghostTx.setScale(point.scale, point.scale);
+        for (auto& ghost : m_ghosts)
+        {
+            if (ghost.entity.isValid())
+            {
+                auto& ghostTx = ghost.entity.getComponent<xy::Transform>();
+                const auto point = Ghost::getPoint(ghost.points, index, interp);
 
-            m_playbackIndex = (m_playbackIndex + 1) % MaxPoints;
+                ghostTx.setPosition(point.x, point.y);
+                ghostTx.setRotation(point.rotation);
+                ghostTx.setScale(point.scale, point.scale);
+            }
         }
+
+        m_ghostTime += dt;
     }
 }
 
 //private
-void TimeTrialDirector::createGhost()
+void TimeTrialDirector::createGhost(GhostTrack& ghost)
 {
+    if (ghost.points.empty())
+    {
+        return;
+    }
+
     auto entity = m_resources.gameScene->createEntity();
-    entity.addComponent<xy::Transform>().setPosition(m_playbackPoints[0].x, m_playbackPoints[0].y);
-    entity.getComponent<xy::Transform>().setRotation(m_playbackPoints[0].rotation);
+    entity.addComponent<xy::Transform>().setPosition(ghost.points[0].x, ghost.points[0].y);
+    entity.getComponent<xy::Transform>().setRotation(ghost.points[0].rotation);
     entity.addComponent<InverseRotation>();
     entity.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth + 1);
     entity.getComponent<xy::Drawable>().setShader(&m_resources.shaders->get(ShaderID::Ghost));
@@ -225,7 +266,7 @@ void TimeTrialDirector::createGhost()
     entity.getComponent<xy::Drawable>().bindUniform("u_specularMap", m_resources.resources->get<sf::Texture>(m_resources.textureIDs->at(TextureID::Game::VehicleSpecular)));
     entity.getComponent<xy::Drawable>().bindUniform("u_lightRotationMatrix", entity.getComponent<InverseRotation>().matrix.getMatrix());
     
-    switch (m_vehicleType)
+    switch (ghost.vehicleType)
     {
     default:
     case Vehicle::Car:
@@ -239,85 +280,65 @@ void TimeTrialDirector::createGhost()
         break;
     }
 
-    entity.getComponent<xy::Sprite>().setColour({ 255,255,255,120 });
+    //other vehicles are fainter than the player's own ghost
+    entity.getComponent<xy::Sprite>().setColour({ 255,255,255, std::uint8_t(ghost.vehicleType == m_vehicleType ? 120 : 60) });
     auto bounds = entity.getComponent<xy::Sprite>().getTextureBounds();
     entity.getComponent<xy::Transform>().setOrigin(bounds.width * GameConst::VehicleCentreOffset, bounds.height / 2.f);
 
-    m_ghostEntity = entity;
+    ghost.entity = entity;
 }
 
-void TimeTrialDirector::loadGhost()
+void TimeTrialDirector::loadGhosts()
 {
-    auto path = getGhostPath();
-    if (xy::FileSystem::fileExists(path))
+    m_ghostsLoaded = true;
+
+    //results are in the same order as the ghosts
+    auto& results = m_ghostLoader.getResults();
+    for (auto i = 0u; i < results.size(); ++i)
     {
-        std::ifstream file(path, std::ios::binary);
-        if (file.is_open() && file.good())
+        if (!results[i].loaded)
         {
-            auto expectedSize = MaxPoints * sizeof(Point);
-            expectedSize += sizeof(float);
+            continue;
+        }
 
-            file.seekg(0, file.end);
-            auto fileSize = file.tellg();
-            if (fileSize != expectedSize)
+        if (i == 0)
+        {
+            //the player may already have beaten it
+            auto lapTime = results[i].lapTime;
+            if (lapTime >= m_fastestLap)
             {
-                file.close();
-                return;
+                continue;
             }
-            file.seekg(file.beg);
-
-            std::vector<char> buffer(fileSize);
-            file.read(buffer.data(), fileSize);
-            file.close();
-
-            std::memcpy(&m_fastestLap, buffer.data(), sizeof(float));
-            std::memcpy(m_playbackPoints.data(), buffer.data() + sizeof(float), MaxPoints * sizeof(Point));
-
-            createGhost();
+            m_fastestLap = lapTime;
 
             xy::Command cmd;
             cmd.targetFlags = CommandID::UI::BestTimeText;
-            cmd.action = [&](xy::Entity entity, float)
+            cmd.action = [lapTime](xy::Entity entity, float)
             {
-                entity.getComponent<xy::Text>().setString(formatTimeString(m_fastestLap));
+                entity.getComponent<xy::Text>().setString(formatTimeString(lapTime));
             };
             sendCommand(cmd);
         }
-    }
-    else
-    {
-        xy::FileSystem::createDirectory(xy::FileSystem::getConfigDirectory(GameConst::AppName) + m_mapName);
+
+        auto& ghost = m_ghosts[i];
+        ghost.points.swap(results[i].points);
+        if (!ghost.entity.isValid())
+        {
+            createGhost(ghost);
+        }
     }
 }
 
 void TimeTrialDirector::saveGhost()
 {
-    auto path = getGhostPath();
-
-    auto fileSize = MaxPoints * sizeof(Point);
-    fileSize += sizeof(float);
-
-    std::vector<char> buffer(fileSize);
-    std::memcpy(buffer.data(), &m_fastestLap, sizeof(float));
-    std::memcpy(buffer.data() + sizeof(float), m_playbackPoints.data(), sizeof(Point) * MaxPoints);
-
-    std::ofstream file(path, std::ios::binary);
-    if (file.is_open() && file.good())
-    {
-        file.write(buffer.data(), buffer.size());
-    }
-    else
-    {
-        xy::Logger::log("Failed writing ghost to " + path, xy::Logger::Type::Error);
-    }
-    file.close();
+    Ghost::save(getGhostPath(m_vehicleType), m_ghosts.front().points, m_fastestLap);
 }
 
-std::string TimeTrialDirector::getGhostPath() const
+std::string TimeTrialDirector::getGhostPath(std::int32_t vehicleType) const
 {
     auto path = xy::FileSystem::getConfigDirectory(GameConst::AppName);
     path += m_mapName;
-    path += "/" + std::to_string(m_vehicleType) + ".gst";
+    path += "/" + std::to_string(vehicleType) + ".gst";
     return path;
 }
 
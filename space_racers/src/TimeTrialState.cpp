@@ -35,6 +35,7 @@ Copyright 2019 Matt Marchant
 #include "SliderSystem.hpp"
 #include "NixieDisplay.hpp"
 #include "SkidEffectSystem.hpp"
+#include "VehicleEffects.hpp"
 #include "EngineAudioSystem.hpp"
 #include "SoundEffectsDirector.hpp"
 
@@ -548,7 +549,7 @@ void TimeTrialState::loadResources()
     m_shaders.preload(ShaderID::Asteroid, SpriteVertex, GlobeFragment);
     m_shaders.preload(ShaderID::Vehicle, VehicleVertex, VehicleFrag);
     m_shaders.preload(ShaderID::Ghost, VehicleVertex, GhostFrag);
-    m_shaders.preload(ShaderID::Trail, VehicleTrail, sf::Shader::Fragment);
+    loadVehicleEffectShaders(m_shaders);
     m_shaders.preload(ShaderID::Text, TextFragment, sf::Shader::Fragment);
     m_shaders.preload(ShaderID::Shield, ShieldFragment, sf::Shader::Fragment);
 
@@ -625,6 +626,8 @@ bool TimeTrialState::loadMap()
     m_gameScene.setActiveCamera(camEnt);
     m_gameScene.setActiveListener(camEnt);
 
+    createVehicleEffectBatches(m_gameScene, m_shaders, m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
+
     //dem starrs
     std::array<std::size_t, 3u> IDs =
     {
@@ -883,7 +886,6 @@ void TimeTrialState::spawnVehicle()
         {
             auto skidEntity = m_gameScene.createEntity();
             skidEntity.addComponent<xy::Transform>();
-            skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
             skidEntity.addComponent<SkidEffect>().parent = entity;
         }
         break;
@@ -896,7 +898,6 @@ void TimeTrialState::spawnVehicle()
         {
             auto skidEntity = m_gameScene.createEntity();
             skidEntity.addComponent<xy::Transform>();
-            skidEntity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
             skidEntity.addComponent<SkidEffect>().parent = entity;
             skidEntity.getComponent<SkidEffect>().wheelCount = 1;
         }
@@ -972,10 +973,6 @@ void TimeTrialState::spawnTrail(xy::Entity parent, sf::Color colour)
 {
     auto trailEnt = m_gameScene.createEntity();
     trailEnt.addComponent<xy::Transform>();
-    trailEnt.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
-    trailEnt.getComponent<xy::Drawable>().setTexture(&m_resources.get<sf::Texture>(m_textureIDs[TextureID::Game::VehicleTrail]));
-    trailEnt.getComponent<xy::Drawable>().setShader(&m_shaders.get(ShaderID::Trail));
-    trailEnt.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
     trailEnt.addComponent<Trail>().parent = parent;
     trailEnt.getComponent<Trail>().colour = colour;
     trailEnt.addComponent<xy::CommandTarget>().ID = CommandID::Game::Trail;
@@ -0,0 +1,388 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "TrackCache.hpp"
+#include "GameConsts.hpp"
+#include "CollisionObject.hpp"
+#include "Util.hpp"
+
+#include <xyginext/core/FileSystem.hpp>
+#include <xyginext/core/Log.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+#include <type_traits>
+
+namespace
+{
+    const std::uint32_t Magic = 0x4b415254; //TRAK
+
+    //this must be increased whenever the format or the
+    //way in which the MapParser reads maps is changed
+    const std::uint32_t Version = 1;
+
+    //magic, version, map hash
+    const std::size_t HeaderSize = sizeof(std::uint32_t) * 2 + sizeof(std::uint64_t);
+
+    class Writer final
+    {
+    public:
+        template <typename T>
+        void write(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "");
+            const auto* bytes = reinterpret_cast<const std::uint8_t*>(&value);
+            m_data.insert(m_data.end(), bytes, bytes + sizeof(T));
+        }
+
+        template <typename T>
+        void write(const std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "");
+            write(static_cast<std::uint32_t>(values.size()));
+            const auto* bytes = reinterpret_cast<const std::uint8_t*>(values.data());
+            m_data.insert(m_data.end(), bytes, bytes + (values.size() * sizeof(T)));
+        }
+
+        void write(const std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& values)
+        {
+            write(static_cast<std::uint32_t>(values.size()));
+            for (const auto& [first, second] : values)
+            {
+                write(first);
+                write(second);
+            }
+        }
+
+        void write(const std::string& str)
+        {
+            write(std::vector<char>(str.begin(), str.end()));
+        }
+
+        std::vector<std::uint8_t>& getData() { return m_data; }
+
+    private:
+        std::vector<std::uint8_t> m_data;
+    };
+
+    class Reader final
+    {
+    public:
+        Reader(const std::uint8_t* data, std::size_t size)
+            : m_data(data), m_size(size), m_offset(0), m_failed(false) {}
+
+        template <typename T>
+        void read(T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "");
+            if (auto* src = take(sizeof(T)); src)
+            {
+                std::memcpy(&value, src, sizeof(T));
+            }
+        }
+
+        template <typename T>
+        void read(std::vector<T>& values)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "");
+            std::uint32_t count = 0;
+            read(count);
+
+            //check the size before allocating anything
+            if (count > (m_size - m_offset) / sizeof(T))
+            {
+                m_failed = true;
+                return;
+            }
+
+            values.resize(count);
+            if (auto* src = take(count * sizeof(T)); src && count)
+            {
+                std::memcpy(values.data(), src, count * sizeof(T));
+            }
+        }
+
+        void read(std::vector<std::pair<sf::Vector2f, sf::Vector2f>>& values)
+        {
+            std::vector<sf::Vector2f> points;
+            read(points);
+            values.clear();
+            for (auto i = 0u; i + 1 < points.size(); i += 2)
+            {
+                values.emplace_back(points[i], points[i + 1]);
+            }
+        }
+
+        void read(std::string& str)
+        {
+            std::vector<char> chars;
+            read(chars);
+            str.assign(chars.begin(), chars.end());
+        }
+
+        bool failed() const { return m_failed; }
+        bool finished() const { return m_offset == m_size; }
+
+    private:
+        const std::uint8_t* m_data;
+        std::size_t m_size;
+        std::size_t m_offset;
+        bool m_failed;
+
+        const std::uint8_t* take(std::size_t size)
+        {
+            if (m_failed || m_size - m_offset < size)
+            {
+                m_failed = true;
+                return nullptr;
+            }
+
+            const auto* retVal = m_data + m_offset;
+            m_offset += size;
+            return retVal;
+        }
+    };
+
+    //the same function writes and reads the data, so that
+    //the order of the fields can never differ between them
+    template <typename Stream, typename Data>
+    void serialise(Stream& stream, Data& data)
+    {
+        auto objectCount = static_cast<std::uint32_t>(data.objects.size());
+        stream.write(objectCount);
+        if constexpr (std::is_const<Data>::value == false)
+        {
+            data.objects.resize(std::min<std::uint32_t>(objectCount, 0x10000));
+        }
+
+        for (auto& obj : data.objects)
+        {
+            stream.write(obj.type);
+            stream.write(obj.waypoint);
+            stream.write(obj.position);
+            stream.write(obj.area);
+            stream.write(obj.vertices);
+            stream.write(obj.normals);
+            stream.write(obj.worldVertices);
+            stream.write(obj.worldNormals);
+        }
+        stream.write(data.waypoints);
+
+        stream.write(data.startPosition);
+        stream.write(data.startRotation);
+        stream.write(data.trackLength);
+        stream.write(data.size);
+
+        stream.write(data.fences);
+        stream.write(data.chevrons);
+        stream.write(data.barriers);
+        stream.write(data.pylons);
+        stream.write(data.bollards);
+
+        auto tileSetCount = static_cast<std::uint32_t>(data.tileSets.size());
+        stream.write(tileSetCount);
+        if constexpr (std::is_const<Data>::value == false)
+        {
+            data.tileSets.resize(std::min<std::uint32_t>(tileSetCount, 0x100));
+        }
+
+        for (auto& tileSet : data.tileSets)
+        {
+            stream.write(tileSet.imagePath);
+            stream.write(tileSet.firstGID);
+            stream.write(tileSet.lastGID);
+            stream.write(tileSet.columnCount);
+            stream.write(tileSet.tileSize);
+        }
+        stream.write(data.tileCount);
+        stream.write(data.tileSize);
+
+        for (auto& layer : data.tileLayers)
+        {
+            stream.write(layer);
+        }
+    }
+
+    //lets the reader be passed to serialise()
+    struct ReadStream final
+    {
+        Reader& reader;
+
+        template <typename T>
+        void write(T& value) { reader.read(value); }
+    };
+
+    std::vector<std::uint8_t> serialise(const TrackData& data)
+    {
+        Writer writer;
+        serialise(writer, data);
+        return std::move(writer.getData());
+    }
+}
+
+std::string TrackCache::getCachePath(const std::string& path)
+{
+    auto name = path.substr(0, path.find(".tmx"));
+    std::replace(name.begin(), name.end(), '/', '_');
+    std::replace(name.begin(), name.end(), '\\', '_');
+
+    return xy::FileSystem::getConfigDirectory(GameConst::AppName) + "tracks/" + name + ".trk";
+}
+
+std::uint64_t TrackCache::hashMap(const std::string& path)
+{
+    std::ifstream file(xy::FileSystem::getResourcePath() + path, std::ios::binary);
+    if (!file.is_open() || !file.good())
+    {
+        return 0;
+    }
+
+    std::vector<std::uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return fnv1a(data.data(), data.size());
+}
+
+bool TrackCache::load(const std::string& path, TrackData& dst)
+{
+    const auto mapHash = hashMap(path);
+    if (mapHash == 0)
+    {
+        return false;
+    }
+
+    std::ifstream file(getCachePath(path), std::ios::binary);
+    if (!file.is_open() || !file.good())
+    {
+        return false;
+    }
+
+    file.seekg(0, file.end);
+    const auto fileSize = static_cast<std::size_t>(file.tellg());
+    file.seekg(0, file.beg);
+
+    if (fileSize < HeaderSize + sizeof(std::uint64_t))
+    {
+        return false;
+    }
+
+    std::vector<std::uint8_t> data(fileSize);
+    file.read(reinterpret_cast<char*>(data.data()), fileSize);
+    if (!file.good())
+    {
+        return false;
+    }
+
+    //the file ends with a hash of everything before it
+    const auto size = fileSize - sizeof(std::uint64_t);
+    std::uint64_t checksum = 0;
+    std::memcpy(&checksum, data.data() + size, sizeof(checksum));
+    if (checksum != fnv1a(data.data(), size))
+    {
+        xy::Logger::log(getCachePath(path) + ": corrupt track cache", xy::Logger::Type::Warning);
+        return false;
+    }
+
+    Reader reader(data.data(), size);
+    std::uint32_t magic = 0;
+    std::uint32_t version = 0;
+    std::uint64_t bakedHash = 0;
+    reader.read(magic);
+    reader.read(version);
+    reader.read(bakedHash);
+
+    if (magic != Magic || version != Version || bakedHash != mapHash)
+    {
+        return false;
+    }
+
+    TrackData result;
+    ReadStream stream{ reader };
+    serialise(stream, result);
+
+    //the checksum only catches damage to the file, so make sure
+    //nothing read from it can index out of range when it's used
+    const auto validObject = [&result](const TrackData::Object& obj)
+    {
+        return obj.type >= 0 && obj.type < CollisionObject::Type::Count
+            && obj.waypoint >= -1 && obj.waypoint < static_cast<std::int32_t>(result.waypoints.size());
+    };
+
+    if (reader.failed() || !reader.finished()
+        || !std::all_of(result.objects.begin(), result.objects.end(), validObject))
+    {
+        xy::Logger::log(getCachePath(path) + ": invalid track cache", xy::Logger::Type::Warning);
+        return false;
+    }
+
+    dst = std::move(result);
+    return true;
+}
+
+bool TrackCache::save(const std::string& path, const TrackData& src)
+{
+    const auto mapHash = hashMap(path);
+    if (mapHash == 0)
+    {
+        return false;
+    }
+
+    Writer writer;
+    writer.write(Magic);
+    writer.write(Version);
+    writer.write(mapHash);
+    serialise(writer, src);
+
+    auto& data = writer.getData();
+    writer.write(fnv1a(data.data(), data.size()));
+
+    auto directory = xy::FileSystem::getConfigDirectory(GameConst::AppName) + "tracks";
+    if (!xy::FileSystem::directoryExists(directory))
+    {
+        xy::FileSystem::createDirectory(directory);
+    }
+
+    //several servers may bake the same map at once, so each writes
+    //its own file and moves it into place once it's complete
+    const auto cachePath = getCachePath(path);
+    const auto tempPath = cachePath + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    {
+        std::ofstream file(tempPath, std::ios::binary);
+        if (!file.is_open() || !file.good()
+            || !file.write(reinterpret_cast<const char*>(data.data()), data.size()))
+        {
+            xy::Logger::log("Failed writing track cache " + cachePath, xy::Logger::Type::Warning);
+            return false;
+        }
+    }
+
+    std::remove(cachePath.c_str());
+    if (std::rename(tempPath.c_str(), cachePath.c_str()) != 0)
+    {
+        std::remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool TrackCache::equal(const TrackData& a, const TrackData& b)
+{
+    return serialise(a) == serialise(b);
+}
@@ -0,0 +1,172 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "TrackCheck.hpp"
+#include "TrackCache.hpp"
+#include "MapParser.hpp"
+#include "CollisionObject.hpp"
+#include "WayPoint.hpp"
+
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/BroadPhaseComponent.hpp>
+#include <xyginext/ecs/systems/DynamicTreeSystem.hpp>
+
+#include <SFML/System/Clock.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+namespace
+{
+    struct MapScene final
+    {
+        xy::MessageBus messageBus;
+        xy::Scene scene;
+        MapParser parser;
+
+        MapScene()
+            : scene(messageBus), parser(scene)
+        {
+            scene.addSystem<xy::DynamicTreeSystem>(messageBus);
+        }
+
+        //every map entity, in the order they were created
+        std::vector<xy::Entity> getEntities()
+        {
+            //adds the entities to the tree
+            scene.update(0.f);
+
+            auto area = sf::FloatRect(sf::Vector2f(), parser.getSize());
+            area.left -= area.width;
+            area.top -= area.height;
+            area.width *= 3.f;
+            area.height *= 3.f;
+
+            auto entities = scene.getSystem<xy::DynamicTreeSystem>().query(area, CollisionFlags::Static);
+            std::sort(entities.begin(), entities.end());
+            return entities;
+        }
+    };
+
+    bool sameEntity(xy::Entity a, xy::Entity b)
+    {
+        if (a.getComponent<xy::Transform>().getPosition() != b.getComponent<xy::Transform>().getPosition()
+            || a.getComponent<xy::BroadphaseComponent>().getArea() != b.getComponent<xy::BroadphaseComponent>().getArea())
+        {
+            return false;
+        }
+
+        const auto& collisionA = a.getComponent<CollisionObject>();
+        const auto& collisionB = b.getComponent<CollisionObject>();
+        if (collisionA.type != collisionB.type
+            || collisionA.isStatic != collisionB.isStatic
+            || collisionA.vertices != collisionB.vertices
+            || collisionA.normals != collisionB.normals
+            || collisionA.worldVertices != collisionB.worldVertices
+            || collisionA.worldNormals != collisionB.worldNormals
+            || collisionA.worldBounds != collisionB.worldBounds
+            || collisionA.vertexX != collisionB.vertexX
+            || collisionA.vertexY != collisionB.vertexY
+            || collisionA.normalX != collisionB.normalX
+            || collisionA.normalY != collisionB.normalY
+            || collisionA.faceOffsets != collisionB.faceOffsets)
+        {
+            return false;
+        }
+
+        if (a.hasComponent<WayPoint>() != b.hasComponent<WayPoint>())
+        {
+            return false;
+        }
+
+        if (a.hasComponent<WayPoint>())
+        {
+            const auto& waypointA = a.getComponent<WayPoint>();
+            const auto& waypointB = b.getComponent<WayPoint>();
+            return waypointA.id == waypointB.id
+                && waypointA.nextPoint == waypointB.nextPoint
+                && waypointA.nextDistance == waypointB.nextDistance
+                && waypointA.rotation == waypointB.rotation
+                && waypointA.trackDistance == waypointB.trackDistance;
+        }
+        return true;
+    }
+
+    float timeLoad(const std::string& map, bool useCache, std::size_t repeatCount)
+    {
+        std::int64_t total = 0;
+        for (auto i = 0u; i < repeatCount; ++i)
+        {
+            auto mapScene = std::make_unique<MapScene>();
+
+            sf::Clock clock;
+            mapScene->parser.load(map, useCache);
+            total += clock.getElapsedTime().asMicroseconds();
+        }
+        return repeatCount ? static_cast<float>(total) / (repeatCount * 1000.f) : 0.f;
+    }
+}
+
+TrackCheckResult runTrackCheck(const std::string& map, std::size_t repeatCount)
+{
+    TrackCheckResult result;
+
+    auto parsed = std::make_unique<MapScene>();
+    if (!parsed->parser.load(map, false))
+    {
+        return result;
+    }
+    result.loaded = true;
+
+    //make sure the cache is up to date before loading from it
+    TrackCache::save(map, parsed->parser.getTrackData());
+
+    auto baked = std::make_unique<MapScene>();
+    baked->parser.load(map);
+    result.cacheUsed = baked->parser.loadedFromCache();
+    result.dataMatches = TrackCache::equal(parsed->parser.getTrackData(), baked->parser.getTrackData());
+
+    auto parsedEntities = parsed->getEntities();
+    auto bakedEntities = baked->getEntities();
+    result.entityCount = parsedEntities.size();
+
+    const auto count = std::min(parsedEntities.size(), bakedEntities.size());
+    result.mismatchCount = std::max(parsedEntities.size(), bakedEntities.size()) - count;
+    for (auto i = 0u; i < count; ++i)
+    {
+        if (parsedEntities[i].getIndex() != bakedEntities[i].getIndex()
+            || !sameEntity(parsedEntities[i], bakedEntities[i]))
+        {
+            result.mismatchCount++;
+        }
+    }
+
+    std::ifstream file(TrackCache::getCachePath(map), std::ios::binary | std::ios::ate);
+    if (file.is_open())
+    {
+        result.cacheSize = static_cast<std::size_t>(file.tellg());
+    }
+
+    result.parseTime = timeLoad(map, false, repeatCount);
+    result.cacheTime = timeLoad(map, true, repeatCount);
+
+    return result;
+}
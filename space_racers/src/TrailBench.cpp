@@ -0,0 +1,161 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "TrailBench.hpp"
+#include "TrailSystem.hpp"
+#include "SkidEffectSystem.hpp"
+#include "VehicleSystem.hpp"
+#include "InputBinding.hpp"
+
+#include <xyginext/core/MessageBus.hpp>
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/Drawable.hpp>
+#include <xyginext/ecs/components/ParticleEmitter.hpp>
+#include <xyginext/util/Const.hpp>
+
+#include <SFML/Graphics/Vertex.hpp>
+
+#include <vector>
+#include <cmath>
+
+namespace
+{
+    const float FrameTime = 1.f / 60.f;
+    const float DriftRadius = 400.f;
+    const float DriftSpeed = 1200.f; //fast enough to skid
+
+    //verts per trail when the whole strip was rebuilt
+    const std::size_t TrailVertCount = 1 + (std::tuple_size<decltype(Trail::points)>::value * 2);
+
+    void drift(xy::Entity entity, std::size_t index, float time)
+    {
+        const sf::Vector2f centre(static_cast<float>(index) * DriftRadius * 3.f, 0.f);
+        const float angle = (time * DriftSpeed / DriftRadius) + static_cast<float>(index);
+        const sf::Vector2f direction(-std::sin(angle), std::cos(angle));
+
+        auto& tx = entity.getComponent<xy::Transform>();
+        tx.setPosition(centre + (sf::Vector2f(std::cos(angle), std::sin(angle)) * DriftRadius));
+        tx.setRotation(angle * xy::Util::Const::radToDeg + 90.f);
+
+        entity.getComponent<Vehicle>().velocity = direction * DriftSpeed;
+    }
+}
+
+TrailBenchResult runTrailBench(std::size_t vehicleCount, float duration)
+{
+    TrailBenchResult result;
+
+    xy::MessageBus messageBus;
+    xy::Scene scene(messageBus);
+    auto& trailSystem = scene.addSystem<TrailSystem>(messageBus);
+    auto& skidSystem = scene.addSystem<SkidEffectSystem>(messageBus);
+
+    auto trailBatch = scene.createEntity();
+    trailBatch.addComponent<xy::Transform>();
+    trailBatch.addComponent<xy::Drawable>();
+    trailSystem.setBatchEntity(trailBatch);
+
+    auto skidBatch = scene.createEntity();
+    skidBatch.addComponent<xy::Transform>();
+    skidBatch.addComponent<xy::Drawable>();
+    skidSystem.setBatchEntity(skidBatch);
+
+    std::vector<xy::Entity> vehicles;
+    std::vector<xy::Entity> skids;
+    for (auto i = 0u; i < vehicleCount; ++i)
+    {
+        auto entity = scene.createEntity();
+        entity.addComponent<xy::Transform>();
+        entity.addComponent<Vehicle>().stateFlags = (1 << Vehicle::Normal);
+        entity.getComponent<Vehicle>().history[0].flags = InputFlag::Left;
+        entity.addComponent<xy::ParticleEmitter>();
+        drift(entity, i, 0.f);
+        vehicles.push_back(entity);
+
+        auto skidEntity = scene.createEntity();
+        skidEntity.addComponent<xy::Transform>();
+        skidEntity.addComponent<SkidEffect>().parent = entity;
+        skids.push_back(skidEntity);
+
+        auto trailEnt = scene.createEntity();
+        trailEnt.addComponent<xy::Transform>();
+        trailEnt.addComponent<Trail>().parent = entity;
+    }
+
+    float time = 0.f;
+    std::size_t frameCount = 0;
+    std::size_t trailBytes = 0;
+    std::size_t skidBytes = 0;
+    std::size_t rebuildBytes = 0;
+
+    const auto totalFrames = static_cast<std::size_t>(duration / FrameTime);
+    for (auto frame = 0u; frame < totalFrames; ++frame)
+    {
+        time += FrameTime;
+        for (auto i = 0u; i < vehicles.size(); ++i)
+        {
+            drift(vehicles[i], i, time);
+        }
+
+        const auto trailStart = trailSystem.getBytesWritten();
+        const auto skidStart = skidSystem.getBytesWritten();
+
+        scene.update(FrameTime);
+
+        while (!messageBus.empty())
+        {
+            scene.forwardMessage(messageBus.poll());
+        }
+
+        //the first frame adds the entities and fills the batches
+        if (frame == 0)
+        {
+            continue;
+        }
+
+        trailBytes += trailSystem.getBytesWritten() - trailStart;
+        skidBytes += skidSystem.getBytesWritten() - skidStart;
+
+        std::size_t rebuildCount = vehicles.size() * TrailVertCount;
+        for (auto skidEntity : skids)
+        {
+            const auto& skid = skidEntity.getComponent<SkidEffect>();
+            for (const auto& mark : skid.skidmarks)
+            {
+                if (time - mark.timestamp < Skidmark::DefaultLifeTime)
+                {
+                    rebuildCount += skid.wheelCount * 4;
+                }
+            }
+        }
+        rebuildBytes += rebuildCount * sizeof(sf::Vertex);
+        frameCount++;
+    }
+
+    if (frameCount)
+    {
+        result.trailBytes = static_cast<float>(trailBytes) / frameCount;
+        result.skidBytes = static_cast<float>(skidBytes) / frameCount;
+        result.rebuildBytes = static_cast<float>(rebuildBytes) / frameCount;
+    }
+    result.vertexCount = trailBatch.getComponent<xy::Drawable>().getVertices().size()
+        + skidBatch.getComponent<xy::Drawable>().getVertices().size();
+
+    return result;
+}
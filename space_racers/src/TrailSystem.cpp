@@ -22,99 +22,171 @@ Copyright 2019 Matt Marchant
 #include <xyginext/ecs/components/Transform.hpp>
 #include <xyginext/ecs/Scene.hpp>
 
+#include <algorithm>
+
+namespace
+{
+    const std::size_t VertsPerSegment = 4;
+    const std::size_t VertsPerTrail = std::tuple_size<decltype(Trail::points)>::value * VertsPerSegment;
+
+    //this is a kludge to save normalising the perp and resizing to a specific size.
+    const float TrailWidth = 0.1f;
+
+    //horizontal texture coords across the trail
+    const float EdgeCoord = 13.f;
+    const float TipCoord = 12.5f;
+}
+
 TrailSystem::TrailSystem(xy::MessageBus& mb)
-    : xy::System(mb, typeid(TrailSystem))
+    : xy::System    (mb, typeid(TrailSystem)),
+    m_time          (0.f),
+    m_bytesWritten  (0),
+    m_boundsMin     (std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+    m_boundsMax     (std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest()),
+    m_boundsChanged (false)
 {
-    requireComponent<xy::Drawable>();
     requireComponent<Trail>();
 }
 
 //public
 void TrailSystem::process(float dt)
 {
-    auto entities = getEntities();
+    m_time += dt;
+
+    auto& entities = getEntities();
     for (auto entity : entities)
     {
         auto& trail = entity.getComponent<Trail>();
-        auto& drawable = entity.getComponent<xy::Drawable>();
-        auto& verts = drawable.getVertices();
 
         if (trail.parent.isValid())
         {
             trail.parentLastPosition = trail.parent.getComponent<xy::Transform>().getPosition();
         }
 
-        for (auto i = 0u; i < trail.points.size(); ++i)
+        const auto pointCount = trail.points.size();
+        for (auto i = 0u; i < pointCount; ++i)
         {
-            trail.points[i].lifetime = std::max(0.f, trail.points[i].lifetime - dt);
-            if (!trail.points[i].sleeping)
+            auto& point = trail.points[i];
+            point.lifetime = std::max(0.f, point.lifetime - dt);
+            if (!point.sleeping && point.lifetime == 0)
             {
-                if (trail.points[i].lifetime == 0)
+                const auto& previous = trail.points[(i + pointCount - 1) % pointCount];
+                sf::Vector2f direction = trail.parentLastPosition - previous.position;
+                point.normal = sf::Vector2f(direction.y, -direction.x) * TrailWidth;
+                point.position = trail.parentLastPosition;
+                point.timestamp = m_time;
+
+                if (trail.parent.isValid())
+                {
+                    point.lifetime = Trail::Point::MaxLifetime;
+                }
+                else
                 {
-                    trail.points[i].position = trail.parentLastPosition;
-                    if (trail.parent.isValid())
-                    {
-                        trail.points[i].lifetime = Trail::Point::MaxLifetime;
-                    }
-                    else
-                    {
-                        trail.points[i].sleeping = true;
-                        trail.sleepCount++;
-                    }
-                    trail.oldestPoint = (trail.oldestPoint + 1) % trail.points.size();
-                } 
+                    //sleeping points are already faded out
+                    point.sleeping = true;
+                    point.timestamp -= Trail::Point::MaxLifetime;
+                    trail.sleepCount++;
+                }
+                trail.oldestPoint = (trail.oldestPoint + 1) % pointCount;
+
+                //the next oldest point becomes the tip of the trail so
+                //the segments either side of it need updating too
+                writeSegment(trail, i);
+                writeSegment(trail, trail.oldestPoint);
+                writeSegment(trail, (trail.oldestPoint + 1) % pointCount);
             }
         }
-        //rebuild vert array here making sure to start with the oldest
-        verts.clear();
 
-        auto i = trail.oldestPoint;
-        verts.emplace_back(trail.points[i].position, trail.colour, sf::Vector2f(12.5f, 0.f));
-        verts.back().color.a = static_cast<sf::Uint8>(255.f * (trail.points[i].lifetime / Trail::Point::MaxLifetime));
-        i = (i + 1) % trail.points.size();
-
-        for (auto j = 0u; j < trail.points.size(); ++j)
+        if (trail.sleepCount == pointCount)
         {
-            std::size_t next = (i + 1) % trail.points.size();
-            
-            if (next == trail.oldestPoint)
-            {
-                //we're at the end so go the other way
-                next = (i + (trail.points.size() - 1)) % trail.points.size();
-            }
-            
-            sf::Vector2f direction = trail.points[next].position - trail.points[i].position;
-            sf::Vector2f vertPos(direction.y, -direction.x);
-            vertPos *= 0.1f; //this is a kludge to save normalising the perp and resizing to a specific size.
-
-            verts.emplace_back(vertPos + trail.points[i].position, trail.colour);
-            verts.back().color.a = static_cast<sf::Uint8>(255.f * (trail.points[i].lifetime / Trail::Point::MaxLifetime));
+            getScene()->destroyEntity(entity);
+        }
+    }
 
-            verts.emplace_back(-vertPos + trail.points[i].position, trail.colour, sf::Vector2f(13.f, 0.f));
-            verts.back().color.a = static_cast<sf::Uint8>(255.f * (trail.points[i].lifetime / Trail::Point::MaxLifetime));
+    if (m_batchEntity.isValid())
+    {
+        auto& drawable = m_batchEntity.getComponent<xy::Drawable>();
+        drawable.bindUniform("u_time", m_time);
 
-            i = next;
+        //bounds only ever grow, they're just used for culling
+        if (m_boundsChanged)
+        {
+            drawable.updateLocalBounds({ m_boundsMin, m_boundsMax - m_boundsMin });
+            m_boundsChanged = false;
         }
+    }
+}
 
-        drawable.updateLocalBounds();
+void TrailSystem::setBatchEntity(xy::Entity entity)
+{
+    XY_ASSERT(entity.hasComponent<xy::Drawable>(), "Trail batch requires a drawable");
+    m_batchEntity = entity;
+
+    auto& drawable = entity.getComponent<xy::Drawable>();
+    drawable.setPrimitiveType(sf::Quads);
+    drawable.bindUniform("u_lifetime", Trail::Point::MaxLifetime);
+    drawable.bindUniform("u_time", m_time);
+}
+
+//private
+void TrailSystem::writeSegment(const Trail& trail, std::size_t index)
+{
+    auto& verts = m_batchEntity.getComponent<xy::Drawable>().getVertices();
+    auto* segment = &verts[trail.slot * VertsPerTrail + index * VertsPerSegment];
+    const auto& point = trail.points[index];
 
-        if (trail.sleepCount == trail.points.size())
+    if (index == trail.oldestPoint)
+    {
+        //the oldest point is the tip, so has no segment of its own
+        for (auto i = 0u; i < VertsPerSegment; ++i)
         {
-            getScene()->destroyEntity(entity);
+            segment[i] = sf::Vertex(point.position, trail.colour, sf::Vector2f(TipCoord, point.timestamp));
         }
     }
+    else
+    {
+        const auto previousIndex = (index + trail.points.size() - 1) % trail.points.size();
+        const auto& previous = trail.points[previousIndex];
+
+        const bool tip = (previousIndex == trail.oldestPoint);
+        const auto previousNormal = tip ? sf::Vector2f() : previous.normal;
+
+        segment[0] = sf::Vertex(previous.position + previousNormal, trail.colour, sf::Vector2f(tip ? TipCoord : 0.f, previous.timestamp));
+        segment[1] = sf::Vertex(point.position + point.normal, trail.colour, sf::Vector2f(0.f, point.timestamp));
+        segment[2] = sf::Vertex(point.position - point.normal, trail.colour, sf::Vector2f(EdgeCoord, point.timestamp));
+        segment[3] = sf::Vertex(previous.position - previousNormal, trail.colour, sf::Vector2f(tip ? TipCoord : EdgeCoord, previous.timestamp));
+    }
+
+    for (auto i = 0u; i < VertsPerSegment; ++i)
+    {
+        m_boundsMin.x = std::min(m_boundsMin.x, segment[i].position.x);
+        m_boundsMin.y = std::min(m_boundsMin.y, segment[i].position.y);
+        m_boundsMax.x = std::max(m_boundsMax.x, segment[i].position.x);
+        m_boundsMax.y = std::max(m_boundsMax.y, segment[i].position.y);
+    }
+    m_boundsChanged = true;
+    m_bytesWritten += VertsPerSegment * sizeof(sf::Vertex);
 }
 
-//private
 void TrailSystem::onEntityAdded(xy::Entity entity)
 {
     auto& trail = entity.getComponent<Trail>();
 
     XY_ASSERT(trail.parent.isValid(), "Can't init a trail without a parent");
+    XY_ASSERT(m_batchEntity.isValid(), "Trail batch entity not set");
 
-    auto& drawable = entity.getComponent<xy::Drawable>();
-    //drawable.getVertices().resize(trail.points.size());
-    drawable.setPrimitiveType(sf::TriangleStrip);
+    //reuse the slot of a destroyed trail if there is one
+    if (m_freeSlots.empty())
+    {
+        auto& verts = m_batchEntity.getComponent<xy::Drawable>().getVertices();
+        trail.slot = verts.size() / VertsPerTrail;
+        verts.resize(verts.size() + VertsPerTrail);
+    }
+    else
+    {
+        trail.slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
 
     float lifeStep = Trail::Point::MaxLifetime / trail.points.size();
     auto position = trail.parent.getComponent<xy::Transform>().getPosition();
@@ -122,6 +194,28 @@ void TrailSystem::onEntityAdded(xy::Entity entity)
     for (auto i = 0u; i < trail.points.size(); ++i)
     {
         trail.points[i].lifetime = i * lifeStep;
+        trail.points[i].timestamp = m_time - (Trail::Point::MaxLifetime - trail.points[i].lifetime);
         trail.points[i].position = position;
     }
-}
\ No newline at end of file
+
+    for (auto i = 0u; i < trail.points.size(); ++i)
+    {
+        writeSegment(trail, i);
+    }
+}
+
+void TrailSystem::onEntityRemoved(xy::Entity entity)
+{
+    const auto& trail = entity.getComponent<Trail>();
+    if (m_batchEntity.isValid()
+        && trail.slot != std::numeric_limits<std::size_t>::max())
+    {
+        //collapse the slot so it draws nothing until reused
+        auto& verts = m_batchEntity.getComponent<xy::Drawable>().getVertices();
+        auto start = verts.begin() + (trail.slot * VertsPerTrail);
+        std::fill(start, start + VertsPerTrail, sf::Vertex());
+        m_bytesWritten += VertsPerTrail * sizeof(sf::Vertex);
+
+        m_freeSlots.push_back(trail.slot);
+    }
+}
@@ -36,4 +36,15 @@ std::string formatTimeString(float t)
     ss << std::setw(4) << std::setfill('0') << static_cast<int>(remain * 10000.f);
 
     return ss.str();
-}
\ No newline at end of file
+}
+
+std::uint64_t fnv1a(const void* data, std::size_t size, std::uint64_t hash)
+{
+    const auto* bytes = static_cast<const std::uint8_t*>(data);
+    for (auto i = 0u; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
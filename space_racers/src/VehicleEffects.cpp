@@ -0,0 +1,53 @@
+/*********************************************************************
+
+Copyright 2019 Matt Marchant
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+
+*********************************************************************/
+
+#include "VehicleEffects.hpp"
+#include "TrailSystem.hpp"
+#include "SkidEffectSystem.hpp"
+#include "GameConsts.hpp"
+#include "ResourceIDs.hpp"
+
+#include <xyginext/ecs/Scene.hpp>
+#include <xyginext/ecs/components/Transform.hpp>
+#include <xyginext/ecs/components/Drawable.hpp>
+#include <xyginext/resources/ShaderResource.hpp>
+
+#include "VehicleShader.inl"
+
+void loadVehicleEffectShaders(xy::ShaderResource& shaders)
+{
+    shaders.preload(ShaderID::Trail, TrailVertex, VehicleTrail);
+    shaders.preload(ShaderID::Skid, SkidVertex, SkidFragment);
+}
+
+void createVehicleEffectBatches(xy::Scene& scene, xy::ShaderResource& shaders, const sf::Texture& trailTexture)
+{
+    auto entity = scene.createEntity();
+    entity.addComponent<xy::Transform>();
+    entity.addComponent<xy::Drawable>().setDepth(GameConst::VehicleRenderDepth - 1);
+    entity.getComponent<xy::Drawable>().setTexture(&trailTexture);
+    entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Trail));
+    entity.getComponent<xy::Drawable>().bindUniformToCurrentTexture("u_texture");
+    scene.getSystem<TrailSystem>().setBatchEntity(entity);
+
+    entity = scene.createEntity();
+    entity.addComponent<xy::Transform>();
+    entity.addComponent<xy::Drawable>().setDepth(GameConst::TrackRenderDepth + 1);
+    entity.getComponent<xy::Drawable>().setShader(&shaders.get(ShaderID::Skid));
+    scene.getSystem<SkidEffectSystem>().setBatchEntity(entity);
+}
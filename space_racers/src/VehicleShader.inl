@@ -106,6 +106,24 @@ void main()
     gl_FragColor.rgb = mix(gl_FragColor.rgb, neon, dot(neonSample.rgb, vec3(0.299, 0.587, 0.114))); //uses neon map brightness as blend amount
 })";
 
+//trails and skid marks are batched, and never rewritten once
+//created, so the time each vertex was created is stored in its
+//texture coordinates and used to fade it out here
+static const std::string TrailVertex =
+R"(
+#version 120
+
+uniform float u_time;
+uniform float u_lifetime;
+
+void main()
+{
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    gl_TexCoord[0] = gl_TextureMatrix[0] * vec4(gl_MultiTexCoord0.x, 0.0, 0.0, 1.0);
+    gl_FrontColor = gl_Color;
+    gl_FrontColor.a = clamp(1.0 - ((u_time - gl_MultiTexCoord0.y) / u_lifetime), 0.0, 1.0);
+})";
+
 static const std::string VehicleTrail =
 R"(
 uniform sampler2D u_texture;
@@ -115,6 +133,27 @@ void main()
     gl_FragColor = texture2D(u_texture, gl_TexCoord[0].xy) + gl_Color;
 })";
 
+static const std::string SkidVertex =
+R"(
+#version 120
+
+uniform float u_time;
+uniform float u_lifetime;
+
+void main()
+{
+    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;
+    gl_FrontColor = gl_Color;
+    gl_FrontColor.a *= clamp(1.0 - ((u_time - gl_MultiTexCoord0.x) / u_lifetime), 0.0, 1.0);
+})";
+
+static const std::string SkidFragment =
+R"(
+void main()
+{
+    gl_FragColor = gl_Color;
+})";
+
 static const std::string GhostFrag =
 R"(
 uniform sampler2D u_diffuseMap;
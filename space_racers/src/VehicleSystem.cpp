@@ -44,7 +44,8 @@ Copyright 2019 Matt Marchant
 #include <cmath>
 
 VehicleSystem::VehicleSystem(xy::MessageBus& mb)
-    : xy::System(mb, typeid(VehicleSystem))
+    : xy::System(mb, typeid(VehicleSystem)),
+    m_frame(0)
 {
     requireComponent<Vehicle>();
     requireComponent<xy::Transform>();
@@ -62,6 +63,9 @@ VehicleSystem::VehicleSystem(xy::MessageBus& mb)
 //public
 void VehicleSystem::process(float)
 {
+    m_frame++;
+    m_collisionTime = sf::Time::Zero;
+
     auto& entities = getEntities();
     for (auto entity : entities)
     {
@@ -72,17 +76,16 @@ void VehicleSystem::process(float)
 
         while (vehicle.lastUpdatedInput != idx)
         {
-            auto delta = getDelta(vehicle.history, vehicle.lastUpdatedInput);
-            
-            processVehicle(entity, delta);
+            processVehicle(entity, vehicle.history[vehicle.lastUpdatedInput]);
 
             //check to see if the player went AFK
+            vehicle.afkTime += Vehicle::StepTime;
             if (vehicle.history[vehicle.lastUpdatedInput].flags != 0)
             {
-                vehicle.afkTimer.restart();
+                vehicle.afkTime = 0.f;
                 vehicle.stateFlags &= ~(1 << Vehicle::AFK);
             }
-            if (vehicle.afkTimer.getElapsedTime().asSeconds() > Vehicle::AfkTime
+            if (vehicle.afkTime > Vehicle::AfkTime
                 && ((vehicle.stateFlags & (1 << Vehicle::AFK)) == 0))
             {
                 vehicle.stateFlags |= (1 << Vehicle::AFK);
@@ -91,7 +94,7 @@ void VehicleSystem::process(float)
                 msg->type = VehicleEvent::WentAfk;
                 msg->entity = entity;
             }
-            /*if (vehicle.afkTimer.getElapsedTime().asSeconds() > Vehicle::AfkTimeout)
+            /*if (vehicle.afkTime > Vehicle::AfkTimeout)
             {
                 std::cout << "request kick AFK player!\n";
             }*/
@@ -103,10 +106,14 @@ void VehicleSystem::process(float)
 
 void VehicleSystem::reconcile(const ClientUpdate& update, xy::Entity entity)
 {
+    //other objects may have moved since the last update
+    m_frame++;
+
     //sync state
     auto& vehicle = entity.getComponent<Vehicle>();
     vehicle.velocity = { update.velX, update.velY };
     vehicle.anglularVelocity = update.velRot;
+    vehicle.accelerationMultiplier = update.accelerationMultiplier;
     vehicle.collisionFlags = update.collisionFlags;
     vehicle.stateFlags = update.stateFlags;
 
@@ -128,9 +135,7 @@ void VehicleSystem::reconcile(const ClientUpdate& update, xy::Entity entity)
 
         while (idx != end) //currentInput points to the next free slot in history
         {
-            float delta = getDelta(vehicle.history, idx);
-
-            processVehicle(entity, delta);
+            processVehicle(entity, vehicle.history[idx]);
 
             idx = (idx + 1) % vehicle.history.size();
         }
@@ -138,30 +143,39 @@ void VehicleSystem::reconcile(const ClientUpdate& update, xy::Entity entity)
 }
 
 //private
-void VehicleSystem::processVehicle(xy::Entity entity, float delta)
+void VehicleSystem::processVehicle(xy::Entity entity, const Input& input)
 {
+    const float delta = Vehicle::StepTime;
+
     auto& vehicle = entity.getComponent<Vehicle>();
     switch (vehicle.stateFlags)
     {
     default: break;
     case (1 << Vehicle::Normal):
-        processInput(entity, delta);
+        processInput(entity, input, delta);
     //this is meant to fall through
     case (1 << Vehicle::Disabled):
         applyInput(entity, delta);
+        updateWorldSpace(entity);
+
+        m_collisionClock.restart();
         doCollision(entity);
+        m_collisionTime += m_collisionClock.getElapsedTime();
         break;
     case (1 << Vehicle::Falling):
         updateFalling(entity, delta);
+        updateWorldSpace(entity);
         break;
     case (1 << Vehicle::Exploding):
         updateExploding(entity, delta);
+        updateWorldSpace(entity);
         break;
     case (1 << Vehicle::Eliminated):
         break; //do nothing
     case (1 << Vehicle::Celebrating):
         //dance for me baby!
         updateCelebrating(entity, delta);
+        updateWorldSpace(entity);
         break;
     }
     vehicle.invincibleTime -= delta;
@@ -181,10 +195,9 @@ void VehicleSystem::processVehicle(xy::Entity entity, float delta)
     }
 }
 
-void VehicleSystem::processInput(xy::Entity entity, float delta)
+void VehicleSystem::processInput(xy::Entity entity, const Input& input, float delta)
 {
     auto& vehicle = entity.getComponent<Vehicle>();
-    auto input = vehicle.history[vehicle.lastUpdatedInput];
 
     //acceleration
     auto acceleration = 0.f;
@@ -261,19 +274,19 @@ void VehicleSystem::applyInput(xy::Entity entity, float dt)
     tx.setScale(1.f, 1.f);
 }
 
-float VehicleSystem::getDelta(const History& history, std::size_t idx)
+void VehicleSystem::updateWorldSpace(xy::Entity entity)
 {
-    auto prevInput = (idx + history.size() - 1) % history.size();
-
-    //skip any inputs in the wrong order - actually enet is supposed to guarantee this for us?
-    /*while (history[prevInput].timestamp > history[idx].timestamp)
-    {
-        prevInput = (prevInput + history.size() - 1) % history.size();
-    }*/
-
-    auto delta = history[idx].timestamp - history[prevInput].timestamp;
+    auto& collision = entity.getComponent<CollisionObject>();
+    collision.updateWorldSpace(entity.getComponent<xy::Transform>().getWorldTransform());
+    collision.worldFrame = m_frame;
+}
 
-    return static_cast<float>(delta) / 1000000.f;
+std::uint32_t& VehicleSystem::getSeparatingAxis(xy::Entity entity, xy::Entity other)
+{
+    //stale entries left by destroyed entities are harmless
+    //as the axis is only used as a hint
+    auto key = (static_cast<std::uint64_t>(entity.getIndex()) << 32) | other.getIndex();
+    return m_separatingAxes.try_emplace(key, SeparatingAxis::None).first->second;
 }
 
 void VehicleSystem::doCollision(xy::Entity entity)
@@ -291,11 +304,18 @@ void VehicleSystem::doCollision(xy::Entity entity)
     {
         if (other != entity)
         {
-            auto otherBounds = other.getComponent<xy::Transform>().getTransform().transformRect(other.getComponent<xy::BroadphaseComponent>().getArea());
-            if (otherBounds.intersects(queryArea))
+            //static objects were baked when the map was loaded
+            auto& otherCollision = other.getComponent<CollisionObject>();
+            if (!otherCollision.isStatic
+                && otherCollision.worldFrame != m_frame)
+            {
+                updateWorldSpace(other);
+            }
+
+            if (otherCollision.worldBounds.intersects(queryArea))
             {
                 //we're only doing this on the current vehicle, so let's narrow phase right away!
-                auto type = other.getComponent<CollisionObject>().type;
+                auto type = otherCollision.type;
                 if(type == CollisionObject::Space
                     && contains(tx.getPosition(), other))
                 {
@@ -304,7 +324,7 @@ void VehicleSystem::doCollision(xy::Entity entity)
                     {
                         vehicle.collisionFlags |= (1 << type);
                         vehicle.stateFlags = (1 << Vehicle::Falling);
-                        vehicle.respawnClock.restart();
+                        vehicle.respawnTime = 0.f;
 
                         auto* msg = postMessage<VehicleEvent>(MessageID::VehicleMessage);
                         msg->type = VehicleEvent::Fell;
@@ -354,7 +374,7 @@ void VehicleSystem::doCollision(xy::Entity entity)
                     }
                 }
 
-                else if (auto manifold = intersects(entity, other); manifold)
+                else if (auto manifold = intersects(entity, other, getSeparatingAxis(entity, other)); manifold)
                 {
                     resolveCollision(entity, other, *manifold);
 
@@ -419,6 +439,7 @@ void VehicleSystem::resolveCollision(xy::Entity entity, xy::Entity other, Manifo
         {
             other.getComponent<xy::Transform>().move(-manifold.penetration * manifold.normal);
             roid.setVelocity(xy::Util::Vector::reflect(roid.getVelocity(), -manifold.normal));
+            updateWorldSpace(other);
         }
         else if (manifold.penetration < -14)
         {
@@ -467,6 +488,9 @@ void VehicleSystem::resolveCollision(xy::Entity entity, xy::Entity other, Manifo
 
     //mark this type of collision active
     vehicle.collisionFlags |= (1 << otherCollision.type);
+
+    //we may have been moved, so make sure any further tests are correct
+    updateWorldSpace(entity);
     
 }
 
@@ -485,9 +509,10 @@ void VehicleSystem::updateFalling(xy::Entity entity, float dt)
     tx.rotate(rotation * dt);
     tx.scale(scaleFactor, scaleFactor);
 
-    if(vehicle.respawnClock.getElapsedTime().asSeconds() > Vehicle::RespawnDuration)
+    vehicle.respawnTime += dt;
+    if(vehicle.respawnTime > Vehicle::RespawnDuration)
     {
-        vehicle.respawnClock.restart(); //just gives a small buffer to prevent mutliple messages
+        vehicle.respawnTime = 0.f; //just gives a small buffer to prevent mutliple messages
 
         //raise a message here so that the server can be the arbiter on resetting the vehicle
         auto* msg = postMessage<VehicleEvent>(MessageID::VehicleMessage);
@@ -496,16 +521,17 @@ void VehicleSystem::updateFalling(xy::Entity entity, float dt)
     }
 }
 
-void VehicleSystem::updateExploding(xy::Entity entity, float)
+void VehicleSystem::updateExploding(xy::Entity entity, float dt)
 {
     auto& vehicle = entity.getComponent<Vehicle>();
     vehicle.accelerationMultiplier = 0.f;
 
     entity.getComponent<xy::Transform>().setScale(0.f, 0.f);
 
-    if (vehicle.respawnClock.getElapsedTime().asSeconds() > Vehicle::RespawnDuration)
+    vehicle.respawnTime += dt;
+    if (vehicle.respawnTime > Vehicle::RespawnDuration)
     {
-        vehicle.respawnClock.restart(); //just gives a small buffer to prevent mutliple messages
+        vehicle.respawnTime = 0.f; //just gives a small buffer to prevent mutliple messages
 
         //raise a message here so that the server can be the arbiter on resetting the vehicle
         auto* msg = postMessage<VehicleEvent>(MessageID::VehicleMessage);
@@ -517,7 +543,7 @@ void VehicleSystem::updateExploding(xy::Entity entity, float)
 void VehicleSystem::explode(xy::Entity entity)
 {
     entity.getComponent<xy::Transform>().setScale(0.f, 0.f);
-    entity.getComponent<Vehicle>().respawnClock.restart();
+    entity.getComponent<Vehicle>().respawnTime = 0.f;
     entity.getComponent<Vehicle>().stateFlags = (1 << Vehicle::Exploding);
 
     auto* msg = postMessage<VehicleEvent>(MessageID::VehicleMessage);
@@ -527,7 +553,7 @@ void VehicleSystem::explode(xy::Entity entity)
 
 void VehicleSystem::updateCelebrating(xy::Entity entity, float dt)
 {
-    static size_t index = 0; //yes yes, static var will bite me in the butt eventually.
+    auto& index = entity.getComponent<Vehicle>().celebrationIndex;
     auto& tx = entity.getComponent<xy::Transform>();
     tx.setScale(1.f + m_waveTable[index], 1.f + m_waveTable[index]);
     index = (index + 1) % m_waveTable.size();